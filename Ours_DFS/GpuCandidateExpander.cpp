@@ -1,7 +1,7 @@
 #include "GpuCandidateExpander.h"
 
 #include <algorithm>
-#include <unordered_set>
+#include <limits>
 
 #ifdef BUILD_WITH_CUDA
 namespace cuda_backend {
@@ -62,25 +62,8 @@ std::vector<int> CandidateExpander::filterChildCandidates(int parent_vertex, int
 }
 
 void CandidateExpander::initializeLabelIds() {
-    auto intern_label = [&](const std::string& label) -> int {
-        auto it = label_to_id_.find(label);
-        if (it != label_to_id_.end()) {
-            return it->second;
-        }
-        const int id = static_cast<int>(label_to_id_.size());
-        label_to_id_.emplace(label, id);
-        return id;
-    };
-
-    vertex_label_ids_.resize(graph_.vertex_labels.size(), -1);
-    for (size_t i = 0; i < graph_.vertex_labels.size(); ++i) {
-        vertex_label_ids_[i] = intern_label(graph_.vertex_labels[i]);
-    }
-
-    query_label_ids_.resize(decomposition_.vertex_labels.size(), -1);
-    for (size_t i = 0; i < decomposition_.vertex_labels.size(); ++i) {
-        query_label_ids_[i] = intern_label(decomposition_.vertex_labels[i]);
-    }
+    vertex_label_ids_.assign(graph_.vertex_labels.begin(), graph_.vertex_labels.end());
+    query_label_ids_.assign(decomposition_.vertex_labels.begin(), decomposition_.vertex_labels.end());
 }
 
 void CandidateExpander::initializeVertexStats() {
@@ -92,26 +75,19 @@ void CandidateExpander::initializeVertexStats() {
     for (size_t u = 0; u < num_vertices; ++u) {
         vertex_degrees_[u] = static_cast<int>(graph_.adj[u].size());
 
-        std::unordered_set<int> time_instances;
-        std::unordered_set<int> neighbor_label_ids;
+        unsigned neighbor_label_bits = 0;
+        int distinct_neighbor_labels = 0;
         for (const auto& edge : graph_.adj[u]) {
-            if (edge.to >= 0 && edge.to < static_cast<int>(vertex_label_ids_.size())) {
-                neighbor_label_ids.insert(vertex_label_ids_[edge.to]);
-            }
-
-            auto time_it = graph_.edge_time_instances.find({static_cast<int>(u), edge.to});
-            if (time_it != graph_.edge_time_instances.end()) {
-                time_instances.insert(time_it->second.begin(), time_it->second.end());
-            }
-
-            time_it = graph_.edge_time_instances.find({edge.to, static_cast<int>(u)});
-            if (time_it != graph_.edge_time_instances.end()) {
-                time_instances.insert(time_it->second.begin(), time_it->second.end());
+            const unsigned bit = 1U << vertex_label_ids_[edge.to];
+            if ((neighbor_label_bits & bit) == 0) {
+                neighbor_label_bits |= bit;
+                ++distinct_neighbor_labels;
             }
         }
 
-        vertex_duration_counts_[u] = static_cast<int>(time_instances.size());
-        vertex_distinct_neighbor_label_counts_[u] = static_cast<int>(neighbor_label_ids.size());
+        const size_t duration = countTimeInstances(graph_.vertexTimeIntervals(static_cast<int>(u)));
+        vertex_duration_counts_[u] = static_cast<int>(std::min<size_t>(duration, std::numeric_limits<int>::max()));
+        vertex_distinct_neighbor_label_counts_[u] = distinct_neighbor_labels;
     }
 }
 
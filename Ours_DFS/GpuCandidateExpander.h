@@ -1,8 +1,6 @@
 #ifndef GPU_CANDIDATE_EXPANDER_H
 #define GPU_CANDIDATE_EXPANDER_H
 
-#include <string>
-#include <unordered_map>
 #include <vector>
 
 #include "Utils.h"
@@ -22,7 +20,6 @@ private:
     int k_threshold_;
     bool gpu_enabled_;
 
-    std::unordered_map<std::string, int> label_to_id_;
     std::vector<int> vertex_label_ids_;
     std::vector<int> query_label_ids_;
     std::vector<int> vertex_degrees_;
@@ -1,12 +1,97 @@
 #include "TDTree.h"
 
 #include <algorithm>
-#include <deque>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <queue>
 #include <sstream>
 #include <unordered_map>
+#include <utility>
+
+namespace {
+
+// Distinct candidates of one TD-tree node per parent data vertex, in CSR form.
+struct CandidateIndex {
+    std::vector<int> parents; // Sorted parent data vertices
+    std::vector<size_t> offsets{0}; // Candidates of parents[i] are candidates[offsets[i]..offsets[i + 1])
+    std::vector<int> candidates; // Sorted and distinct per parent
+
+    void build(const std::vector<TDTreeBlock>& blocks) {
+        std::vector<std::pair<int, int>> pairs;
+        for (const auto& block : blocks) {
+            for (int v : block.V_cand) {
+                pairs.emplace_back(block.v_par, v);
+            }
+        }
+        std::sort(pairs.begin(), pairs.end());
+        pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+        for (const auto& pair : pairs) {
+            if (parents.empty() || parents.back() != pair.first) {
+                if (!parents.empty()) {
+                    offsets.push_back(candidates.size());
+                }
+                parents.push_back(pair.first);
+            }
+            candidates.push_back(pair.second);
+        }
+        if (!parents.empty()) {
+            offsets.push_back(candidates.size());
+        }
+    }
+
+    std::pair<const int*, const int*> lookup(int parent_vertex) const {
+        const auto it = std::lower_bound(parents.begin(), parents.end(), parent_vertex);
+        if (it == parents.end() || *it != parent_vertex) {
+            return {nullptr, nullptr};
+        }
+        const size_t i = static_cast<size_t>(it - parents.begin());
+        return {candidates.data() + offsets[i], candidates.data() + offsets[i + 1]};
+    }
+};
+
+// Partial matches of one BFS depth, stored flat: state i is the fixed-size
+// mapping slice [i * stride, (i + 1) * stride) plus an interval range. The
+// vectors are a pool that keeps its capacity from level to level.
+class FrontierPool {
+public:
+    explicit FrontierPool(size_t stride) : stride_(stride) {}
+
+    size_t size() const { return ts_offsets_.size() - 1; }
+
+    size_t bytes() const {
+        return mappings_.size() * sizeof(int) + ts_offsets_.size() * sizeof(size_t) +
+               intervals_.size() * sizeof(TimeInterval);
+    }
+
+    void push(const std::vector<int>& mapping, const std::vector<TimeInterval>& ts) {
+        mappings_.insert(mappings_.end(), mapping.begin(), mapping.end());
+        intervals_.insert(intervals_.end(), ts.begin(), ts.end());
+        ts_offsets_.push_back(intervals_.size());
+    }
+
+    void load(size_t i, std::vector<int>& mapping, std::vector<TimeInterval>& ts) const {
+        const auto first = mappings_.begin() + static_cast<std::ptrdiff_t>(i * stride_);
+        std::copy(first, first + static_cast<std::ptrdiff_t>(stride_), mapping.begin());
+        ts.assign(intervals_.begin() + static_cast<std::ptrdiff_t>(ts_offsets_[i]),
+                  intervals_.begin() + static_cast<std::ptrdiff_t>(ts_offsets_[i + 1]));
+    }
+
+    void clear() {
+        mappings_.clear();
+        ts_offsets_.resize(1);
+        intervals_.clear();
+    }
+
+private:
+    size_t stride_;
+    std::vector<int> mappings_;
+    std::vector<size_t> ts_offsets_{0};
+    std::vector<TimeInterval> intervals_;
+};
+
+} // namespace
 
 TDTree::TDTree(const Graph& temporal_graph, const Graph& query_graph, const QueryDecomposition& decomposition, int k)
     : G(temporal_graph),
@@ -120,7 +205,7 @@ void TDTree::fillRoot() {
     for (int v : root_candidates) {
         TDTreeBlock block(-1);
         block.V_cand.push_back(v);
-        block.TS = computeVertexTimeInstances(v);
+        block.TS = G.vertexTimeIntervals(v);
         root->blocks.emplace_back(std::move(block));
         root->bloom->add(v);
     }
@@ -146,21 +231,10 @@ void TDTree::growTDTree() {
     std::unordered_map<int, size_t> child_reject_duration_non_consecutive_ts_sum;
     std::unordered_map<int, size_t> child_reject_duration_non_consecutive_maxrun_sum;
 
-    auto max_consecutive_run = [](const std::unordered_set<int>& ts_set) -> int {
-        if (ts_set.empty()) {
-            return 0;
-        }
-        std::vector<int> times(ts_set.begin(), ts_set.end());
-        std::sort(times.begin(), times.end());
-        int best = 1;
-        int current = 1;
-        for (size_t i = 1; i < times.size(); ++i) {
-            if (times[i] == times[i - 1] + 1) {
-                current++;
-            } else {
-                current = 1;
-            }
-            best = std::max(best, current);
+    auto max_consecutive_run = [](const std::vector<TimeInterval>& intervals) -> int {
+        int best = 0;
+        for (const auto& interval : intervals) {
+            best = std::max(best, interval.length());
         }
         return best;
     };
@@ -202,20 +276,16 @@ void TDTree::growTDTree() {
                             continue;
                         }
 
-                        auto it_edge_time_instances = G.edge_time_instances.find({v, v_prime});
-                        if (it_edge_time_instances == G.edge_time_instances.end()) {
-                            it_edge_time_instances = G.edge_time_instances.find({v_prime, v});
-                        }
-                        if (it_edge_time_instances == G.edge_time_instances.end()) {
+                        const std::vector<TimeInterval>* edge_intervals = G.findEdgeIntervals(v, v_prime);
+                        if (edge_intervals == nullptr) {
                             missing_time_instances++;
                             continue;
                         }
 
-                        std::unordered_set<int> ts_intersection =
-                            intersectTimeSets(it_edge_time_instances->second, block.TS);
+                        std::vector<TimeInterval> ts_intersection = intersectTimeIntervals(*edge_intervals, block.TS);
                         if (!checkMinimumConsecutiveDuration(ts_intersection)) {
                             rejected_duration++;
-                            const size_t ts_size = ts_intersection.size();
+                            const size_t ts_size = countTimeInstances(ts_intersection);
                             if (ts_size < static_cast<size_t>(k_threshold)) {
                                 rejected_duration_size_lt_k++;
                                 child_reject_duration_size_lt_k[child_query_id]++;
@@ -479,11 +549,7 @@ void TDTree::print() const {
                 std::cout << v << ' ';
             }
             if (!block.TS.empty()) {
-                std::cout << "| TS: { ";
-                for (int ts : block.TS) {
-                    std::cout << ts << ' ';
-                }
-                std::cout << "}";
+                std::cout << "| TS: " << formatIntervals(block.TS);
             }
             std::cout << std::endl;
         }
@@ -500,7 +566,7 @@ size_t TDTree::getMemoryUsage() const {
         for (const auto& block : node_ptr->blocks) {
             total += sizeof(TDTreeBlock);
             total += block.V_cand.capacity() * sizeof(int);
-            total += block.TS.size() * sizeof(int);
+            total += block.TS.capacity() * sizeof(TimeInterval);
         }
     }
     return total;
@@ -528,8 +594,9 @@ void TDTree::print_res() const {
     }
 }
 
-void TDTree::save_res(const std::string& filename) const {
-    std::ofstream out(filename);
+void TDTree::save_res(const std::string& filename, size_t frontier_budget_bytes) const {
+    // Binary mode keeps the tellp/seekp offset of the match count stable on Windows.
+    std::ofstream out(filename, std::ios::binary);
     if (!out.is_open()) {
         return;
     }
@@ -582,7 +649,7 @@ void TDTree::save_res(const std::string& filename) const {
         return;
     }
 
-    std::vector<std::pair<int, std::unordered_set<int>>> root_candidates;
+    std::vector<std::pair<int, std::vector<TimeInterval>>> root_candidates;
     size_t root_blocks_total = root_node->blocks.size();
     size_t root_blocks_with_vpar_minus1 = 0;
     size_t root_blocks_with_candidates = 0;
@@ -604,36 +671,33 @@ void TDTree::save_res(const std::string& filename) const {
         return;
     }
 
-    struct FinalMatch {
-        std::vector<int> mapping;
-        std::unordered_set<int> ts;
-    };
-
-    struct PartialMatchState {
-        std::vector<int> mapping;
-        std::unordered_set<int> used_data_vertices;
-        std::unordered_set<int> current_ts;
-        int depth = 0;
-    };
-
-    std::vector<FinalMatch> final_matches;
-    std::unordered_set<std::string> unique_match_keys;
-
-    auto get_edge_times = [&](int u, int v) -> const std::unordered_set<int>* {
-        auto it = G.edge_time_instances.find({u, v});
-        if (it != G.edge_time_instances.end()) {
-            return &it->second;
-        }
-        it = G.edge_time_instances.find({v, u});
-        if (it != G.edge_time_instances.end()) {
-            return &it->second;
+    // Candidates of each query vertex grouped by parent data vertex, so that a
+    // state finds its children by binary search instead of scanning every block.
+    std::vector<CandidateIndex> candidate_index(Q.num_vertices);
+    for (int qid = 0; qid < Q.num_vertices; ++qid) {
+        if (node_by_qid[qid] != nullptr) {
+            candidate_index[qid].build(node_by_qid[qid]->blocks);
         }
-        return nullptr;
-    };
+    }
 
-    auto query_has_edge = [&](int u, int v) -> bool {
-        return GraphUtils::hasEdge(Q.adj, u, v) || GraphUtils::hasEdge(Q.adj, v, u);
-    };
+    // Query neighbors (either direction) of each query vertex that are mapped
+    // before it, excluding its tree parent, in ascending query ID.
+    std::vector<int> position(Q.num_vertices, -1);
+    for (size_t i = 0; i < order.size(); ++i) {
+        position[order[i]] = static_cast<int>(i);
+    }
+    std::vector<std::vector<int>> non_tree_checks(Q.num_vertices);
+    for (int qid = 0; qid < Q.num_vertices; ++qid) {
+        for (int q2 = 0; q2 < Q.num_vertices; ++q2) {
+            if (q2 == qid || q2 == parent[qid] || position[qid] < 0 || position[q2] < 0 ||
+                position[q2] > position[qid]) {
+                continue;
+            }
+            if (GraphUtils::hasEdge(Q.adj, qid, q2) || GraphUtils::hasEdge(Q.adj, q2, qid)) {
+                non_tree_checks[qid].push_back(q2);
+            }
+        }
+    }
 
     struct MatchDebugStats {
         size_t root_blocks_total = 0;
@@ -652,7 +716,9 @@ void TDTree::save_res(const std::string& filename) const {
         size_t cand_non_tree_ts_fail = 0;
         size_t bfs_accept_branch = 0;
         size_t final_match_unique = 0;
-        size_t final_match_duplicate = 0;
+        size_t bfs_levels_expanded = 0;
+        size_t frontier_peak_bytes = 0;
+        size_t dfs_chunks = 0;
     } dbg;
 
     std::vector<std::string> dbg_samples;
@@ -668,98 +734,73 @@ void TDTree::save_res(const std::string& filename) const {
     dbg.root_blocks_with_candidates = root_blocks_with_candidates;
     dbg.root_candidates_total = root_candidates.size();
 
-    std::deque<PartialMatchState> frontier;
-    for (const auto& root_entry : root_candidates) {
-        const int root_data = root_entry.first;
-        std::unordered_set<int> root_ts = root_entry.second;
-        if (root_ts.empty()) {
-            root_ts = computeVertexTimeInstances(root_data);
-        }
-        if (!checkMinimumConsecutiveDuration(root_ts)) {
-            dbg.root_ts_fail++;
-            continue;
-        }
-
-        PartialMatchState state;
-        state.mapping.assign(Q.num_vertices, -1);
-        state.mapping[root_qid] = root_data;
-        state.used_data_vertices.insert(root_data);
-        state.current_ts = std::move(root_ts);
-        state.depth = 1;
-        frontier.push_back(std::move(state));
-    }
-
-    while (!frontier.empty()) {
-        PartialMatchState state = std::move(frontier.front());
-        frontier.pop_front();
+    // Matches are streamed; the count is patched in once enumeration ends.
+    out << "\n[Final Matches]\nCount: ";
+    const std::streampos count_position = out.tellp();
+    out << std::setw(20) << 0 << '\n';
 
-        if (state.depth >= static_cast<int>(order.size())) {
-            std::string key;
-            key.reserve(static_cast<size_t>(Q.num_vertices) * 16);
-            for (int qid = 0; qid < Q.num_vertices; ++qid) {
-                key += std::to_string(qid);
-                key += "->";
-                key += std::to_string(state.mapping[qid]);
-                key += ';';
-            }
+    // The state being expanded: mapping holds the data vertex of every query
+    // vertex mapped so far and ts_stack[depth] its time instances.
+    std::vector<int> mapping(Q.num_vertices, -1);
+    std::vector<std::vector<TimeInterval>> ts_stack(order.size() + 1);
+    std::vector<TimeInterval> scratch_ts;
 
-            if (unique_match_keys.insert(key).second) {
-                final_matches.push_back({state.mapping, state.current_ts});
-                dbg.final_match_unique++;
-            } else {
-                dbg.final_match_duplicate++;
+    auto emit_match = [&](const std::vector<TimeInterval>& ts) {
+        out << "Match " << dbg.final_match_unique << ": ";
+        for (int qid = 0; qid < Q.num_vertices; ++qid) {
+            if (qid > 0) {
+                out << ", ";
             }
-            continue;
+            out << "q" << qid << "->" << mapping[qid];
         }
+        out << " |TS|=" << countTimeInstances(ts) << '\n';
+        dbg.final_match_unique++;
+    };
 
-        const int qid = order[state.depth];
+    // Calls on_child(qid, cand) for every valid extension of the state at depth,
+    // with ts_stack[depth + 1] holding the child's time instances. Candidates
+    // are sorted and distinct, so every partial match is generated once.
+    auto expand = [&](size_t depth, auto&& on_child) {
+        const int qid = order[depth];
         const int parent_qid = (qid >= 0 && qid < static_cast<int>(parent.size())) ? parent[qid] : -1;
         if (parent_qid < 0 || parent_qid >= Q.num_vertices) {
             dbg.bfs_parent_invalid++;
             push_dbg("drop[parent-invalid]: q" + std::to_string(qid));
-            continue;
+            return;
         }
 
-        const int parent_data = state.mapping[parent_qid];
+        const int parent_data = mapping[parent_qid];
         if (parent_data < 0) {
             dbg.bfs_parent_unmapped++;
             push_dbg("drop[parent-unmapped]: q" + std::to_string(qid) +
                      " parent q" + std::to_string(parent_qid));
-            continue;
+            return;
         }
 
-        const TDTreeNode* node =
-            (qid >= 0 && qid < static_cast<int>(node_by_qid.size())) ? node_by_qid[qid] : nullptr;
-        if (node == nullptr) {
+        if (node_by_qid[qid] == nullptr) {
             dbg.bfs_node_missing++;
             push_dbg("drop[node-missing]: q" + std::to_string(qid));
-            continue;
-        }
-
-        std::vector<int> candidates;
-        for (const auto& block : node->blocks) {
-            if (block.v_par == parent_data) {
-                candidates.insert(candidates.end(), block.V_cand.begin(), block.V_cand.end());
-            }
+            return;
         }
 
-        if (candidates.empty()) {
+        const auto candidates = candidate_index[qid].lookup(parent_data);
+        if (candidates.first == candidates.second) {
             dbg.bfs_empty_candidates++;
             push_dbg("drop[empty-candidates]: q" + std::to_string(qid) +
                      " parent-data " + std::to_string(parent_data));
-            continue;
+            return;
         }
 
-        std::sort(candidates.begin(), candidates.end());
-        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
-
-        for (int cand : candidates) {
-            if (state.used_data_vertices.find(cand) != state.used_data_vertices.end()) {
+        const std::vector<TimeInterval>& current_ts = ts_stack[depth];
+        std::vector<TimeInterval>& next_ts = ts_stack[depth + 1];
+        for (const int* it = candidates.first; it != candidates.second; ++it) {
+            const int cand = *it;
+            if (std::find(mapping.begin(), mapping.end(), cand) != mapping.end()) {
                 dbg.cand_duplicate_vertex++;
                 continue;
             }
 
-            const auto* tree_edge_ts = get_edge_times(parent_data, cand);
+            const auto* tree_edge_ts = G.findEdgeIntervals(parent_data, cand);
             if (tree_edge_ts == nullptr) {
                 dbg.cand_missing_tree_edge++;
                 push_dbg("drop[tree-edge-missing]: q" + std::to_string(qid) +
@@ -768,33 +809,27 @@ void TDTree::save_res(const std::string& filename) const {
                 continue;
             }
 
-            std::unordered_set<int> next_ts = intersectTimeSets(state.current_ts, *tree_edge_ts);
+            intersectTimeIntervals(current_ts, *tree_edge_ts, next_ts);
             if (!checkMinimumConsecutiveDuration(next_ts)) {
                 dbg.cand_tree_ts_fail++;
                 continue;
             }
 
             bool ok = true;
-            for (int q2 = 0; q2 < Q.num_vertices; ++q2) {
-                if (state.mapping[q2] < 0 || q2 == parent_qid || q2 == qid) {
-                    continue;
-                }
-                if (!query_has_edge(qid, q2)) {
-                    continue;
-                }
-
-                const auto* non_tree_ts = get_edge_times(cand, state.mapping[q2]);
+            for (int q2 : non_tree_checks[qid]) {
+                const auto* non_tree_ts = G.findEdgeIntervals(cand, mapping[q2]);
                 if (non_tree_ts == nullptr) {
                     dbg.cand_non_tree_missing_edge++;
                     push_dbg("drop[non-tree-edge-missing]: q" + std::to_string(qid) +
                              "->q" + std::to_string(q2) +
                              " data " + std::to_string(cand) +
-                             "->" + std::to_string(state.mapping[q2]));
+                             "->" + std::to_string(mapping[q2]));
                     ok = false;
                     break;
                 }
 
-                next_ts = intersectTimeSets(next_ts, *non_tree_ts);
+                intersectTimeIntervals(next_ts, *non_tree_ts, scratch_ts);
+                next_ts.swap(scratch_ts);
                 if (!checkMinimumConsecutiveDuration(next_ts)) {
                     dbg.cand_non_tree_ts_fail++;
                     ok = false;
@@ -806,28 +841,96 @@ void TDTree::save_res(const std::string& filename) const {
                 continue;
             }
 
-            PartialMatchState next_state = state;
-            next_state.mapping[qid] = cand;
-            next_state.used_data_vertices.insert(cand);
-            next_state.current_ts = std::move(next_ts);
-            next_state.depth = state.depth + 1;
-            frontier.push_back(std::move(next_state));
             dbg.bfs_accept_branch++;
+            on_child(qid, cand);
         }
-    }
+    };
 
-    out << "\n[Final Matches]\n";
-    out << "Count: " << final_matches.size() << '\n';
-    for (size_t i = 0; i < final_matches.size(); ++i) {
-        out << "Match " << i << ": ";
-        for (int qid = 0; qid < Q.num_vertices; ++qid) {
-            if (qid > 0) {
-                out << ", ";
-            }
-            out << "q" << qid << "->" << final_matches[i].mapping[qid];
+    // Depth-first completion of the state at depth; its stack is one mapping
+    // and one interval buffer per depth.
+    auto dfs = [&](auto&& self, size_t depth) -> void {
+        if (depth >= order.size()) {
+            emit_match(ts_stack[depth]);
+            return;
+        }
+        expand(depth, [&](int qid, int cand) {
+            mapping[qid] = cand;
+            self(self, depth + 1);
+            mapping[qid] = -1;
+        });
+    };
+
+    // Root states, one per distinct root data vertex.
+    std::sort(root_candidates.begin(), root_candidates.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    root_candidates.erase(
+        std::unique(root_candidates.begin(), root_candidates.end(),
+                    [](const auto& a, const auto& b) { return a.first == b.first; }),
+        root_candidates.end());
+
+    FrontierPool level(static_cast<size_t>(Q.num_vertices));
+    for (auto& root_entry : root_candidates) {
+        const int root_data = root_entry.first;
+        std::vector<TimeInterval>& root_ts = root_entry.second;
+        if (root_ts.empty()) {
+            root_ts = G.vertexTimeIntervals(root_data);
+        }
+        if (!checkMinimumConsecutiveDuration(root_ts)) {
+            dbg.root_ts_fail++;
+            continue;
+        }
+
+        mapping[root_qid] = root_data;
+        level.push(mapping, root_ts);
+        mapping[root_qid] = -1;
+    }
+    std::vector<std::pair<int, std::vector<TimeInterval>>>().swap(root_candidates);
+
+    // Breadth-first while the next level fits in the frontier budget. When it
+    // does not, the expanded states' children and then the unexpanded states
+    // are completed depth-first, which keeps the match order of a full BFS.
+    FrontierPool next_level(static_cast<size_t>(Q.num_vertices));
+    size_t depth = 1;
+    while (depth < order.size() && level.size() > 0) {
+        next_level.clear();
+        size_t expanded = 0;
+        for (; expanded < level.size() && next_level.bytes() <= frontier_budget_bytes; ++expanded) {
+            level.load(expanded, mapping, ts_stack[depth]);
+            expand(depth, [&](int qid, int cand) {
+                mapping[qid] = cand;
+                next_level.push(mapping, ts_stack[depth + 1]);
+                mapping[qid] = -1;
+            });
+        }
+        dbg.frontier_peak_bytes = std::max(dbg.frontier_peak_bytes, level.bytes() + next_level.bytes());
+
+        if (expanded == level.size()) {
+            std::swap(level, next_level);
+            ++depth;
+            dbg.bfs_levels_expanded++;
+            continue;
+        }
+
+        for (size_t i = 0; i < next_level.size(); ++i) {
+            next_level.load(i, mapping, ts_stack[depth + 1]);
+            dfs(dfs, depth + 1);
+        }
+        for (size_t i = expanded; i < level.size(); ++i) {
+            level.load(i, mapping, ts_stack[depth]);
+            dfs(dfs, depth);
         }
-        out << " |TS|=" << final_matches[i].ts.size() << '\n';
+        dbg.dfs_chunks += next_level.size() + (level.size() - expanded);
+        level.clear();
     }
+    for (size_t i = 0; i < level.size(); ++i) {
+        level.load(i, mapping, ts_stack[depth]);
+        emit_match(ts_stack[depth]);
+    }
+
+    const std::streampos end_position = out.tellp();
+    out.seekp(count_position);
+    out << std::setw(20) << dbg.final_match_unique;
+    out.seekp(end_position);
 
     out << "\n[Final Match Debug]\n";
     out << "root_blocks_total: " << dbg.root_blocks_total << '\n';
@@ -846,7 +949,10 @@ void TDTree::save_res(const std::string& filename) const {
     out << "cand_non_tree_ts_fail: " << dbg.cand_non_tree_ts_fail << '\n';
     out << "bfs_accept_branch: " << dbg.bfs_accept_branch << '\n';
     out << "final_match_unique: " << dbg.final_match_unique << '\n';
-    out << "final_match_duplicate: " << dbg.final_match_duplicate << '\n';
+    out << "frontier_budget_bytes: " << frontier_budget_bytes << '\n';
+    out << "frontier_peak_bytes: " << dbg.frontier_peak_bytes << '\n';
+    out << "bfs_levels_expanded: " << dbg.bfs_levels_expanded << '\n';
+    out << "dfs_chunks: " << dbg.dfs_chunks << '\n';
     out << "node_survivors:\n";
     for (int qid = 0; qid < Q.num_vertices; ++qid) {
         const TDTreeNode* node =
@@ -872,64 +978,9 @@ void TDTree::save_res(const std::string& filename) const {
 }
 
 bool TDTree::checkMinimumDuration(int vertex) const {
-    std::unordered_set<int> vertex_time_instances;
-
-    for (const auto& edge : G.adj[vertex]) {
-        auto time_it = G.edge_time_instances.find({vertex, edge.to});
-        if (time_it != G.edge_time_instances.end()) {
-            vertex_time_instances.insert(time_it->second.begin(), time_it->second.end());
-        }
-
-        time_it = G.edge_time_instances.find({edge.to, vertex});
-        if (time_it != G.edge_time_instances.end()) {
-            vertex_time_instances.insert(time_it->second.begin(), time_it->second.end());
-        }
-    }
-
-    if (vertex_time_instances.empty()) {
-        return false;
-    }
-
-    return static_cast<int>(vertex_time_instances.size()) >= k_threshold;
+    return countTimeInstances(G.vertexTimeIntervals(vertex)) >= static_cast<size_t>(std::max(k_threshold, 1));
 }
 
-bool TDTree::checkMinimumConsecutiveDuration(const std::unordered_set<int>& time_instances) const {
-    if (time_instances.size() < static_cast<size_t>(k_threshold)) {
-        return false;
-    }
-
-    std::vector<int> times(time_instances.begin(), time_instances.end());
-    std::sort(times.begin(), times.end());
-
-    int consecutive_count = 1;
-    for (size_t i = 1; i < times.size(); ++i) {
-        if (times[i] == times[i - 1] + 1) {
-            consecutive_count++;
-            if (consecutive_count >= k_threshold) {
-                return true;
-            }
-        } else {
-            consecutive_count = 1;
-        }
-    }
-
-    return false;
-}
-
-std::unordered_set<int> TDTree::computeVertexTimeInstances(int vertex) const {
-    std::unordered_set<int> vertex_time_instances;
-
-    for (const auto& edge : G.adj[vertex]) {
-        auto time_it = G.edge_time_instances.find({vertex, edge.to});
-        if (time_it != G.edge_time_instances.end()) {
-            vertex_time_instances.insert(time_it->second.begin(), time_it->second.end());
-        }
-
-        time_it = G.edge_time_instances.find({edge.to, vertex});
-        if (time_it != G.edge_time_instances.end()) {
-            vertex_time_instances.insert(time_it->second.begin(), time_it->second.end());
-        }
-    }
-
-    return vertex_time_instances;
+bool TDTree::checkMinimumConsecutiveDuration(const std::vector<TimeInterval>& time_instances) const {
+    return !time_instances.empty() && hasMinimumConsecutiveDuration(time_instances, k_threshold);
 }
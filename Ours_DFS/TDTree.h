@@ -15,7 +15,7 @@
 struct TDTreeBlock {
     int v_par; // Parent vertex in the data graph
     std::vector<int> V_cand; // Candidate vertices for the current query vertex
-    std::unordered_set<int> TS; // Time instance set (only for leaf nodes)
+    std::vector<TimeInterval> TS; // Time instances as sorted intervals (only for leaf nodes)
 
     TDTreeBlock(int parent_vertex) : v_par(parent_vertex) {}
 };
@@ -36,6 +36,8 @@ struct TDTreeNode {
 // Class: TDTree
 class TDTree {
 public:
+    static constexpr size_t kDefaultFrontierBudgetBytes = size_t(64) << 20;
+
     // Constructor
     TDTree(const Graph& temporal_graph, const Graph& query_graph, const QueryDecomposition& decomposition, int k);
 
@@ -45,7 +47,10 @@ public:
     // Print the TD-Tree (for debugging)
     void print() const;
     void print_res() const;
-    void save_res(const std::string& filename) const;
+    // Writes the candidate summary and streams every match. Enumeration is
+    // breadth-first while the frontier fits in frontier_budget_bytes and
+    // depth-first from there on.
+    void save_res(const std::string& filename, size_t frontier_budget_bytes = kDefaultFrontierBudgetBytes) const;
     size_t getMemoryUsage() const;
 
 private:
@@ -75,8 +80,7 @@ private:
     // Non-tree edge verification
     bool nonTreeEdgeTest(int v_prime, TDTreeNode* current_node) const;
     bool checkMinimumDuration(int vertex) const;
-    bool checkMinimumConsecutiveDuration(const std::unordered_set<int>& time_instances) const;
-    std::unordered_set<int> computeVertexTimeInstances(int vertex) const;
+    bool checkMinimumConsecutiveDuration(const std::vector<TimeInterval>& time_instances) const;
 
     // Reference to label counts for selectivity
     // const std::unordered_map<std::string, int>& label_counts_;
@@ -1,26 +1,144 @@
 #include "Utils.h"
 
-// Function to compute the intersection of two unordered_sets (Time Instance Sets)
-std::unordered_set<int> intersectTimeSets(const std::unordered_set<int>& set1,
-                                         const std::unordered_set<int>& set2) {
-    // Determine the smaller set and iterate over it to reduce lookups.
-    const std::unordered_set<int>* small = &set1;
-    const std::unordered_set<int>* large = &set2;
-    if (set2.size() < set1.size()) {
-        small = &set2;
-        large = &set1;
-    }
-
-    std::unordered_set<int> intersection;
-    for (const auto& elem : *small) {
-        if (large->find(elem) != large->end()) {
-            intersection.insert(elem);
+#include <limits>
+#include <unordered_map>
+
+Label labelFromString(const std::string& value) {
+    if (value.size() != 1 || value[0] < 'A' || value[0] > 'E') {
+        return kInvalidLabel;
+    }
+    return static_cast<Label>(value[0] - 'A');
+}
+
+std::string labelToString(Label label) {
+    if (label >= kLabelCount) return "?";
+    return std::string(1, static_cast<char>('A' + label));
+}
+
+const TemporalEdge* Graph::findTemporalEdge(int u, int v) const {
+    if (u < 0 || v < 0 || u >= num_vertices || v >= num_vertices) return nullptr;
+    const auto& neighbors = adj[static_cast<size_t>(u)];
+    const auto it = std::lower_bound(
+        neighbors.begin(), neighbors.end(), v,
+        [](const Edge& edge, int target) { return edge.to < target; });
+    if (it == neighbors.end() || it->to != v || it->temporal_edge_id < 0) return nullptr;
+    return &temporal_edges[static_cast<size_t>(it->temporal_edge_id)];
+}
+
+const std::vector<TimeInterval>* Graph::findEdgeIntervals(int u, int v) const {
+    const TemporalEdge* edge = findTemporalEdge(u, v);
+    if (edge == nullptr) {
+        edge = findTemporalEdge(v, u);
+    }
+    return edge != nullptr ? &edge->active_intervals : nullptr;
+}
+
+std::vector<TimeInterval> Graph::vertexTimeIntervals(int u) const {
+    std::vector<TimeInterval> intervals;
+    for (const auto& edge : adj[u]) {
+        const auto& forward = temporal_edges[edge.temporal_edge_id].active_intervals;
+        intervals.insert(intervals.end(), forward.begin(), forward.end());
+
+        const TemporalEdge* backward = findTemporalEdge(edge.to, u);
+        if (backward != nullptr) {
+            intervals.insert(intervals.end(), backward->active_intervals.begin(), backward->active_intervals.end());
+        }
+    }
+    normalizeTimeIntervals(intervals);
+    return intervals;
+}
+
+size_t Graph::getMemoryUsage() const {
+    size_t total = sizeof(Graph);
+    // 인접 리스트 메모리
+    total += adj.capacity() * sizeof(std::vector<Edge>);
+    for (const auto& neighbors : adj) {
+        total += neighbors.capacity() * sizeof(Edge);
+    }
+    // 정점 레이블 메모리
+    total += vertex_labels.capacity() * sizeof(Label);
+    // 시간 정보 (간선별 구간 리스트) 메모리
+    total += temporal_edges.capacity() * sizeof(TemporalEdge);
+    for (const auto& edge : temporal_edges) {
+        total += edge.active_intervals.capacity() * sizeof(TimeInterval);
+    }
+    return total;
+}
+
+std::vector<TimeInterval> intersectTimeIntervals(const std::vector<TimeInterval>& lhs,
+                                                 const std::vector<TimeInterval>& rhs) {
+    std::vector<TimeInterval> result;
+    result.reserve(std::min(lhs.size(), rhs.size()));
+    intersectTimeIntervals(lhs, rhs, result);
+    return result;
+}
+
+void intersectTimeIntervals(const std::vector<TimeInterval>& lhs,
+                            const std::vector<TimeInterval>& rhs,
+                            std::vector<TimeInterval>& out) {
+    out.clear();
+    size_t i = 0;
+    size_t j = 0;
+    while (i < lhs.size() && j < rhs.size()) {
+        const int start = std::max(lhs[i].start, rhs[j].start);
+        const int end = std::min(lhs[i].end, rhs[j].end);
+        if (end >= start) {
+            out.push_back({start, end});
         }
+
+        if (lhs[i].end < rhs[j].end) {
+            ++i;
+        } else {
+            ++j;
+        }
+    }
+}
+
+void normalizeTimeIntervals(std::vector<TimeInterval>& intervals) {
+    if (intervals.empty()) {
+        return;
     }
+    std::sort(intervals.begin(), intervals.end(), [](const TimeInterval& a, const TimeInterval& b) {
+        return a.start < b.start;
+    });
+
+    size_t last = 0;
+    for (size_t i = 1; i < intervals.size(); ++i) {
+        // Adjacent runs merge too: [1, 2] and [3, 4] are the run [1, 4].
+        if (static_cast<long long>(intervals[i].start) <= static_cast<long long>(intervals[last].end) + 1) {
+            intervals[last].end = std::max(intervals[last].end, intervals[i].end);
+        } else {
+            intervals[++last] = intervals[i];
+        }
+    }
+    intervals.resize(last + 1);
+}
+
+size_t countTimeInstances(const std::vector<TimeInterval>& intervals) {
+    size_t total = 0;
+    for (const auto& interval : intervals) {
+        total += static_cast<size_t>(static_cast<long long>(interval.end) - interval.start + 1);
+    }
+    return total;
+}
 
-    // If clarity is preferred over performance, the sets could be copied to
-    // ordered containers and std::set_intersection applied.
-    return intersection;
+bool hasMinimumConsecutiveDuration(const std::vector<TimeInterval>& intervals, int minimum_duration) {
+    if (minimum_duration <= 0) return true;
+    return std::any_of(intervals.begin(), intervals.end(), [minimum_duration](const TimeInterval& interval) {
+        return interval.length() >= minimum_duration;
+    });
+}
+
+std::string formatIntervals(const std::vector<TimeInterval>& intervals) {
+    std::ostringstream out;
+    out << '[';
+    for (size_t i = 0; i < intervals.size(); ++i) {
+        if (i > 0) out << ", ";
+        out << intervals[i].start;
+        if (intervals[i].end != intervals[i].start) out << '-' << intervals[i].end;
+    }
+    out << ']';
+    return out.str();
 }
 
 // Bloom Filter Implementation
@@ -70,11 +188,16 @@ namespace GraphUtils {
     }
 
     int countDistinctNeighborLabels(const std::vector<std::vector<Edge>>& adj, int vertex) {
-        std::unordered_set<std::string> unique_labels;
+        unsigned seen = 0;
+        int count = 0;
         for (const auto& edge : adj[vertex]) {
-            unique_labels.insert(edge.label);
+            const unsigned bit = 1U << edge.label;
+            if ((seen & bit) == 0) {
+                seen |= bit;
+                ++count;
+            }
         }
-        return unique_labels.size();
+        return count;
     }
 }
 
@@ -91,42 +214,72 @@ bool readTemporalGraph(const std::string& filename, Graph& graph) {
     // Random generator for labels using a fixed seed so that tests are
     // reproducible across runs. If deterministic behaviour is not desired, the
     // seed value below can be replaced with a runtime configurable one.
-    std::vector<std::string> labels = {"A", "B", "C", "D", "E"};
     std::mt19937 gen(42);  // Fixed seed for deterministic label assignment
-    std::uniform_int_distribution<> dis(0, static_cast<int>(labels.size()) - 1);
+    std::uniform_int_distribution<> dis(0, static_cast<int>(kLabelCount) - 1);
 
     int max_vertex = -1;
-    std::vector<std::unordered_set<int>> seen_neighbors;
+    // Temporal edge ID of each ordered pair, keyed by (v1 << 32) | v2.
+    std::unordered_map<std::uint64_t, int> edge_ids;
+    // One (temporal edge ID, time) entry per input line; sorted into intervals below.
+    std::vector<std::pair<int, int>> occurrences;
 
     // Read edges and determine the maximum vertex ID
     while (getline(infile, line)) {
         if (line.empty()) continue;
 
-        std::istringstream iss(line);    
-        int v1, v2, time;    
-        if (!(iss >> v1 >> v2 >> time)) {    
-            std::cerr << "Error: Invalid line in temporal graph file: " << line << std::endl;    
-            return false;    
+        std::istringstream iss(line);
+        int v1, v2, time;
+        if (!(iss >> v1 >> v2 >> time) || v1 < 0 || v2 < 0) {
+            std::cerr << "Error: Invalid line in temporal graph file: " << line << std::endl;
+            return false;
         }
 
         max_vertex = std::max(max_vertex, std::max(v1, v2));
-        
+
         // Ensure the graph structure can hold all vertices up to max_vertex
         while (graph.adj.size() <= static_cast<size_t>(max_vertex)) {
             graph.adj.emplace_back();
             // Assign a random label to each new vertex
-            graph.vertex_labels.push_back(labels[dis(gen)]);
-            seen_neighbors.emplace_back();
+            graph.vertex_labels.push_back(static_cast<Label>(dis(gen)));
         }
 
-        // Keep one adjacency entry per (v1, v2) and aggregate times in edge_time_instances.
-        if (seen_neighbors[v1].insert(v2).second) {
-            graph.adj[v1].emplace_back(Edge{v2, labels[dis(gen)]});
+        // Keep one adjacency entry per (v1, v2) and aggregate its times in temporal_edges.
+        const std::uint64_t key = (static_cast<std::uint64_t>(v1) << 32) | static_cast<std::uint32_t>(v2);
+        const auto inserted = edge_ids.emplace(key, static_cast<int>(graph.temporal_edges.size()));
+        if (inserted.second) {
+            graph.adj[v1].push_back(Edge{v2, static_cast<Label>(dis(gen)), inserted.first->second});
+            graph.temporal_edges.push_back(TemporalEdge{v1, v2, {}, 0});
         }
-        graph.edge_time_instances[{v1, v2}].insert(time);
+        occurrences.emplace_back(inserted.first->second, time);
     }
     graph.num_vertices = graph.adj.size();
     infile.close();
+    std::unordered_map<std::uint64_t, int>().swap(edge_ids);
+
+    // Sorted by edge, then time: each edge's times form consecutive runs.
+    std::sort(occurrences.begin(), occurrences.end());
+    for (const auto& occurrence : occurrences) {
+        std::vector<TimeInterval>& intervals = graph.temporal_edges[occurrence.first].active_intervals;
+        const int time = occurrence.second;
+        if (!intervals.empty() && static_cast<long long>(time) <= static_cast<long long>(intervals.back().end) + 1) {
+            intervals.back().end = std::max(intervals.back().end, time);
+        } else {
+            intervals.push_back({time, time});
+        }
+    }
+    std::vector<std::pair<int, int>>().swap(occurrences);
+    for (auto& edge : graph.temporal_edges) {
+        edge.active_intervals.shrink_to_fit();
+        edge.active_snapshot_count = static_cast<int>(
+            std::min<size_t>(countTimeInstances(edge.active_intervals), std::numeric_limits<int>::max()));
+    }
+
+    // Sorted neighbors let findTemporalEdge binary-search.
+    for (auto& neighbors : graph.adj) {
+        std::sort(neighbors.begin(), neighbors.end(), [](const Edge& a, const Edge& b) {
+            return a.to < b.to;
+        });
+    }
 
     return true;
 }
@@ -140,6 +293,8 @@ bool readQueryGraph(const std::string &filename ,Graph &queryGraph){
 		return false;	
 	}
         std::string line;
+        // Each distinct token is one query vertex; its label is the token itself (A-E).
+        std::vector<std::string> vertex_tokens;
 
 	while(getline(infile,line)){
 		if(line.empty()) continue;
@@ -164,25 +319,27 @@ bool readQueryGraph(const std::string &filename ,Graph &queryGraph){
 
                 int v1 = -1, v2 = -1;
 
-                auto it_v1 = std::find(queryGraph.vertex_labels.begin(), queryGraph.vertex_labels.end(), v1_str);
-                if (it_v1 == queryGraph.vertex_labels.end()) {
-                        v1 = queryGraph.vertex_labels.size();
-                        queryGraph.vertex_labels.push_back(v1_str);
+                auto it_v1 = std::find(vertex_tokens.begin(), vertex_tokens.end(), v1_str);
+                if (it_v1 == vertex_tokens.end()) {
+                        v1 = vertex_tokens.size();
+                        vertex_tokens.push_back(v1_str);
+                        queryGraph.vertex_labels.push_back(labelFromString(v1_str));
                         queryGraph.adj.emplace_back();
                 } else {
-                        v1 = it_v1 - queryGraph.vertex_labels.begin();
+                        v1 = it_v1 - vertex_tokens.begin();
                 }
 
-                auto it_v2 = std::find(queryGraph.vertex_labels.begin(), queryGraph.vertex_labels.end(), v2_str);
-                if (it_v2 == queryGraph.vertex_labels.end()) {
-                        v2 = queryGraph.vertex_labels.size();
-                        queryGraph.vertex_labels.push_back(v2_str);
+                auto it_v2 = std::find(vertex_tokens.begin(), vertex_tokens.end(), v2_str);
+                if (it_v2 == vertex_tokens.end()) {
+                        v2 = vertex_tokens.size();
+                        vertex_tokens.push_back(v2_str);
+                        queryGraph.vertex_labels.push_back(labelFromString(v2_str));
                         queryGraph.adj.emplace_back();
                 } else {
-                        v2 = it_v2 - queryGraph.vertex_labels.begin();
+                        v2 = it_v2 - vertex_tokens.begin();
                 }
 
-                queryGraph.adj[v1].emplace_back(Edge{v2, edge_label});
+                queryGraph.adj[v1].emplace_back(Edge{v2, labelFromString(edge_label), -1});
      }
 	 queryGraph.num_vertices = queryGraph.adj.size();
      infile.close();
@@ -3,7 +3,8 @@
 
 #include <vector>
 #include <string>
-#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
 #include <unordered_set>
 #include <set>
 #include <algorithm>
@@ -12,48 +13,78 @@
 #include <iostream>
 #include <random>
 
+// Vertex and edge labels are the letters A-E, stored as 0..4.
+using Label = std::uint8_t;
+
+constexpr std::size_t kLabelCount = 5;
+constexpr Label kInvalidLabel = static_cast<Label>(kLabelCount);
+
+Label labelFromString(const std::string& value);
+std::string labelToString(Label label);
+
+// Closed run of consecutive time instances [start, end].
+struct TimeInterval {
+    int start = 0;
+    int end = -1;
+
+    int length() const {
+        return end >= start ? end - start + 1 : 0;
+    }
+};
+
+// Time instances of one ordered pair as sorted, disjoint, non-adjacent intervals.
+struct TemporalEdge {
+    int u = -1;
+    int v = -1;
+    std::vector<TimeInterval> active_intervals;
+    int active_snapshot_count = 0;
+};
+
 // Structure to represent an edge with a label
 struct Edge {
-    int to;
-    std::string label;
+    int to = -1;
+    Label label = kInvalidLabel;
+    int temporal_edge_id = -1; // Index into Graph::temporal_edges, -1 for query graphs
 };
 
 // Graph structure with edge labels and time instances
 struct Graph {
-    int num_vertices;
-    std::vector<std::vector<Edge>> adj; // Adjacency list with edge labels
-    std::vector<std::string> vertex_labels; // Labels of vertices
-    // Custom hash function for pair<int, int>
-    struct pair_hash {
-        inline std::size_t operator()(const std::pair<int, int>& v) const {
-            return v.first * 31 + v.second;
-        }
-    };
-    std::unordered_map<std::pair<int, int>, std::unordered_set<int>, pair_hash> edge_time_instances; // Time instances for each edge
-
-// Graph 구조체 내부에 추가
-size_t getMemoryUsage() const {
-    size_t total = sizeof(Graph);
-    // 인접 리스트 메모리
-    for (const auto& neighbors : adj) {
-        total += sizeof(std::vector<Edge>) + (neighbors.capacity() * sizeof(Edge));
-    }
-    // 정점 레이블 메모리
-    for (const auto& label : vertex_labels) {
-        total += label.capacity();
-    }
-    // 시간 정보(Map & Set) 메모리 - 대략적인 추정
-    for (const auto& entry : edge_time_instances) {
-        total += sizeof(std::pair<int, int>) + sizeof(std::unordered_set<int>);
-        total += entry.second.size() * sizeof(int); // Set 내부 요소
-    }
-    return total;
-}
+    int num_vertices = 0;
+    std::vector<std::vector<Edge>> adj; // Adjacency list, sorted by Edge::to for data graphs
+    std::vector<Label> vertex_labels; // Labels of vertices
+    std::vector<TemporalEdge> temporal_edges; // Time instances of each data edge
+
+    // Time instances of the arc u -> v, or nullptr if it does not exist.
+    const TemporalEdge* findTemporalEdge(int u, int v) const;
+    // Falls back to v -> u, as the matcher treats time instances as undirected.
+    const std::vector<TimeInterval>* findEdgeIntervals(int u, int v) const;
+    // Union of the time instances of u -> w and w -> u over the out-neighbors w of u.
+    std::vector<TimeInterval> vertexTimeIntervals(int u) const;
 
+    size_t getMemoryUsage() const;
 };
 
-// Function to compute the intersection of two unordered_sets (Time Instance Sets)
-std::unordered_set<int> intersectTimeSets(const std::unordered_set<int>& set1, const std::unordered_set<int>& set2);
+// Intersect two sorted, disjoint interval lists.
+std::vector<TimeInterval> intersectTimeIntervals(
+    const std::vector<TimeInterval>& lhs,
+    const std::vector<TimeInterval>& rhs);
+// Same, into a reused buffer; out must not alias lhs or rhs.
+void intersectTimeIntervals(
+    const std::vector<TimeInterval>& lhs,
+    const std::vector<TimeInterval>& rhs,
+    std::vector<TimeInterval>& out);
+
+// Sort and merge overlapping or adjacent intervals in place.
+void normalizeTimeIntervals(std::vector<TimeInterval>& intervals);
+
+// Number of time instances covered by a normalized interval list.
+size_t countTimeInstances(const std::vector<TimeInterval>& intervals);
+
+bool hasMinimumConsecutiveDuration(
+    const std::vector<TimeInterval>& intervals,
+    int minimum_duration);
+
+std::string formatIntervals(const std::vector<TimeInterval>& intervals);
 
 // Bloom Filter Class
 class BloomFilter {
@@ -1,3 +1,4 @@
+#include <array>
 #include <iostream>
 #include <chrono>
 #include <fstream>
@@ -18,8 +19,8 @@ size_t getPeakRSS() {
 int main(int argc, char* argv[]){
     // File paths for the temporal graph and query graph
 
-    if(argc != 4){
-        std::cerr << "Usage: " << argv[0] << " <Data Graph> <Query Graph> <Minimum Duration k>\n";
+    if(argc != 4 && argc != 5){
+        std::cerr << "Usage: " << argv[0] << " <Data Graph> <Query Graph> <Minimum Duration k> [Frontier Budget MB]\n";
         return 1;
     }
 
@@ -27,6 +28,11 @@ int main(int argc, char* argv[]){
     std::string queryGraphFile = argv[2];
     // Minimum duration threshold
     int k = std::stoi(argv[3]);
+    // Memory for the BFS frontier of the match enumeration before it turns depth-first
+    size_t frontierBudgetBytes = TDTree::kDefaultFrontierBudgetBytes;
+    if(argc == 5){
+        frontierBudgetBytes = static_cast<size_t>(std::stoull(argv[4])) << 20;
+    }
     std::string datasetName = std::filesystem::path(temporalGraphFile).stem().string();
 
     std::unordered_map<std::string, long long> timings;
@@ -58,7 +64,7 @@ int main(int argc, char* argv[]){
     // Assuming label_counts map contains counts of each label in the data graph
     std::cout << "Start Label Counting" << std::endl;
     start = std::chrono::steady_clock::now();
-    std::unordered_map<std::string, int> label_counts;
+    std::array<int, kLabelCount> label_counts{};
 
     for (size_t u = 0; u < temporalGraph.adj.size(); ++u) {
         for (const auto& edge : temporalGraph.adj[u]) {
@@ -66,41 +72,30 @@ int main(int argc, char* argv[]){
         }
     }
 
-    std::unordered_map<std::string, int> label_vertex_counts; // 각 레이블의 정점 개수 저장
-    std::unordered_map<std::string, int> label_total_durations; // 각 레이블의 총 지속 시간 저장
-    std::unordered_map<int, int> vertex_durations; // 각 정점의 총 지속 시간 저장
+    std::array<int, kLabelCount> label_vertex_counts{}; // 각 레이블의 정점 개수 저장
+    std::array<long long, kLabelCount> label_total_durations{}; // 각 레이블의 총 지속 시간 저장
 
     // 정점별 간선 정보를 활용하여 지속 시간 계산
     for (size_t u = 0; u < temporalGraph.adj.size(); ++u) {
-        int total_duration = 0;
+        long long total_duration = 0;
 
         for (const auto& edge : temporalGraph.adj[u]) {
             // 각 간선이 존재하는 스냅샷의 개수를 이용해 지속 시간 계산
-            auto it = temporalGraph.edge_time_instances.find({static_cast<int>(u), edge.to});
-            if (it != temporalGraph.edge_time_instances.end()) {
-                const auto& time_instances = it->second;
-                int duration = time_instances.size();  // 간선이 존재하는 스냅샷의 개수
-                total_duration += duration;
-            }
+            total_duration += temporalGraph.temporal_edges[edge.temporal_edge_id].active_snapshot_count;
         }
 
-        // 현재 정점에 대한 총 지속 시간 저장
-        vertex_durations[static_cast<int>(u)] = total_duration;
-
         // 레이블별 지속 시간 및 정점 개수 누적
-        const std::string& label = temporalGraph.vertex_labels[u];
+        const Label label = temporalGraph.vertex_labels[u];
         label_vertex_counts[label]++;
         label_total_durations[label] += total_duration;
     }
 
     // 각 레이블의 평균 수명을 계산
-    std::unordered_map<std::string, double> label_average_lifespans;
-    for (const auto& label_entry : label_vertex_counts) {
-        const std::string& label = label_entry.first;
-        int vertex_count = label_entry.second;
-
-        if (vertex_count > 0) {
-            label_average_lifespans[label] = static_cast<double>(label_total_durations[label]) / vertex_count;
+    std::array<double, kLabelCount> label_average_lifespans{};
+    for (size_t label = 0; label < kLabelCount; ++label) {
+        if (label_vertex_counts[label] > 0) {
+            label_average_lifespans[label] =
+                static_cast<double>(label_total_durations[label]) / label_vertex_counts[label];
         } else {
             label_average_lifespans[label] = 0.0; // 정점이 없는 경우 평균 수명은 0으로 설정
         }
@@ -128,8 +123,12 @@ int main(int argc, char* argv[]){
     tdTree.print_res();
 
     // Save matching results to file
-    tdTree.save_res("matching_results.txt");
-    tdTree.save_res("matching_results_" + datasetName + ".txt");
+    start = std::chrono::steady_clock::now();
+    tdTree.save_res("matching_results.txt", frontierBudgetBytes);
+    std::filesystem::copy_file("matching_results.txt", "matching_results_" + datasetName + ".txt",
+                               std::filesystem::copy_options::overwrite_existing);
+    timings["saveResults"] = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
 
     auto write_timings = [&](const std::string& filename) {
         std::ofstream resultFile(filename);
@@ -3,7 +3,7 @@
 #include <iostream>
 
 // Query decomposition function implementation
-QueryDecomposition decomposeQuery(const Graph& Q, const std::unordered_map<std::string, int>& label_counts, const std::unordered_map<std::string, double>& label_average_lifespans) {
+QueryDecomposition decomposeQuery(const Graph& Q, const std::array<int, kLabelCount>& label_counts, const std::array<double, kLabelCount>& label_average_lifespans) {
     QueryDecomposition result;
 
     // Copy vertex labels from the query graph
@@ -20,11 +20,10 @@ QueryDecomposition decomposeQuery(const Graph& Q, const std::unordered_map<std::
         if (degree == 0) {
             selectivity[u] = std::numeric_limits<double>::max();
         } else {
-            const std::string& label = Q.vertex_labels[u];
-            auto it = label_counts.find(label);
-            if (it != label_counts.end()) {
-                average_lifespan = label_average_lifespans.at(label);
-                selectivity[u] = (static_cast<double>(it->second) * average_lifespan) / degree;
+            const Label label = Q.vertex_labels[u];
+            if (label < kLabelCount && label_counts[label] > 0) {
+                average_lifespan = label_average_lifespans[label];
+                selectivity[u] = (static_cast<double>(label_counts[label]) * average_lifespan) / degree;
             } else {
                 selectivity[u] = std::numeric_limits<double>::max();
             }
@@ -1,9 +1,9 @@
 #ifndef QUERY_DECOMPOSITION_H
 #define QUERY_DECOMPOSITION_H
 
+#include <array>
 #include <vector>
 #include <string>
-#include <unordered_map>
 #include <utility>
 #include <limits>
 #include <queue>
@@ -17,7 +17,7 @@ struct QueryDecomposition {
     // List of non-tree edges (pairs of vertices)
     std::vector<std::pair<int, int>> non_tree_edges;
     // Vertex labels for the query graph
-    std::vector<std::string> vertex_labels;
+    std::vector<Label> vertex_labels;
     // BFS traversal order of the query spanning tree
     std::vector<int> traversal_order;
     // Parent query vertex for each query node in the spanning tree
@@ -29,5 +29,6 @@ struct QueryDecomposition {
 };
 
 // Function prototype for query decomposition
-QueryDecomposition decomposeQuery(const Graph& Q, const std::unordered_map<std::string, int>& label_counts, const std::unordered_map<std::string, double>& label_average_lifespans);
+// label_counts and label_average_lifespans are indexed by Label.
+QueryDecomposition decomposeQuery(const Graph& Q, const std::array<int, kLabelCount>& label_counts, const std::array<double, kLabelCount>& label_average_lifespans);
 #endif // QUERY_DECOMPOSITION_H
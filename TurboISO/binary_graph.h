@@ -0,0 +1,176 @@
+// Binary data graph written by `turbo_convert.exe --binary` and memory-mapped
+// by turbo.exe, which recognises it by its magic. Every integer is
+// little-endian.
+//
+//   header   "TBGR", u32 version, u32 vertex count n, u32 label count,
+//            u64 arc count m
+//   labels   n x u8 vertex label in 1..label count, zero-padded to a
+//            multiple of 8 bytes
+//   offsets  (n + 1) x u64: the arcs out of v are targets[offsets[v]..offsets[v + 1])
+//   targets  m x u32 directed targets, strictly ascending per source, no self-loops
+//
+// Each vertex has exactly one label; use the text format for multi-label
+// vertices or several graphs per file.
+
+#ifndef _BINARY_GRAPH_H
+#define _BINARY_GRAPH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace binary_graph {
+
+constexpr char kMagic[4] = {'T', 'B', 'G', 'R'};
+constexpr std::uint32_t kVersion = 1;
+// Magic, version, n, label count, m.
+constexpr std::size_t kHeaderSize = 4 + 4 + 4 + 4 + 8;
+
+inline std::size_t labelSectionSize(std::uint64_t vertex_count) {
+    return static_cast<std::size_t>((vertex_count + 7) / 8 * 8);
+}
+
+template <typename Unsigned>
+void appendLittleEndian(std::string& output, Unsigned value) {
+    for (std::size_t i = 0; i < sizeof(Unsigned); ++i) {
+        output.push_back(static_cast<char>((value >> (8 * i)) & 0xffU));
+    }
+}
+
+template <typename Unsigned>
+Unsigned decodeLittleEndian(const unsigned char* bytes) {
+    Unsigned value = 0;
+    for (std::size_t i = 0; i < sizeof(Unsigned); ++i) {
+        value |= static_cast<Unsigned>(bytes[i]) << (8 * i);
+    }
+    return value;
+}
+
+inline bool hasMagic(const unsigned char* data, std::size_t size) {
+    return size >= sizeof(kMagic) && std::memcmp(data, kMagic, sizeof(kMagic)) == 0;
+}
+
+// A validated view into a mapped file.
+struct View {
+    std::uint32_t vertex_count = 0;
+    std::uint32_t label_count = 0;
+    std::uint64_t arc_count = 0;
+    const unsigned char* labels = nullptr;
+    const unsigned char* offsets = nullptr;
+    const unsigned char* targets = nullptr;
+
+    int label(std::uint32_t v) const { return labels[v]; }
+    std::uint64_t offset(std::uint32_t v) const {
+        return decodeLittleEndian<std::uint64_t>(offsets + 8 * static_cast<std::size_t>(v));
+    }
+    std::uint32_t target(std::uint64_t arc) const {
+        return decodeLittleEndian<std::uint32_t>(targets + 4 * static_cast<std::size_t>(arc));
+    }
+};
+
+// Checks the header, the section sizes, every label and the CSR invariants.
+inline bool open(const unsigned char* data, std::size_t size, View& view, std::string& error) {
+    if (!hasMagic(data, size) || size < kHeaderSize) {
+        error = "not a TurboISO binary graph";
+        return false;
+    }
+    if (decodeLittleEndian<std::uint32_t>(data + 4) != kVersion) {
+        error = "unsupported binary graph version";
+        return false;
+    }
+    view.vertex_count = decodeLittleEndian<std::uint32_t>(data + 8);
+    view.label_count = decodeLittleEndian<std::uint32_t>(data + 12);
+    view.arc_count = decodeLittleEndian<std::uint64_t>(data + 16);
+    const std::uint64_t expected = kHeaderSize + labelSectionSize(view.vertex_count) +
+        8 * (static_cast<std::uint64_t>(view.vertex_count) + 1) + 4 * view.arc_count;
+    if (view.vertex_count == 0 || view.vertex_count > 0x7fffffffU ||
+        view.label_count == 0 || view.label_count > 255 ||
+        view.arc_count > (std::uint64_t(1) << 40) || expected != size) {
+        error = "invalid binary graph header or file size";
+        return false;
+    }
+    view.labels = data + kHeaderSize;
+    view.offsets = view.labels + labelSectionSize(view.vertex_count);
+    view.targets = view.offsets + 8 * (static_cast<std::size_t>(view.vertex_count) + 1);
+
+    for (std::uint32_t v = 0; v < view.vertex_count; ++v) {
+        if (view.label(v) < 1 || static_cast<std::uint32_t>(view.label(v)) > view.label_count) {
+            error = "invalid binary graph vertex label";
+            return false;
+        }
+    }
+    if (view.offset(0) != 0 || view.offset(view.vertex_count) != view.arc_count) {
+        error = "invalid binary graph offsets";
+        return false;
+    }
+    for (std::uint32_t v = 0; v < view.vertex_count; ++v) {
+        const std::uint64_t first = view.offset(v);
+        const std::uint64_t last = view.offset(v + 1);
+        if (first > last || last > view.arc_count) {
+            error = "invalid binary graph offsets";
+            return false;
+        }
+        for (std::uint64_t arc = first; arc < last; ++arc) {
+            const std::uint32_t to = view.target(arc);
+            if (to >= view.vertex_count || to == v ||
+                (arc > first && view.target(arc - 1) >= to)) {
+                error = "invalid binary graph arc";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// labels[v] in 1..label_count; arcs sorted by (from, to) without duplicates
+// or self-loops, as compact IDs.
+template <typename Arc>
+bool write(
+    const std::string& path,
+    const std::vector<int>& labels,
+    std::uint32_t label_count,
+    const std::vector<Arc>& arcs,
+    std::string& error) {
+    std::ofstream output(path, std::ios::binary);
+    if (!output) {
+        error = "cannot create binary graph: " + path;
+        return false;
+    }
+    std::string bytes(kMagic, sizeof(kMagic));
+    appendLittleEndian(bytes, kVersion);
+    appendLittleEndian(bytes, static_cast<std::uint32_t>(labels.size()));
+    appendLittleEndian(bytes, label_count);
+    appendLittleEndian(bytes, static_cast<std::uint64_t>(arcs.size()));
+    for (int label : labels) bytes.push_back(static_cast<char>(label));
+    bytes.resize(kHeaderSize + labelSectionSize(labels.size()), '\0');
+
+    std::size_t arc = 0;
+    for (std::size_t v = 0; v <= labels.size(); ++v) {
+        while (arc < arcs.size() && static_cast<std::size_t>(arcs[arc].from) < v) ++arc;
+        appendLittleEndian(bytes, static_cast<std::uint64_t>(arc));
+    }
+    output.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+
+    // Targets are streamed in 1 MiB pieces.
+    bytes.clear();
+    for (const Arc& current : arcs) {
+        appendLittleEndian(bytes, static_cast<std::uint32_t>(current.to));
+        if (bytes.size() >= (std::size_t(1) << 20)) {
+            output.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+            bytes.clear();
+        }
+    }
+    output.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    if (!output) {
+        error = "failed while writing binary graph: " + path;
+        return false;
+    }
+    return true;
+}
+
+} // namespace binary_graph
+
+#endif
@@ -8,13 +8,13 @@ $sourceDir = Split-Path -Parent $MyInvocation.MyCommand.Path
 
 Push-Location $sourceDir
 try {
-    & $Compiler -std=c++17 -O3 -Wall -Wextra -Wpedantic `
+    & $Compiler -std=c++17 -O3 -Wall -Wextra -Wpedantic -pthread `
         .\main.cpp .\Graph.cpp -o .\turbo.exe
     if ($LASTEXITCODE -ne 0) {
         throw "TurboISO build failed with exit code $LASTEXITCODE"
     }
 
-    & $Compiler -std=c++17 -O3 -Wall -Wextra -Wpedantic `
+    & $Compiler -std=c++17 -O3 -Wall -Wextra -Wpedantic -pthread `
         .\convert_temporal.cpp -o .\turbo_convert.exe
     if ($LASTEXITCODE -ne 0) {
         throw "TurboISO converter build failed with exit code $LASTEXITCODE"
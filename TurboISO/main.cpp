@@ -4,17 +4,40 @@
 #include <climits>
 #include <cstdint>
 #include <limits>
+#include <tuple>
 
 using namespace std;
 
-std::uint64_t num_recursive_call = 0;
-std::uint64_t numofembeddings = 0;
+//shared by the search threads; each thread also keeps its own counters and folds them in
+std::atomic<std::uint64_t> num_recursive_call(0);
+std::atomic<std::uint64_t> numofembeddings(0);
 std::uint64_t max_results = std::numeric_limits<std::uint64_t>::max();
 double max_mem = 0.0;
 double max_rss = 0.0;
+std::mutex memory_lock;
 int TIME_LIMIT_SECONDS = 600;
-bool timed_out = false;
-bool results_truncated = false;
+std::atomic<bool> timed_out(false);
+std::atomic<bool> results_truncated(false);
+unsigned search_threads = 0;		//--threads; 0 uses the hardware threads
+//phase times of the last query in ms; explore/order/join are summed over the threads
+long rewrite_t = 0, explore_t = 0, order_t = 0, join_t = 0;
+thread_local std::uint64_t thread_recursive_calls = 0;
+
+//--durable k: only arcs with a run of at least durable_k snapshots are in G', and
+//durable_stack[dc] holds the runs common to every query arc checked up to depth dc
+const TemporalArcs* durable_arcs = NULL;
+long long durable_k = 0;
+thread_local vector < vector <DurableInterval> > durable_stack;
+vector <int> durable_nec_size;			//size of the NEC containing each query vertex
+vector < pair<int, int> > durable_deferred;	//query arcs touching a multi-vertex NEC
+thread_local int durable_leaf_depth = 0;
+
+//Count mode (built without PRINT_RESULT): nec_weight[u'] is |NEC(u')|! when every
+//permutation of NEC(u') is an automorphism of the directed query, and 0 when GenPerm
+//must still try each permutation. count_last_nec lets SubgraphSearch count the last
+//NEC in the order as P(m, s) over its m individually valid candidates.
+vector <std::uint64_t> nec_weight;
+bool count_last_nec = false;
 
 bool searchShouldStop()
 {
@@ -35,6 +58,7 @@ void sampleMemory()
 	double virtual_kb = 0.0;
 	double resident_kb = 0.0;
 	process_mem_usage(virtual_kb, resident_kb);
+	std::lock_guard<std::mutex> guard(memory_lock);
 	max_mem = std::max(max_mem, virtual_kb);
 	max_rss = std::max(max_rss, resident_kb);
 }
@@ -207,18 +231,6 @@ bool equals(vector <labelVlist> *v1, vector <labelVlist> *v2)
 	else return false;
 }
 
-void PureInsert(vector<int>& vecs, int id)
-{
-    for(int value : vecs)
-    {
-        if(value == id)
-        {
-            return;
-        }
-    }
-    vecs.push_back(id);
-}
-
 int ChooseStartQVertex(Query *q, Graph *g)
 {
 	if(q == NULL || g == NULL || q->numVertex <= 0)
@@ -572,19 +584,12 @@ void RewriteToNECTree(Query *q, int us, NECTree *q_prime)
 		delete []flag;
 }
 
-void ClearCR(int uc_Dprime, int v_prime, CRTree *CR)
-{
-	int pos = contain(v_prime, &(CR->parent[uc_Dprime]));
-	vector <int>::iterator Iter1 = CR->parent[uc_Dprime].begin() + pos;
-	CR->parent[uc_Dprime].erase(Iter1);
-	vector <vector <int> >::iterator Iter2 = CR->CR[uc_Dprime].begin() + pos;
-	CR->CR[uc_Dprime].erase(Iter2);
-}
-
 bool ExploreCR(int u_prime, vector <int> *VM, CRTree *CR, int v, NECTree *q_prime, Graph *g, Query *q, bool *visited)
 {
 	if(searchShouldStop())
 		return false;
+	vector <int>& found = CR->collecting(u_prime);
+	found.clear();
 	int VMSize = VM->size();
 	for(int i = 0; i < VMSize; i ++)
 	{
@@ -656,7 +661,7 @@ bool ExploreCR(int u_prime, vector <int> *VM, CRTree *CR, int v, NECTree *q_prim
 				{
 					for(int k = 0; k < j; k ++)
 					{
-						ClearCR(neighbor[k].uc_prime, v_prime, CR);
+						CR->clear(neighbor[k].uc_prime, v_prime);
 					}
 					matched = false;
 					break;
@@ -669,31 +674,19 @@ ExploreCR_L1:
 		if(!matched)
 			continue;
 
-		int pos = contain(v, &(CR->parent[u_prime]));
-		if(pos == -1)
-		{
-            //if no parent(the root), then -1.
-			CR->parent[u_prime].push_back(v);
-			vector <int> tempV;
-			tempV.push_back(v_prime);
-			CR->CR[u_prime].push_back(tempV);
-		}
-		else
-        {
-            PureInsert(CR->CR[u_prime][pos], v_prime);
-            //CR->CR[u_prime][pos].push_back(v_prime);
-        }
+		//VM is ascending, so the collected candidates are too
+		found.push_back(v_prime);
 	}
 
     //if v is -1, and u_prime is the root, then its parent is -1
-	int pos = contain(v, &(CR->parent[u_prime]));
-	if(pos == -1)
+	int size = CR->commit(u_prime, v);
+	if(size == 0)
 	{
 		return false;
 	}
-	if(CR->CR[u_prime][pos].size() < q_prime->NEC[u_prime].size())
+	if(size < static_cast<int>(q_prime->NEC[u_prime].size()))
 	{
-		ClearCR(u_prime, v, CR);
+		CR->clear(u_prime, v);
 		return false;
 	}
 	return true;
@@ -784,10 +777,10 @@ double DetermineMatchingOrder(NECTree *q_prime, CRTree *CRTree, Elem *order, int
 		if(Size == 1)
 		{
 			int Num = 0;
-			int Size2 = CRTree->CR[v].size();
+			int Size2 = CRTree->parentNum(v);
 			for(int i = 0; i < Size2; i ++)
 			{
-				Num += CRTree->CR[v][i].size();
+				Num += CRTree->entry(v, i).end - CRTree->entry(v, i).begin;
 			}
 			order[v].v = v;
 			order[v].value = (double)Num / Product;
@@ -795,10 +788,10 @@ double DetermineMatchingOrder(NECTree *q_prime, CRTree *CRTree, Elem *order, int
 		else
 		{
 			double Num = 0.0;
-			int Size2 = CRTree->CR[v].size();
+			int Size2 = CRTree->parentNum(v);
 			for(int i = 0; i < Size2; i ++)
 			{
-				Num += C(CRTree->CR[v][i].size(), Size);
+				Num += C(CRTree->entry(v, i).end - CRTree->entry(v, i).begin, Size);
 			}
 			order[v].v = v;
 			order[v].value = Num / Product;
@@ -896,7 +889,9 @@ bool IsJoinable(Query *q, Graph *g, int *M, int qV, int gV)
 				int pos = contain(label, &(g->graList[gV]));
 				if(pos == -1)
 					return false;
-				if(contain(v, &(g->graList[gV][pos].vlist)) == -1)
+				//vlist is sorted by Graph::transform()
+				const vector<int>& vlist = g->graList[gV][pos].vlist;
+				if(!binary_search(vlist.begin(), vlist.end(), v))
 					return false;
 			}
 		}
@@ -967,6 +962,93 @@ bool NextPerm(int *M, vector <int> *qV, int *rank)
 	}
 }
 
+std::uint64_t saturatingProduct(std::uint64_t a, std::uint64_t b)
+{
+	if(a != 0 && b > std::numeric_limits<std::uint64_t>::max() / a)
+		return std::numeric_limits<std::uint64_t>::max();
+	return a * b;
+}
+
+//true when swapping any two members of nec maps the directed query onto itself:
+//equal arcs and edge labels to the rest of the query, and between members either
+//no arc or the same arcs in both directions for every pair
+bool SymmetricNEC(Query *q, const vector<int>& nec)
+{
+	vector<Vertex>& vertices = q->real_graph->vertices;
+	//(direction, neighbor, edge label) of each member's arcs leaving the NEC
+	vector < vector < std::tuple<int, int, int> > > profiles(nec.size());
+	vector <int> inner;
+	for(std::size_t i = 0; i < nec.size(); ++i)
+	{
+		const Vertex& x = vertices[nec[i]];
+		for(int pass = 0; pass < 2; ++pass)
+		{
+			const vector<DNeighbor>& arcs = pass == 0 ? x.out : x.in;
+			for(std::size_t j = 0; j < arcs.size(); ++j)
+			{
+				if(find(nec.begin(), nec.end(), arcs[j].vid) != nec.end())
+				{
+					if(pass == 0)
+						inner.push_back(arcs[j].elb);
+					continue;
+				}
+				profiles[i].push_back(std::make_tuple(pass, arcs[j].vid, arcs[j].elb));
+			}
+		}
+		sort(profiles[i].begin(), profiles[i].end());
+		if(profiles[i] != profiles[0])
+			return false;
+	}
+	if(inner.empty())
+		return true;
+	//complete in both directions with one edge label
+	const std::size_t pairs = nec.size() * (nec.size() - 1);
+	if(inner.size() != pairs)
+		return false;
+	for(std::size_t i = 0; i < nec.size(); ++i)
+		for(std::size_t j = 0; j < nec.size(); ++j)
+			if(i != j && !q->real_graph->isEdgeContained(nec[i], nec[j], inner[0]))
+				return false;
+	return true;
+}
+
+//the directed arcs of query vertex x to mapped vertices, with x mapped to c
+bool ArcsContained(int* M, Query* q, Graph* g, int x, int c)
+{
+	const Vertex& vx = q->real_graph->vertices[x];
+	for(std::size_t j = 0; j < vx.out.size(); ++j)
+		if(M[vx.out[j].vid] != -1 && !g->real_graph->isEdgeContained(c, M[vx.out[j].vid], vx.out[j].elb))
+			return false;
+	for(std::size_t j = 0; j < vx.in.size(); ++j)
+		if(M[vx.in[j].vid] != -1 && !g->real_graph->isEdgeContained(M[vx.in[j].vid], c, vx.in[j].elb))
+			return false;
+	return true;
+}
+
+//verify() restricted to the arcs whose endpoints are both mapped
+bool verifyMapped(int* M, Query* q, Graph* g)
+{
+	vector<Vertex>& qvlist = q->real_graph->vertices;
+	for(std::size_t i = 0; i < qvlist.size(); ++i)
+	{
+		if(M[i] == -1)
+			continue;
+		vector<DNeighbor>& in = qvlist[i].in;
+		for(std::size_t j = 0; j < in.size(); ++j)
+			if(M[in[j].vid] != -1 && !g->real_graph->isEdgeContained(M[in[j].vid], M[i], in[j].elb))
+				return false;
+	}
+	return true;
+}
+
+//whether the members of NEC(u') are adjacent to each other, as tested in SubgraphSearch
+bool NECIsClique(Query *q, NECTree *q_prime, int u_prime)
+{
+	vector <labelVlist> *p = &(q->graList[q_prime->NEC[u_prime][0]]);
+	int pos = contain(q_prime->vList[u_prime], p);
+	return pos != -1 && contain(q_prime->NEC[u_prime][1], &((*p)[pos].vlist)) != -1;
+}
+
 bool verify(int* M, Query* q, Graph* g)
 {
 	if(M == NULL || q == NULL || g == NULL || q->real_graph == NULL || g->real_graph == NULL)
@@ -995,37 +1077,139 @@ bool verify(int* M, Query* q, Graph* g)
 	return true;
 }
 
-//output a result after verified
-void output(int* M, int qVNum, FILE* fpR) {
+//Intersect durable_stack[depth - 1] with the runs of every query arc between the
+//singleton NEC u_prime and the already mapped singleton NECs into durable_stack[depth].
+//Arcs touching a multi-vertex NEC are deferred to DurableLeaf(), since GenPerm
+//still permutes those vertices.
+bool ExtendDurable(Query *q, NECTree *q_prime, int u_prime, int depth, int *M)
+{
+	vector <DurableInterval>& current = durable_stack[depth];
+	current = durable_stack[depth - 1];
+	if(q_prime->NEC[u_prime].size() != 1)
+		return true;
+	const int x = q_prime->NEC[u_prime][0];
+	vector <DurableInterval> next;
+	const DurableInterval *first, *last;
+	const Vertex& vx = q->real_graph->vertices[x];
+	for(int pass = 0; pass < 2; ++pass)
+	{
+		const vector<DNeighbor>& arcs = pass == 0 ? vx.out : vx.in;
+		for(std::size_t j = 0; j < arcs.size(); ++j)
+		{
+			const int y = arcs[j].vid;
+			if(M[y] == -1 || durable_nec_size[y] != 1)
+				continue;
+			const bool found = pass == 0 ? durable_arcs->find(M[x], M[y], first, last)
+				: durable_arcs->find(M[y], M[x], first, last);
+			if(!found)
+				return false;
+			intersectDurable(current, first, last, durable_k, next);
+			current.swap(next);
+			if(current.empty())
+				return false;
+		}
+	}
+	return true;
+}
+
+//the durable counterpart of verify(): the deferred arcs must share a run of k snapshots
+//with everything checked on the way down
+bool DurableLeaf(int *M)
+{
+	if(durable_deferred.empty())
+		return !durable_stack[durable_leaf_depth].empty();
+	vector <DurableInterval> current = durable_stack[durable_leaf_depth], next;
+	const DurableInterval *first, *last;
+	for(std::size_t i = 0; i < durable_deferred.size(); ++i)
+	{
+		if(!durable_arcs->find(M[durable_deferred[i].first], M[durable_deferred[i].second], first, last))
+			return false;
+		intersectDurable(current, first, last, durable_k, next);
+		current.swap(next);
+		if(current.empty())
+			return false;
+	}
+	return true;
+}
+
+//one per search thread: result rows are appended to the shared result file in blocks,
+//and without a result cap the embeddings are counted locally until flush();
+//cache line aligned so that neighbouring threads do not share count
+class alignas(64) ResultBuffer
+{
+public:
+	FILE* fpR;
+	std::mutex* file_lock;
+	string rows;
+	std::uint64_t count;
+
+	ResultBuffer(FILE* _fpR, std::mutex* _file_lock)
+	{
+		fpR = _fpR;
+		file_lock = _file_lock;
+		count = 0;
+	}
+
+	void flush()
+	{
+		numofembeddings += count;
+		count = 0;
+		if(rows.empty())
+			return;
+		std::lock_guard<std::mutex> guard(*file_lock);
+		fwrite(rows.data(), 1, rows.size(), fpR);
+		rows.clear();
+	}
+};
+
+//output a result after verified; weight > 1 only in count mode, for embeddings
+//that were counted instead of enumerated
+void output(int* M, int qVNum, ResultBuffer* out, std::uint64_t weight = 1) {
 	if (searchShouldStop())
 		return;
-	if(numofembeddings >= max_results) {
-		// Reaching the cap is not itself proof of truncation. Only a subsequent
-		// complete mapping proves that at least one result was omitted.
-		results_truncated = true;
-		return;
+	if(max_results == std::numeric_limits<std::uint64_t>::max()) {
+		out->count += weight;
+	}
+	else {
+		//claim slots, so that the threads together never pass the cap
+		std::uint64_t claimed = numofembeddings.load(std::memory_order_relaxed);
+		std::uint64_t take = 0;
+		do {
+			if(claimed >= max_results) {
+				// Reaching the cap is not itself proof of truncation. Only a subsequent
+				// complete mapping proves that at least one result was omitted.
+				results_truncated = true;
+				return;
+			}
+			take = std::min(weight, max_results - claimed);
+		} while(!numofembeddings.compare_exchange_weak(claimed, claimed + take, std::memory_order_relaxed));
+		if(take < weight)
+			results_truncated = true;
 	}
 #ifdef PRINT_RESULT
-	for(int i = 0; i < qVNum; ++i)
-		fprintf(fpR, "(%d, %d) ", i, M[i]);
-	fprintf(fpR, "\n");
+	char row[32];
+	for(int i = 0; i < qVNum; ++i) {
+		snprintf(row, sizeof(row), "(%d, %d) ", i, M[i]);
+		out->rows += row;
+	}
+	out->rows += '\n';
+	if(out->rows.size() >= (1U << 16))
+		out->flush();
 #endif
-	numofembeddings++;
 	(void)M;
 	(void)qVNum;
-	(void)fpR;
 }
 
-void GenPerm(int *M, NECTree *q_prime, int i, FILE *fpR, Query* q, Graph* g) {
+void GenPerm(int *M, NECTree *q_prime, int i, ResultBuffer *out, Query* q, Graph* g, std::uint64_t weight = 1) {
 	if (searchShouldStop())
 		return;
 	int qVNum = q->numVertex;
 	if(i == q_prime->numVertex)
 	{
-		if(verify(M, q, g))
+		if(durable_arcs != NULL ? DurableLeaf(M) : verify(M, q, g))
 		{
 			//cout<<"found a valid answer"<<endl;
-			output(M, qVNum, fpR);
+			output(M, qVNum, out, weight);
 		}
 		//char buffer[1000];
 		//buffer[0] = '\0';
@@ -1047,7 +1231,12 @@ void GenPerm(int *M, NECTree *q_prime, int i, FILE *fpR, Query* q, Graph* g) {
 	int Size = q_prime->NEC[i].size();
 	if(Size == 1)
 	{
-		GenPerm(M, q_prime, i + 1, fpR, q, g);
+		GenPerm(M, q_prime, i + 1, out, q, g, weight);
+	}
+	else if(nec_weight[i] != 0)
+	{
+		//every permutation is valid iff this one is
+		GenPerm(M, q_prime, i + 1, out, q, g, saturatingProduct(weight, nec_weight[i]));
 	}
 	else
 	{
@@ -1056,15 +1245,15 @@ void GenPerm(int *M, NECTree *q_prime, int i, FILE *fpR, Query* q, Graph* g) {
 		while(!NextPerm(M, &(q_prime->NEC[i]), rank))
 		{
 			if (searchShouldStop()) break;
-			GenPerm(M, q_prime, i + 1, fpR, q, g);
+			GenPerm(M, q_prime, i + 1, out, q, g, weight);
 		}
 		delete []rank;
 	}
 }
 
-void SubgraphSearch(Query *q, NECTree *q_prime, Graph *g, Elem *order, int dc, int *M, bool *F, CRTree *CR, FILE *fpR) {
+void SubgraphSearch(Query *q, NECTree *q_prime, Graph *g, Elem *order, int dc, int *M, bool *F, CRTree *CR, ResultBuffer *out) {
 	if (searchShouldStop()) return;
-    num_recursive_call++;
+    thread_recursive_calls++;
 	int u_prime = order[dc].v;
 	int p_u_prime = q_prime->parent[u_prime];
 
@@ -1073,22 +1262,21 @@ void SubgraphSearch(Query *q, NECTree *q_prime, Graph *g, Elem *order, int dc, i
 	int Size = q_prime->NEC[p_u_prime].size();
 	for(int i = 0; i < Size; i ++) {
 		int v = M[q_prime->NEC[p_u_prime][i]];
-		int pos = contain(v, &(CR->parent[u_prime]));
-        if(pos == -1) {
+		const CRTree::Entry *t = CR->lookup(u_prime, v);
+        if(t == NULL) {
             csize = 0;
             break;
         }
-		vector <int> *t = &(CR->CR[u_prime][pos]);
 		if(i == 0) {
 			//cout<<"check stack: "<<t->size()<<endl;
-			C1 = *t;
+			C1.assign(CR->begin(t), CR->end(t));
             csize = C1.size();
 		}
 		else {
 			for(std::size_t j = 0; j < C1.size(); ++j) {
                 if(C1[j] == -1)
                     continue;
-				if(contain(C1[j], t) == -1) {
+				if(!binary_search(CR->begin(t), CR->end(t), C1[j])) {
                     csize--;
                     C1[j] = -1;
                     continue;
@@ -1106,6 +1294,29 @@ void SubgraphSearch(Query *q, NECTree *q_prime, Graph *g, Elem *order, int dc, i
         C.push_back(C1[i]);
     }
 
+	//count mode: the members of the last NEC are interchangeable and not adjacent, so
+	//its injective assignments are P(m, s) over the m candidates valid on their own
+	Size = q_prime->NEC[u_prime].size();
+	if(count_last_nec && Size > 1 && q_prime->numVertex == dc + 1 && !NECIsClique(q, q_prime, u_prime)) {
+		if(!verifyMapped(M, q, g))
+			return;
+		const int x = q_prime->NEC[u_prime][0];
+		std::uint64_t m = 0;
+		for(std::size_t i = 0; i < C.size(); ++i)
+			if(!F[C[i]] && IsJoinable(q, g, M, x, C[i]) && ArcsContained(M, q, g, x, C[i]))
+				++m;
+		if(m < static_cast<std::uint64_t>(Size))
+			return;
+		std::uint64_t weight = 1;
+		for(int i = 0; i < Size; i ++)
+			weight = saturatingProduct(weight, m - i);
+		for(int j = 0; j < q_prime->numVertex; j ++)
+			if(j != u_prime && q_prime->NEC[j].size() > 1)
+				weight = saturatingProduct(weight, nec_weight[j]);
+		output(M, q->numVertex, out, weight);
+		return;
+	}
+
 	//int *Srank = new int[Size];
 	vector <int> Srank;
 	Srank.push_back(-1);
@@ -1141,7 +1352,7 @@ void SubgraphSearch(Query *q, NECTree *q_prime, Graph *g, Elem *order, int dc, i
 							break;
 						}
 						for(int j = i + 1; j < Size; j ++) {
-							if(contain(value[j], &((*p)[pos].vlist)) == -1) {
+							if(!binary_search((*p)[pos].vlist.begin(), (*p)[pos].vlist.end(), value[j])) {
 								Continue = true;
 								break;
 							}
@@ -1164,36 +1375,24 @@ void SubgraphSearch(Query *q, NECTree *q_prime, Graph *g, Elem *order, int dc, i
 
 		if(!matched) continue;
 		UpdateState(M, F, &(q_prime->NEC[u_prime]), &value);
-		if(q_prime->numVertex == dc + 1)
-			GenPerm(M, q_prime, 0, fpR, q, g);
+		if(durable_arcs != NULL && !ExtendDurable(q, q_prime, u_prime, dc, M)) {
+			RestoreState(M, F, &(q_prime->NEC[u_prime]), &value);
+			continue;
+		}
+		if(q_prime->numVertex == dc + 1) {
+			durable_leaf_depth = dc;
+			GenPerm(M, q_prime, 0, out, q, g);
+		}
 		else
-            SubgraphSearch(q, q_prime, g, order, dc + 1, M, F, CR, fpR);
+            SubgraphSearch(q, q_prime, g, order, dc + 1, M, F, CR, out);
 		RestoreState(M, F, &(q_prime->NEC[u_prime]), &value);
 	}
 }
 
-void TurboISO(Query *q, Graph *g, FILE *fpR) {
-	long rewrite_t = 0, explore_t = 0, order_t = 0, join_t = 0, begin, end;
-	begin = get_cur_time();
-	NECTree q_prime;
-	q_prime.init();
-	int us = ChooseStartQVertex(q, g);
-	if(us < 0)
-		return;
-
-	//if(g->labelList != NULL)
-	//	delete [](g->labelList);
-
-	//merge similar query nodes, generate a BFS tree
-	RewriteToNECTree(q, us, &q_prime);
-	//cout<<"rewrite to nec tree"<<endl;
-	end = get_cur_time();
-	rewrite_t += (end-begin);
-
-	const int root_label = q->vList[us];
-	if(root_label < 0 || root_label > g->LabelNum)
-		return;
-	const vector<int>& root_candidates = g->labelList[root_label];
+//explore and search the candidate regions of the roots this thread claims from next_root
+void SearchRegions(Query *q, Graph *g, NECTree *q_prime, int us, const vector<int>& root_candidates,
+	std::atomic<std::size_t>* next_root, ResultBuffer *out, long *explore_t, long *order_t, long *join_t)
+{
 	bool *visited = new bool[g->numVertex];
 	memset(visited, false, sizebool * g->numVertex);
 	bool *F = new bool[g->numVertex];
@@ -1201,9 +1400,17 @@ void TurboISO(Query *q, Graph *g, FILE *fpR) {
 	int *M = new int[q->numVertex];
 	for(int j = 0; j < q->numVertex; ++j)
 		M[j] = -1;
+	if(durable_arcs != NULL) {
+		//the root starts from one unbounded run
+		durable_stack.assign(q_prime->numVertex, vector<DurableInterval>());
+		durable_stack[0].push_back({LLONG_MIN / 4, LLONG_MAX / 4});
+	}
+	thread_recursive_calls = 0;
+	CRTree CR;		//reused by every region this thread explores
 
-	for(std::size_t root_index = 0; root_index < root_candidates.size(); ++root_index) {
-		if(searchShouldStop())
+	while(true) {
+		const std::size_t root_index = next_root->fetch_add(1);
+		if(root_index >= root_candidates.size() || searchShouldStop())
 			break;
 		if((root_index & 255U) == 0U)
 			sampleMemory();
@@ -1211,45 +1418,26 @@ void TurboISO(Query *q, Graph *g, FILE *fpR) {
 		//cout<<"this is the "<<i<<"th data vertex"<<endl;
 		if(contain(q->vList[us], &(g->vList[i])) != -1) { //find a region: check labels
 			//cout<<"to init CR"<<endl;
-			CRTree CR;
-			CR.init(q_prime.numVertex);
+			CR.init(q_prime->numVertex);
 			vector <int> VM;  //for each candidate region
 			VM.push_back(i);
 			long begin = get_cur_time();
-			bool explore = ExploreCR(0, &VM, &CR, -1, &q_prime, g, q, visited);
+			bool explore = ExploreCR(0, &VM, &CR, -1, q_prime, g, q, visited);
 			long end = get_cur_time();
-			explore_t += (end-begin);
-			/*for(int j = 0; j < q_prime.numVertex; j ++)
-			{
-				for(int k = 0; k < CR.parent[j].size(); k ++)
-					printf("%d ", CR.parent[j][k]);
-				printf("\n");
-			}
-			printf("\n");
-			for(int j = 0; j < q_prime.numVertex; j ++) {
-				for(int k = 0; k < CR.CR[j].size(); k ++) {
-					for(int l = 0; l < CR.CR[j][k].size(); l ++) {
-						printf("%d ", CR.CR[j][k][l]);
-					} printf("\n");
-				} printf("\n");
-			}*/
+			*explore_t += (end-begin);
 
 			if(explore) {
+				CR.seal();
 				begin = get_cur_time();
 				Elem *order = NULL;
 				//NOTICE: a new matching order for each candidate region
-				//cout<<"to choose matching order"<<endl;
-				if(q_prime.numVertex > 1) {
-					order = new Elem[q_prime.numVertex];
-					DetermineMatchingOrder(&q_prime, &CR, order, 0, 1, q);
-					qsort(order, q_prime.numVertex, sizeof(Elem), cmpE);
+				if(q_prime->numVertex > 1) {
+					order = new Elem[q_prime->numVertex];
+					DetermineMatchingOrder(q_prime, &CR, order, 0, 1, q);
+					qsort(order, q_prime->numVertex, sizeof(Elem), cmpE);
 				}
 				end = get_cur_time();
-				order_t += (end-begin);
-
-				/*for(int j = 0; j < q_prime.numVertex; j ++) {
-					printf("%d %lf\n", order[j].v, order[j].value);
-				}*/
+				*order_t += (end-begin);
 
 				begin =	get_cur_time();
 				//Subgraph search process for each candidate region (CR)
@@ -1260,31 +1448,104 @@ void TurboISO(Query *q, Graph *g, FILE *fpR) {
 				vector <int> gV;
 				gV.push_back(i);
 				UpdateState(M, F, &qV, &gV);
-				//cout<<"to do subgraph search"<<endl;
-				if(q_prime.numVertex == 1)
-					GenPerm(M, &q_prime, 0, fpR, q, g);
+				if(q_prime->numVertex == 1) {
+					durable_leaf_depth = 0;
+					GenPerm(M, q_prime, 0, out, q, g);
+				}
 				else
-					SubgraphSearch(q, &q_prime, g, order, 1, M, F, &CR, fpR);
+					SubgraphSearch(q, q_prime, g, order, 1, M, F, &CR, out);
 				end = get_cur_time();
-				join_t += (end-begin);
+				*join_t += (end-begin);
 
-				//cout<<"after subgraph search"<<endl;
 				if(order != NULL) delete []order;
 				RestoreState(M, F, &qV, &gV);
 			}
 		}
 	}
+	out->flush();
+	num_recursive_call += thread_recursive_calls;
 	delete []M;
 	delete []F;
 	delete []visited;
+}
+
+void TurboISO(Query *q, Graph *g, FILE *fpR) {
+	long begin, end;
+	begin = get_cur_time();
+	NECTree q_prime;
+	q_prime.init();
+	int us = ChooseStartQVertex(q, g);
+	if(us < 0)
+		return;
+
+	//if(g->labelList != NULL)
+	//	delete [](g->labelList);
+
+	//merge similar query nodes, generate a BFS tree
+	RewriteToNECTree(q, us, &q_prime);
+	//cout<<"rewrite to nec tree"<<endl;
+	end = get_cur_time();
+	rewrite_t += (end-begin);
+
+	const int root_label = q->vList[us];
+	if(root_label < 0 || root_label > g->LabelNum)
+		return;
+	if(durable_arcs != NULL) {
+		durable_nec_size.assign(q->numVertex, 0);
+		for(int j = 0; j < q_prime.numVertex; ++j)
+			for(std::size_t l = 0; l < q_prime.NEC[j].size(); ++l)
+				durable_nec_size[q_prime.NEC[j][l]] = q_prime.NEC[j].size();
+		durable_deferred.clear();
+		for(int x = 0; x < q->numVertex; ++x) {
+			const vector<DNeighbor>& out = q->real_graph->vertices[x].out;
+			for(std::size_t j = 0; j < out.size(); ++j)
+				if(durable_nec_size[x] > 1 || durable_nec_size[out[j].vid] > 1)
+					durable_deferred.push_back(make_pair(x, out[j].vid));
+		}
+	}
+	nec_weight.assign(q_prime.numVertex, 1);
+	count_last_nec = durable_arcs == NULL;
+	for(int j = 0; j < q_prime.numVertex; ++j) {
+		const std::size_t size = q_prime.NEC[j].size();
+		if(size < 2)
+			continue;
+		nec_weight[j] = 0;
+#ifndef PRINT_RESULT
+		//every mapping is printed otherwise
+		if(SymmetricNEC(q, q_prime.NEC[j])) {
+			nec_weight[j] = 1;
+			for(std::size_t f = 2; f <= size; ++f)
+				nec_weight[j] = saturatingProduct(nec_weight[j], f);
+		}
+#endif
+		if(nec_weight[j] == 0)
+			count_last_nec = false;
+	}
+	const vector<int>& root_candidates = g->labelList[root_label];
+
+	//each root candidate is one candidate region: the threads claim them one at a time
+	unsigned thread_count = search_threads;
+	if(thread_count == 0)
+		thread_count = std::max(1U, std::thread::hardware_concurrency());
+	thread_count = static_cast<unsigned>(std::min<std::size_t>(thread_count, std::max<std::size_t>(1, root_candidates.size())));
+	std::atomic<std::size_t> next_root(0);
+	std::mutex file_lock;
+	vector <ResultBuffer> buffers(thread_count, ResultBuffer(fpR, &file_lock));
+	vector <long> thread_explore_t(thread_count, 0), thread_order_t(thread_count, 0), thread_join_t(thread_count, 0);
+	vector <std::thread> workers;
+	for(unsigned t = 1; t < thread_count; ++t)
+		workers.push_back(std::thread(SearchRegions, q, g, &q_prime, us, std::cref(root_candidates),
+			&next_root, &buffers[t], &thread_explore_t[t], &thread_order_t[t], &thread_join_t[t]));
+	SearchRegions(q, g, &q_prime, us, root_candidates, &next_root, &buffers[0],
+		&thread_explore_t[0], &thread_order_t[0], &thread_join_t[0]);
+	for(std::size_t t = 0; t < workers.size(); ++t)
+		workers[t].join();
+	for(unsigned t = 0; t < thread_count; ++t) {
+		explore_t += thread_explore_t[t];
+		order_t += thread_order_t[t];
+		join_t += thread_join_t[t];
+	}
 	sampleMemory();
-	/*
-	cout<<"recursive call: "<<num_recursive_call<<endl;
-	cout<<"rewrite time: "<<rewrite_t<<endl;
-	cout<<"explore time: "<<explore_t<<endl;
-	cout<<"order time: "<<order_t<<endl;
-	cout<<"join time: "<<join_t<<endl;
-*/
 }
 
 bool ValidateQuery(Query *q) {
@@ -1333,7 +1594,102 @@ void printUsage(const char* program)
 {
 	cerr << "Usage: " << program
 	     << " <data.turbo> <query.turbo> [result.txt]"
-	     << " [--time-limit seconds] [--max-results count]\n";
+	     << " [--time-limit seconds] [--max-results count] [--threads N]\n"
+	     << "       " << program
+	     << " <temporal.txt> <query.txt> [result.txt] --durable k [--seed N]"
+	     << " [--time-limit seconds] [--max-results count] [--threads N]\n";
+}
+
+//run one query against one data graph and report it in the result file and on stdout;
+//load_time is the time spent loading that data graph, reported but not counted
+long RunQuery(Query *q, Graph *g, int dgcnt, std::size_t i, long load_time, FILE *fpR)
+{
+	long begin = get_cur_time();
+	numofembeddings = 0;
+	num_recursive_call = 0;
+	timed_out = false;
+	results_truncated = false;
+	max_mem = 0.0;
+	max_rss = 0.0;
+	rewrite_t = explore_t = order_t = join_t = 0;
+#ifdef _PRINT_ANS
+	fprintf(fpR, "query graph:%d	data graph:%d\n", i, dgcnt);
+	fprintf(fpR, "============================================================\n");
+#endif
+	sampleMemory();
+	timeLimit(TIME_LIMIT_SECONDS);
+	if(CheckQ(q, g))  //check the maximum label num
+		TurboISO(q, g, fpR);
+	noTimeLimit();
+	sampleMemory();
+#ifdef _PRINT_ANS
+	fprintf(fpR, "\n\n\n");
+	fflush(fpR);
+#endif
+	long end = get_cur_time();
+	const long elapsed = end - begin;
+	fprintf(
+		fpR,
+		"data=%d query=%llu Count: %llu time_ms=%ld timed_out=%s truncated=%s"
+		" load_ms=%ld rewrite_ms=%ld explore_ms=%ld order_ms=%ld join_ms=%ld\n",
+		dgcnt,
+		static_cast<unsigned long long>(i),
+		static_cast<unsigned long long>(numofembeddings),
+		elapsed,
+		timed_out ? "yes" : "no",
+		results_truncated ? "yes" : "no",
+		load_time,
+		rewrite_t,
+		explore_t,
+		order_t,
+		join_t);
+	fflush(fpR);
+	printf(
+		"turbo: data=%d query=%llu nembeddings=%llu ncalls=%llu "
+		"time=%ld ms vm=%.0lf kB rss=%.0lf kB timed_out=%s truncated=%s "
+		"load=%ld ms rewrite=%ld ms explore=%ld ms order=%ld ms join=%ld ms\n",
+		dgcnt,
+		static_cast<unsigned long long>(i),
+		static_cast<unsigned long long>(numofembeddings),
+		static_cast<unsigned long long>(num_recursive_call),
+		elapsed,
+		max_mem,
+		max_rss,
+		timed_out ? "yes" : "no",
+		results_truncated ? "yes" : "no",
+		load_time,
+		rewrite_t,
+		explore_t,
+		order_t,
+		join_t);
+	return elapsed;
+}
+
+//--durable: the temporal triples are matched directly, without a turbo_convert.exe pass
+int RunDurable(const char* temporal_path, const char* query_path, int k, std::uint32_t seed, const string& result)
+{
+	Graph g;
+	Query q;
+	TemporalArcs arcs;
+	long begin = get_cur_time();
+	if(!loadDurableInput(temporal_path, query_path, k, seed, search_threads, g, q, arcs) || !ValidateQuery(&q))
+		return 1;
+	const long load_time = get_cur_time() - begin;
+	FILE *fpR = fopen(result.c_str(), "w");
+	if(fpR == NULL) {
+		cerr << "Error: cannot open result file: " << result << '\n';
+		return 1;
+	}
+	cout << "TurboIso input OK: " << g.numVertex << " vertices, " << arcs.targets.size()
+	     << " arcs with a run of at least " << k << " snapshots" << endl;
+	durable_arcs = &arcs;
+	durable_k = k;
+	const long elapsed = RunQuery(&q, &g, 0, 0, load_time, fpR);
+	durable_arcs = NULL;
+	cout << "TurboISO total time: " << elapsed << " ms\n";
+	fclose(fpR);
+	cout.flush();
+	return 0;
 }
 
 bool parseNonNegativeInt(const char* value, int& result)
@@ -1366,9 +1722,30 @@ int main(int argc, char** argv) {
 
 	string result = "ans.txt";
 	bool result_path_set = false;
+	int durable = 0;
+	std::uint32_t seed = temporal_input::kDefaultSeed;
+	bool seed_set = false;
 	for(int i = 3; i < argc; ++i) {
 		const string option = argv[i];
-		if(option == "--time-limit") {
+		if(option == "--durable") {
+			if(durable != 0 || i + 1 >= argc || !parseNonNegativeInt(argv[++i], durable) || durable == 0) {
+				cerr << "Error: --durable must be a positive integer.\n";
+				return 2;
+			}
+		} else if(option == "--seed") {
+			if(seed_set || i + 1 >= argc || !temporal_input::parseSeed(argv[++i], seed)) {
+				cerr << "Error: --seed must be a 32-bit unsigned integer.\n";
+				return 2;
+			}
+			seed_set = true;
+		} else if(option == "--threads") {
+			int threads = 0;
+			if(i + 1 >= argc || !parseNonNegativeInt(argv[++i], threads) || threads == 0) {
+				cerr << "Error: --threads must be a positive integer.\n";
+				return 2;
+			}
+			search_threads = static_cast<unsigned>(threads);
+		} else if(option == "--time-limit") {
 			if(i + 1 >= argc || !parseNonNegativeInt(argv[++i], TIME_LIMIT_SECONDS)) {
 				cerr << "Error: --time-limit must be a non-negative integer.\n";
 				return 2;
@@ -1388,15 +1765,30 @@ int main(int argc, char** argv) {
 		}
 	}
 
-	FILE *fp = fopen(argv[1], "r");
-	if(fp == NULL) {
-		cerr << "Error: cannot open data graph: " << argv[1] << '\n';
-		return 1;
+	if(seed_set && durable == 0) {
+		cerr << "Error: --seed only applies with --durable.\n";
+		return 2;
+	}
+	if(durable != 0)
+		return RunDurable(argv[1], argv[2], durable, seed, result);
+
+	//a binary_graph.h data graph is mapped instead of parsed
+	MappedFile mapped;
+	const bool binary = mapped.open(argv[1]) && binary_graph::hasMagic(mapped.data(), mapped.size());
+	FILE *fp = NULL;
+	if(!binary) {
+		//a text graph is read through stdio, so do not keep its pages mapped
+		mapped.close();
+		fp = fopen(argv[1], "r");
+		if(fp == NULL) {
+			cerr << "Error: cannot open data graph: " << argv[1] << '\n';
+			return 1;
+		}
 	}
 	FILE *fpQ = fopen(argv[2], "r");
 	if(fpQ == NULL) {
 		cerr << "Error: cannot open query graph: " << argv[2] << '\n';
-		fclose(fp);
+		if(fp != NULL) fclose(fp);
 		return 1;
 	}
 	vector<Query*> qlist;
@@ -1421,7 +1813,7 @@ int main(int argc, char** argv) {
 	if(query_input_error || qlist.empty()) {
 		if(!query_input_error)
 			cerr << "Error: no query graph was loaded.\n";
-		fclose(fp);
+		if(fp != NULL) fclose(fp);
 		for(Query* q : qlist) delete q;
 		return 1;
 	}
@@ -1429,7 +1821,7 @@ int main(int argc, char** argv) {
 	FILE *fpR = fopen(result.c_str(), "w");
 	if(fpR == NULL) {
 		cerr << "Error: cannot open result file: " << result << '\n';
-		fclose(fp);
+		if(fp != NULL) fclose(fp);
 		for(Query* q : qlist) delete q;
 		return 1;
 	}
@@ -1439,68 +1831,29 @@ int main(int argc, char** argv) {
 	bool data_input_error = false;
 	cout << "TurboIso input OK" << endl;
 	while(true) {
+		long load_begin = get_cur_time();
 		Graph* g = new Graph;
-		const NativeParseStatus status = g->createGraph(fp);
+		NativeParseStatus status;
+		if(!binary)
+			status = g->createGraph(fp);
+		else if(dgcnt >= 0)
+			status = NativeParseStatus::End;		//one graph per binary file
+		else
+			status = g->loadBinary(mapped.data(), mapped.size()) ? NativeParseStatus::Loaded : NativeParseStatus::Error;
 		if(status != NativeParseStatus::Loaded) {
 			data_input_error = status == NativeParseStatus::Error;
 			delete g;
 			break;
 		}
 		dgcnt++;
+		const long load_time = get_cur_time() - load_begin;
 
-		for(std::size_t i = 0; i < qlist.size(); ++i) {
-			long begin = get_cur_time();
-			numofembeddings = 0;
-			num_recursive_call = 0;
-			timed_out = false;
-			results_truncated = false;
-			max_mem = 0.0;
-			max_rss = 0.0;
-			Query* q = qlist[i];
-#ifdef _PRINT_ANS
-			fprintf(fpR, "query graph:%d	data graph:%d\n", i, dgcnt);
-			fprintf(fpR, "============================================================\n");
-#endif
-			sampleMemory();
-			timeLimit(TIME_LIMIT_SECONDS);
-			if(CheckQ(q, g))  //check the maximum label num
-				TurboISO(q, g, fpR);
-			noTimeLimit();
-			sampleMemory();
-#ifdef _PRINT_ANS
-			fprintf(fpR, "\n\n\n");
-			fflush(fpR);
-#endif
-			long end = get_cur_time();
-			const long elapsed = end - begin;
-			total_time += elapsed;
-			fprintf(
-				fpR,
-				"data=%d query=%llu Count: %llu time_ms=%ld timed_out=%s truncated=%s\n",
-				dgcnt,
-				static_cast<unsigned long long>(i),
-				static_cast<unsigned long long>(numofembeddings),
-				elapsed,
-				timed_out ? "yes" : "no",
-				results_truncated ? "yes" : "no");
-			fflush(fpR);
-			printf(
-				"turbo: data=%d query=%llu nembeddings=%llu ncalls=%llu "
-				"time=%ld ms vm=%.0lf kB rss=%.0lf kB timed_out=%s truncated=%s\n",
-				dgcnt,
-				static_cast<unsigned long long>(i),
-				static_cast<unsigned long long>(numofembeddings),
-				static_cast<unsigned long long>(num_recursive_call),
-				elapsed,
-				max_mem,
-				max_rss,
-				timed_out ? "yes" : "no",
-				results_truncated ? "yes" : "no");
-		}
+		for(std::size_t i = 0; i < qlist.size(); ++i)
+			total_time += RunQuery(qlist[i], g, dgcnt, i, load_time, fpR);
 		delete g;
 	}
 
-	fclose(fp);
+	if(fp != NULL) fclose(fp);
 	if(data_input_error)
 		cerr << "Error: data graph parsing failed.\n";
 	else if(dgcnt < 0)
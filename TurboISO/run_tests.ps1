@@ -164,6 +164,51 @@ t # -1
     $reciprocalOutput = Invoke-Turbo $reciprocalData $reciprocalQuery
     Assert-Match $reciprocalOutput 'nembeddings=1(?:\s|$)' "Valid reciprocal arcs were not retained."
 
+    # One A with three B out-neighbours and one B in-neighbour. The two B leaves
+    # of the out-star are interchangeable, so count mode multiplies instead of
+    # permuting; the mixed-direction pair is not, and must still be verified.
+    $starData = Join-Path $testDir "star-data.turbo"
+    Write-Ascii $starData @"
+t # 0
+5 4 3
+v 0 1
+v 1 2
+v 2 2
+v 3 2
+v 4 2
+e 0 1
+e 0 2
+e 0 3
+e 4 0
+t # -1
+"@
+    $starQuery = Join-Path $testDir "star-query.turbo"
+    Write-Ascii $starQuery @"
+t # 0
+3 2 3 1
+v 0 1
+v 1 2
+v 2 2
+e 0 1 1
+e 0 2 1
+t # -1
+"@
+    $starOutput = Invoke-Turbo $starData $starQuery
+    Assert-Match $starOutput 'nembeddings=6(?:\s|$)' "Interchangeable NEC leaves were not counted as 3 * 2 assignments."
+    $mixedQuery = Join-Path $testDir "mixed-query.turbo"
+    Write-Ascii $mixedQuery @"
+t # 0
+3 2 3 1
+v 0 1
+v 1 2
+v 2 2
+e 0 1 1
+e 2 0 1
+t # -1
+"@
+    $mixedOutput = Invoke-Turbo $starData $mixedQuery
+    Assert-Match $mixedOutput 'nembeddings=3(?:\s|$)' "A NEC with differently directed arcs was counted as interchangeable."
+
     $query1 = Join-Path $testDir "query1.turbo"
     Write-Ascii $query1 @"
 t # 0
@@ -189,6 +234,10 @@ t # -1
     $limitedOutput = Invoke-Turbo $multiRootData $query1 @("--max-results", "1")
     Assert-Match $limitedOutput 'nembeddings=1(?:\s|$)' "The explicit result limit returned the wrong count."
     Assert-Match $limitedOutput 'truncated=yes' "The explicit result limit was not reported as truncated."
+    $threadedOutput = Invoke-Turbo $multiRootData $query1 @("--threads", "3")
+    Assert-Match $threadedOutput 'nembeddings=2(?:\s|$)' "Threaded root claiming lost or repeated a candidate region."
+    $threadedLimitedOutput = Invoke-Turbo $multiRootData $query1 @("--threads", "2", "--max-results", "1")
+    Assert-Match $threadedLimitedOutput 'nembeddings=1(?:\s|$)' "Threads together passed the result limit."
 
     $temporal = Join-Path $testDir "temporal.txt"
     $edgeQuery = Join-Path $testDir "query.txt"
@@ -234,6 +283,50 @@ A B
     $convertedRun = Invoke-Turbo $convertedData $convertedQuery
     Assert-Match $convertedRun 'timed_out=no' "Converted current-format input did not run normally."
 
+    $binaryData = Join-Path $testDir "converted-data.tbgr"
+    $binaryQuery = Join-Path $testDir "converted-query-binary.turbo"
+    & (Join-Path $sourceDir "turbo_convert.exe") $temporal $edgeQuery $binaryData $binaryQuery 42 --binary --threads 2 | Out-Null
+    if ($LASTEXITCODE -ne 0) { throw "Binary converter run failed" }
+    $binaryRun = Invoke-Turbo $binaryData $binaryQuery
+    $textCount = [regex]::Match($convertedRun, 'nembeddings=(\d+)').Groups[1].Value
+    Assert-Match $binaryRun "nembeddings=$textCount\b" "Binary data graph matched differently from its text form."
+    Assert-Match $binaryRun 'load=\d+ ms' "Load time is not reported."
+
+    $truncatedBinary = Join-Path $testDir "truncated.tbgr"
+    $binaryBytes = [System.IO.File]::ReadAllBytes($binaryData)
+    [System.IO.File]::WriteAllBytes($truncatedBinary, $binaryBytes[0..($binaryBytes.Length - 2)])
+    Assert-TurboFails $truncatedBinary $binaryQuery "invalid binary graph header or file size" "Truncated binary data graph was accepted."
+
+    # Seed 42 labels raw IDs 1, 2, 3 as C, D, E (see the converter checks).
+    # 2 -> 3 is active over [1, 2] and 3 -> 2 over [3, 4]: each arc is
+    # durable for k = 2, but the reciprocal pair never shares a snapshot.
+    $durableTemporal = Join-Path $testDir "durable-temporal.txt"
+    Write-Ascii $durableTemporal @"
+1 1 0
+2 3 1
+2 3 2
+3 2 3
+3 2 4
+3 2 4
+"@
+    $durableQuery = Join-Path $testDir "durable-query.txt"
+    Write-Ascii $durableQuery @"
+D E
+"@
+    $durableReciprocal = Join-Path $testDir "durable-reciprocal.txt"
+    Write-Ascii $durableReciprocal @"
+x:D y:E
+y:E x:D
+"@
+    $durableOutput = Invoke-Turbo $durableTemporal $durableQuery @("--durable", "2", "--seed", "42")
+    Assert-Match $durableOutput 'nembeddings=1(?:\s|$)' "A durable arc was not matched from temporal triples."
+    $shortOutput = Invoke-Turbo $durableTemporal $durableQuery @("--durable", "3", "--seed", "42")
+    Assert-Match $shortOutput 'nembeddings=0(?:\s|$)' "An arc whose run is shorter than k entered a candidate region."
+    $disjointOutput = Invoke-Turbo $durableTemporal $durableReciprocal @("--durable", "2")
+    Assert-Match $disjointOutput 'nembeddings=0(?:\s|$)' "Reciprocal arcs without a common run were accepted."
+    $overlapOutput = Invoke-Turbo $durableTemporal $durableReciprocal @("--durable", "1")
+    Assert-Match $overlapOutput 'nembeddings=0(?:\s|$)' "Disjoint single-snapshot runs were intersected incorrectly."
+
     $multiLabelData = Join-Path $testDir "multi-label-data.turbo"
     Write-Ascii $multiLabelData @"
 t # 0
@@ -0,0 +1,358 @@
+// Project inputs shared by turbo_convert.exe and turbo.exe --durable:
+// `src dst timestamp` temporal triples, `A B` query pairs, and the seeded
+// A-E labels drawn over the sorted raw vertex universe, as in ours/original.
+
+#ifndef _TEMPORAL_INPUT_H
+#define _TEMPORAL_INPUT_H
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace temporal_input {
+
+constexpr int kLabelCount = 5;
+constexpr std::uint32_t kDefaultSeed = 42;
+
+struct DirectedEdge {
+    int from = 0;
+    int to = 0;
+
+    bool operator<(const DirectedEdge& other) const {
+        return from < other.from || (from == other.from && to < other.to);
+    }
+
+    bool operator==(const DirectedEdge& other) const {
+        return from == other.from && to == other.to;
+    }
+};
+
+struct QueryVertexToken {
+    std::string identity;
+    int label = 0;
+};
+
+inline bool parseLabel(const std::string& text, int& label) {
+    if (text.size() != 1 || text[0] < 'A' || text[0] > 'E') return false;
+    label = text[0] - 'A' + 1;
+    return true;
+}
+
+inline bool parseQueryVertex(const std::string& token, QueryVertexToken& result) {
+    const std::size_t separator = token.rfind(':');
+    if (separator == std::string::npos) {
+        result.identity = token;
+        return parseLabel(token, result.label);
+    }
+    if (separator == 0 || separator + 1 >= token.size()) return false;
+    result.identity = token.substr(0, separator);
+    return parseLabel(token.substr(separator + 1), result.label);
+}
+
+inline bool parseSeed(const char* text, std::uint32_t& seed) {
+    if (text == nullptr || *text == '\0' || *text == '-') return false;
+    try {
+        std::size_t consumed = 0;
+        const unsigned long long value = std::stoull(text, &consumed, 10);
+        if (consumed == 0 || text[consumed] != '\0' ||
+            value > std::numeric_limits<std::uint32_t>::max()) {
+            return false;
+        }
+        seed = static_cast<std::uint32_t>(value);
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+struct TemporalTriple {
+    int from = 0;
+    int to = 0;
+    long long timestamp = 0;
+
+    bool operator<(const TemporalTriple& other) const {
+        if (from != other.from) return from < other.from;
+        if (to != other.to) return to < other.to;
+        return timestamp < other.timestamp;
+    }
+};
+
+inline bool parseTemporalTriple(
+    const char* cursor,
+    const char* end,
+    long long& from,
+    long long& to,
+    long long& timestamp) {
+    auto skip_space = [&]() {
+        while (cursor < end &&
+               std::isspace(static_cast<unsigned char>(*cursor)) != 0) {
+            ++cursor;
+        }
+    };
+    auto parse_integer = [&](long long& value) {
+        skip_space();
+        if (cursor == end) return false;
+        const auto parsed = std::from_chars(cursor, end, value);
+        if (parsed.ec != std::errc{} || parsed.ptr == cursor) return false;
+        cursor = parsed.ptr;
+        return true;
+    };
+
+    if (!parse_integer(from) || !parse_integer(to) || !parse_integer(timestamp)) {
+        return false;
+    }
+    skip_space();
+    return cursor == end;
+}
+
+// One thread's share of a block: its triples and raw endpoints accumulate
+// over all blocks; lines and the first error are per block.
+struct TripleChunk {
+    std::vector<TemporalTriple> triples;
+    std::vector<int> raw_vertices;
+    std::size_t lines = 0;
+    std::size_t error_line = 0;
+    const char* error = nullptr;
+};
+
+inline void parseTripleChunk(const char* cursor, const char* end, TripleChunk& chunk) {
+    chunk.lines = 0;
+    long long from = 0;
+    long long to = 0;
+    long long timestamp = 0;
+    while (cursor < end) {
+        const char* line_end = static_cast<const char*>(
+            std::memchr(cursor, '\n', static_cast<std::size_t>(end - cursor)));
+        if (line_end == nullptr) line_end = end;
+        ++chunk.lines;
+        const char* line = cursor;
+        cursor = line_end < end ? line_end + 1 : end;
+        const char* last = line_end;
+        while (last > line && (last[-1] == ' ' || last[-1] == '\t' || last[-1] == '\r')) --last;
+        const char* first = line;
+        while (first < last && (*first == ' ' || *first == '\t')) ++first;
+        if (first == last) continue;
+        if (!parseTemporalTriple(first, last, from, to, timestamp)) {
+            chunk.error_line = chunk.lines;
+            chunk.error = " must contain exactly three integers.";
+            return;
+        }
+        if (from < 0 || to < 0 ||
+            from > std::numeric_limits<int>::max() ||
+            to > std::numeric_limits<int>::max()) {
+            chunk.error_line = chunk.lines;
+            chunk.error = " has a vertex ID outside the supported int range.";
+            return;
+        }
+        // A self-loop is not a matchable arc and is not emitted as a Turbo
+        // vertex, but its endpoint still consumes its stable seed-ordered
+        // RNG position before active labels are selected.
+        chunk.raw_vertices.push_back(static_cast<int>(from));
+        chunk.raw_vertices.push_back(static_cast<int>(to));
+        if (from == to) continue;
+        chunk.triples.push_back(
+            {static_cast<int>(from), static_cast<int>(to), timestamp});
+    }
+}
+
+// Streams the file once in 64 MiB blocks. Each block is split at line breaks
+// into one chunk per thread and parsed in parallel; threads = 0 uses the
+// hardware threads. triples gets every non-self-loop triple in no particular
+// order. Every endpoint, self-loops included, goes to raw_vertices, which is
+// returned sorted and unique: labels are drawn over that whole universe.
+inline bool readTemporalTriples(
+    const std::string& path,
+    unsigned threads,
+    std::vector<TemporalTriple>& triples,
+    std::vector<int>& raw_vertices) {
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        std::cerr << "Error: cannot open temporal graph: " << path << '\n';
+        return false;
+    }
+    if (threads == 0) threads = std::max(1U, std::thread::hardware_concurrency());
+
+    constexpr std::size_t kBlockBytes = std::size_t(1) << 26;
+    std::vector<char> block;
+    std::vector<TripleChunk> chunks(threads);
+    std::size_t lines_before = 0;
+    std::size_t carried = 0;
+    bool at_end = false;
+    while (!at_end) {
+        block.resize(carried + kBlockBytes);
+        input.read(block.data() + carried, static_cast<std::streamsize>(kBlockBytes));
+        const std::size_t filled = carried + static_cast<std::size_t>(input.gcount());
+        at_end = !input;
+        if (input.bad()) {
+            std::cerr << "Error: failed while reading temporal graph " << path << '\n';
+            return false;
+        }
+        // The partial last line is carried into the next block.
+        std::size_t usable = filled;
+        if (!at_end) {
+            while (usable > 0 && block[usable - 1] != '\n') --usable;
+            if (usable == 0) usable = filled;
+        }
+
+        std::vector<const char*> bounds(threads + 1);
+        bounds[0] = block.data();
+        bounds[threads] = block.data() + usable;
+        for (unsigned t = 1; t < threads; ++t) {
+            const char* split = std::max<const char*>(bounds[t - 1], block.data() + usable * t / threads);
+            while (split < bounds[threads] && split > block.data() && split[-1] != '\n') ++split;
+            bounds[t] = split;
+        }
+        std::vector<std::thread> workers;
+        for (unsigned t = 1; t < threads; ++t) {
+            workers.emplace_back(parseTripleChunk, bounds[t], bounds[t + 1], std::ref(chunks[t]));
+        }
+        parseTripleChunk(bounds[0], bounds[1], chunks[0]);
+        for (std::thread& worker : workers) worker.join();
+
+        for (TripleChunk& chunk : chunks) {
+            if (chunk.error != nullptr) {
+                std::cerr << "Error: temporal graph line " << lines_before + chunk.error_line
+                          << chunk.error << '\n';
+                return false;
+            }
+            lines_before += chunk.lines;
+        }
+        carried = filled - usable;
+        std::copy(block.begin() + static_cast<std::ptrdiff_t>(usable),
+                  block.begin() + static_cast<std::ptrdiff_t>(filled), block.begin());
+    }
+
+    std::size_t triple_count = 0;
+    for (const TripleChunk& chunk : chunks) triple_count += chunk.triples.size();
+    triples.reserve(triple_count);
+    for (TripleChunk& chunk : chunks) {
+        triples.insert(triples.end(), chunk.triples.begin(), chunk.triples.end());
+        std::vector<TemporalTriple>().swap(chunk.triples);
+        std::sort(chunk.raw_vertices.begin(), chunk.raw_vertices.end());
+        chunk.raw_vertices.erase(
+            std::unique(chunk.raw_vertices.begin(), chunk.raw_vertices.end()),
+            chunk.raw_vertices.end());
+        raw_vertices.insert(raw_vertices.end(), chunk.raw_vertices.begin(), chunk.raw_vertices.end());
+        std::vector<int>().swap(chunk.raw_vertices);
+    }
+    if (raw_vertices.empty()) {
+        std::cerr << "Error: temporal graph has no vertex endpoint.\n";
+        return false;
+    }
+    std::sort(raw_vertices.begin(), raw_vertices.end());
+    raw_vertices.erase(
+        std::unique(raw_vertices.begin(), raw_vertices.end()), raw_vertices.end());
+    return true;
+}
+
+// Labels 1-5 for the sorted active_vertices, drawn in raw_vertices order.
+inline bool assignSeededLabels(
+    const std::vector<int>& raw_vertices,
+    const std::vector<int>& active_vertices,
+    std::uint32_t seed,
+    std::vector<int>& labels) {
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> distribution(1, kLabelCount);
+    std::vector<int> raw_labels(raw_vertices.size());
+    for (int& label : raw_labels) label = distribution(generator);
+    labels.clear();
+    labels.reserve(active_vertices.size());
+    std::size_t raw_index = 0;
+    for (int active_id : active_vertices) {
+        while (raw_index < raw_vertices.size() && raw_vertices[raw_index] < active_id) {
+            ++raw_index;
+        }
+        if (raw_index >= raw_vertices.size() || raw_vertices[raw_index] != active_id) {
+            std::cerr << "Error: active vertex is absent from the raw label universe.\n";
+            return false;
+        }
+        labels.push_back(raw_labels[raw_index]);
+    }
+    return true;
+}
+
+inline bool readQuery(
+    const std::string& path,
+    std::vector<int>& labels,
+    std::vector<DirectedEdge>& edges) {
+    std::ifstream input(path);
+    if (!input) {
+        std::cerr << "Error: cannot open query graph: " << path << '\n';
+        return false;
+    }
+
+    std::unordered_map<std::string, int> vertex_ids;
+    std::string line;
+    int line_number = 0;
+    while (std::getline(input, line)) {
+        ++line_number;
+        const std::size_t comment = line.find('#');
+        if (comment != std::string::npos) line.resize(comment);
+        std::istringstream parser(line);
+        std::string from_text;
+        std::string to_text;
+        std::string extra;
+        if (!(parser >> from_text)) continue;
+        if (!(parser >> to_text) || (parser >> extra)) {
+            std::cerr << "Error: query line " << line_number
+                      << " must contain exactly two vertex tokens.\n";
+            return false;
+        }
+
+        QueryVertexToken from_token;
+        QueryVertexToken to_token;
+        if (!parseQueryVertex(from_text, from_token) ||
+            !parseQueryVertex(to_text, to_token)) {
+            std::cerr << "Error: query labels must be A-E; use id:A for repeated labels.\n";
+            return false;
+        }
+
+        auto intern = [&](const QueryVertexToken& token) -> int {
+            const auto found = vertex_ids.find(token.identity);
+            if (found != vertex_ids.end()) {
+                if (labels[static_cast<std::size_t>(found->second)] != token.label) return -1;
+                return found->second;
+            }
+            const int id = static_cast<int>(labels.size());
+            vertex_ids.emplace(token.identity, id);
+            labels.push_back(token.label);
+            return id;
+        };
+
+        const int from_id = intern(from_token);
+        const int to_id = intern(to_token);
+        if (from_id < 0 || to_id < 0) {
+            std::cerr << "Error: a query vertex identity was assigned conflicting labels.\n";
+            return false;
+        }
+        if (from_id == to_id) {
+            std::cerr << "Error: query self-loops are not supported.\n";
+            return false;
+        }
+        edges.push_back({from_id, to_id});
+    }
+    if (edges.empty()) {
+        std::cerr << "Error: query graph has no edge.\n";
+        return false;
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+    return true;
+}
+
+} // namespace temporal_input
+
+#endif
@@ -54,6 +54,8 @@ with TurboISO, and finally verify each answer according to the real graph restri
 #include <windows.h>
 #include <synchapi.h>
 #include <psapi.h>
+#else
+#include <sys/mman.h>
 #endif
 
 //NOTICE:below are restricted to C++, C files should not include(maybe nested) this header!
@@ -112,6 +114,8 @@ with TurboISO, and finally verify each answer according to the real graph restri
 //#include <type_traits>
 
 #include "Graph.h"
+#include "binary_graph.h"
+#include "temporal_input.h"
 
 using namespace std;
 
@@ -542,6 +546,11 @@ public:
 			readNativeGraph(fp, false, record, "data");
 		if(status != NativeParseStatus::Loaded)
 			return status;
+		return loadRecord(record) ? NativeParseStatus::Loaded : NativeParseStatus::Error;
+	}
+
+	bool loadRecord(const NativeGraphRecord& record)
+	{
 		try
 		{
 			this->numVertex = record.vertex_count;
@@ -567,7 +576,7 @@ public:
 		catch(const bad_alloc&)
 		{
 			cerr << "Error: cannot allocate data graph.\n";
-			return NativeParseStatus::Error;
+			return false;
 		}
 		//char buffer[1024];
 		//if(fgets(buffer, 1024, fp) != NULL)
@@ -613,7 +622,56 @@ public:
 			//}
 		//}
 		this->transform();
-		return NativeParseStatus::Loaded;
+		return true;
+	}
+
+	//build G' from a mapped binary_graph.h file; nothing is parsed
+	bool loadBinary(const unsigned char* data, std::size_t size)
+	{
+		binary_graph::View view;
+		string error;
+		if(!binary_graph::open(data, size, view, error))
+		{
+			cerr << "Error: " << error << ".\n";
+			return false;
+		}
+		try
+		{
+			this->numVertex = static_cast<int>(view.vertex_count);
+			this->LabelNum = static_cast<int>(view.label_count);
+			vList = new vector<int>[numVertex];
+			labelList = new vector<int>[LabelNum + 1];
+			graList = new vector<labelVlist>[numVertex];
+			this->real_graph = new DGraph;
+			vector<Vertex>& vertices = this->real_graph->vertices;
+			vertices.resize(static_cast<std::size_t>(numVertex));
+			vector <std::uint32_t> in_degree(view.vertex_count, 0);
+			for(std::uint64_t arc = 0; arc < view.arc_count; ++arc)
+				++in_degree[view.target(arc)];
+			for(std::uint32_t v = 0; v < view.vertex_count; ++v)
+			{
+				addVertex(static_cast<int>(v), view.label(v));
+				vertices[v].label = view.label(v);
+				vertices[v].out.reserve(view.offset(v + 1) - view.offset(v));
+				vertices[v].in.reserve(in_degree[v]);
+			}
+			for(std::uint32_t v = 0; v < view.vertex_count; ++v)
+			{
+				for(std::uint64_t arc = view.offset(v); arc < view.offset(v + 1); ++arc)
+				{
+					const int to = static_cast<int>(view.target(arc));
+					addEdge(static_cast<int>(v), to);
+					this->real_graph->addEdge(static_cast<int>(v), to, 1);
+				}
+			}
+		}
+		catch(const bad_alloc&)
+		{
+			cerr << "Error: cannot allocate data graph.\n";
+			return false;
+		}
+		this->transform();
+		return true;
 	}
 };
 
@@ -736,6 +794,11 @@ public:
 			readNativeGraph(fp, true, record, "query");
 		if(status != NativeParseStatus::Loaded)
 			return status;
+		return loadRecord(record) ? NativeParseStatus::Loaded : NativeParseStatus::Error;
+	}
+
+	bool loadRecord(const NativeGraphRecord& record)
+	{
 		try
 		{
 			this->numVertex = record.vertex_count;
@@ -760,7 +823,7 @@ public:
 		catch(const bad_alloc&)
 		{
 			cerr << "Error: cannot allocate query graph.\n";
-			return NativeParseStatus::Error;
+			return false;
 		}
 		//char buffer[1024];
 		//if(fgets(buffer, 1024, fp) != NULL)
@@ -787,7 +850,7 @@ public:
 			//}
 		//}
 		this->transform();
-		return NativeParseStatus::Loaded;
+		return true;
 	}
 };
 
@@ -806,27 +869,395 @@ public:
 	}
 };
 
+//Candidate regions of one root. CR(u', v) is the candidate list of NEC node u' under
+//its parent's data vertex v. All lists live in one bump-allocated pool that init()
+//resets for the next region without freeing, so a thread allocates only while its
+//regions grow. ExploreCR fills the per-node entries; seal() then copies them, sorted
+//by parent, into offset arrays for binary-searched lookups during the search.
 class CRTree
 {
 public:
-	vector <vector <int> > *CR;	 //the real data vertices of CRTree
-	vector <int> *parent;			//parent nodes: each query node u has a set of parent nodes v (data nodes)   CR(uprime,v) of vprimes
+	struct Entry
+	{
+		int parent;
+		int begin;		//CR(u', parent) is pool[begin..end), ascending
+		int end;
+	};
 
 	void init(int num)
 	{
-		CR = new vector <vector <int> > [num];
-		parent = new vector <int> [num];
+		if(static_cast<int>(entries.size()) < num)
+		{
+			entries.resize(num);
+			scratch.resize(num);
+		}
+		numNode = num;
+		for(int i = 0; i < num; ++i)
+			entries[i].clear();
+		pool.clear();
+		sealed.clear();
+		node_offsets.assign(num + 1, 0);
 	}
 
-	~CRTree()
+	//candidates of u' collected by the ExploreCR call in progress for u'
+	vector <int>& collecting(int u_prime)
 	{
-		if(CR != NULL)
-			delete []CR;
-		if(parent != NULL)
-			delete []parent;
+		return scratch[u_prime];
 	}
+
+	//merge the collected candidates into CR(u', parent); returns its size
+	int commit(int u_prime, int parent)
+	{
+		vector <int>& found = scratch[u_prime];
+		vector <Entry>& list = entries[u_prime];
+		int pos = find(u_prime, parent);
+		if(pos == -1)
+		{
+			if(found.empty())
+				return 0;
+			list.push_back({parent, static_cast<int>(pool.size()), static_cast<int>(pool.size() + found.size())});
+			pool.insert(pool.end(), found.begin(), found.end());
+			found.clear();
+			return list.back().end - list.back().begin;
+		}
+		Entry& entry = list[pos];
+		if(!found.empty())
+		{
+			//a data vertex reached again under another grandparent: the union goes to
+			//the end of the pool and the old range is left until the next init()
+			const std::size_t old_size = pool.size();
+			pool.resize(old_size + (entry.end - entry.begin) + found.size());
+			int* last = set_union(pool.data() + entry.begin, pool.data() + entry.end,
+				found.data(), found.data() + found.size(), pool.data() + old_size);
+			pool.resize(last - pool.data());
+			entry.begin = static_cast<int>(old_size);
+			entry.end = static_cast<int>(pool.size());
+			found.clear();
+		}
+		return entry.end - entry.begin;
+	}
+
+	int find(int u_prime, int parent) const
+	{
+		const vector <Entry>& list = entries[u_prime];
+		for(std::size_t i = 0; i < list.size(); ++i)
+			if(list[i].parent == parent)
+				return static_cast<int>(i);
+		return -1;
+	}
+
+	void clear(int u_prime, int parent)
+	{
+		int pos = find(u_prime, parent);
+		if(pos != -1)
+			entries[u_prime].erase(entries[u_prime].begin() + pos);
+	}
+
+	void seal()
+	{
+		sealed.clear();
+		for(int u = 0; u < numNode; ++u)
+		{
+			node_offsets[u] = static_cast<int>(sealed.size());
+			sealed.insert(sealed.end(), entries[u].begin(), entries[u].end());
+			sort(sealed.begin() + node_offsets[u], sealed.end(),
+				[](const Entry& a, const Entry& b) { return a.parent < b.parent; });
+		}
+		node_offsets[numNode] = static_cast<int>(sealed.size());
+	}
+
+	//after seal(): the sealed entries of u'
+	int parentNum(int u_prime) const
+	{
+		return node_offsets[u_prime + 1] - node_offsets[u_prime];
+	}
+
+	const Entry& entry(int u_prime, int i) const
+	{
+		return sealed[node_offsets[u_prime] + i];
+	}
+
+	//after seal(): CR(u', parent), or NULL when parent has no region under u'
+	const Entry* lookup(int u_prime, int parent) const
+	{
+		const Entry* first = sealed.data() + node_offsets[u_prime];
+		const Entry* last = sealed.data() + node_offsets[u_prime + 1];
+		const Entry* it = lower_bound(first, last, parent,
+			[](const Entry& e, int value) { return e.parent < value; });
+		if(it == last || it->parent != parent)
+			return NULL;
+		return it;
+	}
+
+	const int* begin(const Entry* e) const
+	{
+		return pool.data() + e->begin;
+	}
+
+	const int* end(const Entry* e) const
+	{
+		return pool.data() + e->end;
+	}
+
+private:
+	int numNode = 0;
+	vector <vector <Entry> > entries;
+	vector <vector <int> > scratch;
+	vector <int> pool;
+	vector <Entry> sealed;
+	vector <int> node_offsets;
 };
 
+//A read-only memory map of a whole file
+class MappedFile
+{
+public:
+	MappedFile()
+	{
+		bytes = NULL;
+		length = 0;
+#ifdef _WIN32
+		file = INVALID_HANDLE_VALUE;
+		mapping = NULL;
+#endif
+	}
+
+	~MappedFile()
+	{
+		close();
+	}
+
+	//releases the mapping; safe to call more than once
+	void close()
+	{
+#ifdef _WIN32
+		if(bytes != NULL)
+			UnmapViewOfFile(bytes);
+		if(mapping != NULL)
+			CloseHandle(mapping);
+		if(file != INVALID_HANDLE_VALUE)
+			CloseHandle(file);
+		mapping = NULL;
+		file = INVALID_HANDLE_VALUE;
+#else
+		if(bytes != NULL)
+			munmap(const_cast<unsigned char*>(bytes), length);
+#endif
+		bytes = NULL;
+		length = 0;
+	}
+
+	//false for a missing, unreadable or empty file
+	bool open(const char* path)
+	{
+#ifdef _WIN32
+		file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if(file == INVALID_HANDLE_VALUE)
+			return false;
+		LARGE_INTEGER file_size;
+		if(!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+			return false;
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if(mapping == NULL)
+			return false;
+		bytes = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		if(bytes == NULL)
+			return false;
+		length = static_cast<std::size_t>(file_size.QuadPart);
+		return true;
+#else
+		int fd = ::open(path, O_RDONLY);
+		if(fd < 0)
+			return false;
+		struct stat st;
+		if(fstat(fd, &st) != 0 || st.st_size <= 0)
+		{
+			::close(fd);
+			return false;
+		}
+		void* mapped = mmap(NULL, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+		if(mapped == MAP_FAILED)
+			return false;
+		bytes = static_cast<const unsigned char*>(mapped);
+		length = static_cast<std::size_t>(st.st_size);
+		return true;
+#endif
+	}
+
+	const unsigned char* data() const
+	{
+		return bytes;
+	}
+
+	std::size_t size() const
+	{
+		return length;
+	}
+
+private:
+	const unsigned char* bytes;
+	std::size_t length;
+#ifdef _WIN32
+	HANDLE file;
+	HANDLE mapping;
+#endif
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+};
+
+//A maximal run of consecutive snapshots [start, end] of one ordered data pair
+struct DurableInterval
+{
+	long long start;
+	long long end;
+
+	long long length() const
+	{
+		return end >= start ? end - start + 1 : 0;
+	}
+};
+
+//The runs of every durable arc of G': arcs out of u are targets[offsets[u]..offsets[u+1]),
+//sorted ascending, and the runs of arc e are intervals[interval_offsets[e]..interval_offsets[e+1])
+class TemporalArcs
+{
+public:
+	vector <int> offsets;
+	vector <int> targets;
+	vector <std::size_t> interval_offsets;
+	vector <DurableInterval> intervals;
+
+	//false when from -> to is not a durable arc
+	bool find(int from, int to, const DurableInterval*& first, const DurableInterval*& last) const
+	{
+		const int* begin = targets.data() + offsets[from];
+		const int* end = targets.data() + offsets[from + 1];
+		const int* it = lower_bound(begin, end, to);
+		if(it == end || *it != to)
+			return false;
+		const std::size_t arc = static_cast<std::size_t>(it - targets.data());
+		first = intervals.data() + interval_offsets[arc];
+		last = intervals.data() + interval_offsets[arc + 1];
+		return true;
+	}
+};
+
+//out = lhs intersected with [first, last), keeping only overlaps of at least k snapshots;
+//shorter overlaps are dropped because later intersections cannot lengthen them
+void intersectDurable(const vector <DurableInterval>& lhs, const DurableInterval* first,
+	const DurableInterval* last, long long k, vector <DurableInterval>& out)
+{
+	out.clear();
+	std::size_t i = 0;
+	while(i < lhs.size() && first != last)
+	{
+		const long long start = max(lhs[i].start, first->start);
+		const long long end = min(lhs[i].end, first->end);
+		if(end - start + 1 >= k)
+			out.push_back({start, end});
+		if(lhs[i].end < first->end)
+			++i;
+		else
+			++first;
+	}
+}
+
+//Build G', Q and the durable arc runs straight from `src dst timestamp` triples and an
+//`A B` query file. Repeated timestamps of an ordered pair collapse into maximal runs, and
+//only pairs with a run of at least k snapshots become arcs of G', so ExploreCR never
+//expands a candidate region over a non-durable edge. Labels are the seeded A-E labels
+//of turbo_convert.exe, drawn over the whole raw vertex universe.
+bool loadDurableInput(const string& temporal_path, const string& query_path, int k,
+	std::uint32_t seed, unsigned threads, Graph& g, Query& q, TemporalArcs& arcs)
+{
+	vector <temporal_input::TemporalTriple> triples;
+	vector <int> raw_vertices;
+	if(!temporal_input::readTemporalTriples(temporal_path, threads, triples, raw_vertices))
+		return false;
+	sort(triples.begin(), triples.end());
+
+	vector <temporal_input::DirectedEdge> durable_pairs;
+	vector <std::size_t> pair_offsets(1, 0);
+	vector <DurableInterval> runs;
+	for(std::size_t i = 0; i < triples.size();)
+	{
+		const int from = triples[i].from, to = triples[i].to;
+		const std::size_t first_run = runs.size();
+		bool durable = false;
+		for(; i < triples.size() && triples[i].from == from && triples[i].to == to; ++i)
+		{
+			const long long t = triples[i].timestamp;
+			if(runs.size() > first_run && t <= runs.back().end + 1)
+				runs.back().end = max(runs.back().end, t);
+			else
+				runs.push_back({t, t});
+			durable = durable || runs.back().length() >= k;
+		}
+		if(durable)
+		{
+			durable_pairs.push_back({from, to});
+			pair_offsets.push_back(runs.size());
+		}
+		else
+			runs.resize(first_run);
+	}
+	vector <temporal_input::TemporalTriple>().swap(triples);
+
+	vector <int> active_vertices;
+	active_vertices.reserve(durable_pairs.size() * 2);
+	for(const temporal_input::DirectedEdge& edge : durable_pairs)
+	{
+		active_vertices.push_back(edge.from);
+		active_vertices.push_back(edge.to);
+	}
+	sort(active_vertices.begin(), active_vertices.end());
+	active_vertices.erase(unique(active_vertices.begin(), active_vertices.end()), active_vertices.end());
+	vector <int> labels;
+	if(!temporal_input::assignSeededLabels(raw_vertices, active_vertices, seed, labels))
+		return false;
+
+	//durable_pairs is sorted by external ids and the compaction is monotone,
+	//so the CSR rows come out grouped by source with ascending targets
+	NativeGraphRecord data;
+	data.vertex_count = static_cast<int>(active_vertices.size());
+	data.edge_count = static_cast<int>(durable_pairs.size());
+	data.vertex_label_count = temporal_input::kLabelCount;
+	for(int label : labels)
+		data.vertex_labels.push_back(vector<int>(1, label));
+	arcs.offsets.assign(active_vertices.size() + 1, 0);
+	arcs.targets.reserve(durable_pairs.size());
+	auto compact = [&](int id) {
+		return static_cast<int>(lower_bound(active_vertices.begin(), active_vertices.end(), id) - active_vertices.begin());
+	};
+	for(const temporal_input::DirectedEdge& edge : durable_pairs)
+	{
+		const int from = compact(edge.from), to = compact(edge.to);
+		data.edges.push_back({from, to, 1});
+		++arcs.offsets[from + 1];
+		arcs.targets.push_back(to);
+	}
+	for(std::size_t i = 0; i < active_vertices.size(); ++i)
+		arcs.offsets[i + 1] += arcs.offsets[i];
+	arcs.interval_offsets.swap(pair_offsets);
+	arcs.intervals.swap(runs);
+
+	vector <int> query_labels;
+	vector <temporal_input::DirectedEdge> query_edges;
+	if(!temporal_input::readQuery(query_path, query_labels, query_edges))
+		return false;
+	NativeGraphRecord query;
+	query.vertex_count = static_cast<int>(query_labels.size());
+	query.edge_count = static_cast<int>(query_edges.size());
+	query.vertex_label_count = temporal_input::kLabelCount;
+	for(int label : query_labels)
+		query.vertex_labels.push_back(vector<int>(1, label));
+	for(const temporal_input::DirectedEdge& edge : query_edges)
+		query.edges.push_back({edge.from, edge.to, 1});
+
+	return g.loadRecord(data) && q.loadRecord(query);
+}
+
 string int2string(long n)
 {
     string s;
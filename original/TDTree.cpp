@@ -6,13 +6,94 @@
 #include <functional>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <limits>
 #include <unordered_map>
 
+namespace {
+
+// Embeddings of a query subtree grouped by the common interval set of their
+// arcs. unconstrained marks the single class of a subtree without arcs.
+struct IntervalClass {
+    std::vector<TimeInterval> intervals;
+    bool unconstrained = false;
+    std::uint64_t count = 0;
+};
+
+// Search nodes between two deadline checks; a power of two.
+constexpr std::uint64_t kDeadlineCheckInterval = 1024;
+
+// Larger class lists make factorized counting slower than enumeration.
+constexpr std::size_t kMaxIntervalClasses = 4096;
+
+bool intervalsLess(const std::vector<TimeInterval>& lhs, const std::vector<TimeInterval>& rhs) {
+    return std::lexicographical_compare(
+        lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+        [](const TimeInterval& left, const TimeInterval& right) {
+            if (left.start != right.start) return left.start < right.start;
+            return left.end < right.end;
+        });
+}
+
+bool intervalsEqual(const std::vector<TimeInterval>& lhs, const std::vector<TimeInterval>& rhs) {
+    return std::equal(
+        lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+        [](const TimeInterval& left, const TimeInterval& right) {
+            return left.start == right.start && left.end == right.end;
+        });
+}
+
+bool checkedAdd(std::uint64_t& total, std::uint64_t value) {
+    if (total > std::numeric_limits<std::uint64_t>::max() - value) return false;
+    total += value;
+    return true;
+}
+
+bool checkedMultiply(std::uint64_t lhs, std::uint64_t rhs, std::uint64_t& product) {
+    if (lhs != 0 && rhs > std::numeric_limits<std::uint64_t>::max() / lhs) return false;
+    product = lhs * rhs;
+    return true;
+}
+
+// Sort classes by interval set and add the counts of equal sets. Returns
+// false on count overflow or when too many distinct sets remain.
+bool mergeIntervalClasses(std::vector<IntervalClass>& classes) {
+    std::sort(classes.begin(), classes.end(), [](const IntervalClass& lhs, const IntervalClass& rhs) {
+        return intervalsLess(lhs.intervals, rhs.intervals);
+    });
+    std::size_t merged = 0;
+    for (std::size_t i = 0; i < classes.size(); ++i) {
+        if (merged > 0 && intervalsEqual(classes[merged - 1].intervals, classes[i].intervals)) {
+            if (!checkedAdd(classes[merged - 1].count, classes[i].count)) return false;
+        } else {
+            if (merged != i) classes[merged] = std::move(classes[i]);
+            ++merged;
+        }
+    }
+    classes.resize(merged);
+    return classes.size() <= kMaxIntervalClasses;
+}
+
+} // namespace
+
 const char* matchOutputModeName(MatchOutputMode mode) {
     return mode == MatchOutputMode::CountOnly ? "count-only" : "full";
 }
 
+const char* matchStopReasonName(MatchStopReason reason) {
+    switch (reason) {
+    case MatchStopReason::ResultLimit:
+        return "result-limit";
+    case MatchStopReason::Exists:
+        return "exists";
+    case MatchStopReason::TimeLimit:
+        return "time-limit";
+    case MatchStopReason::Complete:
+        break;
+    }
+    return "complete";
+}
+
 bool CheckedMatchCounter::increment() {
     if (value == std::numeric_limits<std::uint64_t>::max()) {
         overflowed = true;
@@ -399,10 +480,225 @@ void TDTree::print_res() const {
     }
 }
 
+bool TDTree::countFactorized(CheckedMatchCounter& match_counter) const {
+    match_counter = {};
+    if (QD.root < 0 || !QD.connected || !QD.non_tree_edges.empty()) return false;
+    // A query without arcs has no interval constraint to count by; its
+    // matches are bounded by vertex durations, which enumeration checks.
+    if (Q.num_vertices < 2) return false;
+
+    // A subtree is independent when no query vertex outside it shares one of
+    // its labels. Its embeddings can then never reuse a data vertex mapped
+    // outside it, and without non-tree arcs they only depend on the parent's
+    // mapping, so they are summarized once per parent data vertex and
+    // multiplied into the rest as counts per class of interval sets.
+    const std::size_t query_count = static_cast<std::size_t>(Q.num_vertices);
+    std::vector<std::array<int, kLabelCount>> subtree_labels(query_count);
+    for (auto it = QD.dfs_order.rbegin(); it != QD.dfs_order.rend(); ++it) {
+        const std::size_t query_vertex = static_cast<std::size_t>(*it);
+        const Label label = Q.vertex_labels[query_vertex];
+        if (label >= kLabelCount) return false;
+        ++subtree_labels[query_vertex][label];
+        if (QD.parent[query_vertex] >= 0) {
+            auto& parent_labels = subtree_labels[static_cast<std::size_t>(QD.parent[query_vertex])];
+            for (std::size_t l = 0; l < kLabelCount; ++l) {
+                parent_labels[l] += subtree_labels[query_vertex][l];
+            }
+        }
+    }
+    const auto& query_labels = subtree_labels[static_cast<std::size_t>(QD.root)];
+    std::vector<bool> independent(query_count, false);
+    bool factors = false;
+    for (std::size_t query_vertex = 0; query_vertex < query_count; ++query_vertex) {
+        independent[query_vertex] = true;
+        for (std::size_t l = 0; l < kLabelCount; ++l) {
+            const int inside = subtree_labels[query_vertex][l];
+            if (inside != 0 && inside != query_labels[l]) independent[query_vertex] = false;
+        }
+        factors = factors || (independent[query_vertex] && static_cast<int>(query_vertex) != QD.root);
+    }
+    // With no independent subtree below the root, the count would be a
+    // plain enumeration.
+    if (!factors) return false;
+
+    // The region of an independent vertex: itself and the vertices below it
+    // up to the next independent subtrees, parents first. Regions are
+    // enumerated injectively; the independent children hanging off them are
+    // multiplied in.
+    std::vector<std::vector<int>> regions(query_count);
+    for (std::size_t query_vertex = 0; query_vertex < query_count; ++query_vertex) {
+        if (!independent[query_vertex]) continue;
+        auto& region = regions[query_vertex];
+        region.push_back(static_cast<int>(query_vertex));
+        for (std::size_t next = 0; next < region.size(); ++next) {
+            for (int child : QD.spanning_tree_adj[static_cast<std::size_t>(region[next])]) {
+                if (!independent[static_cast<std::size_t>(child)]) region.push_back(child);
+            }
+        }
+    }
+
+    // Common intervals of the tree arcs between parent and child, at least k long.
+    std::vector<TimeInterval> arc_intervals;
+    auto tree_arc_intervals = [&](int parent, int parent_data, int child, int child_data) {
+        arc_intervals.clear();
+        bool has_arc_intervals = false;
+        auto apply_arc = [&](int source, int target) {
+            const TemporalEdge* temporal_edge = G.findTemporalEdge(source, target);
+            if (temporal_edge == nullptr) return false;
+            if (!has_arc_intervals) {
+                for (const auto& interval : temporal_edge->active_intervals) {
+                    if (interval.length() >= k_threshold) arc_intervals.push_back(interval);
+                }
+                has_arc_intervals = true;
+            } else {
+                arc_intervals = intersectTimeIntervals(
+                    arc_intervals, temporal_edge->active_intervals, k_threshold);
+            }
+            return !arc_intervals.empty();
+        };
+        return !(GraphUtils::hasEdge(Q.adj, parent, child) && !apply_arc(parent_data, child_data)) &&
+            !(GraphUtils::hasEdge(Q.adj, child, parent) && !apply_arc(child_data, parent_data));
+    };
+
+    std::vector<std::unordered_map<int, std::vector<IntervalClass>>> subtree_classes(query_count);
+    std::vector<std::unordered_map<int, std::vector<IntervalClass>>> attached_classes(query_count);
+    std::function<const std::vector<IntervalClass>*(int, int)> count_subtree;
+
+    // Classes of the independent subtree of child, arcs to its parent's
+    // data vertex included.
+    auto count_attached = [&](int child, int parent_data) -> const std::vector<IntervalClass>* {
+        auto& memo = attached_classes[static_cast<std::size_t>(child)];
+        const auto found = memo.find(parent_data);
+        if (found != memo.end()) return &found->second;
+
+        std::vector<IntervalClass> child_classes;
+        const TDTreeBlock* block = nodes[static_cast<std::size_t>(child)].findBlock(parent_data);
+        if (block != nullptr) {
+            const int parent = QD.parent[static_cast<std::size_t>(child)];
+            for (int candidate : block->V_cand) {
+                if (!tree_arc_intervals(parent, parent_data, child, candidate)) continue;
+                const std::vector<TimeInterval> candidate_intervals = arc_intervals;
+                const std::vector<IntervalClass>* below = count_subtree(child, candidate);
+                if (below == nullptr) return nullptr;
+                for (const auto& entry : *below) {
+                    auto intervals = entry.unconstrained
+                        ? candidate_intervals
+                        : intersectTimeIntervals(entry.intervals, candidate_intervals, k_threshold);
+                    if (!intervals.empty()) {
+                        child_classes.push_back({std::move(intervals), false, entry.count});
+                    }
+                }
+            }
+        }
+        if (!mergeIntervalClasses(child_classes)) return nullptr;
+        return &memo.emplace(parent_data, std::move(child_classes)).first->second;
+    };
+
+    count_subtree = [&](int query_vertex, int data_vertex) -> const std::vector<IntervalClass>* {
+        auto& memo = subtree_classes[static_cast<std::size_t>(query_vertex)];
+        const auto found = memo.find(data_vertex);
+        if (found != memo.end()) return &found->second;
+
+        const std::vector<int>& region = regions[static_cast<std::size_t>(query_vertex)];
+        std::vector<int> region_mapping(region.size(), -1);
+        region_mapping[0] = data_vertex;
+        // common_intervals[i]: the region arcs up to region[i], from i = 1.
+        std::vector<std::vector<TimeInterval>> common_intervals(region.size());
+        std::vector<IntervalClass> classes;
+
+        // Multiplies the independent children of a complete region mapping.
+        auto add_region_match = [&]() {
+            std::vector<IntervalClass> combined{
+                {region.size() > 1 ? common_intervals.back() : std::vector<TimeInterval>{},
+                 region.size() == 1, 1}};
+            for (std::size_t i = 0; i < region.size() && !combined.empty(); ++i) {
+                for (int child : QD.spanning_tree_adj[static_cast<std::size_t>(region[i])]) {
+                    if (!independent[static_cast<std::size_t>(child)]) continue;
+                    const std::vector<IntervalClass>* child_classes =
+                        count_attached(child, region_mapping[i]);
+                    if (child_classes == nullptr) return false;
+
+                    std::vector<IntervalClass> product;
+                    for (const auto& lhs : combined) {
+                        for (const auto& rhs : *child_classes) {
+                            auto intervals = lhs.unconstrained
+                                ? rhs.intervals
+                                : intersectTimeIntervals(lhs.intervals, rhs.intervals, k_threshold);
+                            if (intervals.empty()) continue;
+                            std::uint64_t count = 0;
+                            if (!checkedMultiply(lhs.count, rhs.count, count)) return false;
+                            product.push_back({std::move(intervals), false, count});
+                        }
+                    }
+                    if (!mergeIntervalClasses(product)) return false;
+                    combined.swap(product);
+                    if (combined.empty()) break;
+                }
+            }
+            classes.insert(classes.end(),
+                std::make_move_iterator(combined.begin()), std::make_move_iterator(combined.end()));
+            return classes.size() <= kMaxIntervalClasses || mergeIntervalClasses(classes);
+        };
+
+        std::function<bool(std::size_t)> place_region;
+        place_region = [&](std::size_t index) {
+            if (index == region.size()) return add_region_match();
+            const int region_vertex = region[index];
+            const int parent = QD.parent[static_cast<std::size_t>(region_vertex)];
+            const std::size_t parent_index = static_cast<std::size_t>(
+                std::find(region.begin(), region.begin() + static_cast<std::ptrdiff_t>(index), parent) -
+                region.begin());
+            const int parent_data = region_mapping[parent_index];
+            const TDTreeBlock* block =
+                nodes[static_cast<std::size_t>(region_vertex)].findBlock(parent_data);
+            if (block == nullptr) return true;
+            for (int candidate : block->V_cand) {
+                if (std::find(region_mapping.begin(),
+                              region_mapping.begin() + static_cast<std::ptrdiff_t>(index),
+                              candidate) != region_mapping.begin() + static_cast<std::ptrdiff_t>(index) ||
+                    !tree_arc_intervals(parent, parent_data, region_vertex, candidate)) {
+                    continue;
+                }
+                common_intervals[index] = index == 1
+                    ? arc_intervals
+                    : intersectTimeIntervals(common_intervals[index - 1], arc_intervals, k_threshold);
+                if (common_intervals[index].empty()) continue;
+                region_mapping[index] = candidate;
+                if (!place_region(index + 1)) return false;
+            }
+            region_mapping[index] = -1;
+            return true;
+        };
+        if (!place_region(1) || !mergeIntervalClasses(classes)) return nullptr;
+        return &memo.emplace(data_vertex, std::move(classes)).first->second;
+    };
+
+    // Root classes hold complete matches, so only this final sum can prove
+    // that the exact count exceeds uint64_t. Overflow in a subtree product
+    // falls back to enumeration, which reports overflow itself if it occurs.
+    std::uint64_t total = 0;
+    for (int root_candidate : nodes[static_cast<std::size_t>(QD.root)].root_candidates) {
+        const std::vector<IntervalClass>* classes = count_subtree(QD.root, root_candidate);
+        if (classes == nullptr) return false;
+        for (const auto& entry : *classes) {
+            if (!entry.unconstrained && !checkedAdd(total, entry.count)) {
+                match_counter.value = std::numeric_limits<std::uint64_t>::max();
+                match_counter.overflowed = true;
+                return true;
+            }
+        }
+    }
+    match_counter.value = total;
+    return true;
+}
+
 CheckedMatchCounter TDTree::enumerateMatches(
     std::ostream& output,
-    MatchOutputMode mode) const {
+    MatchOutputMode mode,
+    const MatchLimits& limits,
+    MatchStopReason& stop_reason) const {
     CheckedMatchCounter match_counter;
+    stop_reason = MatchStopReason::Complete;
     if (QD.root < 0 || !QD.connected || QD.dfs_order.empty()) {
         return match_counter;
     }
@@ -410,11 +706,32 @@ CheckedMatchCounter TDTree::enumerateMatches(
     std::vector<int> mapping(static_cast<std::size_t>(Q.num_vertices), -1);
     std::vector<std::uint8_t> used_data_vertices(static_cast<std::size_t>(G.num_vertices), 0);
 
+    // Overflow and every limit stop the search the same way. The clock is
+    // read only once per kDeadlineCheckInterval search nodes.
+    const auto deadline = std::chrono::steady_clock::now() +
+        std::chrono::seconds(limits.time_limit_seconds);
+    std::uint64_t search_nodes = 0;
+    auto halted = [&]() {
+        if (match_counter.overflowed || stop_reason != MatchStopReason::Complete) return true;
+        if (limits.time_limit_seconds > 0 &&
+            (++search_nodes & (kDeadlineCheckInterval - 1)) == 0 &&
+            std::chrono::steady_clock::now() >= deadline) {
+            stop_reason = MatchStopReason::TimeLimit;
+        }
+        return stop_reason != MatchStopReason::Complete;
+    };
+
     std::function<void(std::size_t, const std::vector<TimeInterval>&, bool)> dfs;
     dfs = [&](std::size_t depth, const std::vector<TimeInterval>& current_intervals, bool has_intervals) {
-        if (match_counter.overflowed) return;
+        if (halted()) return;
         if (depth >= QD.dfs_order.size()) {
+            if (limits.max_results > 0 && match_counter.value >= limits.max_results) {
+                // Only a further match proves that the output is truncated.
+                stop_reason = MatchStopReason::ResultLimit;
+                return;
+            }
             if (!match_counter.increment()) return;
+            if (limits.exists_only) stop_reason = MatchStopReason::Exists;
             if (mode == MatchOutputMode::Full) {
                 output << "Match " << (match_counter.value - 1) << ": ";
                 for (int query_vertex = 0; query_vertex < Q.num_vertices; ++query_vertex) {
@@ -497,7 +814,7 @@ CheckedMatchCounter TDTree::enumerateMatches(
             dfs(depth + 1, next_intervals, next_has_intervals);
             used_data_vertices[static_cast<std::size_t>(candidate)] = 0;
             mapping[static_cast<std::size_t>(query_vertex)] = -1;
-            if (match_counter.overflowed) return;
+            if (match_counter.overflowed || stop_reason != MatchStopReason::Complete) return;
         }
     };
 
@@ -522,14 +839,15 @@ CheckedMatchCounter TDTree::enumerateMatches(
         dfs(1, root_intervals, root_has_intervals);
         used_data_vertices[static_cast<std::size_t>(root_candidate)] = 0;
         mapping[static_cast<std::size_t>(QD.root)] = -1;
-        if (match_counter.overflowed) break;
+        if (match_counter.overflowed || stop_reason != MatchStopReason::Complete) break;
     }
     return match_counter;
 }
 
 MatchSummary TDTree::save_res(
     const std::string& filename,
-    MatchOutputMode mode) const {
+    MatchOutputMode mode,
+    const MatchLimits& limits) const {
     MatchSummary summary;
     // Binary mode keeps tellp/seekp offsets stable on Windows (text mode
     // translates '\n' to CRLF and would corrupt the count placeholder).
@@ -559,7 +877,12 @@ MatchSummary TDTree::save_res(
     output << std::setw(20) << 0 << '\n';
 
     const auto start = std::chrono::steady_clock::now();
-    const CheckedMatchCounter counter = enumerateMatches(output, mode);
+    CheckedMatchCounter counter;
+    if (mode == MatchOutputMode::CountOnly && !limits.active() && countFactorized(counter)) {
+        summary.factorized_count = true;
+    } else {
+        counter = enumerateMatches(output, mode, limits, summary.stop_reason);
+    }
     summary.match_count = counter.value;
     summary.count_overflow = counter.overflowed;
     summary.enumeration_milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -573,9 +896,14 @@ MatchSummary TDTree::save_res(
         output << std::setw(20) << summary.match_count;
     }
     output.seekp(end_position);
+    if (summary.stop_reason != MatchStopReason::Complete) {
+        output << "Truncated: " << matchStopReasonName(summary.stop_reason) << '\n';
+    }
     output << "\n[Statistics]\n"
            << "mode: " << matchOutputModeName(mode) << '\n'
            << "count_overflow: " << (summary.count_overflow ? "true" : "false") << '\n'
+           << "count_strategy: " << (summary.factorized_count ? "factorized" : "enumeration") << '\n'
+           << "stop_reason: " << matchStopReasonName(summary.stop_reason) << '\n'
            << "candidate_relation_entries: " << candidateRelationCount() << '\n'
            << "enumeration_ms: " << summary.enumeration_milliseconds << '\n';
     output.flush();
@@ -29,15 +29,44 @@ struct TDTreeNode {
     void rebuildBlockIndex();
 };
 
+enum class MatchStopReason {
+    Complete,
+    // A match beyond max_results was found, so the output is truncated.
+    ResultLimit,
+    // exists_only stopped enumeration at the first match.
+    Exists,
+    TimeLimit
+};
+
+const char* matchStopReasonName(MatchStopReason reason);
+
+struct MatchLimits {
+    // Report at most this many matches; 0 means unlimited.
+    std::uint64_t max_results = 0;
+    bool exists_only = false;
+    // Cooperative enumeration deadline in seconds; 0 disables it.
+    int time_limit_seconds = 0;
+
+    bool active() const {
+        return max_results > 0 || exists_only || time_limit_seconds > 0;
+    }
+};
+
 struct MatchSummary {
     std::uint64_t match_count = 0;
     long long enumeration_milliseconds = 0;
     bool output_written = false;
     bool count_overflow = false;
+    // True when CountOnly was answered without enumerating embeddings.
+    bool factorized_count = false;
+    // Anything but Complete means match_count is a partial count.
+    MatchStopReason stop_reason = MatchStopReason::Complete;
 };
 
 enum class MatchOutputMode {
     Full,
+    // Only the exact count is produced. Tree queries with a subtree whose
+    // labels occur nowhere else are counted by factorization over the blocks.
     CountOnly
 };
 
@@ -61,7 +90,8 @@ public:
     void print_res() const;
     MatchSummary save_res(
         const std::string& filename,
-        MatchOutputMode mode = MatchOutputMode::Full) const;
+        MatchOutputMode mode = MatchOutputMode::Full,
+        const MatchLimits& limits = {}) const;
     std::size_t getMemoryUsage() const;
     std::size_t candidateRelationCount() const;
 
@@ -91,11 +121,15 @@ private:
         const std::vector<int>& order_position,
         const std::vector<std::vector<std::uint8_t>>& candidate_flags) const;
 
+    bool countFactorized(CheckedMatchCounter& match_counter) const;
+
     std::vector<int> uniqueCandidates(const TDTreeNode& node) const;
     std::size_t uniqueCandidateCount(const TDTreeNode& node) const;
     CheckedMatchCounter enumerateMatches(
         std::ostream& output,
-        MatchOutputMode mode) const;
+        MatchOutputMode mode,
+        const MatchLimits& limits,
+        MatchStopReason& stop_reason) const;
 };
 
 #endif // TDTREE_H
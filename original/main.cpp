@@ -40,13 +40,27 @@ long long elapsedMilliseconds(std::chrono::steady_clock::time_point start) {
         std::chrono::steady_clock::now() - start).count();
 }
 
+// Parses a decimal option value without a sign or trailing characters.
+bool parseUnsignedOption(const std::string& text, unsigned long long maximum,
+                         unsigned long long& value) {
+    if (text.empty() || text.front() == '-' || text.front() == '+') return false;
+    try {
+        std::size_t parsed_characters = 0;
+        value = std::stoull(text, &parsed_characters);
+        return parsed_characters == text.size() && value <= maximum;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
     if (argc < 4) {
         std::cerr << "Usage: " << argv[0]
                   << " <Data Graph> <Query Graph> <Minimum Duration k> "
-                     "[Label Seed] [--count-only]\n";
+                     "[Label Seed] [--count-only] [--limit N] [--exists] "
+                     "[--time-limit seconds]\n";
         return 1;
     }
 
@@ -70,8 +84,55 @@ int main(int argc, char* argv[]) {
     std::uint32_t label_seed = kDefaultLabelSeed;
     bool label_seed_seen = false;
     bool count_only = false;
+    MatchLimits match_limits;
+    bool limit_seen = false;
+    bool time_limit_seen = false;
     for (int argument_index = 4; argument_index < argc; ++argument_index) {
         const std::string argument = argv[argument_index];
+        if (argument == "--limit") {
+            unsigned long long parsed_limit = 0;
+            if (limit_seen) {
+                std::cerr << "Error: --limit may be specified only once.\n";
+                return 1;
+            }
+            if (argument_index + 1 >= argc ||
+                !parseUnsignedOption(argv[++argument_index],
+                                     std::numeric_limits<std::uint64_t>::max(), parsed_limit) ||
+                parsed_limit == 0) {
+                std::cerr << "Error: --limit requires a positive integer.\n";
+                return 1;
+            }
+            limit_seen = true;
+            match_limits.max_results = parsed_limit;
+            continue;
+        }
+        if (argument == "--exists") {
+            if (match_limits.exists_only) {
+                std::cerr << "Error: --exists may be specified only once.\n";
+                return 1;
+            }
+            match_limits.exists_only = true;
+            continue;
+        }
+        if (argument == "--time-limit") {
+            unsigned long long parsed_seconds = 0;
+            if (time_limit_seen) {
+                std::cerr << "Error: --time-limit may be specified only once.\n";
+                return 1;
+            }
+            if (argument_index + 1 >= argc ||
+                !parseUnsignedOption(argv[++argument_index],
+                                     static_cast<unsigned long long>(
+                                         std::numeric_limits<int>::max()),
+                                     parsed_seconds)) {
+                std::cerr << "Error: --time-limit requires a non-negative integer "
+                             "number of seconds.\n";
+                return 1;
+            }
+            time_limit_seen = true;
+            match_limits.time_limit_seconds = static_cast<int>(parsed_seconds);
+            continue;
+        }
         if (argument == "--count-only") {
             if (count_only) {
                 std::cerr << "Error: --count-only may be specified only once.\n";
@@ -182,7 +243,7 @@ int main(int argc, char* argv[]) {
 
     const std::string matching_result_file = "matching_results_" + dataset_name + ".txt";
     const MatchSummary match_summary = td_tree.save_res(
-        matching_result_file, output_mode);
+        matching_result_file, output_mode, match_limits);
     if (!match_summary.output_written) {
         std::cerr << "Error: Could not write " << matching_result_file << '\n';
         return 4;
@@ -198,7 +259,10 @@ int main(int argc, char* argv[]) {
     }
     timing_output << "mode: " << matchOutputModeName(output_mode) << '\n'
                   << "count_overflow: "
-                  << (match_summary.count_overflow ? "true" : "false") << '\n';
+                  << (match_summary.count_overflow ? "true" : "false") << '\n'
+                  << "count_strategy: "
+                  << (match_summary.factorized_count ? "factorized" : "enumeration") << '\n'
+                  << "stop_reason: " << matchStopReasonName(match_summary.stop_reason) << '\n';
     const std::array<const char*, 9> timing_order{{
         "readTemporalGraph",
         "preprocessTemporalGraph",
@@ -228,7 +292,11 @@ int main(int argc, char* argv[]) {
                      "without wrapping the count.\n";
         std::cout << "Final durable matches: OVERFLOW\n";
     } else {
-        std::cout << "Final durable matches: " << match_summary.match_count << '\n';
+        std::cout << "Final durable matches: " << match_summary.match_count;
+        if (match_summary.stop_reason != MatchStopReason::Complete) {
+            std::cout << " (truncated: " << matchStopReasonName(match_summary.stop_reason) << ')';
+        }
+        std::cout << '\n';
     }
     std::cout << "Result file: " << matching_result_file << '\n'
               << "Timing file: " << timing_result_file << '\n'
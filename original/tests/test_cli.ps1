@@ -67,6 +67,20 @@ try {
         Invoke-Success ($required + @("--count-only", "42")) `
             "count-only before seed"
 
+        Invoke-Success ($required + @("--limit", "1", "--time-limit", "0")) `
+            "result limit with disabled deadline"
+        Invoke-Success ($required + @("--exists", "--count-only")) "existence check"
+        $existsResult = [System.IO.File]::ReadAllText(
+            (Join-Path $tempRoot "matching_results_data.txt"))
+        # Random labels decide whether the single arc matches, so accept both.
+        if ($existsResult -notmatch "(?m)^stop_reason: (exists|complete)\r?$") {
+            throw "existence check does not record its stop reason"
+        }
+
+        Invoke-Failure ($required + @("--limit", "0")) "zero result limit"
+        Invoke-Failure ($required + @("--limit")) "missing result limit"
+        Invoke-Failure ($required + @("--time-limit", "-1")) "negative time limit"
+        Invoke-Failure ($required + @("--exists", "--exists")) "duplicate exists option"
         Invoke-Failure ($required + @("--count-only", "--count-only")) `
             "duplicate count-only option"
         Invoke-Failure ($required + @("--unknown")) "unknown option"
@@ -108,6 +108,50 @@ void finalizeSyntheticGraph(Graph& graph) {
     }
 }
 
+// A random directed temporal graph over snapshots 1..6 without self-loops.
+// Each ordered pair gets an arc with probability density, active in a
+// random subset of the snapshots; long_runs biases the subsets towards long
+// runs so that large k keep some matches. Vertex v has external ID
+// id_base + v and label v % label_count. seed must not be 0.
+Graph makeRandomTemporalGraph(
+    std::uint32_t seed,
+    int id_base,
+    double density,
+    int vertex_count = 9,
+    std::size_t label_count = 3,
+    bool long_runs = false) {
+    // The odd multiplier keeps the state non-zero and spreads nearby seeds.
+    std::uint32_t state = seed * 0x9e3779b1U;
+    auto next_random = [&]() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    };
+    const std::uint32_t arc_threshold = static_cast<std::uint32_t>(density * 1024.0);
+
+    Graph graph;
+    graph.num_vertices = vertex_count;
+    graph.adj.resize(static_cast<std::size_t>(vertex_count));
+    graph.in_adj.resize(static_cast<std::size_t>(vertex_count));
+    for (int vertex = 0; vertex < vertex_count; ++vertex) {
+        graph.external_ids.push_back(id_base + vertex);
+        graph.vertex_labels.push_back(
+            static_cast<Label>(static_cast<std::size_t>(vertex) % label_count));
+    }
+    for (int u = 0; u < vertex_count; ++u) {
+        for (int v = 0; v < vertex_count; ++v) {
+            if (u == v || (next_random() & 1023U) >= arc_threshold) continue;
+            std::uint32_t mask = next_random();
+            if (long_runs) mask |= next_random();
+            mask &= 0x3fU;
+            if (mask != 0) addTemporalEdge(graph, u, v, intervalsFromMask(mask));
+        }
+    }
+    finalizeSyntheticGraph(graph);
+    return graph;
+}
+
 std::uint64_t bruteForceTriangleCount(const Graph& graph, int minimum_duration) {
     const Label label_a = labelFromString("A");
     const Label label_b = labelFromString("B");
@@ -140,6 +184,33 @@ std::uint64_t bruteForceTriangleCount(const Graph& graph, int minimum_duration)
     return count;
 }
 
+Graph makeQuery(
+    const std::vector<std::string>& labels,
+    const std::vector<std::pair<int, int>>& edges) {
+    Graph query;
+    query.num_vertices = static_cast<int>(labels.size());
+    for (const auto& label : labels) query.vertex_labels.push_back(labelFromString(label));
+    query.external_ids.resize(labels.size());
+    for (std::size_t i = 0; i < labels.size(); ++i) query.external_ids[i] = static_cast<int>(i);
+    query.adj.resize(labels.size());
+    query.in_adj.resize(labels.size());
+    for (const auto& edge : edges) {
+        query.adj[static_cast<std::size_t>(edge.first)].push_back({edge.second, -1});
+        query.in_adj[static_cast<std::size_t>(edge.second)].push_back({edge.first, -1});
+    }
+    for (auto& neighbors : query.adj) {
+        std::sort(neighbors.begin(), neighbors.end(), [](const Edge& lhs, const Edge& rhs) {
+            return lhs.to < rhs.to;
+        });
+    }
+    for (auto& neighbors : query.in_adj) {
+        std::sort(neighbors.begin(), neighbors.end(), [](const Edge& lhs, const Edge& rhs) {
+            return lhs.to < rhs.to;
+        });
+    }
+    return query;
+}
+
 Graph makeMatchingDataGraph() {
     Graph graph;
     graph.num_vertices = 6;
@@ -609,6 +680,145 @@ void testRandomGraphsAgainstBruteForce(const std::filesystem::path& directory) {
             "random oracle fixtures must include positive and zero-match graphs");
 }
 
+void testFactorizedCountOnlyParity(const std::filesystem::path& directory) {
+    const std::vector<Graph> tree_queries{
+        makeQuery({"A", "B", "C", "D"}, {{0, 1}, {0, 2}, {3, 0}}),
+        makeQuery({"B", "A", "C", "D", "E"}, {{0, 1}, {1, 2}, {2, 3}, {1, 4}})};
+    std::array<std::size_t, kLabelCount> counts{};
+    counts.fill(3);
+
+    bool saw_match = false;
+    for (int round = 0; round < 16; ++round) {
+        const Graph graph = makeRandomTemporalGraph(
+            0xc2b2ae35U + round, 900, 2.0 / 3.0, 10, kLabelCount);
+
+        for (const Graph& query : tree_queries) {
+            const QueryDecomposition decomposition = decomposeQuery(query, counts);
+            TDTree tree(graph, query, decomposition, 2);
+            const auto full_path = directory / "original_factorized_full.dat";
+            const auto count_path = directory / "original_factorized_count.dat";
+            const MatchSummary full = tree.save_res(full_path.string());
+            const MatchSummary count_only =
+                tree.save_res(count_path.string(), MatchOutputMode::CountOnly);
+            saw_match = saw_match || full.match_count > 0;
+            require(!full.factorized_count && count_only.factorized_count,
+                    "only count-only tree queries are factorized");
+            require(count_only.match_count == full.match_count,
+                    "factorized count differs from enumeration in round " +
+                        std::to_string(round));
+            std::filesystem::remove(full_path);
+            std::filesystem::remove(count_path);
+        }
+    }
+    require(saw_match, "factorized fixtures must include matches");
+
+    // Repeated labels only keep the subtrees that share them from being
+    // multiplied; the vertices between those are enumerated in place.
+    const std::vector<Graph> repeated_label_queries{
+        makeQuery({"A", "B", "C", "B", "D"}, {{0, 1}, {0, 2}, {2, 3}, {0, 4}}),
+        makeQuery({"A", "B", "C", "D", "C"}, {{0, 1}, {0, 2}, {2, 3}, {3, 4}}),
+        makeQuery({"A", "B", "C", "D", "E", "B"}, {{0, 1}, {1, 2}, {0, 3}, {3, 4}, {4, 5}})};
+    saw_match = false;
+    for (int round = 0; round < 16; ++round) {
+        const Graph graph = makeRandomTemporalGraph(
+            0x27d4eb2fU + round, 900, 3.0 / 4.0, 10, kLabelCount, true);
+
+        for (const Graph& query : repeated_label_queries) {
+            const QueryDecomposition decomposition = decomposeQuery(query, counts);
+            TDTree tree(graph, query, decomposition, 2);
+            const auto full_path = directory / "original_factorized_full.dat";
+            const auto count_path = directory / "original_factorized_count.dat";
+            const MatchSummary full = tree.save_res(full_path.string());
+            const MatchSummary count_only =
+                tree.save_res(count_path.string(), MatchOutputMode::CountOnly);
+            saw_match = saw_match || full.match_count > 0;
+            require(count_only.factorized_count,
+                    "tree queries with a subtree of their own labels are factorized");
+            require(count_only.match_count == full.match_count,
+                    "repeated-label factorized count differs from enumeration in round " +
+                        std::to_string(round));
+            std::filesystem::remove(full_path);
+            std::filesystem::remove(count_path);
+        }
+    }
+    require(saw_match, "repeated-label factorized fixtures must include matches");
+
+    // decomposeQuery gives a query without arcs no root, but a caller can
+    // still build its one-vertex decomposition by hand.
+    const Graph data = makeMatchingDataGraph();
+    const Graph vertex = makeQuery({"A"}, {});
+    QueryDecomposition vertex_decomposition;
+    vertex_decomposition.spanning_tree_adj.resize(1);
+    vertex_decomposition.vertex_labels = vertex.vertex_labels;
+    vertex_decomposition.parent = {-1};
+    vertex_decomposition.dfs_order = {0};
+    vertex_decomposition.topological_selectivity = {1.0};
+    vertex_decomposition.root = 0;
+    vertex_decomposition.connected = true;
+    TDTree vertex_tree(data, vertex, vertex_decomposition, 2);
+    const auto full_path = directory / "original_factorized_vertex_full.dat";
+    const auto count_path = directory / "original_factorized_vertex_count.dat";
+    const MatchSummary full = vertex_tree.save_res(full_path.string());
+    const MatchSummary count_only =
+        vertex_tree.save_res(count_path.string(), MatchOutputMode::CountOnly);
+    require(full.match_count == 2 && !count_only.factorized_count &&
+                count_only.match_count == full.match_count,
+            "count-only runs of queries without arcs match enumeration");
+    std::filesystem::remove(full_path);
+    std::filesystem::remove(count_path);
+}
+
+void testResultLimitsAndExists(const std::filesystem::path& directory) {
+    const Graph query = makeQuery({"A", "B", "C"}, {{0, 1}, {0, 2}});
+    std::array<std::size_t, kLabelCount> counts{};
+    counts.fill(3);
+    const QueryDecomposition decomposition = decomposeQuery(query, counts);
+
+    const auto result_path = directory / "original_result_limits.dat";
+    bool saw_truncation = false;
+    for (int round = 0; round < 16; ++round) {
+        const Graph graph = makeRandomTemporalGraph(0x27d4eb2fU + round, 1100, 2.0 / 3.0, 12);
+        TDTree tree(graph, query, decomposition, 2);
+        const std::uint64_t expected =
+            tree.save_res(result_path.string(), MatchOutputMode::CountOnly).match_count;
+
+        for (std::uint64_t limit : {std::uint64_t{1}, std::uint64_t{3}, expected}) {
+            if (limit == 0) continue;
+            MatchLimits limits;
+            limits.max_results = limit;
+            const MatchSummary summary =
+                tree.save_res(result_path.string(), MatchOutputMode::Full, limits);
+            std::ifstream result(result_path, std::ios::binary);
+            const std::string contents(
+                (std::istreambuf_iterator<char>(result)), std::istreambuf_iterator<char>());
+            result.close();
+            if (limit < expected) {
+                saw_truncation = true;
+                require(summary.match_count == limit &&
+                        summary.stop_reason == MatchStopReason::ResultLimit &&
+                        contents.find("Truncated: result-limit") != std::string::npos,
+                        "--limit stops and marks the truncated result");
+            } else {
+                require(summary.match_count == expected &&
+                        summary.stop_reason == MatchStopReason::Complete &&
+                        contents.find("Truncated:") == std::string::npos,
+                        "a limit equal to the match count is not a truncation");
+            }
+        }
+
+        MatchLimits exists;
+        exists.exists_only = true;
+        const MatchSummary summary =
+            tree.save_res(result_path.string(), MatchOutputMode::CountOnly, exists);
+        require(!summary.factorized_count, "limited runs are enumerated");
+        require(summary.match_count == (expected > 0 ? 1U : 0U) &&
+                (summary.stop_reason == MatchStopReason::Exists) == (expected > 0),
+                "--exists stops at the first durable match");
+    }
+    std::filesystem::remove(result_path);
+    require(saw_truncation, "result-limit fixtures must include truncations");
+}
+
 } // namespace
 
 int main() {
@@ -626,6 +836,8 @@ int main() {
         testSelfLoopDurability(temp_directory);
         testInjectiveMapping(temp_directory);
         testRandomGraphsAgainstBruteForce(temp_directory);
+        testFactorizedCountOnlyParity(temp_directory);
+        testResultLimitsAndExists(temp_directory);
         std::cout << "All original tests passed.\n";
         return 0;
     } catch (const std::exception& error) {
@@ -0,0 +1,285 @@
+#include "BatchRunner.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "TDTree.h"
+#include "TemporalWindow.h"
+#include "query_decomposition.h"
+
+namespace {
+
+long long elapsedMilliseconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+// The timing keys td_tree.exe writes, in the same order.
+const std::array<const char*, 11> kTimingOrder{{
+    "readTemporalGraph",
+    "filterTemporalGraph",
+    "readAndFilterTemporalGraph",
+    "windowView",
+    "readQueryGraph",
+    "labelStatistics",
+    "queryDecomposition",
+    "buildTDTree",
+    "enumerateMatches",
+    "matchWriterBlocked",
+    "endToEnd"}};
+
+} // namespace
+
+bool readManifest(std::istream& input, BatchManifest& manifest) {
+    bool seeds_seen = false;
+    std::string line;
+    int line_number = 0;
+    while (std::getline(input, line)) {
+        ++line_number;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        std::istringstream parser(line);
+        std::string key;
+        if (!(parser >> key) || key[0] == '#') continue;
+        std::vector<std::string> values;
+        for (std::string value; parser >> value;) values.push_back(value);
+        auto fail = [&](const std::string& message) {
+            std::cerr << "Error: Manifest line " << line_number << ": " << message << '\n';
+            return false;
+        };
+        if (values.empty()) return fail(key + " needs a value");
+
+        if (key == "dataset") {
+            manifest.datasets.insert(manifest.datasets.end(), values.begin(), values.end());
+        } else if (key == "query") {
+            manifest.queries.insert(manifest.queries.end(), values.begin(), values.end());
+        } else if (key == "k") {
+            // Either explicit values or one inclusive range such as 2-10.
+            for (const std::string& value : values) {
+                const std::size_t dash = value.find('-', 1);
+                long long first = 0;
+                long long last = 0;
+                if (dash == std::string::npos
+                        ? !parseInteger(value, 2, std::numeric_limits<int>::max(), first)
+                        : !parseInteger(value.substr(0, dash), 2,
+                                        std::numeric_limits<int>::max(), first) ||
+                          !parseInteger(value.substr(dash + 1), first,
+                                        std::numeric_limits<int>::max(), last)) {
+                    return fail("k values must be integers of at least 2 or a range a-b");
+                }
+                if (dash == std::string::npos) last = first;
+                for (long long k = first; k <= last; ++k) {
+                    manifest.minimum_durations.push_back(static_cast<int>(k));
+                }
+            }
+        } else if (key == "seed") {
+            if (!seeds_seen) manifest.label_seeds.clear();
+            seeds_seen = true;
+            for (const std::string& value : values) {
+                long long seed = 0;
+                if (!parseInteger(value, 0, std::numeric_limits<std::uint32_t>::max(), seed)) {
+                    return fail("label seeds must be 32-bit unsigned integers");
+                }
+                manifest.label_seeds.push_back(static_cast<std::uint32_t>(seed));
+            }
+        } else if (key == "window" && values.size() == 2) {
+            long long first = 0;
+            long long last = 0;
+            if (!parseInteger(values[0], std::numeric_limits<int>::min(),
+                              std::numeric_limits<int>::max(), first) ||
+                !parseInteger(values[1], first, std::numeric_limits<int>::max(), last)) {
+                return fail("window needs two integer snapshots t1 <= t2");
+            }
+            manifest.windows.push_back({static_cast<int>(first), static_cast<int>(last)});
+        } else if (key == "mode" && values.size() == 1 &&
+                   (values[0] == "full" || values[0] == "count-only")) {
+            manifest.options.output_mode = values[0] == "full"
+                ? MatchOutputMode::Full
+                : MatchOutputMode::CountOnly;
+        } else if (key == "order" && values.size() == 1 &&
+                   (values[0] == "static" || values[0] == "adaptive")) {
+            manifest.options.matching_order = values[0] == "static"
+                ? MatchingOrder::Static
+                : MatchingOrder::Adaptive;
+        } else if (key == "limit" && values.size() == 1) {
+            long long limit = 0;
+            if (!parseInteger(values[0], 1, std::numeric_limits<long long>::max(), limit)) {
+                return fail("limit must be a positive integer");
+            }
+            manifest.options.limits.max_results = static_cast<std::uint64_t>(limit);
+        } else if (key == "time-limit" && values.size() == 1) {
+            long long seconds = 0;
+            if (!parseInteger(values[0], 0, std::numeric_limits<int>::max(), seconds)) {
+                return fail("time-limit must be a non-negative integer");
+            }
+            manifest.options.limits.time_limit_seconds = static_cast<int>(seconds);
+        } else if (key == "output" && values.size() == 1) {
+            manifest.output_file = values[0];
+        } else if (key == "results_dir" && values.size() == 1) {
+            manifest.results_directory = values[0];
+        } else {
+            return fail("unknown or malformed key " + key);
+        }
+    }
+    if (manifest.datasets.empty() || manifest.queries.empty() ||
+        manifest.minimum_durations.empty()) {
+        std::cerr << "Error: The manifest needs at least one dataset, query and k.\n";
+        return false;
+    }
+    // Ascending k lets each run filter the previous run's TD-tree in place.
+    auto& durations = manifest.minimum_durations;
+    std::sort(durations.begin(), durations.end());
+    durations.erase(std::unique(durations.begin(), durations.end()), durations.end());
+    return true;
+}
+
+int runBatch(const BatchManifest& manifest, std::ostream& csv, std::size_t& run_count) {
+    csv << "dataset,query,k,label_seed,window,mode,count_strategy,matching_order,stop_reason,"
+           "match_count,failing_set_pruned_candidates";
+    for (const char* timing_name : kTimingOrder) csv << ',' << timing_name;
+    csv << '\n';
+
+    std::vector<Graph> query_graphs(manifest.queries.size());
+    std::vector<long long> query_read_milliseconds(manifest.queries.size(), 0);
+    for (std::size_t query_index = 0; query_index < manifest.queries.size(); ++query_index) {
+        const auto stage_start = std::chrono::steady_clock::now();
+        if (!readQueryGraph(manifest.queries[query_index], query_graphs[query_index])) return 2;
+        query_read_milliseconds[query_index] = elapsedMilliseconds(stage_start);
+    }
+
+    run_count = 0;
+    for (const std::string& dataset : manifest.datasets) {
+        Graph temporal_graph;
+        TemporalGraphLoadTimings load_timings;
+        auto stage_start = std::chrono::steady_clock::now();
+        if (!readTemporalGraph(dataset, temporal_graph, manifest.label_seeds.front(), &load_timings)) {
+            return 2;
+        }
+        const long long read_and_filter_milliseconds = elapsedMilliseconds(stage_start);
+        const std::string dataset_name = std::filesystem::path(dataset).stem().string();
+        std::cout << "Dataset " << dataset_name << ": " << temporal_graph.filtered_edge_count
+                  << " retained edges, " << temporal_graph.num_vertices
+                  << " active vertices, read+filter=" << read_and_filter_milliseconds << " ms\n";
+
+        // The interval index only depends on the edges, so it serves every
+        // seed and window of this dataset.
+        std::unique_ptr<TemporalIntervalIndex> interval_index;
+        if (!manifest.windows.empty()) {
+            stage_start = std::chrono::steady_clock::now();
+            interval_index = std::make_unique<TemporalIntervalIndex>(temporal_graph);
+            std::cout << "Interval index: " << interval_index->entryCount() << " intervals, "
+                      << elapsedMilliseconds(stage_start) << " ms\n";
+        }
+        const std::size_t window_count = std::max<std::size_t>(manifest.windows.size(), 1);
+
+        for (std::size_t seed_index = 0; seed_index < manifest.label_seeds.size(); ++seed_index) {
+            const std::uint32_t label_seed = manifest.label_seeds[seed_index];
+            stage_start = std::chrono::steady_clock::now();
+            // readTemporalGraph already drew the first seed's labels.
+            if (seed_index > 0) assignSeededLabels(temporal_graph, label_seed);
+            const long long relabel_milliseconds = elapsedMilliseconds(stage_start);
+
+            for (std::size_t window_index = 0; window_index < window_count; ++window_index) {
+                // Without windows every run uses the loaded graph itself.
+                const Graph* run_graph = &temporal_graph;
+                Graph window_graph;
+                std::string window_name = "all";
+                long long window_milliseconds = 0;
+                if (interval_index != nullptr) {
+                    const SnapshotWindow window = manifest.windows[window_index];
+                    stage_start = std::chrono::steady_clock::now();
+                    // Built for the smallest k; larger k filter the TD-tree.
+                    window_graph = makeWindowGraph(
+                        temporal_graph, *interval_index, window,
+                        manifest.minimum_durations.front());
+                    window_milliseconds = elapsedMilliseconds(stage_start);
+                    run_graph = &window_graph;
+                    window_name = std::to_string(window.first) + '-' + std::to_string(window.last);
+                }
+
+                stage_start = std::chrono::steady_clock::now();
+                const LabelStatistics label_statistics = computeLabelStatistics(*run_graph);
+                const long long label_milliseconds =
+                    relabel_milliseconds + elapsedMilliseconds(stage_start);
+
+                for (std::size_t query_index = 0; query_index < query_graphs.size(); ++query_index) {
+                    const Graph& query_graph = query_graphs[query_index];
+                    const std::string query_name =
+                        std::filesystem::path(manifest.queries[query_index]).stem().string();
+                    stage_start = std::chrono::steady_clock::now();
+                    const QueryDecomposition decomposition = decomposeQuery(
+                        query_graph, label_statistics.vertex_counts,
+                        label_statistics.average_lifespans);
+                    const long long decomposition_milliseconds = elapsedMilliseconds(stage_start);
+                    if (decomposition.root < 0 || !decomposition.connected) {
+                        std::cerr << "Skipping " << query_name << " on " << dataset_name
+                                  << " seed " << label_seed << " window " << window_name
+                                  << ": the query is disconnected or has no viable root.\n";
+                        continue;
+                    }
+
+                    std::unique_ptr<TDTree> td_tree;
+                    for (int minimum_duration : manifest.minimum_durations) {
+                        stage_start = std::chrono::steady_clock::now();
+                        if (td_tree == nullptr || !td_tree->raiseMinimumDuration(minimum_duration)) {
+                            td_tree = std::make_unique<TDTree>(
+                                *run_graph, query_graph, decomposition, minimum_duration);
+                        }
+                        const long long build_milliseconds = elapsedMilliseconds(stage_start);
+
+                        const std::filesystem::path result_file =
+                            std::filesystem::path(manifest.results_directory) /
+                            ("matching_results_" + dataset_name + '_' + query_name + "_k" +
+                             std::to_string(minimum_duration) + "_seed" +
+                             std::to_string(label_seed) +
+                             (interval_index != nullptr ? "_w" + window_name : "") + ".txt");
+                        const MatchSummary summary =
+                            td_tree->save_res(result_file.string(), manifest.options);
+                        if (!summary.output_written) {
+                            std::cerr << "Error: Could not write " << result_file.string() << '\n';
+                            return 4;
+                        }
+
+                        // Shared stages report their one-time cost on every
+                        // row; endToEnd covers only the stages this run paid for.
+                        const std::array<long long, kTimingOrder.size()> timings{{
+                            load_timings.read_milliseconds,
+                            load_timings.filter_milliseconds,
+                            read_and_filter_milliseconds,
+                            window_milliseconds,
+                            query_read_milliseconds[query_index],
+                            label_milliseconds,
+                            decomposition_milliseconds,
+                            build_milliseconds,
+                            summary.enumeration_milliseconds,
+                            summary.io_blocked_milliseconds,
+                            label_milliseconds + decomposition_milliseconds + build_milliseconds +
+                                summary.enumeration_milliseconds}};
+                        csv << dataset_name << ',' << query_name << ',' << minimum_duration << ','
+                            << label_seed << ',' << window_name
+                            << ',' << matchOutputModeName(manifest.options.output_mode)
+                            << ',' << (summary.factorized_count ? "factorized" : "enumeration")
+                            << ',' << matchingOrderName(manifest.options.matching_order)
+                            << ',' << matchStopReasonName(summary.stop_reason)
+                            << ',' << summary.match_count
+                            << ',' << summary.failing_set_pruned_candidates;
+                        for (long long timing : timings) csv << ',' << timing;
+                        csv << '\n';
+                        csv.flush();
+                        ++run_count;
+                    }
+                }
+            }
+        }
+    }
+    return csv.good() ? 0 : 4;
+}
@@ -0,0 +1,43 @@
+#ifndef BATCH_RUNNER_H
+#define BATCH_RUNNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "TDTree.h"
+#include "TemporalWindow.h"
+#include "Utils.h"
+
+// Manifest-driven sweep over datasets x label seeds x snapshot windows x
+// queries x k in one process. Each dataset is read, filtered and interval
+// indexed once; each window is a clipped view of it; each seed only redraws
+// labels in memory; each (seed, query) pair is decomposed once, and its
+// TD-tree is built for the smallest k and filtered in place for each larger
+// k. See README.md for the manifest format.
+
+struct BatchManifest {
+    std::vector<std::string> datasets;
+    std::vector<std::string> queries;
+    std::vector<int> minimum_durations;
+    std::vector<std::uint32_t> label_seeds{kDefaultLabelSeed};
+    // Empty runs on the whole graph.
+    std::vector<SnapshotWindow> windows;
+    MatchOptions options;
+    std::string output_file = "batch_results.csv";
+    std::string results_directory = ".";
+};
+
+// Parses a manifest, reporting the first malformed line on std::cerr. k
+// values come back sorted and unique.
+bool readManifest(std::istream& input, BatchManifest& manifest);
+
+// Runs every combination of the manifest, writing the CSV header and one
+// row per run to csv. Returns 0, 2 when an input graph cannot be read, or 4
+// when a result file or the table cannot be written.
+int runBatch(const BatchManifest& manifest, std::ostream& csv, std::size_t& run_count);
+
+#endif // BATCH_RUNNER_H
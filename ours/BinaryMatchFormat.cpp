@@ -0,0 +1,205 @@
+#include "BinaryMatchFormat.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <istream>
+#include <ostream>
+
+#include "MatchWriter.h"
+#include "TDTree.h"
+
+namespace {
+
+constexpr char kBinaryMatchMagic[4] = {'T', 'D', 'M', 'B'};
+// Magic, version, n, k, flags, three u64 fields; the labels follow.
+constexpr std::size_t kFixedHeaderSize = 4 + 4 + 4 + 4 + 4 + 8 + 8 + 8;
+
+template <typename Unsigned>
+void writeLittleEndian(std::ostream& output, Unsigned value) {
+    char bytes[sizeof(Unsigned)];
+    for (std::size_t i = 0; i < sizeof(Unsigned); ++i) {
+        bytes[i] = static_cast<char>((value >> (8 * i)) & 0xffU);
+    }
+    output.write(bytes, sizeof(Unsigned));
+}
+
+template <typename Unsigned>
+Unsigned decodeLittleEndian(const unsigned char* bytes) {
+    Unsigned value = 0;
+    for (std::size_t i = 0; i < sizeof(Unsigned); ++i) {
+        value |= static_cast<Unsigned>(bytes[i]) << (8 * i);
+    }
+    return value;
+}
+
+template <typename Unsigned>
+bool readLittleEndian(std::istream& input, Unsigned& value) {
+    unsigned char bytes[sizeof(Unsigned)];
+    if (!input.read(reinterpret_cast<char*>(bytes), sizeof(Unsigned))) return false;
+    value = decodeLittleEndian<Unsigned>(bytes);
+    return true;
+}
+
+} // namespace
+
+std::size_t BinaryMatchHeader::headerSize() const {
+    return kFixedHeaderSize + query_labels.size();
+}
+
+std::size_t BinaryMatchHeader::rowWidth() const {
+    return query_labels.size() * sizeof(std::uint32_t);
+}
+
+void writeBinaryMatchHeader(std::ostream& output, const BinaryMatchHeader& header) {
+    output.write(kBinaryMatchMagic, sizeof(kBinaryMatchMagic));
+    writeLittleEndian(output, kBinaryMatchVersion);
+    writeLittleEndian(output, static_cast<std::uint32_t>(header.query_labels.size()));
+    writeLittleEndian(output, static_cast<std::uint32_t>(header.minimum_duration));
+    writeLittleEndian(output, header.stop_reason);
+    writeLittleEndian(output, static_cast<std::uint8_t>(header.count_only ? 1 : 0));
+    writeLittleEndian(output, std::uint16_t{0});
+    writeLittleEndian(output, header.match_count);
+    writeLittleEndian(output, header.interval_section_offset);
+    writeLittleEndian(output, header.dictionary_offset);
+    for (Label label : header.query_labels) writeLittleEndian(output, label);
+}
+
+void writeBinaryMatchDictionary(std::ostream& output, const Graph& graph) {
+    writeLittleEndian(output, static_cast<std::uint32_t>(graph.num_vertices));
+    for (int data_vertex = 0; data_vertex < graph.num_vertices; ++data_vertex) {
+        writeLittleEndian(output, static_cast<std::uint32_t>(graph.externalId(data_vertex)));
+    }
+}
+
+bool readBinaryMatchHeader(std::istream& input, BinaryMatchHeader& header, std::string& error) {
+    char magic[sizeof(kBinaryMatchMagic)];
+    if (!input.read(magic, sizeof(magic)) ||
+        !std::equal(magic, magic + sizeof(magic), kBinaryMatchMagic)) {
+        error = "not a binary match file";
+        return false;
+    }
+    std::uint32_t query_vertex_count = 0;
+    std::uint32_t minimum_duration = 0;
+    std::uint8_t count_only = 0;
+    std::uint16_t reserved = 0;
+    if (!readLittleEndian(input, header.version) ||
+        !readLittleEndian(input, query_vertex_count) ||
+        !readLittleEndian(input, minimum_duration) ||
+        !readLittleEndian(input, header.stop_reason) ||
+        !readLittleEndian(input, count_only) ||
+        !readLittleEndian(input, reserved) ||
+        !readLittleEndian(input, header.match_count) ||
+        !readLittleEndian(input, header.interval_section_offset) ||
+        !readLittleEndian(input, header.dictionary_offset)) {
+        error = "truncated header";
+        return false;
+    }
+    if (header.version != kBinaryMatchVersion) {
+        error = "unsupported version " + std::to_string(header.version);
+        return false;
+    }
+    header.minimum_duration = static_cast<std::int32_t>(minimum_duration);
+    header.count_only = count_only != 0;
+    header.query_labels.assign(query_vertex_count, 0);
+    for (Label& label : header.query_labels) {
+        if (!readLittleEndian(input, label) || label >= kLabelCount) {
+            error = "invalid query schema";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool convertBinaryMatchesToText(
+    const std::string& filename, std::ostream& output, std::string& error) {
+    // Rows and their intervals are stored in the same order, so one stream
+    // walks each section sequentially.
+    std::ifstream rows(filename, std::ios::binary);
+    std::ifstream intervals(filename, std::ios::binary);
+    if (!rows.is_open() || !intervals.is_open()) {
+        error = "cannot open " + filename;
+        return false;
+    }
+    BinaryMatchHeader header;
+    if (!readBinaryMatchHeader(rows, header, error)) return false;
+
+    std::vector<int> external_ids;
+    std::uint32_t dictionary_size = 0;
+    intervals.seekg(static_cast<std::streamoff>(header.dictionary_offset));
+    if (!readLittleEndian(intervals, dictionary_size)) {
+        error = "missing external-ID dictionary";
+        return false;
+    }
+    external_ids.resize(dictionary_size);
+    for (int& external_id : external_ids) {
+        std::uint32_t value = 0;
+        if (!readLittleEndian(intervals, value)) {
+            error = "truncated external-ID dictionary";
+            return false;
+        }
+        external_id = static_cast<int>(value);
+    }
+    intervals.clear();
+    intervals.seekg(static_cast<std::streamoff>(header.interval_section_offset));
+
+    const std::size_t query_vertex_count = header.query_labels.size();
+    std::vector<std::string> row_prefixes(query_vertex_count);
+    for (std::size_t query_vertex = 0; query_vertex < query_vertex_count; ++query_vertex) {
+        row_prefixes[query_vertex] = (query_vertex > 0 ? ", q" : "q") +
+            std::to_string(query_vertex) + '(' + labelToString(header.query_labels[query_vertex]) + ")->";
+    }
+
+    output << "[Final Matches]\nCount: " << std::setw(20) << header.match_count << '\n';
+    std::vector<unsigned char> row(header.rowWidth());
+    std::vector<TimeInterval> active;
+    {
+        AsyncMatchWriter writer(output);
+        for (std::uint64_t match = 0; match < header.match_count && !header.count_only; ++match) {
+            std::uint32_t interval_count = 0;
+            if (!rows.read(reinterpret_cast<char*>(row.data()),
+                           static_cast<std::streamsize>(row.size())) ||
+                !readLittleEndian(intervals, interval_count)) {
+                error = "truncated match " + std::to_string(match);
+                return false;
+            }
+            active.resize(interval_count);
+            for (TimeInterval& interval : active) {
+                std::uint32_t start = 0;
+                std::uint32_t end = 0;
+                if (!readLittleEndian(intervals, start) || !readLittleEndian(intervals, end)) {
+                    error = "truncated intervals of match " + std::to_string(match);
+                    return false;
+                }
+                interval.start = static_cast<int>(start);
+                interval.end = static_cast<int>(end);
+            }
+
+            writer.append("Match ");
+            writer.appendInteger(match);
+            writer.append(": ");
+            for (std::size_t query_vertex = 0; query_vertex < query_vertex_count; ++query_vertex) {
+                const std::uint32_t data_vertex = decodeLittleEndian<std::uint32_t>(
+                    row.data() + query_vertex * sizeof(std::uint32_t));
+                if (data_vertex >= external_ids.size()) {
+                    error = "match " + std::to_string(match) + " has an unknown data vertex";
+                    return false;
+                }
+                writer.append(row_prefixes[query_vertex]);
+                writer.appendInteger(external_ids[data_vertex]);
+            }
+            writer.append(" | active=");
+            writer.appendIntervals(active);
+            writer.append('\n');
+        }
+        if (!writer.finish()) {
+            error = "write failed";
+            return false;
+        }
+    }
+    const auto stop_reason = static_cast<MatchStopReason>(header.stop_reason);
+    if (stop_reason != MatchStopReason::Complete) {
+        output << "Truncated: " << matchStopReasonName(stop_reason) << '\n';
+    }
+    return static_cast<bool>(output);
+}
@@ -0,0 +1,51 @@
+#ifndef BINARY_MATCH_FORMAT_H
+#define BINARY_MATCH_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "Utils.h"
+
+// Binary result file written by --output-format binary. Every integer is
+// little-endian.
+//
+//   header      "TDMB", u32 version, u32 query vertex count n, i32 k,
+//               u8 stop reason, u8 count-only flag, u16 reserved,
+//               u64 match count, u64 interval section offset,
+//               u64 dictionary offset, n x u8 query labels
+//   rows        match count x n x u32 compact data vertex
+//   intervals   per row, in row order: u32 interval count,
+//               count x (i32 start, i32 end)
+//   dictionary  u32 data vertex count, count x i32 external ID
+//
+// Rows have a fixed width, so row i starts at headerSize + i * rowWidth.
+struct BinaryMatchHeader {
+    std::uint32_t version = 0;
+    std::int32_t minimum_duration = 0;
+    std::uint8_t stop_reason = 0;
+    bool count_only = false;
+    std::uint64_t match_count = 0;
+    std::uint64_t interval_section_offset = 0;
+    std::uint64_t dictionary_offset = 0;
+    std::vector<Label> query_labels;
+
+    std::size_t headerSize() const;
+    std::size_t rowWidth() const;
+};
+
+constexpr std::uint32_t kBinaryMatchVersion = 2;
+
+// Writes the header at the current position; the offsets may be
+// placeholders that are rewritten once the sections are known.
+void writeBinaryMatchHeader(std::ostream& output, const BinaryMatchHeader& header);
+void writeBinaryMatchDictionary(std::ostream& output, const Graph& graph);
+bool readBinaryMatchHeader(std::istream& input, BinaryMatchHeader& header, std::string& error);
+
+// Rewrites a binary result file as the text [Final Matches] section.
+bool convertBinaryMatchesToText(
+    const std::string& filename, std::ostream& output, std::string& error);
+
+#endif // BINARY_MATCH_FORMAT_H
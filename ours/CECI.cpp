@@ -0,0 +1,460 @@
+#include "CECI.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+#include "MatchWriter.h"
+
+CeciMatcher::CeciMatcher(
+    const Graph& temporal_graph,
+    const Graph& query_graph,
+    int minimum_duration,
+    unsigned threads)
+    : G(temporal_graph), Q(query_graph), k_threshold(minimum_duration), thread_count(threads) {
+    const std::size_t query_count = static_cast<std::size_t>(Q.num_vertices);
+    query_relations.assign(query_count * query_count, 0);
+    for (int source = 0; source < Q.num_vertices; ++source) {
+        for (const Edge& edge : Q.adj[static_cast<std::size_t>(source)]) {
+            query_relations[static_cast<std::size_t>(source) * query_count +
+                            static_cast<std::size_t>(edge.to)] |= 1U;
+            query_relations[static_cast<std::size_t>(edge.to) * query_count +
+                            static_cast<std::size_t>(source)] |= 2U;
+        }
+    }
+    durable_edges.resize(G.temporal_edges.size());
+    for (std::size_t edge_id = 0; edge_id < G.temporal_edges.size(); ++edge_id) {
+        durable_edges[edge_id] = hasMinimumConsecutiveDuration(
+            G.temporal_edges[edge_id].active_intervals, k_threshold) ? 1 : 0;
+    }
+    buildIndex();
+}
+
+std::uint8_t CeciMatcher::relation(int source, int target) const {
+    return query_relations[static_cast<std::size_t>(source) * static_cast<std::size_t>(Q.num_vertices) +
+                           static_cast<std::size_t>(target)];
+}
+
+bool CeciMatcher::isInitialCandidate(int data_vertex, int query_vertex) const {
+    const std::size_t data_index = static_cast<std::size_t>(data_vertex);
+    const std::size_t query_index = static_cast<std::size_t>(query_vertex);
+    if (G.vertex_labels[data_index] != Q.vertex_labels[query_index]) return false;
+    if (G.adj[data_index].size() < Q.adj[query_index].size()) return false;
+    if (G.in_adj[data_index].size() < Q.in_adj[query_index].size()) return false;
+    if (data_index >= G.vertex_active_durations.size() ||
+        G.vertex_active_durations[data_index] < k_threshold) {
+        return false;
+    }
+    std::array<int, kLabelCount> out_required{};
+    std::array<int, kLabelCount> in_required{};
+    for (const Edge& edge : Q.adj[query_index]) {
+        ++out_required[Q.vertex_labels[static_cast<std::size_t>(edge.to)]];
+    }
+    for (const Edge& edge : Q.in_adj[query_index]) {
+        ++in_required[Q.vertex_labels[static_cast<std::size_t>(edge.to)]];
+    }
+    for (std::size_t label = 0; label < kLabelCount; ++label) {
+        if (G.neighbor_label_counts[data_index][label] < out_required[label] ||
+            G.incoming_neighbor_label_counts[data_index][label] < in_required[label]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Visits every data vertex that may play query_vertex next to data_vertex
+// playing neighbor: all query arcs between the two map to data arcs that
+// share a k-run.
+template <typename Visit>
+void CeciMatcher::forEachEdgeCandidate(
+    int query_vertex,
+    int neighbor,
+    int data_vertex,
+    Visit visit) const {
+    const std::uint8_t arcs = relation(neighbor, query_vertex);
+    const std::size_t data_index = static_cast<std::size_t>(data_vertex);
+    if ((arcs & 1U) == 0) {
+        for (const Edge& edge : G.in_adj[data_index]) {
+            if (durable_edges[static_cast<std::size_t>(edge.temporal_edge_id)] != 0) visit(edge.to);
+        }
+        return;
+    }
+    for (const Edge& edge : G.adj[data_index]) {
+        if (durable_edges[static_cast<std::size_t>(edge.temporal_edge_id)] == 0) continue;
+        if ((arcs & 2U) != 0) {
+            const TemporalEdge* reverse_edge = G.findTemporalEdge(edge.to, data_vertex);
+            if (reverse_edge == nullptr || intersectTimeIntervals(
+                    G.temporal_edges[static_cast<std::size_t>(edge.temporal_edge_id)].active_intervals,
+                    reverse_edge->active_intervals, k_threshold).empty()) {
+                continue;
+            }
+        }
+        visit(edge.to);
+    }
+}
+
+void CeciMatcher::chooseOrder(const std::vector<std::vector<std::uint8_t>>& members) {
+    const std::size_t query_count = static_cast<std::size_t>(Q.num_vertices);
+    // CECI's root minimizes candidates per query degree.
+    int root = 0;
+    double best_score = std::numeric_limits<double>::infinity();
+    for (int query_vertex = 0; query_vertex < Q.num_vertices; ++query_vertex) {
+        const std::size_t query_index = static_cast<std::size_t>(query_vertex);
+        const double degree = static_cast<double>(
+            Q.adj[query_index].size() + Q.in_adj[query_index].size());
+        const double candidates = static_cast<double>(
+            std::count(members[query_index].begin(), members[query_index].end(), 1));
+        const double score = degree > 0 ? candidates / degree : candidates;
+        if (score < best_score) {
+            best_score = score;
+            root = query_vertex;
+        }
+    }
+
+    order.assign(1, root);
+    order_positions.assign(query_count, -1);
+    parents.assign(query_count, -1);
+    order_positions[static_cast<std::size_t>(root)] = 0;
+    for (std::size_t head = 0; head < order.size(); ++head) {
+        const int query_vertex = order[head];
+        for (int neighbor = 0; neighbor < Q.num_vertices; ++neighbor) {
+            if (relation(query_vertex, neighbor) == 0 ||
+                order_positions[static_cast<std::size_t>(neighbor)] >= 0) {
+                continue;
+            }
+            order_positions[static_cast<std::size_t>(neighbor)] = static_cast<int>(order.size());
+            parents[static_cast<std::size_t>(neighbor)] = query_vertex;
+            order.push_back(neighbor);
+        }
+    }
+}
+
+void CeciMatcher::buildIndex() {
+    const std::size_t query_count = static_cast<std::size_t>(Q.num_vertices);
+    const std::size_t vertex_count = static_cast<std::size_t>(G.num_vertices);
+    index.assign(query_count, {});
+    std::vector<std::vector<std::uint8_t>> members(query_count,
+                                                  std::vector<std::uint8_t>(vertex_count, 0));
+    for (int query_vertex = 0; query_vertex < Q.num_vertices; ++query_vertex) {
+        for (int data_vertex = 0; data_vertex < G.num_vertices; ++data_vertex) {
+            if (isInitialCandidate(data_vertex, query_vertex)) {
+                members[static_cast<std::size_t>(query_vertex)]
+                       [static_cast<std::size_t>(data_vertex)] = 1;
+            }
+        }
+    }
+    chooseOrder(members);
+    // A disconnected query has no embedding.
+    if (order.size() != query_count) {
+        for (auto& vertex_index : index) vertex_index.candidates.clear();
+        return;
+    }
+
+    // Keeps the candidates of query_vertex supported by every listed
+    // neighbour: each must reach it through an edge candidate.
+    std::vector<int> support(vertex_count, 0);
+    std::vector<int> last_supporter(vertex_count, -1);
+    std::vector<int> touched;
+    auto filter = [&](int query_vertex, const std::vector<int>& neighbors) {
+        auto& member = members[static_cast<std::size_t>(query_vertex)];
+        touched.clear();
+        for (int neighbor : neighbors) {
+            for (int data_vertex : index[static_cast<std::size_t>(neighbor)].candidates) {
+                forEachEdgeCandidate(query_vertex, neighbor, data_vertex, [&](int candidate) {
+                    const std::size_t candidate_index = static_cast<std::size_t>(candidate);
+                    if (member[candidate_index] == 0 || last_supporter[candidate_index] == neighbor) {
+                        return;
+                    }
+                    last_supporter[candidate_index] = neighbor;
+                    if (support[candidate_index]++ == 0) touched.push_back(candidate);
+                });
+            }
+        }
+        std::vector<int> candidates;
+        for (int candidate : touched) {
+            const std::size_t candidate_index = static_cast<std::size_t>(candidate);
+            if (support[candidate_index] == static_cast<int>(neighbors.size())) {
+                candidates.push_back(candidate);
+            }
+            support[candidate_index] = 0;
+            last_supporter[candidate_index] = -1;
+        }
+        std::sort(candidates.begin(), candidates.end());
+        std::fill(member.begin(), member.end(), 0);
+        for (int candidate : candidates) member[static_cast<std::size_t>(candidate)] = 1;
+        index[static_cast<std::size_t>(query_vertex)].candidates = std::move(candidates);
+    };
+
+    const int root = order.front();
+    for (int data_vertex = 0; data_vertex < G.num_vertices; ++data_vertex) {
+        if (members[static_cast<std::size_t>(root)][static_cast<std::size_t>(data_vertex)] != 0) {
+            index[static_cast<std::size_t>(root)].candidates.push_back(data_vertex);
+        }
+    }
+    // Forward pass: each vertex needs support from every earlier neighbour.
+    for (std::size_t position = 1; position < order.size(); ++position) {
+        const int query_vertex = order[position];
+        std::vector<int> earlier_neighbors;
+        for (std::size_t earlier = 0; earlier < position; ++earlier) {
+            if (relation(order[earlier], query_vertex) != 0) earlier_neighbors.push_back(order[earlier]);
+        }
+        filter(query_vertex, earlier_neighbors);
+    }
+    for (const auto& vertex_index : index) {
+        index_statistics.forward_candidates += vertex_index.candidates.size();
+    }
+    // Backward refinement: every later neighbour must support it too.
+    for (std::size_t position = order.size(); position-- > 0;) {
+        const int query_vertex = order[position];
+        std::vector<int> later_neighbors;
+        for (std::size_t later = position + 1; later < order.size(); ++later) {
+            if (relation(order[later], query_vertex) != 0) later_neighbors.push_back(order[later]);
+        }
+        if (!later_neighbors.empty()) filter(query_vertex, later_neighbors);
+    }
+
+    std::vector<int> positions(vertex_count, -1);
+    for (std::size_t position = 0; position < order.size(); ++position) {
+        const int query_vertex = order[position];
+        QueryVertexIndex& vertex_index = index[static_cast<std::size_t>(query_vertex)];
+        index_statistics.refined_candidates += vertex_index.candidates.size();
+        for (std::size_t earlier = 0; earlier < position; ++earlier) {
+            const int neighbor = order[earlier];
+            const std::uint8_t arcs = relation(neighbor, query_vertex);
+            if ((arcs & 1U) != 0) vertex_index.backward_arcs.emplace_back(neighbor, query_vertex);
+            if ((arcs & 2U) != 0) vertex_index.backward_arcs.emplace_back(query_vertex, neighbor);
+        }
+        if (position == 0) continue;
+
+        for (std::size_t candidate = 0; candidate < vertex_index.candidates.size(); ++candidate) {
+            positions[static_cast<std::size_t>(vertex_index.candidates[candidate])] =
+                static_cast<int>(candidate);
+        }
+        vertex_index.tree = buildCandidateMap(
+            query_vertex, parents[static_cast<std::size_t>(query_vertex)], positions);
+        index_statistics.tree_edge_candidates += vertex_index.tree.positions.size();
+        for (std::size_t earlier = 0; earlier < position; ++earlier) {
+            const int neighbor = order[earlier];
+            if (neighbor == parents[static_cast<std::size_t>(query_vertex)] ||
+                relation(neighbor, query_vertex) == 0) {
+                continue;
+            }
+            vertex_index.non_tree.push_back(buildCandidateMap(query_vertex, neighbor, positions));
+            index_statistics.non_tree_edge_candidates += vertex_index.non_tree.back().positions.size();
+        }
+        for (int data_vertex : vertex_index.candidates) {
+            positions[static_cast<std::size_t>(data_vertex)] = -1;
+        }
+    }
+    index_statistics.clusters = index[static_cast<std::size_t>(root)].candidates.size();
+}
+
+CeciMatcher::CandidateMap CeciMatcher::buildCandidateMap(
+    int query_vertex,
+    int neighbor,
+    std::vector<int>& positions) const {
+    CandidateMap map;
+    map.neighbor = neighbor;
+    const auto& neighbor_candidates = index[static_cast<std::size_t>(neighbor)].candidates;
+    map.offsets.reserve(neighbor_candidates.size() + 1);
+    for (int data_vertex : neighbor_candidates) {
+        map.offsets.push_back(static_cast<int>(map.positions.size()));
+        forEachEdgeCandidate(query_vertex, neighbor, data_vertex, [&](int candidate) {
+            const int position = positions[static_cast<std::size_t>(candidate)];
+            if (position >= 0) map.positions.push_back(position);
+        });
+        std::sort(map.positions.begin() + map.offsets.back(), map.positions.end());
+    }
+    map.offsets.push_back(static_cast<int>(map.positions.size()));
+    return map;
+}
+
+MatchSummary CeciMatcher::forEachMatch(
+    const MatchCallback& callback,
+    const MatchOptions& options) const {
+    MatchSummary summary;
+    const auto start = std::chrono::steady_clock::now();
+    if (Q.num_vertices < 2 || order.size() != static_cast<std::size_t>(Q.num_vertices)) {
+        return summary;
+    }
+    const MatchLimits& limits = options.limits;
+    const auto& clusters = index[static_cast<std::size_t>(order.front())].candidates;
+
+    std::atomic<std::size_t> next_cluster{0};
+    std::atomic<std::uint64_t> claimed_matches{0};
+    std::atomic<std::uint64_t> match_count{0};
+    std::atomic<bool> stop_requested{false};
+    std::mutex stop_mutex;
+    auto request_stop = [&](MatchStopReason reason) {
+        const std::lock_guard<std::mutex> lock(stop_mutex);
+        if (summary.stop_reason == MatchStopReason::Complete) summary.stop_reason = reason;
+        stop_requested.store(true);
+    };
+
+    auto run_clusters = [&]() {
+        const std::size_t query_count = static_cast<std::size_t>(Q.num_vertices);
+        std::vector<int> mapping(query_count, -1);
+        // Each mapped query vertex's position in its candidates.
+        std::vector<int> mapped_positions(query_count, -1);
+        std::vector<std::uint8_t> used(static_cast<std::size_t>(G.num_vertices), 0);
+        std::vector<std::vector<TimeInterval>> common_intervals(order.size());
+        DeadlineGuard deadline(limits, start);
+
+        // Intersects the running common intervals with the arcs to earlier
+        // vertices; false when no k-run is left.
+        auto extend_intervals = [&](std::size_t depth, const QueryVertexIndex& vertex_index) {
+            auto& current = common_intervals[depth];
+            const std::vector<TimeInterval>* previous = depth > 1 ? &common_intervals[depth - 1] : nullptr;
+            for (const auto& arc : vertex_index.backward_arcs) {
+                const TemporalEdge* edge = G.findTemporalEdge(
+                    mapping[static_cast<std::size_t>(arc.first)],
+                    mapping[static_cast<std::size_t>(arc.second)]);
+                if (edge == nullptr) return false;
+                if (previous == nullptr) {
+                    current.clear();
+                    for (const auto& interval : edge->active_intervals) {
+                        if (interval.length() >= k_threshold) current.push_back(interval);
+                    }
+                } else {
+                    current = intersectTimeIntervals(*previous, edge->active_intervals, k_threshold);
+                }
+                previous = &current;
+                if (current.empty()) return false;
+            }
+            return true;
+        };
+        auto report = [&]() {
+            if (stop_requested.load(std::memory_order_relaxed)) return;
+            // Workers race past a stop, so every match is claimed first.
+            const std::uint64_t claim =
+                limits.max_results > 0 || limits.exists_only ? claimed_matches++ : 0;
+            bool accept = true;
+            const MatchStopReason limit_stop = applyResultLimits(limits, claim, accept);
+            if (limit_stop != MatchStopReason::Complete) request_stop(limit_stop);
+            if (!accept) return;
+            ++match_count;
+            if (!callback(mapping, common_intervals.back())) request_stop(MatchStopReason::Consumer);
+        };
+
+        std::function<void(std::size_t)> extend;
+        extend = [&](std::size_t depth) {
+            if (stop_requested.load(std::memory_order_relaxed)) return;
+            if (deadline.expired()) {
+                request_stop(MatchStopReason::TimeLimit);
+                return;
+            }
+            if (depth == order.size()) {
+                report();
+                return;
+            }
+            const int query_vertex = order[depth];
+            const QueryVertexIndex& vertex_index = index[static_cast<std::size_t>(query_vertex)];
+            const CandidateMap& tree = vertex_index.tree;
+            const int parent_position = mapped_positions[static_cast<std::size_t>(tree.neighbor)];
+            for (int entry = tree.offsets[static_cast<std::size_t>(parent_position)];
+                 entry < tree.offsets[static_cast<std::size_t>(parent_position) + 1] &&
+                 !stop_requested.load(std::memory_order_relaxed);
+                 ++entry) {
+                const int position = tree.positions[static_cast<std::size_t>(entry)];
+                const int data_vertex = vertex_index.candidates[static_cast<std::size_t>(position)];
+                if (used[static_cast<std::size_t>(data_vertex)] != 0) continue;
+                bool listed = true;
+                for (const CandidateMap& non_tree : vertex_index.non_tree) {
+                    const std::size_t key = static_cast<std::size_t>(
+                        mapped_positions[static_cast<std::size_t>(non_tree.neighbor)]);
+                    if (!std::binary_search(
+                            non_tree.positions.begin() + non_tree.offsets[key],
+                            non_tree.positions.begin() + non_tree.offsets[key + 1], position)) {
+                        listed = false;
+                        break;
+                    }
+                }
+                if (!listed) continue;
+                mapping[static_cast<std::size_t>(query_vertex)] = data_vertex;
+                mapped_positions[static_cast<std::size_t>(query_vertex)] = position;
+                if (extend_intervals(depth, vertex_index)) {
+                    used[static_cast<std::size_t>(data_vertex)] = 1;
+                    extend(depth + 1);
+                    used[static_cast<std::size_t>(data_vertex)] = 0;
+                }
+                mapping[static_cast<std::size_t>(query_vertex)] = -1;
+                mapped_positions[static_cast<std::size_t>(query_vertex)] = -1;
+            }
+        };
+
+        const int root = order.front();
+        for (std::size_t cluster = next_cluster++;
+             cluster < clusters.size() && !stop_requested.load();
+             cluster = next_cluster++) {
+            mapping[static_cast<std::size_t>(root)] = clusters[cluster];
+            mapped_positions[static_cast<std::size_t>(root)] = static_cast<int>(cluster);
+            used[static_cast<std::size_t>(clusters[cluster])] = 1;
+            extend(1);
+            used[static_cast<std::size_t>(clusters[cluster])] = 0;
+        }
+    };
+
+    unsigned workers_wanted = thread_count > 0 ? thread_count : std::thread::hardware_concurrency();
+    workers_wanted = static_cast<unsigned>(std::min<std::size_t>(
+        std::max(workers_wanted, 1U), std::max<std::size_t>(clusters.size(), 1)));
+    std::vector<std::thread> workers;
+    for (unsigned worker = 1; worker < workers_wanted; ++worker) workers.emplace_back(run_clusters);
+    run_clusters();
+    for (auto& worker : workers) worker.join();
+
+    summary.match_count = match_count.load();
+    summary.enumeration_milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    return summary;
+}
+
+MatchSummary CeciMatcher::save_res(
+    const std::string& filename,
+    const MatchOptions& options) const {
+    MatchSummary summary;
+    std::ofstream output(filename, std::ios::binary);
+    if (!output.is_open()) return summary;
+
+    // Clusters share the section's writer; rowCallback() serializes them.
+    FinalMatchesSection section(output, G, Q, options.output_mode);
+    summary = forEachMatch(section.rowCallback(), options);
+    section.finish(summary);
+
+    output << "\n[CECI Summary]\n"
+           << "matching_order:";
+    for (int query_vertex : order) output << ' ' << query_vertex;
+    output << '\n'
+           << "clusters: " << index_statistics.clusters << '\n'
+           << "forward_candidates: " << index_statistics.forward_candidates << '\n'
+           << "refined_candidates: " << index_statistics.refined_candidates << '\n'
+           << "tree_edge_candidates: " << index_statistics.tree_edge_candidates << '\n'
+           << "non_tree_edge_candidates: " << index_statistics.non_tree_edge_candidates << '\n'
+           << "\n[Statistics]\n";
+    writeRunStatistics(output, options.output_mode, "ceci", summary.stop_reason);
+    writeTimingStatistics(output, summary);
+    output.flush();
+    summary.output_written = summary.output_written && output.good();
+    return summary;
+}
+
+std::size_t CeciMatcher::getMemoryUsage() const {
+    std::size_t total = query_relations.capacity() + durable_edges.capacity() +
+        (order.capacity() + order_positions.capacity() + parents.capacity()) * sizeof(int);
+    auto map_bytes = [](const CandidateMap& map) {
+        return sizeof(CandidateMap) +
+            (map.offsets.capacity() + map.positions.capacity()) * sizeof(int);
+    };
+    for (const auto& vertex_index : index) {
+        total += sizeof(QueryVertexIndex) + vertex_index.candidates.capacity() * sizeof(int) +
+            map_bytes(vertex_index.tree) +
+            vertex_index.backward_arcs.capacity() * sizeof(std::pair<int, int>);
+        for (const auto& non_tree : vertex_index.non_tree) total += map_bytes(non_tree);
+    }
+    return total;
+}
@@ -0,0 +1,105 @@
+#ifndef CECI_H
+#define CECI_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "TDTree.h"
+#include "Utils.h"
+
+// Durable CECI (compact embedding cluster index). The query is ordered by a
+// BFS tree from the vertex with the fewest candidates per query degree.
+// Every non-root query vertex keeps tree-edge candidates, keyed by its
+// parent's candidates, and non-tree-edge candidates, keyed by each earlier
+// non-tree neighbour's candidates. A data pair is an edge candidate only
+// when every query arc between the two query vertices maps to a data arc
+// and those arcs share a run of at least k snapshots. A forward pass in BFS
+// order and a backward refinement in reverse order drop candidates without
+// support from some query neighbour. Each root candidate's embedding
+// cluster is then enumerated on its own, in parallel, by intersecting
+// tree-edge and non-tree-edge candidate lists. Matches and their common
+// intervals equal TDTree's; only the row order differs.
+struct CeciStatistics {
+    // Root candidates, one embedding cluster each.
+    std::size_t clusters = 0;
+    // Candidates summed over query vertices after the forward pass and
+    // after backward refinement.
+    std::size_t forward_candidates = 0;
+    std::size_t refined_candidates = 0;
+    std::size_t tree_edge_candidates = 0;
+    std::size_t non_tree_edge_candidates = 0;
+};
+
+class CeciMatcher {
+public:
+    // query_graph must be connected with at least one arc. threads = 0 uses
+    // std::thread::hardware_concurrency() for enumeration.
+    CeciMatcher(
+        const Graph& temporal_graph,
+        const Graph& query_graph,
+        int minimum_duration,
+        unsigned threads = 0);
+
+    // The TDTree::save_res text layout, with a [CECI Summary] section after
+    // the matches in place of the candidate summary. Rows are numbered in
+    // the order clusters report them. Limits apply; the matching order,
+    // top-N and binary output do not.
+    MatchSummary save_res(
+        const std::string& filename,
+        const MatchOptions& options = {}) const;
+    // Calls come concurrently from the worker threads, one cluster per
+    // worker at a time, in no fixed cluster order.
+    MatchSummary forEachMatch(
+        const MatchCallback& callback,
+        const MatchOptions& options = {}) const;
+    const CeciStatistics& statistics() const { return index_statistics; }
+    const std::vector<int>& matchingOrder() const { return order; }
+    std::size_t getMemoryUsage() const;
+
+private:
+    // Candidate lists keyed by the candidates of an earlier query vertex:
+    // the entries for its candidate at position i are
+    // positions[offsets[i]..offsets[i + 1]), ascending positions into the
+    // owning vertex's candidates.
+    struct CandidateMap {
+        int neighbor = -1;
+        std::vector<int> offsets;
+        std::vector<int> positions;
+    };
+    struct QueryVertexIndex {
+        // Ascending data vertices.
+        std::vector<int> candidates;
+        // Keyed by the BFS-tree parent's candidates; empty at the root.
+        CandidateMap tree;
+        std::vector<CandidateMap> non_tree;
+        // Query arcs to earlier vertices in the order, tree arc included.
+        std::vector<std::pair<int, int>> backward_arcs;
+    };
+
+    const Graph& G;
+    const Graph& Q;
+    int k_threshold;
+    unsigned thread_count;
+
+    // Bit 1: source -> target is a query arc; bit 2: target -> source.
+    std::vector<std::uint8_t> query_relations;
+    std::vector<std::uint8_t> durable_edges;
+    std::vector<int> order;
+    std::vector<int> order_positions;
+    std::vector<int> parents;
+    std::vector<QueryVertexIndex> index;
+    CeciStatistics index_statistics;
+
+    std::uint8_t relation(int source, int target) const;
+    bool isInitialCandidate(int data_vertex, int query_vertex) const;
+    template <typename Visit>
+    void forEachEdgeCandidate(int query_vertex, int neighbor, int data_vertex, Visit visit) const;
+    void chooseOrder(const std::vector<std::vector<std::uint8_t>>& members);
+    void buildIndex();
+    CandidateMap buildCandidateMap(int query_vertex, int neighbor, std::vector<int>& positions) const;
+};
+
+#endif // CECI_H
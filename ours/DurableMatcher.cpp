@@ -0,0 +1,117 @@
+#include "DurableMatcher.h"
+
+#include <algorithm>
+#include <utility>
+
+PreparedQuery::PreparedQuery(
+    std::shared_ptr<const DataGraphHandle> data_graph,
+    Graph query_graph,
+    int minimum_duration)
+    : data_graph_(std::move(data_graph)),
+      query_graph_(std::move(query_graph)),
+      decomposition_(decomposeQuery(
+          query_graph_,
+          data_graph_->label_statistics.vertex_counts,
+          data_graph_->label_statistics.average_lifespans)),
+      minimum_duration_(minimum_duration) {
+    if (decomposition_.root >= 0 && decomposition_.connected) {
+        td_tree_ = std::make_unique<TDTree>(
+            data_graph_->graph, query_graph_, decomposition_, minimum_duration_);
+    }
+}
+
+MatchSummary PreparedQuery::forEachMatch(
+    const MatchCallback& callback,
+    const MatchOptions& options) const {
+    return td_tree_->forEachMatch(callback, options);
+}
+
+std::shared_ptr<const DataGraphHandle> loadGraph(
+    const std::string& filename,
+    std::uint32_t label_seed,
+    std::string& error) {
+    Graph graph;
+    if (!readTemporalGraph(filename, graph, label_seed)) {
+        error = "could not load temporal graph " + filename;
+        return nullptr;
+    }
+    return makeDataGraphHandle(std::move(graph));
+}
+
+std::shared_ptr<const DataGraphHandle> makeDataGraphHandle(Graph graph) {
+    auto handle = std::make_shared<DataGraphHandle>();
+    handle->graph = std::move(graph);
+    handle->label_statistics = computeLabelStatistics(handle->graph);
+    const Graph& data = handle->graph;
+    for (int source = 0; source < data.num_vertices; ++source) {
+        const Label source_label = data.vertex_labels[static_cast<std::size_t>(source)];
+        for (const Edge& edge : data.adj[static_cast<std::size_t>(source)]) {
+            const Label target_label = data.vertex_labels[static_cast<std::size_t>(edge.to)];
+            if (source_label < kLabelCount && target_label < kLabelCount) {
+                ++handle->label_arc_counts[source_label][target_label];
+            }
+        }
+    }
+    return handle;
+}
+
+std::shared_ptr<const PreparedQuery> prepareQuery(
+    std::shared_ptr<const DataGraphHandle> data_graph,
+    Graph query_graph,
+    int minimum_duration,
+    std::string& error) {
+    if (data_graph == nullptr) {
+        error = "no data graph";
+        return nullptr;
+    }
+    if (minimum_duration < 2) {
+        error = "k must be at least 2";
+        return nullptr;
+    }
+    // The constructor is private, so make_shared cannot reach it.
+    std::shared_ptr<const PreparedQuery> prepared(new PreparedQuery(
+        std::move(data_graph), std::move(query_graph), minimum_duration));
+    if (prepared->decomposition().root < 0) {
+        error = "no query root has data candidates with a positive active lifespan";
+        return nullptr;
+    }
+    if (!prepared->decomposition().connected) {
+        error = "query graph must be connected";
+        return nullptr;
+    }
+    return prepared;
+}
+
+std::size_t estimateTDTreeBytes(const DataGraphHandle& data_graph, const Graph& query_graph) {
+    const QueryDecomposition decomposition = decomposeQuery(
+        query_graph,
+        data_graph.label_statistics.vertex_counts,
+        data_graph.label_statistics.average_lifespans);
+    if (decomposition.root < 0) return 0;
+
+    // Vectors may hold up to twice their size after growth. Each block also
+    // costs an index entry and a hash node.
+    constexpr std::size_t kBlockOverhead = 2 * sizeof(TDTreeBlock) +
+        sizeof(std::pair<const int, std::size_t>) + 2 * sizeof(void*);
+    auto label_of = [&](int query_vertex) {
+        return query_graph.vertex_labels[static_cast<std::size_t>(query_vertex)];
+    };
+    std::size_t bytes = static_cast<std::size_t>(query_graph.num_vertices) * sizeof(TDTreeNode);
+    bytes += 2 * data_graph.label_statistics.vertex_counts[label_of(decomposition.root)] *
+        sizeof(int);
+    for (int query_vertex = 0; query_vertex < query_graph.num_vertices; ++query_vertex) {
+        const int parent = decomposition.parent[static_cast<std::size_t>(query_vertex)];
+        if (parent < 0) continue;
+        std::size_t arcs = 0;
+        if (GraphUtils::hasEdge(query_graph.adj, parent, query_vertex)) {
+            arcs += data_graph.label_arc_counts[label_of(parent)][label_of(query_vertex)];
+        }
+        if (GraphUtils::hasEdge(query_graph.adj, query_vertex, parent)) {
+            arcs += data_graph.label_arc_counts[label_of(query_vertex)][label_of(parent)];
+        }
+        const std::size_t blocks = std::min(
+            arcs, data_graph.label_statistics.vertex_counts[label_of(parent)]);
+        bytes += 2 * arcs * sizeof(int) + blocks * kBlockOverhead;
+    }
+    return bytes;
+}
@@ -0,0 +1,89 @@
+#ifndef DURABLE_MATCHER_H
+#define DURABLE_MATCHER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "TDTree.h"
+#include "Utils.h"
+#include "query_decomposition.h"
+
+// Embeddable entry points for linking the engine into another process.
+// Handles are immutable once built, so one data graph can serve many
+// queries and one prepared query can be enumerated repeatedly, including
+// from several threads at once.
+
+// A filtered temporal data graph and the label statistics its queries use.
+struct DataGraphHandle {
+    Graph graph;
+    LabelStatistics label_statistics;
+    // label_arc_counts[a][b] counts retained arcs from label a to label b.
+    std::array<std::array<std::size_t, kLabelCount>, kLabelCount> label_arc_counts{};
+};
+
+// A query decomposed against one data graph, with its TD-tree built for k.
+// Holds a reference to the data graph so it outlives the caller's handle.
+// Only prepareQuery builds one, so every handle has a connected query and a TD-tree.
+class PreparedQuery {
+public:
+    PreparedQuery(const PreparedQuery&) = delete;
+    PreparedQuery& operator=(const PreparedQuery&) = delete;
+
+    const DataGraphHandle& dataGraph() const { return *data_graph_; }
+    const Graph& queryGraph() const { return query_graph_; }
+    const QueryDecomposition& decomposition() const { return decomposition_; }
+    const TDTree& tdTree() const { return *td_tree_; }
+    int minimumDuration() const { return minimum_duration_; }
+
+    // Streams (mapping, intervals) pairs; see MatchCallback.
+    MatchSummary forEachMatch(
+        const MatchCallback& callback,
+        const MatchOptions& options = {}) const;
+
+private:
+    friend std::shared_ptr<const PreparedQuery> prepareQuery(
+        std::shared_ptr<const DataGraphHandle> data_graph,
+        Graph query_graph,
+        int minimum_duration,
+        std::string& error);
+
+    PreparedQuery(
+        std::shared_ptr<const DataGraphHandle> data_graph,
+        Graph query_graph,
+        int minimum_duration);
+
+    std::shared_ptr<const DataGraphHandle> data_graph_;
+    Graph query_graph_;
+    QueryDecomposition decomposition_;
+    int minimum_duration_;
+    // Built last: the TD-tree keeps references to the members above.
+    std::unique_ptr<TDTree> td_tree_;
+};
+
+// Reads and filters a temporal graph exactly like td_tree.exe. Returns null
+// and sets error on failure; the reader also reports details on stderr.
+std::shared_ptr<const DataGraphHandle> loadGraph(
+    const std::string& filename,
+    std::uint32_t label_seed,
+    std::string& error);
+
+// Wraps an already filtered graph, e.g. one built in memory.
+std::shared_ptr<const DataGraphHandle> makeDataGraphHandle(Graph graph);
+
+// Decomposes query_graph and builds its TD-tree. Returns null and sets error
+// when k is below 2 or the query is disconnected or has no viable root.
+std::shared_ptr<const PreparedQuery> prepareQuery(
+    std::shared_ptr<const DataGraphHandle> data_graph,
+    Graph query_graph,
+    int minimum_duration,
+    std::string& error);
+
+// Estimates the TD-tree size of query_graph from label-level arc counts
+// without building it, e.g. for admission control. Each spanning-tree arc
+// is assumed to keep every data arc between its two labels.
+std::size_t estimateTDTreeBytes(const DataGraphHandle& data_graph, const Graph& query_graph);
+
+#endif // DURABLE_MATCHER_H
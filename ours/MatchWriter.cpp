@@ -0,0 +1,181 @@
+#include "MatchWriter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <ostream>
+
+AsyncMatchWriter::AsyncMatchWriter(std::ostream& output, std::size_t buffer_bytes)
+    : output_(output),
+      // Room for the longest integer keeps appendInteger a single reserve.
+      active_(std::max<std::size_t>(buffer_bytes, 64)),
+      pending_(active_.size()),
+      worker_([this]() { run(); }) {}
+
+AsyncMatchWriter::~AsyncMatchWriter() {
+    finish();
+}
+
+void AsyncMatchWriter::append(char value) {
+    reserve(1);
+    active_[active_size_++] = value;
+}
+
+void AsyncMatchWriter::append(std::string_view text) {
+    while (!text.empty()) {
+        if (active_size_ == active_.size()) submit();
+        const std::size_t chunk = std::min(text.size(), active_.size() - active_size_);
+        std::memcpy(active_.data() + active_size_, text.data(), chunk);
+        active_size_ += chunk;
+        text.remove_prefix(chunk);
+    }
+}
+
+void AsyncMatchWriter::appendIntervals(const std::vector<TimeInterval>& intervals) {
+    append('[');
+    for (std::size_t i = 0; i < intervals.size(); ++i) {
+        if (i > 0) append(", ");
+        appendInteger(intervals[i].start);
+        if (intervals[i].end != intervals[i].start) {
+            append('-');
+            appendInteger(intervals[i].end);
+        }
+    }
+    append(']');
+}
+
+bool AsyncMatchWriter::finish() {
+    if (finished_) return output_.good();
+    finished_ = true;
+    const auto start = std::chrono::steady_clock::now();
+    if (active_size_ > 0) submit();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    condition_.notify_all();
+    worker_.join();
+    blocked_ += std::chrono::steady_clock::now() - start;
+    return output_.good();
+}
+
+long long AsyncMatchWriter::blockedMilliseconds() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(blocked_).count();
+}
+
+void AsyncMatchWriter::reserve(std::size_t bytes) {
+    if (active_.size() - active_size_ < bytes) submit();
+}
+
+void AsyncMatchWriter::submit() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (has_pending_) {
+        const auto start = std::chrono::steady_clock::now();
+        condition_.wait(lock, [this]() { return !has_pending_; });
+        blocked_ += std::chrono::steady_clock::now() - start;
+    }
+    active_.swap(pending_);
+    pending_size_ = active_size_;
+    active_size_ = 0;
+    has_pending_ = true;
+    lock.unlock();
+    condition_.notify_all();
+}
+
+void AsyncMatchWriter::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        condition_.wait(lock, [this]() { return has_pending_ || stopping_; });
+        if (!has_pending_) return;
+        // The producer never touches pending_ while has_pending_ is set.
+        lock.unlock();
+        output_.write(pending_.data(), static_cast<std::streamsize>(pending_size_));
+        lock.lock();
+        has_pending_ = false;
+        condition_.notify_all();
+    }
+}
+
+MatchRowFormatter::MatchRowFormatter(const Graph& data_graph, const Graph& query_graph)
+    : data_graph_(data_graph),
+      prefixes_(static_cast<std::size_t>(query_graph.num_vertices)) {
+    for (int query_vertex = 0; query_vertex < query_graph.num_vertices; ++query_vertex) {
+        prefixes_[static_cast<std::size_t>(query_vertex)] =
+            (query_vertex > 0 ? ", q" : "q") + std::to_string(query_vertex) + '(' +
+            labelToString(query_graph.vertex_labels[static_cast<std::size_t>(query_vertex)]) +
+            ")->";
+    }
+}
+
+void MatchRowFormatter::append(
+    AsyncMatchWriter& writer,
+    std::uint64_t match_index,
+    const std::vector<int>& mapping,
+    const std::vector<TimeInterval>& intervals) const {
+    writer.append("Match ");
+    writer.appendInteger(match_index);
+    writer.append(": ");
+    for (std::size_t query_vertex = 0; query_vertex < prefixes_.size(); ++query_vertex) {
+        writer.append(prefixes_[query_vertex]);
+        writer.appendInteger(data_graph_.externalId(mapping[query_vertex]));
+    }
+    writer.append(" | active=");
+    writer.appendIntervals(intervals);
+    writer.append('\n');
+}
+
+FinalMatchesSection::FinalMatchesSection(
+    std::ostream& output,
+    const Graph& data_graph,
+    const Graph& query_graph,
+    MatchOutputMode mode)
+    : output_(output),
+      row_formatter_(data_graph, query_graph) {
+    // Callers open output in binary mode so that the placeholder offset
+    // survives; text mode would translate '\n' to CRLF on Windows.
+    output_ << "[Final Matches]\nCount: ";
+    count_position_ = output_.tellp();
+    output_ << std::setw(20) << 0 << '\n';
+    if (mode == MatchOutputMode::Full) writer_ = std::make_unique<AsyncMatchWriter>(output_);
+}
+
+MatchCallback FinalMatchesSection::rowCallback() {
+    return [this](const std::vector<int>& mapping, const std::vector<TimeInterval>& intervals) {
+        if (writer_ == nullptr) return true;
+        const std::lock_guard<std::mutex> lock(row_mutex_);
+        row_formatter_.append(*writer_, next_row_++, mapping, intervals);
+        return true;
+    };
+}
+
+void FinalMatchesSection::finish(MatchSummary& summary) {
+    bool rows_written = true;
+    if (writer_ != nullptr) {
+        rows_written = writer_->finish();
+        summary.io_blocked_milliseconds = writer_->blockedMilliseconds();
+        writer_.reset();
+    }
+    const std::streampos end_position = output_.tellp();
+    output_.seekp(count_position_);
+    output_ << std::setw(20) << summary.match_count;
+    output_.seekp(end_position);
+    if (summary.stop_reason != MatchStopReason::Complete) {
+        output_ << "Truncated: " << matchStopReasonName(summary.stop_reason) << '\n';
+    }
+    summary.output_written = rows_written && output_.good();
+}
+
+void writeRunStatistics(
+    std::ostream& output,
+    MatchOutputMode mode,
+    const char* count_strategy,
+    MatchStopReason stop_reason) {
+    output << "mode: " << matchOutputModeName(mode) << '\n'
+           << "count_strategy: " << count_strategy << '\n'
+           << "stop_reason: " << matchStopReasonName(stop_reason) << '\n';
+}
+
+void writeTimingStatistics(std::ostream& output, const MatchSummary& summary) {
+    output << "enumeration_ms: " << summary.enumeration_milliseconds << '\n'
+           << "io_blocked_ms: " << summary.io_blocked_milliseconds << '\n';
+}
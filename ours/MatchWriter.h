@@ -0,0 +1,144 @@
+#ifndef MATCH_WRITER_H
+#define MATCH_WRITER_H
+
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "TDTree.h"
+#include "Utils.h"
+
+// Double-buffered writer for text or binary match rows. The enumerating
+// thread formats into one byte buffer with std::to_chars while a background
+// thread writes the other one to the stream. The stream must not be touched
+// by anyone else until finish() returns.
+class AsyncMatchWriter {
+public:
+    static constexpr std::size_t kDefaultBufferBytes = std::size_t{1} << 20;
+
+    explicit AsyncMatchWriter(
+        std::ostream& output,
+        std::size_t buffer_bytes = kDefaultBufferBytes);
+    ~AsyncMatchWriter();
+
+    AsyncMatchWriter(const AsyncMatchWriter&) = delete;
+    AsyncMatchWriter& operator=(const AsyncMatchWriter&) = delete;
+
+    void append(char value);
+    void append(std::string_view text);
+    void appendIntervals(const std::vector<TimeInterval>& intervals);
+
+    template <typename Integer>
+    void appendInteger(Integer value) {
+        // 20 digits and a sign cover every 64-bit integer.
+        reserve(21);
+        const auto result = std::to_chars(
+            active_.data() + active_size_, active_.data() + active_.size(), value);
+        active_size_ = static_cast<std::size_t>(result.ptr - active_.data());
+    }
+
+    template <typename Unsigned>
+    void appendLittleEndian(Unsigned value) {
+        reserve(sizeof(Unsigned));
+        for (std::size_t i = 0; i < sizeof(Unsigned); ++i) {
+            active_[active_size_++] = static_cast<char>((value >> (8 * i)) & 0xffU);
+        }
+    }
+
+    // Writes the remaining bytes and joins the background thread. Returns
+    // false if the stream failed. Later calls are no-ops.
+    bool finish();
+
+    // Time the enumerating thread spent waiting for the background writes.
+    long long blockedMilliseconds() const;
+
+private:
+    void reserve(std::size_t bytes);
+    void submit();
+    void run();
+
+    std::ostream& output_;
+    std::vector<char> active_;
+    std::size_t active_size_ = 0;
+    std::vector<char> pending_;
+    std::size_t pending_size_ = 0;
+    bool has_pending_ = false;
+    bool stopping_ = false;
+    bool finished_ = false;
+    std::chrono::steady_clock::duration blocked_{};
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::thread worker_;
+};
+
+// Formats the text rows every engine writes under [Final Matches]:
+// "Match <index>: q0(A)-><id>, q1(B)-><id> | active=[<intervals>]", with
+// data vertices restored to their external IDs.
+class MatchRowFormatter {
+public:
+    MatchRowFormatter(const Graph& data_graph, const Graph& query_graph);
+
+    void append(
+        AsyncMatchWriter& writer,
+        std::uint64_t match_index,
+        const std::vector<int>& mapping,
+        const std::vector<TimeInterval>& intervals) const;
+
+private:
+    const Graph& data_graph_;
+    std::vector<std::string> prefixes_;
+};
+
+// The [Final Matches] section every text result file shares. The
+// constructor writes a Count placeholder; rows go through writer() or
+// rowCallback() and finish() drains them, patches the count and adds a
+// Truncated line when the run stopped early. output must stay untouched
+// in between.
+class FinalMatchesSection {
+public:
+    FinalMatchesSection(
+        std::ostream& output,
+        const Graph& data_graph,
+        const Graph& query_graph,
+        MatchOutputMode mode);
+
+    FinalMatchesSection(const FinalMatchesSection&) = delete;
+    FinalMatchesSection& operator=(const FinalMatchesSection&) = delete;
+
+    // Null in count-only mode.
+    AsyncMatchWriter* writer() { return writer_.get(); }
+    // Numbers and formats each match as it arrives; safe to call from
+    // several threads. Writes nothing in count-only mode.
+    MatchCallback rowCallback();
+
+    // Also fills summary.io_blocked_milliseconds and output_written.
+    void finish(MatchSummary& summary);
+
+private:
+    std::ostream& output_;
+    std::streampos count_position_;
+    MatchRowFormatter row_formatter_;
+    std::unique_ptr<AsyncMatchWriter> writer_;
+    std::mutex row_mutex_;
+    std::uint64_t next_row_ = 0;
+};
+
+// The mode, count_strategy and stop_reason lines of [Statistics].
+void writeRunStatistics(
+    std::ostream& output,
+    MatchOutputMode mode,
+    const char* count_strategy,
+    MatchStopReason stop_reason);
+// The enumeration_ms and io_blocked_ms lines of [Statistics].
+void writeTimingStatistics(std::ostream& output, const MatchSummary& summary);
+
+#endif // MATCH_WRITER_H
@@ -0,0 +1,341 @@
+#include "QueryService.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DurableMatcher.h"
+
+namespace {
+
+long long elapsedMilliseconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+// Serializes response blocks so lines from concurrent queries never mix.
+class ResponseWriter {
+public:
+    explicit ResponseWriter(std::ostream& output) : output_(output) {}
+
+    void write(const std::string& block) {
+        if (block.empty()) return;
+        std::lock_guard<std::mutex> lock(mutex_);
+        output_ << block;
+        output_.flush();
+    }
+
+private:
+    std::ostream& output_;
+    std::mutex mutex_;
+};
+
+// Admits a query only while the estimated TD-tree bytes of all running
+// queries fit in the budget. A budget of 0 admits everything.
+class MemoryAdmission {
+public:
+    explicit MemoryAdmission(std::size_t budget_bytes) : budget_bytes_(budget_bytes) {}
+
+    // Waits for room; false if the estimate alone exceeds the budget.
+    bool acquire(std::size_t bytes) {
+        if (budget_bytes_ == 0) return true;
+        if (bytes > budget_bytes_) return false;
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait(lock, [&]() { return reserved_bytes_ + bytes <= budget_bytes_; });
+        reserved_bytes_ += bytes;
+        return true;
+    }
+
+    void release(std::size_t bytes) {
+        if (budget_bytes_ == 0) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            reserved_bytes_ -= bytes;
+        }
+        condition_.notify_all();
+    }
+
+private:
+    std::size_t budget_bytes_;
+    std::size_t reserved_bytes_ = 0;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+};
+
+class WorkerPool {
+public:
+    explicit WorkerPool(unsigned worker_count) {
+        for (unsigned i = 0; i < worker_count; ++i) {
+            workers_.emplace_back([this]() { run(); });
+        }
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        condition_.notify_all();
+        for (auto& worker : workers_) worker.join();
+    }
+
+    void submit(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            jobs_.push_back(std::move(job));
+        }
+        condition_.notify_one();
+    }
+
+private:
+    void run() {
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                condition_.wait(lock, [this]() { return stopping_ || !jobs_.empty(); });
+                // Queued queries still run after QUIT; stopping only ends idle workers.
+                if (jobs_.empty()) return;
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+            }
+            job();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> jobs_;
+    bool stopping_ = false;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+};
+
+struct QueryRequest {
+    std::string id;
+    std::shared_ptr<const DataGraphHandle> data_graph;
+    Graph query_graph;
+    int minimum_duration = 0;
+    bool stream_matches = false;
+    MatchOptions options;
+};
+
+// Streamed rows are flushed in blocks of about this size.
+constexpr std::size_t kResponseBlockBytes = 64 * 1024;
+
+void runQuery(const QueryRequest& request, MemoryAdmission& admission, ResponseWriter& responses) {
+    const std::size_t estimated_bytes =
+        estimateTDTreeBytes(*request.data_graph, request.query_graph);
+    const auto admission_start = std::chrono::steady_clock::now();
+    if (!admission.acquire(estimated_bytes)) {
+        responses.write("ERROR " + request.id + " estimated TD-tree size " +
+                        std::to_string(estimated_bytes) + " bytes exceeds the memory budget\n");
+        return;
+    }
+    const long long admission_wait_milliseconds = elapsedMilliseconds(admission_start);
+
+    const auto build_start = std::chrono::steady_clock::now();
+    std::string error;
+    const auto prepared = prepareQuery(
+        request.data_graph, request.query_graph, request.minimum_duration, error);
+    const long long build_milliseconds = elapsedMilliseconds(build_start);
+    if (prepared == nullptr) {
+        admission.release(estimated_bytes);
+        responses.write("ERROR " + request.id + ' ' + error + '\n');
+        return;
+    }
+
+    const Graph& data = request.data_graph->graph;
+    std::string block;
+    const MatchSummary summary = prepared->forEachMatch(
+        [&](const std::vector<int>& mapping, const std::vector<TimeInterval>& intervals) {
+            if (!request.stream_matches) return true;
+            block += "MATCH ";
+            block += request.id;
+            for (std::size_t query_vertex = 0; query_vertex < mapping.size(); ++query_vertex) {
+                block += query_vertex == 0 ? ' ' : ',';
+                block += std::to_string(data.externalId(mapping[query_vertex]));
+            }
+            block += ' ';
+            block += formatIntervals(intervals);
+            block += '\n';
+            if (block.size() >= kResponseBlockBytes) {
+                responses.write(block);
+                block.clear();
+            }
+            return true;
+        },
+        request.options);
+    const std::size_t td_tree_bytes = prepared->tdTree().getMemoryUsage();
+    const std::size_t relation_entries = prepared->tdTree().candidateRelationCount();
+    admission.release(estimated_bytes);
+
+    std::ostringstream result;
+    result << "RESULT " << request.id
+           << " count=" << summary.match_count
+           << " stop_reason=" << matchStopReasonName(summary.stop_reason)
+           << " estimated_td_tree_bytes=" << estimated_bytes
+           << " td_tree_bytes=" << td_tree_bytes
+           << " candidate_relation_entries=" << relation_entries
+           << " admission_wait_ms=" << admission_wait_milliseconds
+           << " build_ms=" << build_milliseconds
+           << " enumeration_ms=" << summary.enumeration_milliseconds << '\n';
+    block += result.str();
+    responses.write(block);
+}
+
+} // namespace
+
+void serveQueries(std::istream& input, std::ostream& output, const QueryServiceOptions& options) {
+    ResponseWriter responses(output);
+    MemoryAdmission admission(options.memory_budget_bytes);
+    std::map<std::string, std::shared_ptr<const DataGraphHandle>> catalog;
+    std::mutex catalog_mutex;
+    {
+        WorkerPool pool(options.worker_count);
+        std::string line;
+        while (std::getline(input, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            std::istringstream parser(line);
+            std::string command;
+            if (!(parser >> command) || command[0] == '#') continue;
+
+            if (command == "QUIT") break;
+            if (command == "LOAD") {
+                std::string name;
+                std::string path;
+                std::string seed_text;
+                long long seed = kDefaultLabelSeed;
+                if (!(parser >> name >> path) ||
+                    ((parser >> seed_text) &&
+                     !parseInteger(seed_text, 0, std::numeric_limits<std::uint32_t>::max(), seed))) {
+                    responses.write("ERROR LOAD usage: LOAD <name> <path> [label seed]\n");
+                    continue;
+                }
+                const auto load_start = std::chrono::steady_clock::now();
+                std::string error;
+                auto handle = loadGraph(path, static_cast<std::uint32_t>(seed), error);
+                if (handle == nullptr) {
+                    responses.write("ERROR LOAD " + name + ' ' + error + '\n');
+                    continue;
+                }
+                std::ostringstream response;
+                response << "OK LOAD " << name
+                         << " vertices=" << handle->graph.num_vertices
+                         << " retained_edges=" << handle->graph.filtered_edge_count
+                         << " memory_bytes=" << handle->graph.getMemoryUsage()
+                         << " load_ms=" << elapsedMilliseconds(load_start) << '\n';
+                {
+                    std::lock_guard<std::mutex> lock(catalog_mutex);
+                    catalog[name] = std::move(handle);
+                }
+                responses.write(response.str());
+                continue;
+            }
+            if (command == "UNLOAD") {
+                std::string name;
+                parser >> name;
+                std::lock_guard<std::mutex> lock(catalog_mutex);
+                // Running queries keep their own reference to the graph.
+                responses.write(catalog.erase(name) > 0
+                    ? "OK UNLOAD " + name + '\n'
+                    : "ERROR UNLOAD unknown graph " + name + '\n');
+                continue;
+            }
+            if (command == "GRAPHS") {
+                std::ostringstream response;
+                std::lock_guard<std::mutex> lock(catalog_mutex);
+                for (const auto& entry : catalog) {
+                    response << "GRAPH " << entry.first
+                             << " vertices=" << entry.second->graph.num_vertices
+                             << " retained_edges=" << entry.second->graph.filtered_edge_count << '\n';
+                }
+                response << "OK GRAPHS " << catalog.size() << '\n';
+                responses.write(response.str());
+                continue;
+            }
+            if (command != "QUERY") {
+                responses.write("ERROR " + command + " unknown command\n");
+                continue;
+            }
+
+            // QUERY <id> <graph> <k> <count|matches> [options] : <u> <v> [; <u> <v> ...]
+            QueryRequest request;
+            std::string graph_name;
+            std::string k_text;
+            std::string mode;
+            long long k = 0;
+            if (!(parser >> request.id >> graph_name >> k_text >> mode) ||
+                !parseInteger(k_text, 0, std::numeric_limits<int>::max(), k) ||
+                (mode != "count" && mode != "matches")) {
+                responses.write("ERROR QUERY usage: QUERY <id> <graph> <k> <count|matches> "
+                                "[limit=N] [exists] [time-limit=S] [order=adaptive] : <u> <v> ; ...\n");
+                continue;
+            }
+            request.minimum_duration = static_cast<int>(k);
+            request.stream_matches = mode == "matches";
+            std::string token;
+            bool options_valid = true;
+            bool saw_edges = false;
+            while (parser >> token) {
+                long long value = 0;
+                if (token == ":") {
+                    saw_edges = true;
+                    break;
+                }
+                if (token == "exists") {
+                    request.options.limits.exists_only = true;
+                } else if (token == "order=adaptive") {
+                    request.options.matching_order = MatchingOrder::Adaptive;
+                } else if (token.rfind("limit=", 0) == 0 &&
+                           parseInteger(token.substr(6), 1,
+                                        std::numeric_limits<long long>::max(), value)) {
+                    request.options.limits.max_results = static_cast<std::uint64_t>(value);
+                } else if (token.rfind("time-limit=", 0) == 0 &&
+                           parseInteger(token.substr(11), 0,
+                                        std::numeric_limits<int>::max(), value)) {
+                    request.options.limits.time_limit_seconds = static_cast<int>(value);
+                } else {
+                    options_valid = false;
+                    break;
+                }
+            }
+            if (!options_valid || !saw_edges) {
+                responses.write("ERROR " + request.id + " invalid query options\n");
+                continue;
+            }
+            std::string edges;
+            std::getline(parser, edges);
+            std::replace(edges.begin(), edges.end(), ';', '\n');
+            std::istringstream edge_input(edges);
+            if (!parseQueryGraph(edge_input, request.query_graph) ||
+                request.query_graph.num_vertices == 0) {
+                responses.write("ERROR " + request.id + " invalid query graph\n");
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> lock(catalog_mutex);
+                const auto found = catalog.find(graph_name);
+                if (found != catalog.end()) request.data_graph = found->second;
+            }
+            if (request.data_graph == nullptr) {
+                responses.write("ERROR " + request.id + " unknown graph " + graph_name + '\n');
+                continue;
+            }
+            pool.submit([request = std::move(request), &admission, &responses]() {
+                runQuery(request, admission, responses);
+            });
+        }
+    }
+}
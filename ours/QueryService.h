@@ -0,0 +1,21 @@
+#ifndef QUERY_SERVICE_H
+#define QUERY_SERVICE_H
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+
+// Line-protocol query service: graphs are loaded once and stay resident while
+// queries run concurrently on a worker pool. See README.md for the protocol.
+
+struct QueryServiceOptions {
+    unsigned worker_count = 1;
+    // Estimated TD-tree bytes all running queries may reserve; 0 admits everything.
+    std::size_t memory_budget_bytes = 0;
+};
+
+// Answers the request lines of input on output until QUIT or end of input.
+// Returns once every admitted query has written its reply.
+void serveQueries(std::istream& input, std::ostream& output, const QueryServiceOptions& options);
+
+#endif // QUERY_SERVICE_H
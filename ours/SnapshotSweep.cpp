@@ -0,0 +1,336 @@
+#include "SnapshotSweep.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <limits>
+
+#include "MatchWriter.h"
+
+SnapshotSweepMatcher::SnapshotSweepMatcher(
+    const Graph& temporal_graph,
+    const Graph& query_graph,
+    int minimum_duration)
+    : G(temporal_graph), Q(query_graph), k_threshold(minimum_duration) {
+    for (int source = 0; source < Q.num_vertices; ++source) {
+        for (const Edge& edge : Q.adj[static_cast<std::size_t>(source)]) {
+            query_arcs.emplace_back(source, edge.to);
+        }
+    }
+    buildSeedPlans();
+    buildRuns();
+}
+
+void SnapshotSweepMatcher::buildSeedPlans() {
+    seed_plans.resize(query_arcs.size());
+    for (std::size_t seed_arc = 0; seed_arc < query_arcs.size(); ++seed_arc) {
+        SeedPlan& plan = seed_plans[seed_arc];
+        std::vector<std::uint8_t> placed(static_cast<std::size_t>(Q.num_vertices), 0);
+        placed[static_cast<std::size_t>(query_arcs[seed_arc].first)] = 1;
+        placed[static_cast<std::size_t>(query_arcs[seed_arc].second)] = 1;
+        for (std::size_t arc = 0; arc < query_arcs.size(); ++arc) {
+            if (arc != seed_arc && placed[static_cast<std::size_t>(query_arcs[arc].first)] &&
+                placed[static_cast<std::size_t>(query_arcs[arc].second)]) {
+                plan.check_arcs.push_back(static_cast<int>(arc));
+            }
+        }
+
+        // Greedily place the vertex with the most arcs to placed vertices
+        // (the lowest ID on ties): its first such arc supplies candidates
+        // and the others prune them.
+        for (int placed_count = 2; placed_count < Q.num_vertices; ++placed_count) {
+            int best_vertex = -1;
+            int best_arcs = 0;
+            for (int query_vertex = 0; query_vertex < Q.num_vertices; ++query_vertex) {
+                if (placed[static_cast<std::size_t>(query_vertex)]) continue;
+                int arcs_to_placed = 0;
+                for (const auto& arc : query_arcs) {
+                    if ((arc.first == query_vertex && placed[static_cast<std::size_t>(arc.second)]) ||
+                        (arc.second == query_vertex && placed[static_cast<std::size_t>(arc.first)])) {
+                        ++arcs_to_placed;
+                    }
+                }
+                if (arcs_to_placed > best_arcs) {
+                    best_vertex = query_vertex;
+                    best_arcs = arcs_to_placed;
+                }
+            }
+            // A disconnected query leaves the plan incomplete; it never matches.
+            if (best_vertex < 0) {
+                plan.steps.clear();
+                plan.check_arcs.assign(1, -1);
+                break;
+            }
+
+            PlanStep step;
+            step.query_vertex = best_vertex;
+            for (std::size_t arc = 0; arc < query_arcs.size(); ++arc) {
+                const auto [source, target] = query_arcs[arc];
+                int other_vertex = -1;
+                if (source == best_vertex && placed[static_cast<std::size_t>(target)]) {
+                    other_vertex = target;
+                } else if (target == best_vertex && placed[static_cast<std::size_t>(source)]) {
+                    other_vertex = source;
+                } else {
+                    continue;
+                }
+                if (step.parent_arc < 0) {
+                    step.parent_vertex = other_vertex;
+                    step.parent_arc = static_cast<int>(arc);
+                    step.parent_outgoing = source == other_vertex;
+                } else {
+                    step.check_arcs.push_back(static_cast<int>(arc));
+                }
+            }
+            placed[static_cast<std::size_t>(best_vertex)] = 1;
+            plan.steps.push_back(std::move(step));
+        }
+    }
+}
+
+void SnapshotSweepMatcher::buildRuns() {
+    for (std::size_t edge_id = 0; edge_id < G.temporal_edges.size(); ++edge_id) {
+        for (const auto& interval : G.temporal_edges[edge_id].active_intervals) {
+            if (interval.length() < k_threshold) continue;
+            runs_by_enter.push_back(
+                {interval.start, interval.end - k_threshold + 2, static_cast<int>(edge_id)});
+        }
+    }
+    runs_by_leave = runs_by_enter;
+    std::sort(runs_by_enter.begin(), runs_by_enter.end(), [](const Run& lhs, const Run& rhs) {
+        return lhs.enter != rhs.enter ? lhs.enter < rhs.enter : lhs.edge_id < rhs.edge_id;
+    });
+    std::sort(runs_by_leave.begin(), runs_by_leave.end(), [](const Run& lhs, const Run& rhs) {
+        return lhs.leave < rhs.leave;
+    });
+}
+
+MatchSummary SnapshotSweepMatcher::forEachMatch(
+    const MatchCallback& callback,
+    const MatchOptions& options,
+    SnapshotSweepStatistics* statistics) const {
+    MatchSummary summary;
+    const auto start = std::chrono::steady_clock::now();
+    SnapshotSweepStatistics sweep_statistics;
+    sweep_statistics.runs = runs_by_enter.size();
+
+    const MatchLimits& limits = options.limits;
+    DeadlineGuard deadline(limits, start);
+    bool stop_requested = false;
+    auto should_stop = [&]() {
+        if (stop_requested) return true;
+        if (deadline.expired()) {
+            stop_requested = true;
+            summary.stop_reason = MatchStopReason::TimeLimit;
+        }
+        return stop_requested;
+    };
+
+    // The alive edges of the current window, with each edge's slot in its
+    // endpoints' lists so that a leaving run is removed in O(1).
+    const std::size_t edge_count = G.temporal_edges.size();
+    std::vector<std::vector<Edge>> alive_out(static_cast<std::size_t>(G.num_vertices));
+    std::vector<std::vector<Edge>> alive_in(static_cast<std::size_t>(G.num_vertices));
+    std::vector<int> out_slot(edge_count, -1);
+    std::vector<int> in_slot(edge_count, -1);
+    std::vector<int> entered_at(edge_count, std::numeric_limits<int>::min());
+    std::size_t alive_edges = 0;
+    auto insert_edge = [&](int edge_id) {
+        const TemporalEdge& edge = G.temporal_edges[static_cast<std::size_t>(edge_id)];
+        auto& out_edges = alive_out[static_cast<std::size_t>(edge.u)];
+        auto& in_edges = alive_in[static_cast<std::size_t>(edge.v)];
+        out_slot[static_cast<std::size_t>(edge_id)] = static_cast<int>(out_edges.size());
+        in_slot[static_cast<std::size_t>(edge_id)] = static_cast<int>(in_edges.size());
+        out_edges.push_back({edge.v, edge_id});
+        in_edges.push_back({edge.u, edge_id});
+        ++alive_edges;
+    };
+    auto erase_from = [](std::vector<Edge>& edges, std::vector<int>& slots, int edge_id) {
+        const int slot = slots[static_cast<std::size_t>(edge_id)];
+        edges[static_cast<std::size_t>(slot)] = edges.back();
+        slots[static_cast<std::size_t>(edges.back().temporal_edge_id)] = slot;
+        edges.pop_back();
+        slots[static_cast<std::size_t>(edge_id)] = -1;
+    };
+    auto erase_edge = [&](int edge_id) {
+        const TemporalEdge& edge = G.temporal_edges[static_cast<std::size_t>(edge_id)];
+        erase_from(alive_out[static_cast<std::size_t>(edge.u)], out_slot, edge_id);
+        erase_from(alive_in[static_cast<std::size_t>(edge.v)], in_slot, edge_id);
+        --alive_edges;
+    };
+
+    std::vector<int> mapping(static_cast<std::size_t>(Q.num_vertices), -1);
+    std::vector<std::uint8_t> used(static_cast<std::size_t>(G.num_vertices), 0);
+    std::vector<int> arc_edges(query_arcs.size(), -1);
+    std::vector<TimeInterval> common_intervals;
+    int sweep_time = 0;
+    std::size_t seed_arc = 0;
+    std::uint64_t match_count = 0;
+
+    // An embedding containing several entering edges is seeded only from
+    // the first arc mapped to one, so earlier arcs must not be entering.
+    auto usable = [&](int arc, int edge_id) {
+        return out_slot[static_cast<std::size_t>(edge_id)] >= 0 &&
+            (static_cast<std::size_t>(arc) >= seed_arc ||
+             entered_at[static_cast<std::size_t>(edge_id)] != sweep_time);
+    };
+    auto verify_arcs = [&](const std::vector<int>& arcs) {
+        for (int arc : arcs) {
+            if (arc < 0) return false;
+            const auto [source, target] = query_arcs[static_cast<std::size_t>(arc)];
+            const TemporalEdge* edge = G.findTemporalEdge(
+                mapping[static_cast<std::size_t>(source)], mapping[static_cast<std::size_t>(target)]);
+            if (edge == nullptr) return false;
+            const int edge_id = static_cast<int>(edge - G.temporal_edges.data());
+            if (!usable(arc, edge_id)) return false;
+            arc_edges[static_cast<std::size_t>(arc)] = edge_id;
+        }
+        return true;
+    };
+    // Every arc is alive, so the common intervals hold a run starting at or
+    // before sweep_time; the embedding is new only if none starts earlier.
+    auto report_embedding = [&]() {
+        ++sweep_statistics.seeded_embeddings;
+        common_intervals.clear();
+        for (const auto& interval :
+             G.temporal_edges[static_cast<std::size_t>(arc_edges[0])].active_intervals) {
+            if (interval.length() >= k_threshold) common_intervals.push_back(interval);
+        }
+        for (std::size_t arc = 1; arc < arc_edges.size(); ++arc) {
+            common_intervals = intersectTimeIntervals(
+                common_intervals,
+                G.temporal_edges[static_cast<std::size_t>(arc_edges[arc])].active_intervals,
+                k_threshold);
+        }
+        if (common_intervals.empty() || common_intervals.front().start != sweep_time) return;
+        bool accept = true;
+        const MatchStopReason limit_stop = applyResultLimits(limits, match_count, accept);
+        if (limit_stop != MatchStopReason::Complete) {
+            stop_requested = true;
+            summary.stop_reason = limit_stop;
+        }
+        if (!accept) return;
+        ++match_count;
+        if (!callback(mapping, common_intervals) && !stop_requested) {
+            stop_requested = true;
+            summary.stop_reason = MatchStopReason::Consumer;
+        }
+    };
+
+    std::function<void(std::size_t)> extend;
+    extend = [&](std::size_t step_index) {
+        if (should_stop()) return;
+        const SeedPlan& plan = seed_plans[seed_arc];
+        if (step_index == plan.steps.size()) {
+            report_embedding();
+            return;
+        }
+        const PlanStep& step = plan.steps[step_index];
+        const Label label = Q.vertex_labels[static_cast<std::size_t>(step.query_vertex)];
+        const int parent = mapping[static_cast<std::size_t>(step.parent_vertex)];
+        const auto& neighbors = step.parent_outgoing
+            ? alive_out[static_cast<std::size_t>(parent)]
+            : alive_in[static_cast<std::size_t>(parent)];
+        for (std::size_t i = 0; i < neighbors.size() && !stop_requested; ++i) {
+            const Edge& edge = neighbors[i];
+            if (used[static_cast<std::size_t>(edge.to)] ||
+                G.vertex_labels[static_cast<std::size_t>(edge.to)] != label ||
+                !usable(step.parent_arc, edge.temporal_edge_id)) {
+                continue;
+            }
+            mapping[static_cast<std::size_t>(step.query_vertex)] = edge.to;
+            used[static_cast<std::size_t>(edge.to)] = 1;
+            arc_edges[static_cast<std::size_t>(step.parent_arc)] = edge.temporal_edge_id;
+            if (verify_arcs(step.check_arcs)) extend(step_index + 1);
+            used[static_cast<std::size_t>(edge.to)] = 0;
+            mapping[static_cast<std::size_t>(step.query_vertex)] = -1;
+        }
+    };
+
+    std::size_t next_enter = 0;
+    std::size_t next_leave = 0;
+    while (next_enter < runs_by_enter.size() && !stop_requested) {
+        sweep_time = runs_by_enter[next_enter].enter;
+        ++sweep_statistics.steps;
+        while (next_leave < runs_by_leave.size() && runs_by_leave[next_leave].leave <= sweep_time) {
+            erase_edge(runs_by_leave[next_leave++].edge_id);
+        }
+        const std::size_t first_entering = next_enter;
+        for (; next_enter < runs_by_enter.size() && runs_by_enter[next_enter].enter == sweep_time;
+             ++next_enter) {
+            const int edge_id = runs_by_enter[next_enter].edge_id;
+            insert_edge(edge_id);
+            entered_at[static_cast<std::size_t>(edge_id)] = sweep_time;
+        }
+        sweep_statistics.peak_alive_edges = std::max(sweep_statistics.peak_alive_edges, alive_edges);
+
+        for (std::size_t run = first_entering; run < next_enter && !stop_requested; ++run) {
+            const int edge_id = runs_by_enter[run].edge_id;
+            const TemporalEdge& edge = G.temporal_edges[static_cast<std::size_t>(edge_id)];
+            for (seed_arc = 0; seed_arc < query_arcs.size() && !stop_requested; ++seed_arc) {
+                const auto [source, target] = query_arcs[seed_arc];
+                if (edge.u == edge.v ||
+                    G.vertex_labels[static_cast<std::size_t>(edge.u)] !=
+                        Q.vertex_labels[static_cast<std::size_t>(source)] ||
+                    G.vertex_labels[static_cast<std::size_t>(edge.v)] !=
+                        Q.vertex_labels[static_cast<std::size_t>(target)]) {
+                    continue;
+                }
+                mapping[static_cast<std::size_t>(source)] = edge.u;
+                mapping[static_cast<std::size_t>(target)] = edge.v;
+                used[static_cast<std::size_t>(edge.u)] = 1;
+                used[static_cast<std::size_t>(edge.v)] = 1;
+                arc_edges[seed_arc] = edge_id;
+                if (verify_arcs(seed_plans[seed_arc].check_arcs)) extend(0);
+                used[static_cast<std::size_t>(edge.u)] = 0;
+                used[static_cast<std::size_t>(edge.v)] = 0;
+                mapping[static_cast<std::size_t>(source)] = -1;
+                mapping[static_cast<std::size_t>(target)] = -1;
+            }
+        }
+    }
+
+    summary.match_count = match_count;
+    summary.enumeration_milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    if (statistics != nullptr) *statistics = sweep_statistics;
+    return summary;
+}
+
+MatchSummary SnapshotSweepMatcher::save_res(
+    const std::string& filename,
+    const MatchOptions& options) const {
+    MatchSummary summary;
+    std::ofstream output(filename, std::ios::binary);
+    if (!output.is_open()) return summary;
+
+    FinalMatchesSection section(output, G, Q, options.output_mode);
+    SnapshotSweepStatistics statistics;
+    summary = forEachMatch(section.rowCallback(), options, &statistics);
+    section.finish(summary);
+
+    output << "\n[Sweep Summary]\n"
+           << "runs: " << statistics.runs << '\n'
+           << "steps: " << statistics.steps << '\n'
+           << "peak_alive_edges: " << statistics.peak_alive_edges << '\n'
+           << "seeded_embeddings: " << statistics.seeded_embeddings << '\n'
+           << "\n[Statistics]\n";
+    writeRunStatistics(output, options.output_mode, "snapshot-sweep", summary.stop_reason);
+    writeTimingStatistics(output, summary);
+    output.flush();
+    summary.output_written = summary.output_written && output.good();
+    return summary;
+}
+
+std::size_t SnapshotSweepMatcher::getMemoryUsage() const {
+    std::size_t total = (runs_by_enter.capacity() + runs_by_leave.capacity()) * sizeof(Run) +
+        query_arcs.capacity() * sizeof(std::pair<int, int>);
+    for (const auto& plan : seed_plans) {
+        total += sizeof(SeedPlan) + plan.check_arcs.capacity() * sizeof(int);
+        for (const auto& step : plan.steps) {
+            total += sizeof(PlanStep) + step.check_arcs.capacity() * sizeof(int);
+        }
+    }
+    return total;
+}
@@ -0,0 +1,90 @@
+#ifndef SNAPSHOT_SWEEP_H
+#define SNAPSHOT_SWEEP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "TDTree.h"
+#include "Utils.h"
+
+// Time-centric alternative to the TD-tree engine. A window of k snapshots
+// sweeps the time axis; an edge is alive while the window lies inside one
+// of its active intervals, so each interval of at least k snapshots is one
+// run that enters at its start and leaves k - 1 snapshots before its end.
+// Whenever runs enter, static matching is seeded on each entering edge and
+// extended over the alive edges only. A match is reported at the start of
+// its earliest common k-run, which is exactly one sweep step, and by the
+// first query arc mapped to an entering edge there, so it is reported once.
+// Matches and their common intervals equal TDTree's; only the row order
+// differs.
+struct SnapshotSweepStatistics {
+    std::size_t runs = 0;
+    // Sweep steps, i.e. distinct run start snapshots.
+    std::size_t steps = 0;
+    std::size_t peak_alive_edges = 0;
+    // Embeddings completed on alive edges, before the earliest-run check.
+    std::uint64_t seeded_embeddings = 0;
+};
+
+class SnapshotSweepMatcher {
+public:
+    // query_graph needs at least one arc.
+    SnapshotSweepMatcher(
+        const Graph& temporal_graph,
+        const Graph& query_graph,
+        int minimum_duration);
+
+    // The TDTree::save_res text layout, with a [Sweep Summary] section after
+    // the matches in place of the candidate summary. Limits apply; the
+    // matching order, top-N and binary output do not.
+    MatchSummary save_res(
+        const std::string& filename,
+        const MatchOptions& options = {}) const;
+    // Concurrent calls are safe; each keeps its own sweep state.
+    MatchSummary forEachMatch(
+        const MatchCallback& callback,
+        const MatchOptions& options = {},
+        SnapshotSweepStatistics* statistics = nullptr) const;
+    std::size_t getMemoryUsage() const;
+
+private:
+    struct Run {
+        int enter = 0;
+        // First window start at which the run is no longer alive.
+        int leave = 0;
+        int edge_id = -1;
+    };
+    // Places one query vertex after a seed arc's endpoints: candidates are
+    // the alive neighbours of parent_vertex through parent_arc, and
+    // check_arcs to earlier vertices are verified by edge lookup.
+    struct PlanStep {
+        int query_vertex = -1;
+        int parent_vertex = -1;
+        int parent_arc = -1;
+        // True when parent_arc leaves parent_vertex.
+        bool parent_outgoing = false;
+        std::vector<int> check_arcs;
+    };
+    struct SeedPlan {
+        // Arcs between the seed arc's endpoints other than the seed arc.
+        std::vector<int> check_arcs;
+        std::vector<PlanStep> steps;
+    };
+
+    const Graph& G;
+    const Graph& Q;
+    int k_threshold;
+
+    std::vector<std::pair<int, int>> query_arcs;
+    std::vector<SeedPlan> seed_plans;
+    std::vector<Run> runs_by_enter;
+    std::vector<Run> runs_by_leave;
+
+    void buildSeedPlans();
+    void buildRuns();
+};
+
+#endif // SNAPSHOT_SWEEP_H
@@ -1,14 +1,217 @@
 #include "TDTree.h"
+#include "BinaryMatchFormat.h"
+#include "MatchWriter.h"
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstdio>
 #include <fstream>
 #include <functional>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <limits>
+#include <memory>
+#include <thread>
 #include <unordered_map>
 
+namespace {
+
+// A match kept by top-N ranking until it is replayed to the sinks.
+struct RankedMatch {
+    int longest_run = 0;
+    std::uint64_t discovery = 0;
+    std::vector<int> mapping;
+};
+
+// Durable peeling gives each thread at least this many vertices or
+// frontier entries, so small graphs peel on the calling thread.
+constexpr std::size_t kPeelingGrain = 1 << 16;
+
+// Runs body(begin, end, worker) over [0, count) split into contiguous
+// chunks, one per worker thread.
+template <typename Body>
+void runChunked(std::size_t count, unsigned max_workers, Body&& body) {
+    const std::size_t workers = std::max<std::size_t>(
+        1, std::min<std::size_t>(max_workers, count / kPeelingGrain));
+    const std::size_t chunk = (count + workers - 1) / workers;
+    std::vector<std::thread> threads;
+    for (std::size_t worker = 1; worker < workers; ++worker) {
+        threads.emplace_back([&, worker]() {
+            body(std::min(count, worker * chunk), std::min(count, (worker + 1) * chunk), worker);
+        });
+    }
+    body(0, std::min(count, chunk), std::size_t{0});
+    for (auto& thread : threads) thread.join();
+}
+
+// Above this size ratio, galloping over the longer sorted list is cheaper
+// than a linear merge.
+constexpr std::size_t kGallopingRatio = 32;
+
+int sortedKey(int value) {
+    return value;
+}
+
+int sortedKey(const Edge& edge) {
+    return edge.to;
+}
+
+template <typename Small, typename Large>
+void gallopingIntersect(
+    const std::vector<Small>& small,
+    const std::vector<Large>& large,
+    std::vector<int>& result) {
+    std::size_t low = 0;
+    for (const auto& entry : small) {
+        const int value = sortedKey(entry);
+        std::size_t high = low;
+        std::size_t step = 1;
+        while (high < large.size() && sortedKey(large[high]) < value) {
+            low = high + 1;
+            high += step;
+            step <<= 1;
+        }
+        const auto first = large.begin() + static_cast<std::ptrdiff_t>(low);
+        const auto last = large.begin() +
+            static_cast<std::ptrdiff_t>(std::min(high + 1, large.size()));
+        low = static_cast<std::size_t>(
+            std::lower_bound(first, last, value, [](const Large& lhs, int rhs) {
+                return sortedKey(lhs) < rhs;
+            }) - large.begin());
+        if (low == large.size()) return;
+        if (sortedKey(large[low]) == value) {
+            result.push_back(value);
+            ++low;
+        }
+    }
+}
+
+// Intersect two lists sorted by vertex ID into result. Either side may be a
+// candidate list or an adjacency list keyed by Edge::to.
+template <typename Lhs, typename Rhs>
+void intersectSortedVertices(
+    const std::vector<Lhs>& lhs,
+    const std::vector<Rhs>& rhs,
+    std::vector<int>& result) {
+    result.clear();
+    if (lhs.empty() || rhs.empty()) return;
+    if (lhs.size() * kGallopingRatio < rhs.size()) {
+        gallopingIntersect(lhs, rhs, result);
+        return;
+    }
+    if (rhs.size() * kGallopingRatio < lhs.size()) {
+        gallopingIntersect(rhs, lhs, result);
+        return;
+    }
+
+    std::size_t i = 0;
+    std::size_t j = 0;
+    while (i < lhs.size() && j < rhs.size()) {
+        const int lhs_value = sortedKey(lhs[i]);
+        const int rhs_value = sortedKey(rhs[j]);
+        if (lhs_value < rhs_value) {
+            ++i;
+        } else if (rhs_value < lhs_value) {
+            ++j;
+        } else {
+            result.push_back(lhs_value);
+            ++i;
+            ++j;
+        }
+    }
+}
+
+// Embeddings of a query subtree grouped by the common interval set of their
+// arcs. unconstrained marks the single class of a subtree without arcs.
+struct IntervalClass {
+    std::vector<TimeInterval> intervals;
+    bool unconstrained = false;
+    std::uint64_t count = 0;
+};
+
+// Larger class lists make factorized counting slower than enumeration.
+constexpr std::size_t kMaxIntervalClasses = 4096;
+
+bool intervalsLess(const std::vector<TimeInterval>& lhs, const std::vector<TimeInterval>& rhs) {
+    return std::lexicographical_compare(
+        lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+        [](const TimeInterval& left, const TimeInterval& right) {
+            if (left.start != right.start) return left.start < right.start;
+            return left.end < right.end;
+        });
+}
+
+bool intervalsEqual(const std::vector<TimeInterval>& lhs, const std::vector<TimeInterval>& rhs) {
+    return std::equal(
+        lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+        [](const TimeInterval& left, const TimeInterval& right) {
+            return left.start == right.start && left.end == right.end;
+        });
+}
+
+bool checkedAdd(std::uint64_t& total, std::uint64_t value) {
+    if (total > std::numeric_limits<std::uint64_t>::max() - value) return false;
+    total += value;
+    return true;
+}
+
+bool checkedMultiply(std::uint64_t lhs, std::uint64_t rhs, std::uint64_t& product) {
+    if (lhs != 0 && rhs > std::numeric_limits<std::uint64_t>::max() / lhs) return false;
+    product = lhs * rhs;
+    return true;
+}
+
+// Sort classes by interval set and add the counts of equal sets. Returns
+// false on count overflow or when too many distinct sets remain.
+bool mergeIntervalClasses(std::vector<IntervalClass>& classes) {
+    std::sort(classes.begin(), classes.end(), [](const IntervalClass& lhs, const IntervalClass& rhs) {
+        return intervalsLess(lhs.intervals, rhs.intervals);
+    });
+    std::size_t merged = 0;
+    for (std::size_t i = 0; i < classes.size(); ++i) {
+        if (merged > 0 && intervalsEqual(classes[merged - 1].intervals, classes[i].intervals)) {
+            if (!checkedAdd(classes[merged - 1].count, classes[i].count)) return false;
+        } else {
+            if (merged != i) classes[merged] = std::move(classes[i]);
+            ++merged;
+        }
+    }
+    classes.resize(merged);
+    return classes.size() <= kMaxIntervalClasses;
+}
+
+} // namespace
+
+const char* matchOutputModeName(MatchOutputMode mode) {
+    return mode == MatchOutputMode::CountOnly ? "count-only" : "full";
+}
+
+const char* matchOutputFormatName(MatchOutputFormat format) {
+    return format == MatchOutputFormat::Binary ? "binary" : "text";
+}
+
+const char* matchStopReasonName(MatchStopReason reason) {
+    switch (reason) {
+    case MatchStopReason::ResultLimit:
+        return "result-limit";
+    case MatchStopReason::Exists:
+        return "exists";
+    case MatchStopReason::TimeLimit:
+        return "time-limit";
+    case MatchStopReason::Consumer:
+        return "consumer";
+    case MatchStopReason::Complete:
+        break;
+    }
+    return "complete";
+}
+
+const char* matchingOrderName(MatchingOrder order) {
+    return order == MatchingOrder::Adaptive ? "adaptive" : "static";
+}
+
 const TDTreeBlock* TDTreeNode::findBlock(int parent_vertex) const {
     const auto found = block_index.find(parent_vertex);
     if (found == block_index.end() || found->second >= blocks.size()) return nullptr;
@@ -61,8 +264,10 @@ TDTree::TDTree(
 void TDTree::build() {
     initializeNodes();
     initializeQueryRequirements();
+    const std::vector<std::uint8_t> durable_edges = durableEdgeFlags();
+    peelDataVertices(durable_edges);
     fillRoot();
-    buildCandidateRelations();
+    buildCandidateRelations(durable_edges);
 
     // A bottom-up semijoin removes unsupported parents. The following
     // top-down semijoin removes orphaned descendant blocks in linear time.
@@ -100,6 +305,172 @@ void TDTree::initializeQueryRequirements() {
     }
 }
 
+std::vector<std::uint8_t> TDTree::durableEdgeFlags() const {
+    std::vector<std::uint8_t> durable_edges(G.temporal_edges.size(), 0);
+    for (std::size_t edge_id = 0; edge_id < G.temporal_edges.size(); ++edge_id) {
+        durable_edges[edge_id] = hasMinimumConsecutiveDuration(
+            G.temporal_edges[edge_id].active_intervals, k_threshold) ? 1 : 0;
+    }
+    return durable_edges;
+}
+
+void TDTree::peelDataVertices(const std::vector<std::uint8_t>& durable_edges) {
+    servable_query_vertices.clear();
+    if (Q.num_vertices > 64 || QD.root < 0) return;
+
+    // A data vertex keeps query vertex q while its label and active duration
+    // fit q and its durable arcs to surviving vertices still cover q's
+    // directed degrees and neighbour-label counts. A vertex that keeps no
+    // query vertex is removed, which lowers its neighbours' counts; removals
+    // propagate in rounds until nothing changes. Counts only fall and masks
+    // only shrink, so a recheck after every decrement reaches the fixpoint
+    // regardless of thread interleaving.
+    std::array<std::uint64_t, kLabelCount> label_query_vertices{};
+    for (int query_vertex = 0; query_vertex < Q.num_vertices; ++query_vertex) {
+        const Label label = Q.vertex_labels[static_cast<std::size_t>(query_vertex)];
+        if (label < kLabelCount) label_query_vertices[label] |= std::uint64_t{1} << query_vertex;
+    }
+
+    const std::size_t vertex_count = static_cast<std::size_t>(G.num_vertices);
+    const unsigned max_workers = std::max(1U, std::thread::hardware_concurrency());
+    std::vector<std::atomic<std::uint64_t>> servable(vertex_count);
+    std::vector<std::atomic<int>> out_counts(vertex_count * kLabelCount);
+    std::vector<std::atomic<int>> in_counts(vertex_count * kLabelCount);
+
+    auto surviving_mask = [&](std::size_t data_index, std::uint64_t mask) {
+        int out_degree = 0;
+        int in_degree = 0;
+        std::array<int, kLabelCount> out_available{};
+        std::array<int, kLabelCount> in_available{};
+        for (std::size_t label = 0; label < kLabelCount; ++label) {
+            out_available[label] = out_counts[data_index * kLabelCount + label].load();
+            in_available[label] = in_counts[data_index * kLabelCount + label].load();
+            out_degree += out_available[label];
+            in_degree += in_available[label];
+        }
+        for (std::uint64_t remaining = mask; remaining != 0; remaining &= remaining - 1) {
+            int query_vertex = 0;
+            while (((remaining >> query_vertex) & 1U) == 0) ++query_vertex;
+            const std::size_t query_index = static_cast<std::size_t>(query_vertex);
+            bool fits = out_degree >= static_cast<int>(Q.adj[query_index].size()) &&
+                in_degree >= static_cast<int>(Q.in_adj[query_index].size());
+            for (std::size_t label = 0; fits && label < kLabelCount; ++label) {
+                fits = out_available[label] >=
+                        query_out_neighbor_label_requirements[query_index][label] &&
+                    in_available[label] >=
+                        query_in_neighbor_label_requirements[query_index][label];
+            }
+            if (!fits) mask &= ~(std::uint64_t{1} << query_vertex);
+        }
+        return mask;
+    };
+    // Returns true when this call removed the vertex.
+    auto recheck = [&](std::size_t data_index) {
+        const std::uint64_t mask = servable[data_index].load();
+        if (mask == 0) return false;
+        const std::uint64_t surviving = surviving_mask(data_index, mask);
+        if (surviving == mask) return false;
+        if (surviving != 0) {
+            servable[data_index].fetch_and(surviving);
+            return false;
+        }
+        return servable[data_index].exchange(0) != 0;
+    };
+
+    // compatible_labels[v] is v's label, or kLabelCount when v can play no
+    // query vertex; one byte per vertex keeps the counting pass's random
+    // neighbour lookups in cache.
+    std::vector<std::uint8_t> compatible_labels(vertex_count, static_cast<std::uint8_t>(kLabelCount));
+    runChunked(vertex_count, max_workers, [&](std::size_t begin, std::size_t end, std::size_t) {
+        for (std::size_t data_index = begin; data_index < end; ++data_index) {
+            const Label label = G.vertex_labels[data_index];
+            const std::uint64_t mask = label < kLabelCount &&
+                    data_index < G.vertex_active_durations.size() &&
+                    G.vertex_active_durations[data_index] >= k_threshold
+                ? label_query_vertices[label]
+                : 0;
+            if (mask != 0) compatible_labels[data_index] = static_cast<std::uint8_t>(label);
+            servable[data_index].store(mask, std::memory_order_relaxed);
+        }
+    });
+    peeling_input_vertices = static_cast<std::size_t>(vertex_count - static_cast<std::size_t>(
+        std::count(compatible_labels.begin(), compatible_labels.end(),
+                   static_cast<std::uint8_t>(kLabelCount))));
+
+    // A vertex's counts are complete once its own arcs are scanned, so the
+    // first removals are decided in the same pass. Every compatible vertex
+    // was counted by its compatible neighbours, so these removals decrement
+    // them like later ones.
+    std::vector<std::vector<int>> frontiers(max_workers);
+    runChunked(vertex_count, max_workers, [&](std::size_t begin, std::size_t end, std::size_t worker) {
+        for (std::size_t data_index = begin; data_index < end; ++data_index) {
+            if (compatible_labels[data_index] == kLabelCount) continue;
+            std::array<int, kLabelCount + 1> out_available{};
+            std::array<int, kLabelCount + 1> in_available{};
+            for (const auto& edge : G.adj[data_index]) {
+                if (durable_edges[static_cast<std::size_t>(edge.temporal_edge_id)] != 0) {
+                    ++out_available[compatible_labels[static_cast<std::size_t>(edge.to)]];
+                }
+            }
+            for (const auto& edge : G.in_adj[data_index]) {
+                if (durable_edges[static_cast<std::size_t>(edge.temporal_edge_id)] != 0) {
+                    ++in_available[compatible_labels[static_cast<std::size_t>(edge.to)]];
+                }
+            }
+            for (std::size_t label = 0; label < kLabelCount; ++label) {
+                out_counts[data_index * kLabelCount + label].store(
+                    out_available[label], std::memory_order_relaxed);
+                in_counts[data_index * kLabelCount + label].store(
+                    in_available[label], std::memory_order_relaxed);
+            }
+            if (recheck(data_index)) frontiers[worker].push_back(static_cast<int>(data_index));
+        }
+    });
+
+    std::vector<int> frontier;
+    peeling_rounds = 0;
+    for (;;) {
+        frontier.clear();
+        for (auto& worker_frontier : frontiers) {
+            frontier.insert(frontier.end(), worker_frontier.begin(), worker_frontier.end());
+            worker_frontier.clear();
+        }
+        if (frontier.empty()) break;
+        ++peeling_rounds;
+        runChunked(frontier.size(), max_workers, [&](std::size_t begin, std::size_t end, std::size_t worker) {
+            for (std::size_t position = begin; position < end; ++position) {
+                const std::size_t removed = static_cast<std::size_t>(frontier[position]);
+                const Label label = G.vertex_labels[removed];
+                for (const auto& edge : G.adj[removed]) {
+                    const std::size_t neighbor = static_cast<std::size_t>(edge.to);
+                    if (durable_edges[static_cast<std::size_t>(edge.temporal_edge_id)] == 0 ||
+                        servable[neighbor].load() == 0) {
+                        continue;
+                    }
+                    --in_counts[neighbor * kLabelCount + label];
+                    if (recheck(neighbor)) frontiers[worker].push_back(static_cast<int>(neighbor));
+                }
+                for (const auto& edge : G.in_adj[removed]) {
+                    const std::size_t neighbor = static_cast<std::size_t>(edge.to);
+                    if (durable_edges[static_cast<std::size_t>(edge.temporal_edge_id)] == 0 ||
+                        servable[neighbor].load() == 0) {
+                        continue;
+                    }
+                    --out_counts[neighbor * kLabelCount + label];
+                    if (recheck(neighbor)) frontiers[worker].push_back(static_cast<int>(neighbor));
+                }
+            }
+        });
+    }
+
+    servable_query_vertices.resize(vertex_count);
+    peeling_survivors = 0;
+    for (std::size_t data_index = 0; data_index < vertex_count; ++data_index) {
+        servable_query_vertices[data_index] = servable[data_index].load();
+        if (servable_query_vertices[data_index] != 0) ++peeling_survivors;
+    }
+}
+
 bool TDTree::isDataVertexCandidate(int data_vertex, int query_vertex) const {
     if (data_vertex < 0 || query_vertex < 0 ||
         data_vertex >= G.num_vertices || query_vertex >= Q.num_vertices) {
@@ -108,6 +479,11 @@ bool TDTree::isDataVertexCandidate(int data_vertex, int query_vertex) const {
 
     const std::size_t data_index = static_cast<std::size_t>(data_vertex);
     const std::size_t query_index = static_cast<std::size_t>(query_vertex);
+    // Peeling already applied every check below, with only durable arcs
+    // to surviving neighbours counted.
+    if (!servable_query_vertices.empty()) {
+        return ((servable_query_vertices[data_index] >> query_index) & 1U) != 0;
+    }
     if (G.vertex_labels[data_index] != Q.vertex_labels[query_index]) return false;
     if (G.adj[data_index].size() < Q.adj[query_index].size()) return false;
     if (G.in_adj[data_index].size() < Q.in_adj[query_index].size()) return false;
@@ -142,37 +518,40 @@ void TDTree::fillRoot() {
 
 bool TDTree::passesAvailableNonTreeConstraints(
     int data_vertex,
-    int query_vertex,
-    const std::vector<int>& order_position,
-    const std::vector<std::vector<std::uint8_t>>& candidate_flags) const {
-    for (const auto& non_tree_edge : QD.non_tree_edges) {
-        int other_query_vertex = -1;
-        const std::vector<Edge>* candidate_neighbors = nullptr;
-        if (non_tree_edge.first == query_vertex) {
-            other_query_vertex = non_tree_edge.second;
-            candidate_neighbors = &G.adj[static_cast<std::size_t>(data_vertex)];
-        } else if (non_tree_edge.second == query_vertex) {
-            other_query_vertex = non_tree_edge.first;
-            candidate_neighbors = &G.in_adj[static_cast<std::size_t>(data_vertex)];
-        } else {
-            continue;
-        }
-
-        if (order_position[static_cast<std::size_t>(other_query_vertex)] >=
-            order_position[static_cast<std::size_t>(query_vertex)]) {
-            continue;
-        }
+    const std::vector<NonTreeCheck>& checks,
+    const std::vector<std::vector<std::uint8_t>>& candidate_flags,
+    const std::vector<std::vector<int>>& candidate_lists,
+    const std::vector<std::uint8_t>& durable_edges) const {
+    for (const auto& check : checks) {
+        const std::size_t other_index = static_cast<std::size_t>(check.other_query_vertex);
+        const auto& candidate_neighbors = check.outgoing
+            ? G.adj[static_cast<std::size_t>(data_vertex)]
+            : G.in_adj[static_cast<std::size_t>(data_vertex)];
+        const auto& other_candidates = candidate_lists[other_index];
 
         bool found_compatible_neighbor = false;
-        for (const auto& edge_ref : *candidate_neighbors) {
-            if (candidate_flags[static_cast<std::size_t>(other_query_vertex)]
-                               [static_cast<std::size_t>(edge_ref.to)] == 0) {
-                continue;
+        if (candidate_neighbors.size() <= other_candidates.size()) {
+            for (const auto& edge_ref : candidate_neighbors) {
+                if (candidate_flags[other_index][static_cast<std::size_t>(edge_ref.to)] != 0 &&
+                    durable_edges[static_cast<std::size_t>(edge_ref.temporal_edge_id)] != 0) {
+                    found_compatible_neighbor = true;
+                    break;
+                }
             }
-            const auto& temporal_edge = G.temporal_edges[static_cast<std::size_t>(edge_ref.temporal_edge_id)];
-            if (hasMinimumConsecutiveDuration(temporal_edge.active_intervals, k_threshold)) {
-                found_compatible_neighbor = true;
-                break;
+        } else {
+            // Hub candidates probe the smaller, sorted candidate set of the
+            // other endpoint instead of scanning their whole neighbor list.
+            auto first = candidate_neighbors.begin();
+            for (int other_candidate : other_candidates) {
+                first = std::lower_bound(
+                    first, candidate_neighbors.end(), other_candidate,
+                    [](const Edge& edge, int target) { return edge.to < target; });
+                if (first == candidate_neighbors.end()) break;
+                if (first->to == other_candidate &&
+                    durable_edges[static_cast<std::size_t>(first->temporal_edge_id)] != 0) {
+                    found_compatible_neighbor = true;
+                    break;
+                }
             }
         }
         if (!found_compatible_neighbor) return false;
@@ -180,7 +559,7 @@ bool TDTree::passesAvailableNonTreeConstraints(
     return true;
 }
 
-void TDTree::buildCandidateRelations() {
+void TDTree::buildCandidateRelations(const std::vector<std::uint8_t>& durable_edges) {
     if (QD.root < 0 || !QD.connected) return;
 
     std::vector<int> order_position(static_cast<std::size_t>(Q.num_vertices), -1);
@@ -188,6 +567,20 @@ void TDTree::buildCandidateRelations() {
         order_position[static_cast<std::size_t>(QD.dfs_order[i])] = static_cast<int>(i);
     }
 
+    // Only non-tree arcs whose other endpoint is already filled can be
+    // checked while a query vertex is expanded.
+    std::vector<std::vector<NonTreeCheck>> non_tree_checks(static_cast<std::size_t>(Q.num_vertices));
+    for (const auto& non_tree_edge : QD.non_tree_edges) {
+        const int source = non_tree_edge.first;
+        const int target = non_tree_edge.second;
+        if (order_position[static_cast<std::size_t>(target)] <
+            order_position[static_cast<std::size_t>(source)]) {
+            non_tree_checks[static_cast<std::size_t>(source)].push_back({target, true});
+        } else {
+            non_tree_checks[static_cast<std::size_t>(target)].push_back({source, false});
+        }
+    }
+
     std::vector<std::vector<std::uint8_t>> candidate_flags(
         static_cast<std::size_t>(Q.num_vertices),
         std::vector<std::uint8_t>(static_cast<std::size_t>(G.num_vertices), 0));
@@ -213,6 +606,13 @@ void TDTree::buildCandidateRelations() {
         const auto& parent_candidates = candidate_lists[static_cast<std::size_t>(parent_query_vertex)];
         node.blocks.reserve(parent_candidates.size());
 
+        // The same data vertex is reached from many parent blocks, but its
+        // vertex and non-tree verdicts do not depend on the parent.
+        const auto& checks = non_tree_checks[static_cast<std::size_t>(query_vertex)];
+        std::vector<std::uint8_t> verdicts(static_cast<std::size_t>(G.num_vertices), 0);
+        constexpr std::uint8_t kAccepted = 1;
+        constexpr std::uint8_t kRejected = 2;
+
         for (int parent_data_vertex : parent_candidates) {
             TDTreeBlock block;
             block.v_par = parent_data_vertex;
@@ -221,25 +621,30 @@ void TDTree::buildCandidateRelations() {
                 : G.in_adj[static_cast<std::size_t>(parent_data_vertex)];
             for (const auto& edge_ref : expansion_edges) {
                 const int candidate = edge_ref.to;
-                if (!isDataVertexCandidate(candidate, query_vertex)) continue;
-
-                const TemporalEdge* forward_edge = parent_to_child
-                    ? G.findTemporalEdge(parent_data_vertex, candidate)
-                    : nullptr;
-                const TemporalEdge* reverse_edge = child_to_parent
-                    ? G.findTemporalEdge(candidate, parent_data_vertex)
-                    : nullptr;
-                if ((parent_to_child &&
-                     (forward_edge == nullptr || !hasMinimumConsecutiveDuration(
-                         forward_edge->active_intervals, k_threshold))) ||
-                    (child_to_parent &&
-                     (reverse_edge == nullptr || !hasMinimumConsecutiveDuration(
-                         reverse_edge->active_intervals, k_threshold)))) {
+                auto& verdict = verdicts[static_cast<std::size_t>(candidate)];
+                if (verdict == kRejected) continue;
+
+                // expansion_edges already holds the arc in the parent-to-child
+                // direction when it exists; otherwise it holds the reverse arc.
+                if (durable_edges[static_cast<std::size_t>(edge_ref.temporal_edge_id)] == 0) {
                     continue;
                 }
-                if (!passesAvailableNonTreeConstraints(
-                        candidate, query_vertex, order_position, candidate_flags)) {
-                    continue;
+                if (parent_to_child && child_to_parent) {
+                    const TemporalEdge* reverse_edge =
+                        G.findTemporalEdge(candidate, parent_data_vertex);
+                    if (reverse_edge == nullptr || !hasMinimumConsecutiveDuration(
+                            reverse_edge->active_intervals, k_threshold)) {
+                        continue;
+                    }
+                }
+                if (verdict == 0) {
+                    verdict = isDataVertexCandidate(candidate, query_vertex) &&
+                            passesAvailableNonTreeConstraints(
+                                candidate, checks, candidate_flags, candidate_lists,
+                                durable_edges)
+                        ? kAccepted
+                        : kRejected;
+                    if (verdict == kRejected) continue;
                 }
 
                 block.V_cand.push_back(candidate);
@@ -341,6 +746,83 @@ void TDTree::rebuildBlockIndexes() {
     for (auto& node : nodes) node.rebuildBlockIndex();
 }
 
+bool TDTree::raiseMinimumDuration(int minimum_duration) {
+    if (minimum_duration < k_threshold) return false;
+    if (minimum_duration == k_threshold) return true;
+    k_threshold = minimum_duration;
+    if (QD.root < 0 || !QD.connected) return true;
+
+    // Only the k-dependent filters of build() can newly fail: the vertex
+    // active duration, durable peeling and the durability of the tree
+    // arc(s) to the parent. Peeling is re-run at the new k so its masks and
+    // counters describe the tree that remains.
+    // remove_if visits candidates in order, which the merge walk relies on.
+    peelDataVertices(durableEdgeFlags());
+    auto dropped = [&](int data_vertex, int query_vertex) {
+        const std::size_t data_index = static_cast<std::size_t>(data_vertex);
+        if (!servable_query_vertices.empty()) {
+            return ((servable_query_vertices[data_index] >> query_vertex) & 1U) == 0;
+        }
+        return G.vertex_active_durations[data_index] < k_threshold;
+    };
+    auto arc_is_durable = [&](int source, int target) {
+        const TemporalEdge* temporal_edge = G.findTemporalEdge(source, target);
+        return temporal_edge != nullptr &&
+            hasMinimumConsecutiveDuration(temporal_edge->active_intervals, k_threshold);
+    };
+
+    auto& root_candidates = nodes[static_cast<std::size_t>(QD.root)].root_candidates;
+    root_candidates.erase(
+        std::remove_if(root_candidates.begin(), root_candidates.end(),
+            [&](int data_vertex) { return dropped(data_vertex, QD.root); }),
+        root_candidates.end());
+    for (int query_vertex = 0; query_vertex < Q.num_vertices; ++query_vertex) {
+        const int parent_query_vertex = QD.parent[static_cast<std::size_t>(query_vertex)];
+        if (parent_query_vertex < 0) continue;
+        const bool parent_to_child =
+            GraphUtils::hasEdge(Q.adj, parent_query_vertex, query_vertex);
+        const bool child_to_parent =
+            GraphUtils::hasEdge(Q.adj, query_vertex, parent_query_vertex);
+
+        auto& blocks = nodes[static_cast<std::size_t>(query_vertex)].blocks;
+        for (auto& block : blocks) {
+            // V_cand follows the sorted expansion list it was built from, so
+            // one merge walk finds each candidate's arc without a search.
+            const auto& expansion_edges = parent_to_child
+                ? G.adj[static_cast<std::size_t>(block.v_par)]
+                : G.in_adj[static_cast<std::size_t>(block.v_par)];
+            auto edge_it = expansion_edges.begin();
+            block.V_cand.erase(
+                std::remove_if(
+                    block.V_cand.begin(), block.V_cand.end(),
+                    [&](int candidate) {
+                        if (dropped(candidate, query_vertex)) return true;
+                        while (edge_it != expansion_edges.end() && edge_it->to < candidate) ++edge_it;
+                        if (edge_it == expansion_edges.end() || edge_it->to != candidate ||
+                            !hasMinimumConsecutiveDuration(
+                                G.temporal_edges[static_cast<std::size_t>(
+                                    edge_it->temporal_edge_id)].active_intervals,
+                                k_threshold)) {
+                            return true;
+                        }
+                        return parent_to_child && child_to_parent &&
+                            !arc_is_durable(candidate, block.v_par);
+                    }),
+                block.V_cand.end());
+        }
+        blocks.erase(
+            std::remove_if(
+                blocks.begin(), blocks.end(),
+                [](const TDTreeBlock& block) { return block.V_cand.empty(); }),
+            blocks.end());
+    }
+
+    trimBottomUp();
+    trimTopDown();
+    rebuildBlockIndexes();
+    return true;
+}
+
 std::vector<int> TDTree::uniqueCandidates(const TDTreeNode& node) const {
     if (node.isRoot) return node.root_candidates;
 
@@ -370,6 +852,11 @@ std::size_t TDTree::candidateRelationCount() const {
 }
 
 void TDTree::print_res() const {
+    if (!servable_query_vertices.empty()) {
+        std::cout << "Durable peeling: " << peeling_survivors << " of " << peeling_input_vertices
+                  << " label- and duration-compatible data vertices survive after "
+                  << peeling_rounds << " rounds.\n";
+    }
     std::cout << "TD-tree candidate summary:\n";
     for (const auto& node : nodes) {
         std::size_t relation_count = 0;
@@ -386,109 +873,715 @@ void TDTree::print_res() const {
     }
 }
 
-std::uint64_t TDTree::enumerateMatches(std::ostream& output) const {
-    if (QD.root < 0 || !QD.connected || QD.dfs_order.empty()) return 0;
+bool TDTree::countFactorized(std::uint64_t& match_count) const {
+    match_count = 0;
+    if (QD.root < 0 || !QD.connected || !QD.non_tree_edges.empty()) return false;
+    // A query without arcs has no interval constraint to count by; its
+    // matches are bounded by vertex durations, which enumeration checks.
+    if (Q.num_vertices < 2) return false;
+
+    // A subtree is independent when no query vertex outside it shares one of
+    // its labels. Its embeddings can then never reuse a data vertex mapped
+    // outside it, and without non-tree arcs they only depend on the parent's
+    // mapping, so they are summarized once per parent data vertex and
+    // multiplied into the rest as counts per class of interval sets.
+    const std::size_t query_count = static_cast<std::size_t>(Q.num_vertices);
+    std::vector<std::array<int, kLabelCount>> subtree_labels(query_count);
+    for (auto it = QD.dfs_order.rbegin(); it != QD.dfs_order.rend(); ++it) {
+        const std::size_t query_vertex = static_cast<std::size_t>(*it);
+        const Label label = Q.vertex_labels[query_vertex];
+        if (label >= kLabelCount) return false;
+        ++subtree_labels[query_vertex][label];
+        if (QD.parent[query_vertex] >= 0) {
+            auto& parent_labels = subtree_labels[static_cast<std::size_t>(QD.parent[query_vertex])];
+            for (std::size_t l = 0; l < kLabelCount; ++l) {
+                parent_labels[l] += subtree_labels[query_vertex][l];
+            }
+        }
+    }
+    const auto& query_labels = subtree_labels[static_cast<std::size_t>(QD.root)];
+    std::vector<bool> independent(query_count, false);
+    bool factors = false;
+    for (std::size_t query_vertex = 0; query_vertex < query_count; ++query_vertex) {
+        independent[query_vertex] = true;
+        for (std::size_t l = 0; l < kLabelCount; ++l) {
+            const int inside = subtree_labels[query_vertex][l];
+            if (inside != 0 && inside != query_labels[l]) independent[query_vertex] = false;
+        }
+        factors = factors || (independent[query_vertex] && static_cast<int>(query_vertex) != QD.root);
+    }
+    // With no independent subtree below the root, the count would be a
+    // plain enumeration.
+    if (!factors) return false;
+
+    // The region of an independent vertex: itself and the vertices below it
+    // up to the next independent subtrees, parents first. Regions are
+    // enumerated injectively; the independent children hanging off them are
+    // multiplied in.
+    std::vector<std::vector<int>> regions(query_count);
+    for (std::size_t query_vertex = 0; query_vertex < query_count; ++query_vertex) {
+        if (!independent[query_vertex]) continue;
+        auto& region = regions[query_vertex];
+        region.push_back(static_cast<int>(query_vertex));
+        for (std::size_t next = 0; next < region.size(); ++next) {
+            for (int child : QD.spanning_tree_adj[static_cast<std::size_t>(region[next])]) {
+                if (!independent[static_cast<std::size_t>(child)]) region.push_back(child);
+            }
+        }
+    }
+
+    // Common intervals of the tree arcs between parent and child, at least k long.
+    std::vector<TimeInterval> arc_intervals;
+    auto tree_arc_intervals = [&](int parent, int parent_data, int child, int child_data) {
+        arc_intervals.clear();
+        bool has_arc_intervals = false;
+        auto apply_arc = [&](int source, int target) {
+            const TemporalEdge* temporal_edge = G.findTemporalEdge(source, target);
+            if (temporal_edge == nullptr) return false;
+            if (!has_arc_intervals) {
+                for (const auto& interval : temporal_edge->active_intervals) {
+                    if (interval.length() >= k_threshold) arc_intervals.push_back(interval);
+                }
+                has_arc_intervals = true;
+            } else {
+                arc_intervals = intersectTimeIntervals(
+                    arc_intervals, temporal_edge->active_intervals, k_threshold);
+            }
+            return !arc_intervals.empty();
+        };
+        return !(GraphUtils::hasEdge(Q.adj, parent, child) && !apply_arc(parent_data, child_data)) &&
+            !(GraphUtils::hasEdge(Q.adj, child, parent) && !apply_arc(child_data, parent_data));
+    };
+
+    std::vector<std::unordered_map<int, std::vector<IntervalClass>>> subtree_classes(query_count);
+    std::vector<std::unordered_map<int, std::vector<IntervalClass>>> attached_classes(query_count);
+    std::function<const std::vector<IntervalClass>*(int, int)> count_subtree;
+
+    // Classes of the independent subtree of child, arcs to its parent's
+    // data vertex included.
+    auto count_attached = [&](int child, int parent_data) -> const std::vector<IntervalClass>* {
+        auto& memo = attached_classes[static_cast<std::size_t>(child)];
+        const auto found = memo.find(parent_data);
+        if (found != memo.end()) return &found->second;
+
+        std::vector<IntervalClass> child_classes;
+        const TDTreeBlock* block = nodes[static_cast<std::size_t>(child)].findBlock(parent_data);
+        if (block != nullptr) {
+            const int parent = QD.parent[static_cast<std::size_t>(child)];
+            for (int candidate : block->V_cand) {
+                if (!tree_arc_intervals(parent, parent_data, child, candidate)) continue;
+                const std::vector<TimeInterval> candidate_intervals = arc_intervals;
+                const std::vector<IntervalClass>* below = count_subtree(child, candidate);
+                if (below == nullptr) return nullptr;
+                for (const auto& entry : *below) {
+                    auto intervals = entry.unconstrained
+                        ? candidate_intervals
+                        : intersectTimeIntervals(entry.intervals, candidate_intervals, k_threshold);
+                    if (!intervals.empty()) {
+                        child_classes.push_back({std::move(intervals), false, entry.count});
+                    }
+                }
+            }
+        }
+        if (!mergeIntervalClasses(child_classes)) return nullptr;
+        return &memo.emplace(parent_data, std::move(child_classes)).first->second;
+    };
+
+    count_subtree = [&](int query_vertex, int data_vertex) -> const std::vector<IntervalClass>* {
+        auto& memo = subtree_classes[static_cast<std::size_t>(query_vertex)];
+        const auto found = memo.find(data_vertex);
+        if (found != memo.end()) return &found->second;
+
+        const std::vector<int>& region = regions[static_cast<std::size_t>(query_vertex)];
+        std::vector<int> region_mapping(region.size(), -1);
+        region_mapping[0] = data_vertex;
+        // common_intervals[i]: the region arcs up to region[i], from i = 1.
+        std::vector<std::vector<TimeInterval>> common_intervals(region.size());
+        std::vector<IntervalClass> classes;
+
+        // Multiplies the independent children of a complete region mapping.
+        auto add_region_match = [&]() {
+            std::vector<IntervalClass> combined{
+                {region.size() > 1 ? common_intervals.back() : std::vector<TimeInterval>{},
+                 region.size() == 1, 1}};
+            for (std::size_t i = 0; i < region.size() && !combined.empty(); ++i) {
+                for (int child : QD.spanning_tree_adj[static_cast<std::size_t>(region[i])]) {
+                    if (!independent[static_cast<std::size_t>(child)]) continue;
+                    const std::vector<IntervalClass>* child_classes =
+                        count_attached(child, region_mapping[i]);
+                    if (child_classes == nullptr) return false;
+
+                    std::vector<IntervalClass> product;
+                    for (const auto& lhs : combined) {
+                        for (const auto& rhs : *child_classes) {
+                            auto intervals = lhs.unconstrained
+                                ? rhs.intervals
+                                : intersectTimeIntervals(lhs.intervals, rhs.intervals, k_threshold);
+                            if (intervals.empty()) continue;
+                            std::uint64_t count = 0;
+                            if (!checkedMultiply(lhs.count, rhs.count, count)) return false;
+                            product.push_back({std::move(intervals), false, count});
+                        }
+                    }
+                    if (!mergeIntervalClasses(product)) return false;
+                    combined.swap(product);
+                    if (combined.empty()) break;
+                }
+            }
+            classes.insert(classes.end(),
+                std::make_move_iterator(combined.begin()), std::make_move_iterator(combined.end()));
+            return classes.size() <= kMaxIntervalClasses || mergeIntervalClasses(classes);
+        };
+
+        std::function<bool(std::size_t)> place_region;
+        place_region = [&](std::size_t index) {
+            if (index == region.size()) return add_region_match();
+            const int region_vertex = region[index];
+            const int parent = QD.parent[static_cast<std::size_t>(region_vertex)];
+            const std::size_t parent_index = static_cast<std::size_t>(
+                std::find(region.begin(), region.begin() + static_cast<std::ptrdiff_t>(index), parent) -
+                region.begin());
+            const int parent_data = region_mapping[parent_index];
+            const TDTreeBlock* block =
+                nodes[static_cast<std::size_t>(region_vertex)].findBlock(parent_data);
+            if (block == nullptr) return true;
+            for (int candidate : block->V_cand) {
+                if (std::find(region_mapping.begin(),
+                              region_mapping.begin() + static_cast<std::ptrdiff_t>(index),
+                              candidate) != region_mapping.begin() + static_cast<std::ptrdiff_t>(index) ||
+                    !tree_arc_intervals(parent, parent_data, region_vertex, candidate)) {
+                    continue;
+                }
+                common_intervals[index] = index == 1
+                    ? arc_intervals
+                    : intersectTimeIntervals(common_intervals[index - 1], arc_intervals, k_threshold);
+                if (common_intervals[index].empty()) continue;
+                region_mapping[index] = candidate;
+                if (!place_region(index + 1)) return false;
+            }
+            region_mapping[index] = -1;
+            return true;
+        };
+        if (!place_region(1) || !mergeIntervalClasses(classes)) return nullptr;
+        return &memo.emplace(data_vertex, std::move(classes)).first->second;
+    };
+
+    std::uint64_t total = 0;
+    for (int root_candidate : nodes[static_cast<std::size_t>(QD.root)].root_candidates) {
+        const std::vector<IntervalClass>* classes = count_subtree(QD.root, root_candidate);
+        if (classes == nullptr) return false;
+        for (const auto& entry : *classes) {
+            if (!entry.unconstrained && !checkedAdd(total, entry.count)) return false;
+        }
+    }
+    match_count = total;
+    return true;
+}
+
+void TDTree::enumerateMatches(
+    const MatchSinks& sinks,
+    const MatchOptions& options,
+    MatchSummary& summary) const {
+    if (QD.root < 0 || !QD.connected || QD.dfs_order.empty()) return;
+
+    const MatchRowFormatter row_formatter(G, Q);
+
+    const bool adaptive_order = options.matching_order == MatchingOrder::Adaptive;
+
+    // Top-N ranking raises the effective k to one past the shortest kept run
+    // whenever the heap is full, so interval intersections prune harder as
+    // better matches are found. An arc whose longest run is already too
+    // short is rejected before it is intersected.
+    const bool rank_matches = options.top_matches > 0 && sinks.durability_counts == nullptr;
+    int minimum_length = k_threshold;
+    std::vector<int> edge_longest_runs;
+    if (rank_matches) {
+        edge_longest_runs.resize(G.temporal_edges.size(), 0);
+        for (std::size_t edge_id = 0; edge_id < G.temporal_edges.size(); ++edge_id) {
+            for (const auto& interval : G.temporal_edges[edge_id].active_intervals) {
+                edge_longest_runs[edge_id] = std::max(edge_longest_runs[edge_id], interval.length());
+            }
+        }
+    }
+    auto longest_run_of = [](const std::vector<TimeInterval>& intervals) {
+        int longest_run = 0;
+        for (const auto& interval : intervals) longest_run = std::max(longest_run, interval.length());
+        return longest_run;
+    };
+    // Heap order: the shortest kept run, and among equal runs the latest
+    // found, sits at the front and is evicted first.
+    std::vector<RankedMatch> ranked_matches;
+    auto ranks_below = [](const RankedMatch& lhs, const RankedMatch& rhs) {
+        return lhs.longest_run != rhs.longest_run
+            ? lhs.longest_run > rhs.longest_run
+            : lhs.discovery < rhs.discovery;
+    };
 
     std::vector<int> mapping(static_cast<std::size_t>(Q.num_vertices), -1);
-    std::vector<std::uint8_t> used_data_vertices(static_cast<std::size_t>(G.num_vertices), 0);
+    // used_by[v] is the query vertex currently mapped to data vertex v, or -1.
+    std::vector<int> used_by(static_cast<std::size_t>(G.num_vertices), -1);
     std::uint64_t match_count = 0;
+    std::uint64_t pruned_candidates = 0;
 
-    std::function<void(std::size_t, const std::vector<TimeInterval>&, bool)> dfs;
-    dfs = [&](std::size_t depth, const std::vector<TimeInterval>& current_intervals, bool has_intervals) {
-        if (depth >= QD.dfs_order.size()) {
-            ++match_count;
-            output << "Match " << (match_count - 1) << ": ";
-            for (int query_vertex = 0; query_vertex < Q.num_vertices; ++query_vertex) {
-                if (query_vertex > 0) output << ", ";
-                output << 'q' << query_vertex << '(' <<
-                    labelToString(Q.vertex_labels[static_cast<std::size_t>(query_vertex)]) << ")->" <<
-                    G.externalId(mapping[static_cast<std::size_t>(query_vertex)]);
-            }
-            output << " | active=" << formatIntervals(current_intervals) << '\n';
-            return;
+    // Limits stop the search cooperatively.
+    const MatchLimits& limits = options.limits;
+    DeadlineGuard deadline(limits, std::chrono::steady_clock::now());
+    bool stop_requested = false;
+    auto should_stop = [&]() {
+        if (stop_requested) return true;
+        if (deadline.expired()) {
+            stop_requested = true;
+            summary.stop_reason = MatchStopReason::TimeLimit;
         }
+        return stop_requested;
+    };
 
+    // Query arcs from each DFS position to earlier, non-parent vertices.
+    std::vector<int> order_position(static_cast<std::size_t>(Q.num_vertices), -1);
+    for (std::size_t i = 0; i < QD.dfs_order.size(); ++i) {
+        order_position[static_cast<std::size_t>(QD.dfs_order[i])] = static_cast<int>(i);
+    }
+    std::vector<std::vector<NonTreeCheck>> non_tree_back_arcs(QD.dfs_order.size());
+    for (std::size_t depth = 1; depth < QD.dfs_order.size(); ++depth) {
         const int query_vertex = QD.dfs_order[depth];
         const int parent_query_vertex = QD.parent[static_cast<std::size_t>(query_vertex)];
-        if (parent_query_vertex < 0) return;
+        auto add_back_arcs = [&](const std::vector<Edge>& query_edges, bool outgoing) {
+            for (const auto& query_edge : query_edges) {
+                const int other = query_edge.to;
+                if (other == parent_query_vertex ||
+                    order_position[static_cast<std::size_t>(other)] >= static_cast<int>(depth)) {
+                    continue;
+                }
+                non_tree_back_arcs[depth].push_back({other, outgoing});
+            }
+        };
+        add_back_arcs(Q.adj[static_cast<std::size_t>(query_vertex)], true);
+        add_back_arcs(Q.in_adj[static_cast<std::size_t>(query_vertex)], false);
+    }
+    std::vector<std::vector<int>> extension_buffers(QD.dfs_order.size());
+    std::vector<int> intersection_scratch;
+    std::vector<int> trial_extension;
+    std::vector<int> best_extension;
+    std::vector<const std::vector<Edge>*> neighbor_lists;
+
+    // DAF-style failing sets over query vertices. ancestor_masks[u] holds u and
+    // every earlier vertex that determines u's candidate list; prefix_masks[d]
+    // holds the first d + 1 vertices in DFS order, which determine the common
+    // interval set after depth d. A returned mask of 0 means a match was found.
+    // Both are defined by the static order, so the adaptive order and queries
+    // wider than a mask use all-ones masks and never backjump.
+    using FailingSet = std::uint64_t;
+    const bool use_failing_sets = !adaptive_order && Q.num_vertices <= 64;
+    auto vertex_bit = [&](int query_vertex) -> FailingSet {
+        return use_failing_sets ? FailingSet{1} << query_vertex : ~FailingSet{0};
+    };
+    std::vector<FailingSet> ancestor_masks(static_cast<std::size_t>(Q.num_vertices), 0);
+    std::vector<FailingSet> prefix_masks(QD.dfs_order.size(), 0);
+    for (std::size_t depth = 0; depth < QD.dfs_order.size(); ++depth) {
+        const int query_vertex = QD.dfs_order[depth];
+        FailingSet mask = vertex_bit(query_vertex);
+        if (depth > 0) {
+            mask |= ancestor_masks[static_cast<std::size_t>(
+                QD.parent[static_cast<std::size_t>(query_vertex)])];
+            for (const auto& arc : non_tree_back_arcs[depth]) {
+                mask |= ancestor_masks[static_cast<std::size_t>(arc.other_query_vertex)];
+            }
+        }
+        ancestor_masks[static_cast<std::size_t>(query_vertex)] = mask;
+        prefix_masks[depth] = (depth > 0 ? prefix_masks[depth - 1] : 0) | vertex_bit(query_vertex);
+    }
+
+    // prefix_intervals[d] is the common interval set after depths 0..d - 1,
+    // or nullptr while no arc has been mapped.
+    std::vector<const std::vector<TimeInterval>*> prefix_intervals(QD.dfs_order.size() + 1, nullptr);
+    std::vector<TimeInterval> own_intervals;
+    std::vector<TimeInterval> trial_intervals;
+
+    // Candidates for query_vertex under the current mapping: its parent's
+    // block, intersected with the sorted adjacency lists of every mapped
+    // non-parent neighbor (smallest first). Returns nullptr without a block.
+    auto collect_extension = [&](int query_vertex, std::vector<int>& buffer)
+        -> const std::vector<int>* {
+        const int parent_query_vertex = QD.parent[static_cast<std::size_t>(query_vertex)];
+        if (parent_query_vertex < 0) return nullptr;
         const int parent_data_vertex = mapping[static_cast<std::size_t>(parent_query_vertex)];
-        const TDTreeBlock* block = nodes[static_cast<std::size_t>(query_vertex)].findBlock(parent_data_vertex);
-        if (block == nullptr) return;
+        const TDTreeBlock* block =
+            nodes[static_cast<std::size_t>(query_vertex)].findBlock(parent_data_vertex);
+        if (block == nullptr) return nullptr;
 
-        for (int candidate : block->V_cand) {
-            if (used_data_vertices[static_cast<std::size_t>(candidate)] != 0) continue;
+        // An arc q -> o requires candidate -> mapping[o], so the candidate
+        // must appear in in_adj(mapping[o]); o -> q uses adj(mapping[o]).
+        neighbor_lists.clear();
+        auto add_neighbor_lists = [&](const std::vector<Edge>& query_edges, bool outgoing) {
+            for (const auto& query_edge : query_edges) {
+                if (query_edge.to == parent_query_vertex) continue;
+                const int other_data_vertex = mapping[static_cast<std::size_t>(query_edge.to)];
+                if (other_data_vertex < 0) continue;
+                neighbor_lists.push_back(outgoing
+                    ? &G.in_adj[static_cast<std::size_t>(other_data_vertex)]
+                    : &G.adj[static_cast<std::size_t>(other_data_vertex)]);
+            }
+        };
+        add_neighbor_lists(Q.adj[static_cast<std::size_t>(query_vertex)], true);
+        add_neighbor_lists(Q.in_adj[static_cast<std::size_t>(query_vertex)], false);
+        if (neighbor_lists.empty()) return &block->V_cand;
 
-            std::vector<TimeInterval> next_intervals = current_intervals;
-            bool next_has_intervals = has_intervals;
-            bool valid = true;
+        std::sort(neighbor_lists.begin(), neighbor_lists.end(),
+            [](const std::vector<Edge>* lhs, const std::vector<Edge>* rhs) {
+                return lhs->size() < rhs->size();
+            });
+        intersectSortedVertices(block->V_cand, *neighbor_lists.front(), buffer);
+        for (std::size_t i = 1; i < neighbor_lists.size() && !buffer.empty(); ++i) {
+            intersectSortedVertices(buffer, *neighbor_lists[i], intersection_scratch);
+            buffer.swap(intersection_scratch);
+        }
+        return &buffer;
+    };
 
-            auto apply_temporal_edge = [&](int source_data_vertex, int target_data_vertex) {
-                const TemporalEdge* temporal_edge =
-                    G.findTemporalEdge(source_data_vertex, target_data_vertex);
-                if (temporal_edge == nullptr) return false;
+    // Intersect current_intervals with every arc between candidate and an
+    // already-mapped query vertex. Tree orientation never changes arc direction.
+    auto extend_intervals = [&](
+        int query_vertex,
+        int candidate,
+        const std::vector<TimeInterval>& current_intervals,
+        bool has_intervals,
+        std::vector<TimeInterval>& next_intervals,
+        bool& next_has_intervals) {
+        next_intervals = current_intervals;
+        next_has_intervals = has_intervals;
+        auto apply_temporal_edge = [&](int source_data_vertex, int target_data_vertex) {
+            const TemporalEdge* temporal_edge =
+                G.findTemporalEdge(source_data_vertex, target_data_vertex);
+            if (temporal_edge == nullptr) return false;
+            if (rank_matches &&
+                edge_longest_runs[static_cast<std::size_t>(temporal_edge - G.temporal_edges.data())] <
+                    minimum_length) {
+                return false;
+            }
+
+            if (!next_has_intervals) {
+                next_intervals.clear();
+                for (const auto& interval : temporal_edge->active_intervals) {
+                    if (interval.length() >= minimum_length) next_intervals.push_back(interval);
+                }
+                next_has_intervals = true;
+            } else {
+                next_intervals = intersectTimeIntervals(
+                    next_intervals, temporal_edge->active_intervals, minimum_length);
+            }
+            return !next_intervals.empty();
+        };
 
-                if (!next_has_intervals) {
-                    next_intervals.clear();
-                    for (const auto& interval : temporal_edge->active_intervals) {
-                        if (interval.length() >= k_threshold) next_intervals.push_back(interval);
+        for (const auto& query_edge : Q.adj[static_cast<std::size_t>(query_vertex)]) {
+            const int other_data_vertex = mapping[static_cast<std::size_t>(query_edge.to)];
+            if (other_data_vertex >= 0 && !apply_temporal_edge(candidate, other_data_vertex)) {
+                return false;
+            }
+        }
+        for (const auto& query_edge : Q.in_adj[static_cast<std::size_t>(query_vertex)]) {
+            const int other_data_vertex = mapping[static_cast<std::size_t>(query_edge.to)];
+            if (other_data_vertex >= 0 && !apply_temporal_edge(other_data_vertex, candidate)) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    // Adaptive order: among unmapped vertices whose spanning-tree parent is
+    // mapped (the only ones with a TD-tree block to draw from), pick the one
+    // with the fewest viable candidates. Ties prefer the smaller total length
+    // of the resulting common intervals, then the static DFS position.
+    auto select_next_vertex = [&](
+        std::size_t depth,
+        const std::vector<TimeInterval>& current_intervals,
+        bool has_intervals,
+        const std::vector<int>*& best_candidates) -> int {
+        int best_vertex = -1;
+        best_candidates = nullptr;
+        std::size_t best_viable = std::numeric_limits<std::size_t>::max();
+        long long best_duration = std::numeric_limits<long long>::max();
+        bool best_uses_buffer = false;
+        for (int query_vertex : QD.dfs_order) {
+            const int parent_query_vertex = QD.parent[static_cast<std::size_t>(query_vertex)];
+            if (mapping[static_cast<std::size_t>(query_vertex)] >= 0 || parent_query_vertex < 0 ||
+                mapping[static_cast<std::size_t>(parent_query_vertex)] < 0) {
+                continue;
+            }
+
+            const std::vector<int>* candidates = collect_extension(query_vertex, trial_extension);
+            std::size_t viable = 0;
+            long long duration = 0;
+            if (candidates != nullptr) {
+                for (int candidate : *candidates) {
+                    if (used_by[static_cast<std::size_t>(candidate)] >= 0) continue;
+                    bool trial_has_intervals = false;
+                    if (!extend_intervals(
+                            query_vertex, candidate, current_intervals, has_intervals,
+                            trial_intervals, trial_has_intervals)) {
+                        continue;
                     }
-                    next_has_intervals = true;
-                } else {
-                    next_intervals = intersectTimeIntervals(
-                        next_intervals, temporal_edge->active_intervals, k_threshold);
+                    if (++viable > best_viable) break;
+                    for (const auto& interval : trial_intervals) duration += interval.length();
                 }
-                return !next_intervals.empty();
-            };
-
-            // Check every outgoing and incoming query arc whose other endpoint
-            // is already mapped. Tree orientation never changes arc direction.
-            for (const auto& query_edge : Q.adj[static_cast<std::size_t>(query_vertex)]) {
-                const int other_query_vertex = query_edge.to;
-                const int other_data_vertex = mapping[static_cast<std::size_t>(other_query_vertex)];
-                if (other_data_vertex < 0) continue;
-                if (!apply_temporal_edge(candidate, other_data_vertex)) {
-                    valid = false;
-                    break;
+            }
+            if (viable < best_viable || (viable == best_viable && duration < best_duration)) {
+                best_vertex = query_vertex;
+                best_viable = viable;
+                best_duration = duration;
+                best_candidates = candidates;
+                best_uses_buffer = candidates == &trial_extension;
+                if (best_uses_buffer) best_extension.swap(trial_extension);
+                if (viable == 0) break;
+            }
+        }
+        if (best_uses_buffer) {
+            extension_buffers[depth].swap(best_extension);
+            best_candidates = &extension_buffers[depth];
+        }
+        return best_vertex;
+    };
+
+    auto append_text_row = [&](
+        AsyncMatchWriter& writer,
+        std::uint64_t match_index,
+        const std::vector<TimeInterval>& intervals) {
+        row_formatter.append(writer, match_index, mapping, intervals);
+    };
+
+    // Hands one match in mapping to the sinks. match_index numbers text rows.
+    auto deliver_match = [&](std::uint64_t match_index, const std::vector<TimeInterval>& intervals) {
+        if (sinks.callback != nullptr) {
+            if (!(*sinks.callback)(mapping, intervals) && !stop_requested) {
+                stop_requested = true;
+                summary.stop_reason = MatchStopReason::Consumer;
+            }
+            return;
+        }
+        if (sinks.binary_rows != nullptr) {
+            for (int data_vertex : mapping) {
+                sinks.binary_rows->appendLittleEndian(static_cast<std::uint32_t>(data_vertex));
+            }
+            sinks.binary_intervals->appendLittleEndian(
+                static_cast<std::uint32_t>(intervals.size()));
+            for (const TimeInterval& interval : intervals) {
+                sinks.binary_intervals->appendLittleEndian(
+                    static_cast<std::uint32_t>(interval.start));
+                sinks.binary_intervals->appendLittleEndian(
+                    static_cast<std::uint32_t>(interval.end));
+            }
+            return;
+        }
+        if (sinks.text != nullptr) append_text_row(*sinks.text, match_index, intervals);
+    };
+
+    // Every common interval already spans k_threshold, so the longest one
+    // decides the largest k the current match survives. A query without
+    // arcs is bounded by its vertex's active duration instead.
+    std::vector<TimeInterval> durable_intervals;
+    auto record_durability = [&](const std::vector<TimeInterval>& intervals) {
+        int longest_run = 0;
+        for (const auto& interval : intervals) longest_run = std::max(longest_run, interval.length());
+        if (QD.dfs_order.size() == 1) {
+            longest_run = G.vertex_active_durations[static_cast<std::size_t>(
+                mapping[static_cast<std::size_t>(QD.root)])];
+        }
+        auto& counts = *sinks.durability_counts;
+        for (std::size_t offset = 0;
+             offset < counts.size() && k_threshold + static_cast<int>(offset) <= longest_run;
+             ++offset) {
+            if (sinks.durability_writers != nullptr) {
+                const int minimum_duration = k_threshold + static_cast<int>(offset);
+                durable_intervals.clear();
+                for (const auto& interval : intervals) {
+                    if (interval.length() >= minimum_duration) durable_intervals.push_back(interval);
                 }
+                append_text_row(
+                    *(*sinks.durability_writers)[offset], counts[offset], durable_intervals);
             }
-            if (!valid) continue;
-            for (const auto& query_edge : Q.in_adj[static_cast<std::size_t>(query_vertex)]) {
-                const int other_query_vertex = query_edge.to;
-                const int other_data_vertex = mapping[static_cast<std::size_t>(other_query_vertex)];
-                if (other_data_vertex < 0) continue;
-                if (!apply_temporal_edge(other_data_vertex, candidate)) {
-                    valid = false;
-                    break;
+            ++counts[offset];
+        }
+    };
+
+    std::function<FailingSet(std::size_t, const std::vector<TimeInterval>&, bool)> dfs;
+    dfs = [&](std::size_t depth, const std::vector<TimeInterval>& current_intervals, bool has_intervals)
+        -> FailingSet {
+        // A stopped search returns the full set, which never backjumps.
+        if (should_stop()) return ~FailingSet{0};
+        // The prefix may predate the latest raise of minimum_length.
+        if (rank_matches && has_intervals && longest_run_of(current_intervals) < minimum_length) {
+            return ~FailingSet{0};
+        }
+        if (depth >= QD.dfs_order.size()) {
+            bool accept = true;
+            const MatchStopReason limit_stop = applyResultLimits(limits, match_count, accept);
+            if (limit_stop != MatchStopReason::Complete) {
+                stop_requested = true;
+                summary.stop_reason = limit_stop;
+            }
+            if (!accept) return ~FailingSet{0};
+            ++match_count;
+            if (sinks.durability_counts != nullptr) {
+                record_durability(current_intervals);
+                return 0;
+            }
+            if (rank_matches) {
+                const int longest_run = QD.dfs_order.size() == 1
+                    ? G.vertex_active_durations[static_cast<std::size_t>(
+                          mapping[static_cast<std::size_t>(QD.root)])]
+                    : longest_run_of(current_intervals);
+                if (ranked_matches.size() == options.top_matches) {
+                    // Only a query without arcs reaches here without beating
+                    // the shortest kept run.
+                    if (longest_run <= ranked_matches.front().longest_run) return 0;
+                    std::pop_heap(ranked_matches.begin(), ranked_matches.end(), ranks_below);
+                    ranked_matches.pop_back();
+                }
+                ranked_matches.push_back({longest_run, match_count - 1, mapping});
+                std::push_heap(ranked_matches.begin(), ranked_matches.end(), ranks_below);
+                if (ranked_matches.size() == options.top_matches) {
+                    minimum_length = std::max(minimum_length, ranked_matches.front().longest_run + 1);
+                }
+                return 0;
+            }
+            deliver_match(match_count - 1, current_intervals);
+            return 0;
+        }
+
+
+        const std::vector<int>* extension_candidates = nullptr;
+        int query_vertex = -1;
+        if (adaptive_order) {
+            query_vertex = select_next_vertex(
+                depth, current_intervals, has_intervals, extension_candidates);
+            if (query_vertex < 0) return ~FailingSet{0};
+        } else {
+            query_vertex = QD.dfs_order[depth];
+            extension_candidates = collect_extension(query_vertex, extension_buffers[depth]);
+        }
+        const FailingSet own_ancestors = ancestor_masks[static_cast<std::size_t>(query_vertex)];
+        if (extension_candidates == nullptr) return own_ancestors;
+        prefix_intervals[depth] = has_intervals ? &current_intervals : nullptr;
+
+        // The candidate's arcs to mapped vertices are fixed by own_ancestors.
+        // When their common run conflicts with the prefix, the shortest prefix
+        // that already empties the intersection names the temporal culprits.
+        auto temporal_failing_set = [&](int candidate) -> FailingSet {
+            if (!use_failing_sets) return ~FailingSet{0};
+            bool has_own_intervals = false;
+            if (!extend_intervals(query_vertex, candidate, {}, false,
+                                  own_intervals, has_own_intervals)) {
+                return own_ancestors;
+            }
+
+            std::size_t low = 1;
+            std::size_t high = depth - 1;
+            while (low < high) {
+                const std::size_t middle = low + (high - low) / 2;
+                const auto* prefix = prefix_intervals[middle + 1];
+                if (prefix != nullptr &&
+                    intersectTimeIntervals(own_intervals, *prefix, minimum_length).empty()) {
+                    high = middle;
+                } else {
+                    low = middle + 1;
                 }
             }
-            if (!valid) continue;
+            return own_ancestors | prefix_masks[high];
+        };
+
+        FailingSet failing_set = own_ancestors;
+        bool found_match = false;
+        std::vector<TimeInterval> next_intervals;
+        for (std::size_t candidate_index = 0;
+             candidate_index < extension_candidates->size();
+             ++candidate_index) {
+            const int candidate = (*extension_candidates)[candidate_index];
+            const int conflicting_query_vertex = used_by[static_cast<std::size_t>(candidate)];
+            if (conflicting_query_vertex >= 0) {
+                failing_set |= own_ancestors |
+                    ancestor_masks[static_cast<std::size_t>(conflicting_query_vertex)];
+                continue;
+            }
+
+            bool next_has_intervals = false;
+            if (!extend_intervals(
+                    query_vertex, candidate, current_intervals, has_intervals,
+                    next_intervals, next_has_intervals)) {
+                failing_set |= temporal_failing_set(candidate);
+                continue;
+            }
 
             mapping[static_cast<std::size_t>(query_vertex)] = candidate;
-            used_data_vertices[static_cast<std::size_t>(candidate)] = 1;
-            dfs(depth + 1, next_intervals, next_has_intervals);
-            used_data_vertices[static_cast<std::size_t>(candidate)] = 0;
+            used_by[static_cast<std::size_t>(candidate)] = query_vertex;
+            const FailingSet child_failing_set = dfs(depth + 1, next_intervals, next_has_intervals);
+            used_by[static_cast<std::size_t>(candidate)] = -1;
             mapping[static_cast<std::size_t>(query_vertex)] = -1;
+            if (stop_requested) return found_match ? 0 : ~FailingSet{0};
+
+            if (child_failing_set == 0) {
+                found_match = true;
+            } else if (!found_match && (child_failing_set & vertex_bit(query_vertex)) == 0) {
+                // The subtree failed for a reason independent of this vertex's
+                // mapping, so every remaining sibling fails the same way.
+                pruned_candidates += extension_candidates->size() - candidate_index - 1;
+                return child_failing_set;
+            } else {
+                failing_set |= child_failing_set;
+            }
         }
+        return found_match ? 0 : failing_set;
     };
 
     const auto& root_candidates = nodes[static_cast<std::size_t>(QD.root)].root_candidates;
-    for (int root_candidate : root_candidates) {
+    for (std::size_t root_index = 0; root_index < root_candidates.size(); ++root_index) {
+        const int root_candidate = root_candidates[root_index];
         mapping[static_cast<std::size_t>(QD.root)] = root_candidate;
-        used_data_vertices[static_cast<std::size_t>(root_candidate)] = 1;
-        dfs(1, {}, false);
-        used_data_vertices[static_cast<std::size_t>(root_candidate)] = 0;
+        used_by[static_cast<std::size_t>(root_candidate)] = QD.root;
+        const FailingSet failing_set = dfs(1, {}, false);
+        used_by[static_cast<std::size_t>(root_candidate)] = -1;
         mapping[static_cast<std::size_t>(QD.root)] = -1;
+        if (stop_requested) break;
+        if (failing_set != 0 && (failing_set & vertex_bit(QD.root)) == 0) {
+            pruned_candidates += root_candidates.size() - root_index - 1;
+            break;
+        }
+    }
+    if (rank_matches) {
+        // Replay the kept matches, longest run first, through the sinks. The
+        // raised k clipped their intervals, so the common intervals are
+        // recomputed at the tree's own k.
+        std::sort_heap(ranked_matches.begin(), ranked_matches.end(), ranks_below);
+        const bool stopped_before_replay = stop_requested;
+        stop_requested = false;
+        match_count = 0;
+        std::vector<TimeInterval> common_intervals;
+        for (const RankedMatch& ranked : ranked_matches) {
+            mapping = ranked.mapping;
+            bool has_intervals = false;
+            for (int query_vertex = 0; query_vertex < Q.num_vertices; ++query_vertex) {
+                for (const auto& query_edge : Q.adj[static_cast<std::size_t>(query_vertex)]) {
+                    const TemporalEdge* temporal_edge = G.findTemporalEdge(
+                        mapping[static_cast<std::size_t>(query_vertex)],
+                        mapping[static_cast<std::size_t>(query_edge.to)]);
+                    common_intervals = has_intervals
+                        ? intersectTimeIntervals(
+                              common_intervals, temporal_edge->active_intervals, k_threshold)
+                        : intersectTimeIntervals(
+                              temporal_edge->active_intervals, temporal_edge->active_intervals,
+                              k_threshold);
+                    has_intervals = true;
+                }
+            }
+            deliver_match(match_count++, common_intervals);
+            if (stop_requested) break;
+        }
+        stop_requested = stop_requested || stopped_before_replay;
     }
-    return match_count;
+    summary.match_count = match_count;
+    summary.failing_set_pruned_candidates = pruned_candidates;
+    summary.effective_minimum_duration = minimum_length;
 }
 
-MatchSummary TDTree::save_res(const std::string& filename) const {
-    MatchSummary summary;
-    // Binary mode keeps tellp/seekp offsets stable on Windows (text mode
-    // translates '\n' to CRLF and would corrupt the count placeholder).
-    std::ofstream output(filename, std::ios::binary);
-    if (!output.is_open()) return summary;
-
+void TDTree::writeCandidateSummary(std::ostream& output) const {
     output << "[Candidate Summary]\n";
     for (const auto& node : nodes) {
         const auto candidates = uniqueCandidates(node);
@@ -505,25 +1598,234 @@ MatchSummary TDTree::save_res(const std::string& filename) const {
         if (candidates.size() > sample_size) output << ",...";
         output << '\n';
     }
+}
+
+MatchSummary TDTree::save_res(
+    const std::string& filename,
+    const MatchOptions& options) const {
+    if (options.output_format == MatchOutputFormat::Binary) {
+        return saveBinaryResults(filename, options);
+    }
+    MatchSummary summary;
+    // Binary mode keeps tellp/seekp offsets stable on Windows (text mode
+    // translates '\n' to CRLF and would corrupt the count placeholder).
+    std::ofstream output(filename, std::ios::binary);
+    if (!output.is_open()) return summary;
 
-    output << "\n[Final Matches]\nCount: ";
-    const std::streampos count_position = output.tellp();
-    output << std::setw(20) << 0 << '\n';
+    writeCandidateSummary(output);
+    output << '\n';
+    FinalMatchesSection section(output, G, Q, options.output_mode);
 
     const auto start = std::chrono::steady_clock::now();
-    summary.match_count = enumerateMatches(output);
+    std::uint64_t factorized_count = 0;
+    if (options.output_mode == MatchOutputMode::CountOnly && !options.limits.active() &&
+        options.top_matches == 0 && countFactorized(factorized_count)) {
+        summary.match_count = factorized_count;
+        summary.factorized_count = true;
+    } else {
+        MatchSinks sinks;
+        sinks.text = section.writer();
+        enumerateMatches(sinks, options, summary);
+    }
+    // Draining the last rows counts towards enumeration, as in the binary path.
+    section.finish(summary);
     summary.enumeration_milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(
         std::chrono::steady_clock::now() - start).count();
 
-    const std::streampos end_position = output.tellp();
-    output.seekp(count_position);
-    output << std::setw(20) << summary.match_count;
-    output.seekp(end_position);
+    output << "\n[Statistics]\n"
+           << "candidate_relation_entries: " << candidateRelationCount() << '\n';
+    writeRunStatistics(output, options.output_mode,
+        options.top_matches > 0
+            ? "top-matches"
+            : (summary.factorized_count ? "factorized" : "enumeration"),
+        summary.stop_reason);
+    output << "matching_order: " << matchingOrderName(options.matching_order) << '\n'
+           << "failing_set_pruned_candidates: " << summary.failing_set_pruned_candidates << '\n';
+    writeTimingStatistics(output, summary);
+    if (options.top_matches > 0) {
+        output << "top_matches: " << options.top_matches << '\n'
+               << "top_effective_k: " << summary.effective_minimum_duration << '\n';
+    }
+    output.flush();
+    summary.output_written = summary.output_written && output.good();
+    return summary;
+}
+
+MatchSummary TDTree::forEachMatch(
+    const MatchCallback& callback,
+    const MatchOptions& options) const {
+    MatchSummary summary;
+    const auto start = std::chrono::steady_clock::now();
+    MatchSinks sinks;
+    sinks.callback = &callback;
+    enumerateMatches(sinks, options, summary);
+    summary.enumeration_milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    return summary;
+}
+
+DurabilityProfile TDTree::saveDurabilityProfile(
+    const std::string& filename,
+    int maximum_duration,
+    const std::vector<std::string>& per_k_filenames,
+    const MatchOptions& options) const {
+    DurabilityProfile profile;
+    profile.minimum_duration = k_threshold;
+    profile.match_counts.assign(
+        static_cast<std::size_t>(std::max(maximum_duration - k_threshold + 1, 1)), 0);
+    std::ofstream output(filename, std::ios::binary);
+    if (!output.is_open()) return profile;
+
+    const bool write_matches = options.output_mode == MatchOutputMode::Full &&
+        !per_k_filenames.empty();
+    if (write_matches && per_k_filenames.size() != profile.match_counts.size()) return profile;
+
+    // Each per-k file gets the same Count: placeholder as save_res.
+    std::vector<std::ofstream> match_outputs;
+    std::vector<std::streampos> count_positions;
+    if (write_matches) {
+        match_outputs.reserve(per_k_filenames.size());
+        for (const auto& match_filename : per_k_filenames) {
+            match_outputs.emplace_back(match_filename, std::ios::binary);
+            if (!match_outputs.back().is_open()) return profile;
+            match_outputs.back() << "[Final Matches]\nCount: ";
+            count_positions.push_back(match_outputs.back().tellp());
+            match_outputs.back() << std::setw(20) << 0 << '\n';
+        }
+    }
+
+    MatchSummary& summary = profile.summary;
+    const auto start = std::chrono::steady_clock::now();
+    bool matches_written = true;
+    {
+        std::vector<std::unique_ptr<AsyncMatchWriter>> writers;
+        std::vector<AsyncMatchWriter*> writer_pointers;
+        for (auto& match_output : match_outputs) {
+            writers.push_back(std::make_unique<AsyncMatchWriter>(match_output));
+            writer_pointers.push_back(writers.back().get());
+        }
+        MatchSinks sinks;
+        sinks.durability_counts = &profile.match_counts;
+        if (write_matches) sinks.durability_writers = &writer_pointers;
+        enumerateMatches(sinks, options, summary);
+        for (auto& writer : writers) {
+            matches_written = writer->finish() && matches_written;
+            summary.io_blocked_milliseconds += writer->blockedMilliseconds();
+        }
+    }
+    summary.enumeration_milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    for (std::size_t offset = 0; offset < match_outputs.size(); ++offset) {
+        auto& match_output = match_outputs[offset];
+        const std::streampos end_position = match_output.tellp();
+        match_output.seekp(count_positions[offset]);
+        match_output << std::setw(20) << profile.match_counts[offset];
+        match_output.seekp(end_position);
+        if (summary.stop_reason != MatchStopReason::Complete) {
+            match_output << "Truncated: " << matchStopReasonName(summary.stop_reason) << '\n';
+        }
+        match_output.flush();
+        matches_written = matches_written && match_output.good();
+    }
+
+    writeCandidateSummary(output);
+    output << "\n[Durability Profile]\n";
+    for (std::size_t offset = 0; offset < profile.match_counts.size(); ++offset) {
+        output << "k=" << k_threshold + static_cast<int>(offset)
+               << " count=" << profile.match_counts[offset] << '\n';
+    }
+    if (summary.stop_reason != MatchStopReason::Complete) {
+        output << "Truncated: " << matchStopReasonName(summary.stop_reason) << '\n';
+    }
     output << "\n[Statistics]\n"
            << "candidate_relation_entries: " << candidateRelationCount() << '\n'
-           << "enumeration_ms: " << summary.enumeration_milliseconds << '\n';
+           << "mode: " << matchOutputModeName(options.output_mode) << '\n'
+           << "count_strategy: durability-profile\n"
+           << "stop_reason: " << matchStopReasonName(summary.stop_reason) << '\n'
+           << "matching_order: " << matchingOrderName(options.matching_order) << '\n'
+           << "failing_set_pruned_candidates: " << summary.failing_set_pruned_candidates << '\n'
+           << "enumeration_ms: " << summary.enumeration_milliseconds << '\n'
+           << "io_blocked_ms: " << summary.io_blocked_milliseconds << '\n';
+    output.flush();
+    summary.output_written = matches_written && output.good();
+    return profile;
+}
+
+MatchSummary TDTree::saveBinaryResults(
+    const std::string& filename,
+    const MatchOptions& options) const {
+    MatchSummary summary;
+    std::ofstream output(filename, std::ios::binary);
+    if (!output.is_open()) return summary;
+
+    BinaryMatchHeader header;
+    header.minimum_duration = k_threshold;
+    header.count_only = options.output_mode == MatchOutputMode::CountOnly;
+    header.query_labels = Q.vertex_labels;
+
+    // Intervals are spooled to a sidecar file during enumeration and
+    // appended after the fixed-width rows. The sidecar is opened first so
+    // that a failure leaves no headerless result file behind.
+    const std::string interval_filename = filename + ".intervals";
+    std::ofstream interval_output;
+    if (!header.count_only) {
+        interval_output.open(interval_filename, std::ios::binary);
+        if (!interval_output.is_open()) {
+            output.close();
+            std::remove(filename.c_str());
+            return summary;
+        }
+    }
+    writeBinaryMatchHeader(output, header);
+
+    const auto start = std::chrono::steady_clock::now();
+    std::uint64_t factorized_count = 0;
+    bool rows_written = true;
+    bool intervals_written = true;
+    if (header.count_only && !options.limits.active() && options.top_matches == 0 &&
+        countFactorized(factorized_count)) {
+        summary.match_count = factorized_count;
+        summary.factorized_count = true;
+    } else if (header.count_only) {
+        enumerateMatches(MatchSinks{}, options, summary);
+    } else {
+        {
+            AsyncMatchWriter writer(output);
+            AsyncMatchWriter interval_writer(interval_output);
+            MatchSinks sinks;
+            sinks.binary_rows = &writer;
+            sinks.binary_intervals = &interval_writer;
+            enumerateMatches(sinks, options, summary);
+            rows_written = writer.finish();
+            intervals_written = interval_writer.finish();
+            summary.io_blocked_milliseconds =
+                writer.blockedMilliseconds() + interval_writer.blockedMilliseconds();
+        }
+        interval_output.close();
+        intervals_written = intervals_written && !interval_output.fail();
+    }
+    summary.enumeration_milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    header.interval_section_offset = static_cast<std::uint64_t>(output.tellp());
+    if (!header.count_only) {
+        std::ifstream interval_input(interval_filename, std::ios::binary);
+        if (interval_input.peek() != std::ifstream::traits_type::eof()) {
+            output << interval_input.rdbuf();
+        }
+        interval_input.close();
+        std::remove(interval_filename.c_str());
+    }
+    header.dictionary_offset = static_cast<std::uint64_t>(output.tellp());
+    writeBinaryMatchDictionary(output, G);
+
+    header.match_count = summary.match_count;
+    header.stop_reason = static_cast<std::uint8_t>(summary.stop_reason);
+    output.seekp(0);
+    writeBinaryMatchHeader(output, header);
     output.flush();
-    summary.output_written = output.good();
+    summary.output_written = rows_written && intervals_written && output.good();
     return summary;
 }
 
@@ -533,6 +1835,7 @@ std::size_t TDTree::getMemoryUsage() const {
         sizeof(std::array<int, kLabelCount>);
     total += query_in_neighbor_label_requirements.capacity() *
         sizeof(std::array<int, kLabelCount>);
+    total += servable_query_vertices.capacity() * sizeof(std::uint64_t);
     for (const auto& node : nodes) {
         total += node.root_candidates.capacity() * sizeof(int);
         total += node.blocks.capacity() * sizeof(TDTreeBlock);
@@ -2,8 +2,10 @@
 #define TDTREE_H
 
 #include <array>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <iosfwd>
 #include <string>
 #include <unordered_map>
@@ -29,12 +31,153 @@ struct TDTreeNode {
     void rebuildBlockIndex();
 };
 
+// A non-tree arc between a query vertex and an earlier vertex in DFS order.
+// outgoing means query_vertex -> other_query_vertex.
+struct NonTreeCheck {
+    int other_query_vertex = -1;
+    bool outgoing = false;
+};
+
+enum class MatchingOrder {
+    // QD.dfs_order, fixed by label-level temporal selectivity.
+    Static,
+    // At each depth, the frontier vertex with the fewest viable candidates
+    // under the current mapping and common interval set.
+    Adaptive
+};
+
+const char* matchingOrderName(MatchingOrder order);
+
+enum class MatchOutputMode {
+    Full,
+    // Only the exact count is produced. Tree queries with a subtree whose
+    // labels occur nowhere else are counted by factorization over the blocks.
+    CountOnly
+};
+
+const char* matchOutputModeName(MatchOutputMode mode);
+
+enum class MatchOutputFormat {
+    Text,
+    // The layout in BinaryMatchFormat.h; read back with td_tree_dump.
+    Binary
+};
+
+const char* matchOutputFormatName(MatchOutputFormat format);
+
+enum class MatchStopReason {
+    Complete,
+    // A match beyond max_results was found, so the output is truncated.
+    ResultLimit,
+    // exists_only stopped enumeration at the first match.
+    Exists,
+    TimeLimit,
+    // A MatchCallback returned false.
+    Consumer
+};
+
+const char* matchStopReasonName(MatchStopReason reason);
+
+struct MatchLimits {
+    // Report at most this many matches; 0 means unlimited.
+    std::uint64_t max_results = 0;
+    bool exists_only = false;
+    // Cooperative enumeration deadline in seconds; 0 disables it.
+    int time_limit_seconds = 0;
+
+    bool active() const {
+        return max_results > 0 || exists_only || time_limit_seconds > 0;
+    }
+};
+
+// Polls MatchLimits::time_limit_seconds from a search loop: expired() is
+// called once per search node and reads the clock only every
+// kCheckInterval calls. One guard per thread; workers of one run share
+// start and so the deadline.
+class DeadlineGuard {
+public:
+    // Search nodes between two clock reads; a power of two.
+    static constexpr std::uint64_t kCheckInterval = 1024;
+
+    DeadlineGuard(const MatchLimits& limits, std::chrono::steady_clock::time_point start)
+        : enabled_(limits.time_limit_seconds > 0),
+          deadline_(start + std::chrono::seconds(limits.time_limit_seconds)) {}
+
+    // Always false without a time limit.
+    bool expired() {
+        return enabled_ && (++search_nodes_ & (kCheckInterval - 1)) == 0 &&
+            std::chrono::steady_clock::now() >= deadline_;
+    }
+
+private:
+    bool enabled_;
+    std::chrono::steady_clock::time_point deadline_;
+    std::uint64_t search_nodes_ = 0;
+};
+
+// Applies MatchLimits::max_results and exists_only to a complete match,
+// match_index being the number of matches accepted before it. accept says
+// whether to report it; the result is the reason to stop after it, or
+// MatchStopReason::Complete to go on. A full --limit rejects the match,
+// because only a further match proves that the output is truncated.
+inline MatchStopReason applyResultLimits(
+    const MatchLimits& limits, std::uint64_t match_index, bool& accept) {
+    accept = false;
+    if (limits.exists_only && match_index > 0) return MatchStopReason::Exists;
+    if (limits.max_results > 0 && match_index >= limits.max_results) {
+        return MatchStopReason::ResultLimit;
+    }
+    accept = true;
+    return limits.exists_only ? MatchStopReason::Exists : MatchStopReason::Complete;
+}
+
+struct MatchOptions {
+    MatchingOrder matching_order = MatchingOrder::Static;
+    MatchOutputMode output_mode = MatchOutputMode::Full;
+    MatchOutputFormat output_format = MatchOutputFormat::Text;
+    MatchLimits limits;
+    // Report only the N matches with the longest common consecutive run,
+    // longest first (ties keep the earliest found); 0 reports every match.
+    // Once N are held, the search raises its own k above the shortest kept
+    // run. Not combined with factorized counting or durability profiles.
+    std::size_t top_matches = 0;
+};
+
 struct MatchSummary {
     std::uint64_t match_count = 0;
+    // Sibling candidates skipped by failing-set backjumping.
+    std::uint64_t failing_set_pruned_candidates = 0;
     long long enumeration_milliseconds = 0;
     bool output_written = false;
+    // True when CountOnly was answered without enumerating embeddings.
+    bool factorized_count = false;
+    // Anything but Complete means match_count is a partial count.
+    MatchStopReason stop_reason = MatchStopReason::Complete;
+    // Time enumeration spent waiting for the background match writer.
+    long long io_blocked_milliseconds = 0;
+    // With top_matches, the k the search had raised itself to at the end.
+    int effective_minimum_duration = 0;
+};
+
+// Per-k counts from one enumeration at a tree's own k.
+struct DurabilityProfile {
+    int minimum_duration = 0;
+    // match_counts[i] counts the matches durable at k = minimum_duration + i,
+    // i.e. those whose longest common consecutive run reaches that k.
+    std::vector<std::uint64_t> match_counts;
+    MatchSummary summary;
 };
 
+// Receives each durable match as compact data-vertex IDs indexed by query
+// vertex (Graph::externalId maps them back) and the common active
+// intervals. Both references are valid only during the call. Returning
+// false stops enumeration with MatchStopReason::Consumer.
+using MatchCallback = std::function<bool(
+    const std::vector<int>& mapping,
+    const std::vector<TimeInterval>& intervals)>;
+
+class AsyncMatchWriter;
+
 class TDTree {
 public:
     TDTree(
@@ -44,9 +187,41 @@ public:
         int minimum_duration);
 
     void print_res() const;
-    MatchSummary save_res(const std::string& filename) const;
+    MatchSummary save_res(
+        const std::string& filename,
+        const MatchOptions& options = {}) const;
+    // Streams matches to callback without touching the filesystem.
+    // options.output_mode and output_format are ignored; limits apply.
+    // Concurrent calls on one TDTree are safe.
+    MatchSummary forEachMatch(
+        const MatchCallback& callback,
+        const MatchOptions& options = {}) const;
+    // Enumerates once at this tree's k and credits every match to each k up
+    // to maximum_duration that its longest common run reaches; larger k only
+    // keep a subset of the matches. filename receives the candidate summary
+    // and the per-k counts. In full mode, per_k_filenames (one per k from
+    // this tree's k upward) receive each k's [Final Matches] with intervals
+    // shorter than that k dropped. Output format and a CountOnly
+    // factorization do not apply.
+    DurabilityProfile saveDurabilityProfile(
+        const std::string& filename,
+        int maximum_duration,
+        const std::vector<std::string>& per_k_filenames = {},
+        const MatchOptions& options = {}) const;
+    // Reuses the tree for a larger k by re-peeling, filtering its candidates
+    // and blocks in place and re-running the semijoins, instead of
+    // rebuilding it.
+    // Non-tree arcs are not re-checked here; enumeration verifies them, so
+    // results equal a fresh build. Returns false, leaving the tree
+    // unchanged, for a smaller k. Must not overlap an enumeration.
+    bool raiseMinimumDuration(int minimum_duration);
+    int minimumDuration() const { return k_threshold; }
     std::size_t getMemoryUsage() const;
     std::size_t candidateRelationCount() const;
+    // Label- and duration-compatible data vertices before durable peeling,
+    // and those that survived it; both 0 when peeling was skipped.
+    std::size_t peelingInputVertexCount() const { return peeling_input_vertices; }
+    std::size_t peelingSurvivorCount() const { return peeling_survivors; }
 
 private:
     const Graph& G;
@@ -57,12 +232,21 @@ private:
     std::vector<TDTreeNode> nodes;
     std::vector<std::array<int, kLabelCount>> query_out_neighbor_label_requirements;
     std::vector<std::array<int, kLabelCount>> query_in_neighbor_label_requirements;
+    // Bit q of servable_query_vertices[v] is set while data vertex v can
+    // still play query vertex q after durable peeling. Empty when the query
+    // has more than 64 vertices, which skips peeling.
+    std::vector<std::uint64_t> servable_query_vertices;
+    std::size_t peeling_input_vertices = 0;
+    std::size_t peeling_survivors = 0;
+    std::size_t peeling_rounds = 0;
 
     void build();
     void initializeNodes();
     void initializeQueryRequirements();
+    std::vector<std::uint8_t> durableEdgeFlags() const;
+    void peelDataVertices(const std::vector<std::uint8_t>& durable_edges);
     void fillRoot();
-    void buildCandidateRelations();
+    void buildCandidateRelations(const std::vector<std::uint8_t>& durable_edges);
     void trimBottomUp();
     void trimTopDown();
     void rebuildBlockIndexes();
@@ -70,13 +254,36 @@ private:
     bool isDataVertexCandidate(int data_vertex, int query_vertex) const;
     bool passesAvailableNonTreeConstraints(
         int data_vertex,
-        int query_vertex,
-        const std::vector<int>& order_position,
-        const std::vector<std::vector<std::uint8_t>>& candidate_flags) const;
+        const std::vector<NonTreeCheck>& checks,
+        const std::vector<std::vector<std::uint8_t>>& candidate_flags,
+        const std::vector<std::vector<int>>& candidate_lists,
+        const std::vector<std::uint8_t>& durable_edges) const;
+
+    void writeCandidateSummary(std::ostream& output) const;
+    MatchSummary saveBinaryResults(
+        const std::string& filename,
+        const MatchOptions& options) const;
+    bool countFactorized(std::uint64_t& match_count) const;
 
     std::vector<int> uniqueCandidates(const TDTreeNode& node) const;
     std::size_t uniqueCandidateCount(const TDTreeNode& node) const;
-    std::uint64_t enumerateMatches(std::ostream& output) const;
+    // Where enumerateMatches delivers matches; all null only counts them.
+    struct MatchSinks {
+        AsyncMatchWriter* text = nullptr;
+        // Binary rows and their interval section.
+        AsyncMatchWriter* binary_rows = nullptr;
+        AsyncMatchWriter* binary_intervals = nullptr;
+        const MatchCallback* callback = nullptr;
+        // Durability profile: per-k counts and, optionally, one text writer
+        // per k. Takes precedence over the sinks above.
+        std::vector<std::uint64_t>* durability_counts = nullptr;
+        const std::vector<AsyncMatchWriter*>* durability_writers = nullptr;
+    };
+
+    void enumerateMatches(
+        const MatchSinks& sinks,
+        const MatchOptions& options,
+        MatchSummary& summary) const;
 };
 
 #endif // TDTREE_H
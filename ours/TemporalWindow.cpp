@@ -0,0 +1,119 @@
+#include "TemporalWindow.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+
+TemporalIntervalIndex::TemporalIntervalIndex(const Graph& graph) {
+    for (std::size_t edge_id = 0; edge_id < graph.temporal_edges.size(); ++edge_id) {
+        for (const auto& interval : graph.temporal_edges[edge_id].active_intervals) {
+            if (span_.length() == 0) {
+                span_ = {interval.start, interval.end};
+            } else {
+                span_.first = std::min(span_.first, interval.start);
+                span_.last = std::max(span_.last, interval.end);
+            }
+            std::size_t length_class = 0;
+            while ((2LL << length_class) <= interval.length()) ++length_class;
+            if (length_class >= length_classes_.size()) length_classes_.resize(length_class + 1);
+            length_classes_[length_class].push_back(
+                {interval.start, interval.end, static_cast<int>(edge_id)});
+        }
+    }
+    for (auto& entries : length_classes_) {
+        std::sort(entries.begin(), entries.end(), [](const Entry& lhs, const Entry& rhs) {
+            return lhs.start < rhs.start;
+        });
+    }
+}
+
+std::size_t TemporalIntervalIndex::entryCount() const {
+    std::size_t count = 0;
+    for (const auto& entries : length_classes_) count += entries.size();
+    return count;
+}
+
+std::size_t TemporalIntervalIndex::getMemoryUsage() const {
+    std::size_t total = length_classes_.capacity() * sizeof(std::vector<Entry>);
+    for (const auto& entries : length_classes_) total += entries.capacity() * sizeof(Entry);
+    return total;
+}
+
+Graph makeWindowGraph(
+    const Graph& graph,
+    const TemporalIntervalIndex& index,
+    SnapshotWindow window,
+    int minimum_duration) {
+    // Each clipped interval is packed as (edge ID, offset of its start in the
+    // window) so one integer sort groups intervals by edge in start order.
+    std::vector<std::uint64_t> clipped;
+    index.forEachOverlap(window, minimum_duration, [&](int edge_id, const TimeInterval& interval) {
+        clipped.push_back(
+            (static_cast<std::uint64_t>(edge_id) << 32) |
+            static_cast<std::uint32_t>(interval.start - window.first));
+    });
+    std::sort(clipped.begin(), clipped.end());
+
+    Graph view;
+    view.num_vertices = graph.num_vertices;
+    view.vertex_labels = graph.vertex_labels;
+    view.external_ids = graph.external_ids;
+    view.label_ranks = graph.label_ranks;
+    view.adj.resize(graph.adj.size());
+    view.in_adj.resize(graph.in_adj.size());
+    view.input_occurrence_count = graph.input_occurrence_count;
+    view.input_unique_edge_count = graph.input_unique_edge_count;
+    view.temporal_edges.reserve(clipped.size());
+
+    std::vector<int> touched_vertices;
+    auto touch = [&](int vertex) {
+        if (view.adj[static_cast<std::size_t>(vertex)].empty() &&
+            view.in_adj[static_cast<std::size_t>(vertex)].empty()) {
+            touched_vertices.push_back(vertex);
+        }
+    };
+    for (std::size_t first = 0; first < clipped.size();) {
+        const int source_edge_id = static_cast<int>(clipped[first] >> 32);
+        const TemporalEdge& source_edge =
+            graph.temporal_edges[static_cast<std::size_t>(source_edge_id)];
+        TemporalEdge edge;
+        edge.u = source_edge.u;
+        edge.v = source_edge.v;
+        std::size_t last = first;
+        while (last < clipped.size() && static_cast<int>(clipped[last] >> 32) == source_edge_id) ++last;
+        edge.active_intervals.reserve(last - first);
+        for (; first < last; ++first) {
+            const int start = window.first + static_cast<int>(clipped[first] & 0xffffffffU);
+            // Only the start was packed; the clipped end is recovered from the
+            // source interval that contains it.
+            const auto source = std::upper_bound(
+                source_edge.active_intervals.begin(), source_edge.active_intervals.end(), start,
+                [](int value, const TimeInterval& interval) { return value < interval.start; });
+            const int end = std::min(std::prev(source)->end, window.last);
+            edge.active_intervals.push_back({start, end});
+            edge.active_snapshot_count += end - start + 1;
+        }
+
+        const int edge_id = static_cast<int>(view.temporal_edges.size());
+        touch(edge.u);
+        touch(edge.v);
+        view.adj[static_cast<std::size_t>(edge.u)].push_back({edge.v, edge_id});
+        view.in_adj[static_cast<std::size_t>(edge.v)].push_back({edge.u, edge_id});
+        view.temporal_edges.push_back(std::move(edge));
+    }
+    view.filtered_edge_count = view.temporal_edges.size();
+
+    // Edge IDs follow the source order, not the target order findTemporalEdge
+    // and the TD-tree expect, so every touched list is re-sorted.
+    auto by_target = [](const Edge& lhs, const Edge& rhs) { return lhs.to < rhs.to; };
+    for (int vertex : touched_vertices) {
+        auto& out_edges = view.adj[static_cast<std::size_t>(vertex)];
+        auto& in_edges = view.in_adj[static_cast<std::size_t>(vertex)];
+        std::sort(out_edges.begin(), out_edges.end(), by_target);
+        std::sort(in_edges.begin(), in_edges.end(), by_target);
+    }
+    computeVertexActiveDurations(view);
+    computeNeighborLabelCounts(view);
+    return view;
+}
@@ -0,0 +1,86 @@
+#ifndef TEMPORAL_WINDOW_H
+#define TEMPORAL_WINDOW_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "Utils.h"
+
+// An inclusive snapshot range [first, last].
+struct SnapshotWindow {
+    int first = 0;
+    int last = -1;
+
+    int length() const {
+        return last >= first ? last - first + 1 : 0;
+    }
+};
+
+// Every active interval of a filtered temporal graph, grouped by length
+// class (lengths in [2^c, 2^(c+1))) and sorted by start within a class. An
+// interval of class c that overlaps a window starts less than 2^(c+1)
+// snapshots before it, so a query scans only a bounded start range per
+// class instead of every edge. Built once per loaded graph.
+class TemporalIntervalIndex {
+public:
+    explicit TemporalIntervalIndex(const Graph& graph);
+
+    // Calls visit(edge_id, clipped) for every interval whose part inside
+    // window spans at least minimum_length snapshots, with clipped being
+    // that part. Classes too short to reach minimum_length are skipped.
+    template <typename Visitor>
+    void forEachOverlap(SnapshotWindow window, int minimum_length, Visitor&& visit) const;
+
+    // The snapshots covered by any interval; empty for an edgeless graph.
+    SnapshotWindow span() const { return span_; }
+    std::size_t entryCount() const;
+    std::size_t getMemoryUsage() const;
+
+private:
+    struct Entry {
+        int start = 0;
+        int end = -1;
+        int edge_id = -1;
+    };
+    std::vector<std::vector<Entry>> length_classes_;
+    SnapshotWindow span_;
+};
+
+// Builds the part of graph that is active inside window: each edge keeps
+// its intervals clipped to the window, and an edge without a clipped run
+// of at least minimum_duration is dropped. Vertex IDs, labels and external
+// IDs are unchanged, so matches need no translation; active durations and
+// neighbor-label counts are recomputed from the clipped edges.
+Graph makeWindowGraph(
+    const Graph& graph,
+    const TemporalIntervalIndex& index,
+    SnapshotWindow window,
+    int minimum_duration);
+
+template <typename Visitor>
+void TemporalIntervalIndex::forEachOverlap(
+    SnapshotWindow window,
+    int minimum_length,
+    Visitor&& visit) const {
+    const int required = minimum_length > 1 ? minimum_length : 1;
+    if (window.length() < required) return;
+    for (std::size_t length_class = 0; length_class < length_classes_.size(); ++length_class) {
+        // The longest interval of this class is 2^(c+1) - 1 snapshots.
+        const long long class_limit = (2LL << length_class) - 1;
+        if (class_limit < required) continue;
+        const auto& entries = length_classes_[length_class];
+        const long long earliest_start = static_cast<long long>(window.first) - class_limit + 1;
+        auto entry = std::lower_bound(
+            entries.begin(), entries.end(), earliest_start,
+            [](const Entry& lhs, long long start) { return lhs.start < start; });
+        for (; entry != entries.end() && entry->start <= window.last; ++entry) {
+            const TimeInterval clipped{
+                entry->start > window.first ? entry->start : window.first,
+                entry->end < window.last ? entry->end : window.last};
+            if (clipped.length() >= required) visit(entry->edge_id, clipped);
+        }
+    }
+}
+
+#endif // TEMPORAL_WINDOW_H
@@ -0,0 +1,186 @@
+#include "TimeParallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <thread>
+#include <utility>
+
+#include "MatchWriter.h"
+
+namespace {
+
+long long elapsedMilliseconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+std::vector<TimeWindowReport> planTimeWindows(
+    SnapshotWindow span,
+    int run_starts_per_window,
+    int minimum_duration) {
+    std::vector<TimeWindowReport> windows;
+    if (run_starts_per_window < 1 || minimum_duration < 1 || span.length() < minimum_duration) {
+        return windows;
+    }
+    const int last_run_start = span.last - minimum_duration + 1;
+    for (int first = span.first;; first += run_starts_per_window) {
+        TimeWindowReport report;
+        report.last_run_start = last_run_start - first < run_starts_per_window
+            ? last_run_start
+            : first + run_starts_per_window - 1;
+        report.window = {first, report.last_run_start + minimum_duration - 1};
+        windows.push_back(report);
+        if (report.last_run_start == last_run_start) break;
+    }
+    return windows;
+}
+
+MatchSummary forEachMatchByTimeWindows(
+    const Graph& graph,
+    const TemporalIntervalIndex& index,
+    const Graph& query_graph,
+    const QueryDecomposition& decomposition,
+    int minimum_duration,
+    const TimeParallelOptions& options,
+    const MatchCallback& callback,
+    std::vector<TimeWindowReport>* reports) {
+    MatchSummary summary;
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<TimeWindowReport> windows =
+        planTimeWindows(index.span(), options.run_starts_per_window, minimum_duration);
+
+    std::vector<std::pair<int, int>> query_arcs;
+    for (int source = 0; source < query_graph.num_vertices; ++source) {
+        for (const Edge& edge : query_graph.adj[static_cast<std::size_t>(source)]) {
+            query_arcs.emplace_back(source, edge.to);
+        }
+    }
+
+    MatchOptions match_options;
+    match_options.matching_order = options.matching_order;
+    std::atomic<std::size_t> next_window{0};
+    std::atomic<bool> stop_requested{false};
+    std::atomic<std::uint64_t> pruned_candidates{0};
+    auto run_windows = [&]() {
+        std::vector<TimeInterval> common_intervals;
+        // Recomputes the match's common intervals on the whole graph; the
+        // window keeps the match only if its earliest k-run starts inside.
+        auto owned_by = [&](const TimeWindowReport& report, const std::vector<int>& mapping) {
+            common_intervals.clear();
+            for (std::size_t arc = 0; arc < query_arcs.size(); ++arc) {
+                const TemporalEdge* edge = graph.findTemporalEdge(
+                    mapping[static_cast<std::size_t>(query_arcs[arc].first)],
+                    mapping[static_cast<std::size_t>(query_arcs[arc].second)]);
+                if (edge == nullptr) return false;
+                if (arc == 0) {
+                    for (const auto& interval : edge->active_intervals) {
+                        if (interval.length() >= minimum_duration) {
+                            common_intervals.push_back(interval);
+                        }
+                    }
+                } else {
+                    common_intervals = intersectTimeIntervals(
+                        common_intervals, edge->active_intervals, minimum_duration);
+                }
+                if (common_intervals.empty()) return false;
+            }
+            return !common_intervals.empty() &&
+                common_intervals.front().start >= report.window.first;
+        };
+
+        for (std::size_t window_index = next_window++;
+             window_index < windows.size() && !stop_requested.load();
+             window_index = next_window++) {
+            TimeWindowReport& report = windows[window_index];
+            const auto build_start = std::chrono::steady_clock::now();
+            const Graph view = makeWindowGraph(graph, index, report.window, minimum_duration);
+            const TDTree tree(view, query_graph, decomposition, minimum_duration);
+            report.view_edges = view.filtered_edge_count;
+            report.td_tree_bytes = tree.getMemoryUsage();
+            report.build_milliseconds = elapsedMilliseconds(build_start);
+
+            const MatchSummary window_summary = tree.forEachMatch(
+                [&](const std::vector<int>& mapping, const std::vector<TimeInterval>&) {
+                    ++report.found_matches;
+                    if (stop_requested.load(std::memory_order_relaxed)) return false;
+                    if (!owned_by(report, mapping)) return true;
+                    ++report.owned_matches;
+                    if (!callback(mapping, common_intervals)) {
+                        stop_requested.store(true);
+                        return false;
+                    }
+                    return true;
+                },
+                match_options);
+            report.enumeration_milliseconds = window_summary.enumeration_milliseconds;
+            pruned_candidates += window_summary.failing_set_pruned_candidates;
+        }
+    };
+
+    unsigned thread_count =
+        options.threads > 0 ? options.threads : std::thread::hardware_concurrency();
+    thread_count = static_cast<unsigned>(std::min<std::size_t>(
+        std::max(thread_count, 1U), std::max<std::size_t>(windows.size(), 1)));
+    std::vector<std::thread> workers;
+    for (unsigned worker = 1; worker < thread_count; ++worker) workers.emplace_back(run_windows);
+    run_windows();
+    for (auto& worker : workers) worker.join();
+
+    for (const auto& report : windows) summary.match_count += report.owned_matches;
+    summary.failing_set_pruned_candidates = pruned_candidates.load();
+    if (stop_requested.load()) summary.stop_reason = MatchStopReason::Consumer;
+    summary.enumeration_milliseconds = elapsedMilliseconds(start);
+    if (reports != nullptr) *reports = std::move(windows);
+    return summary;
+}
+
+MatchSummary saveTimeParallelResults(
+    const std::string& filename,
+    const Graph& graph,
+    const TemporalIntervalIndex& index,
+    const Graph& query_graph,
+    const QueryDecomposition& decomposition,
+    int minimum_duration,
+    const TimeParallelOptions& options,
+    MatchOutputMode output_mode,
+    std::vector<TimeWindowReport>* reports) {
+    MatchSummary summary;
+    std::ofstream output(filename, std::ios::binary);
+    if (!output.is_open()) return summary;
+
+    // Every window shares the section's writer, so rows are numbered in the
+    // order they arrive.
+    FinalMatchesSection section(output, graph, query_graph, output_mode);
+    std::vector<TimeWindowReport> windows;
+    summary = forEachMatchByTimeWindows(
+        graph, index, query_graph, decomposition, minimum_duration, options,
+        section.rowCallback(), &windows);
+    section.finish(summary);
+
+    output << "\n[Time Windows]\n";
+    for (const auto& report : windows) {
+        output << "window=" << report.window.first << '-' << report.window.last
+               << " run_starts=" << report.window.first << '-' << report.last_run_start
+               << " edges=" << report.view_edges
+               << " td_tree_bytes=" << report.td_tree_bytes
+               << " found=" << report.found_matches
+               << " owned=" << report.owned_matches
+               << " build_ms=" << report.build_milliseconds
+               << " enumeration_ms=" << report.enumeration_milliseconds << '\n';
+    }
+    output << "\n[Statistics]\n";
+    writeRunStatistics(output, output_mode, "time-parallel", summary.stop_reason);
+    output << "matching_order: " << matchingOrderName(options.matching_order) << '\n'
+           << "failing_set_pruned_candidates: " << summary.failing_set_pruned_candidates << '\n';
+    writeTimingStatistics(output, summary);
+    output << "time_windows: " << windows.size() << '\n'
+           << "run_starts_per_window: " << options.run_starts_per_window << '\n';
+    output.flush();
+    summary.output_written = summary.output_written && output.good();
+    if (reports != nullptr) *reports = std::move(windows);
+    return summary;
+}
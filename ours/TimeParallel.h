@@ -0,0 +1,83 @@
+#ifndef TIME_PARALLEL_H
+#define TIME_PARALLEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "TDTree.h"
+#include "TemporalWindow.h"
+#include "Utils.h"
+#include "query_decomposition.h"
+
+// Time-parallel execution. A durable match has a common run of at least k
+// snapshots, so it lies inside any window of W + k - 1 snapshots whose
+// first W snapshots contain that run's start. The snapshot axis is split
+// into such windows, the run starts of consecutive windows tiling it, and
+// each window is matched on its own clipped view and TD-tree by a pool of
+// threads; only one view and tree per thread is resident at a time. A
+// match found by several windows is reported by the one holding the start
+// of its earliest k-run over the whole graph.
+
+struct TimeParallelOptions {
+    // W, the run starts owned by each window.
+    int run_starts_per_window = 1;
+    // 0 uses std::thread::hardware_concurrency().
+    unsigned threads = 0;
+    MatchingOrder matching_order = MatchingOrder::Static;
+};
+
+struct TimeWindowReport {
+    // The snapshots kept by the window's view. Runs starting in
+    // [window.first, last_run_start] belong to this window.
+    SnapshotWindow window;
+    int last_run_start = 0;
+    std::size_t view_edges = 0;
+    std::size_t td_tree_bytes = 0;
+    // Matches durable inside the window, and the ones it reported.
+    std::uint64_t found_matches = 0;
+    std::uint64_t owned_matches = 0;
+    long long build_milliseconds = 0;
+    long long enumeration_milliseconds = 0;
+};
+
+// Windows of run_starts_per_window run starts each, in snapshot order,
+// covering every start in span from which a run of minimum_duration fits.
+std::vector<TimeWindowReport> planTimeWindows(
+    SnapshotWindow span,
+    int run_starts_per_window,
+    int minimum_duration);
+
+// Calls callback once per durable match of query_graph in graph, with the
+// match's common intervals over the whole graph, exactly as
+// TDTree::forEachMatch would. Calls come concurrently from the worker
+// threads and in no fixed order. Returning false stops every window with
+// MatchStopReason::Consumer. query_graph needs at least one arc, because
+// windows are assigned by arc intervals. reports, if given, receives one
+// entry per window.
+MatchSummary forEachMatchByTimeWindows(
+    const Graph& graph,
+    const TemporalIntervalIndex& index,
+    const Graph& query_graph,
+    const QueryDecomposition& decomposition,
+    int minimum_duration,
+    const TimeParallelOptions& options,
+    const MatchCallback& callback,
+    std::vector<TimeWindowReport>* reports = nullptr);
+
+// Writes filename in the TDTree::save_res text layout. Rows are numbered in
+// the order windows report them, and a [Time Windows] section with one
+// line per window replaces the candidate summary.
+MatchSummary saveTimeParallelResults(
+    const std::string& filename,
+    const Graph& graph,
+    const TemporalIntervalIndex& index,
+    const Graph& query_graph,
+    const QueryDecomposition& decomposition,
+    int minimum_duration,
+    const TimeParallelOptions& options,
+    MatchOutputMode output_mode,
+    std::vector<TimeWindowReport>* reports = nullptr);
+
+#endif // TIME_PARALLEL_H
@@ -1,6 +1,7 @@
 #include "Utils.h"
 
 #include <algorithm>
+#include <cctype>
 #include <chrono>
 #include <fstream>
 #include <iostream>
@@ -8,6 +9,7 @@
 #include <numeric>
 #include <random>
 #include <sstream>
+#include <stdexcept>
 #include <unordered_map>
 #include <utility>
 
@@ -107,6 +109,7 @@ std::size_t Graph::getMemoryUsage() const {
     for (const auto& neighbors : in_adj) total += neighbors.capacity() * sizeof(Edge);
     total += vertex_labels.capacity() * sizeof(Label);
     total += external_ids.capacity() * sizeof(int);
+    total += label_ranks.capacity() * sizeof(std::size_t);
     total += vertex_active_durations.capacity() * sizeof(int);
     total += neighbor_label_counts.capacity() * sizeof(std::array<int, kLabelCount>);
     total += incoming_neighbor_label_counts.capacity() *
@@ -165,6 +168,24 @@ std::string formatIntervals(const std::vector<TimeInterval>& intervals) {
     return out.str();
 }
 
+bool parseInteger(const std::string& text, long long minimum, long long maximum, long long& value) {
+    // std::stoll would also skip leading whitespace and accept a '+'.
+    const std::size_t first_digit = !text.empty() && text.front() == '-' ? 1 : 0;
+    if (first_digit >= text.size() ||
+        !std::isdigit(static_cast<unsigned char>(text[first_digit]))) {
+        return false;
+    }
+    try {
+        std::size_t parsed_characters = 0;
+        const long long parsed = std::stoll(text, &parsed_characters);
+        if (parsed_characters != text.size() || parsed < minimum || parsed > maximum) return false;
+        value = parsed;
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
 namespace GraphUtils {
 
 bool hasEdge(const std::vector<std::vector<Edge>>& adj, int u, int v) {
@@ -275,13 +296,6 @@ bool readTemporalGraph(
     all_vertex_ids.erase(
         std::unique(all_vertex_ids.begin(), all_vertex_ids.end()),
         all_vertex_ids.end());
-    std::vector<Label> all_vertex_labels(all_vertex_ids.size(), kInvalidLabel);
-    std::mt19937 label_generator(label_seed);
-    std::uniform_int_distribution<int> label_distribution(
-        0, static_cast<int>(kLabelCount) - 1);
-    for (auto& label : all_vertex_labels) {
-        label = static_cast<Label>(label_distribution(label_generator));
-    }
 
     graph.external_ids.reserve(filtered_edges.size() * 2);
     for (const auto& edge : filtered_edges) {
@@ -296,7 +310,7 @@ bool readTemporalGraph(
     graph.num_vertices = static_cast<int>(graph.external_ids.size());
     graph.adj.resize(graph.external_ids.size());
     graph.in_adj.resize(graph.external_ids.size());
-    graph.vertex_labels.resize(graph.external_ids.size(), kInvalidLabel);
+    graph.label_ranks.resize(graph.external_ids.size(), 0);
     std::size_t label_index = 0;
     for (std::size_t i = 0; i < graph.external_ids.size(); ++i) {
         while (label_index < all_vertex_ids.size() &&
@@ -308,7 +322,7 @@ bool readTemporalGraph(
             std::cerr << "Error: Failed to assign a data vertex label.\n";
             return false;
         }
-        graph.vertex_labels[i] = all_vertex_labels[label_index];
+        graph.label_ranks[i] = label_index;
     }
 
     std::vector<std::size_t> out_degrees(graph.external_ids.size(), 0);
@@ -354,9 +368,20 @@ bool readTemporalGraph(
         });
     }
 
-    graph.vertex_active_durations.assign(graph.external_ids.size(), 0);
-    graph.neighbor_label_counts.assign(graph.external_ids.size(), {});
-    graph.incoming_neighbor_label_counts.assign(graph.external_ids.size(), {});
+    computeVertexActiveDurations(graph);
+    assignSeededLabels(graph, label_seed);
+
+    if (load_timings != nullptr) {
+        load_timings->filter_milliseconds =
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - filter_start).count();
+    }
+
+    return true;
+}
+
+void computeVertexActiveDurations(Graph& graph) {
+    graph.vertex_active_durations.assign(graph.adj.size(), 0);
     std::vector<TimeInterval> incident_intervals;
     for (std::size_t vertex = 0; vertex < graph.adj.size(); ++vertex) {
         incident_intervals.clear();
@@ -366,11 +391,6 @@ bool readTemporalGraph(
                 incident_intervals.end(),
                 temporal_edge.active_intervals.begin(),
                 temporal_edge.active_intervals.end());
-
-            const Label neighbor_label = graph.vertex_labels[static_cast<std::size_t>(edge_ref.to)];
-            if (neighbor_label < kLabelCount) {
-                ++graph.neighbor_label_counts[vertex][neighbor_label];
-            }
         }
         for (const auto& edge_ref : graph.in_adj[vertex]) {
             const auto& temporal_edge =
@@ -379,23 +399,48 @@ bool readTemporalGraph(
                 incident_intervals.end(),
                 temporal_edge.active_intervals.begin(),
                 temporal_edge.active_intervals.end());
+        }
+        graph.vertex_active_durations[vertex] = unionDuration(incident_intervals);
+    }
+}
+
+void assignSeededLabels(Graph& graph, std::uint32_t label_seed) {
+    std::mt19937 label_generator(label_seed);
+    std::uniform_int_distribution<int> label_distribution(
+        0, static_cast<int>(kLabelCount) - 1);
+    // label_ranks is sorted, so one pass over the draws labels every vertex.
+    graph.vertex_labels.assign(graph.label_ranks.size(), kInvalidLabel);
+    std::size_t next_rank = 0;
+    Label label = kInvalidLabel;
+    for (std::size_t vertex = 0; vertex < graph.label_ranks.size(); ++vertex) {
+        while (next_rank <= graph.label_ranks[vertex]) {
+            label = static_cast<Label>(label_distribution(label_generator));
+            ++next_rank;
+        }
+        graph.vertex_labels[vertex] = label;
+    }
 
+    computeNeighborLabelCounts(graph);
+}
+
+void computeNeighborLabelCounts(Graph& graph) {
+    graph.neighbor_label_counts.assign(graph.vertex_labels.size(), {});
+    graph.incoming_neighbor_label_counts.assign(graph.vertex_labels.size(), {});
+    for (std::size_t vertex = 0; vertex < graph.adj.size(); ++vertex) {
+        for (const auto& edge_ref : graph.adj[vertex]) {
+            const Label neighbor_label = graph.vertex_labels[static_cast<std::size_t>(edge_ref.to)];
+            if (neighbor_label < kLabelCount) {
+                ++graph.neighbor_label_counts[vertex][neighbor_label];
+            }
+        }
+        for (const auto& edge_ref : graph.in_adj[vertex]) {
             const Label neighbor_label =
                 graph.vertex_labels[static_cast<std::size_t>(edge_ref.to)];
             if (neighbor_label < kLabelCount) {
                 ++graph.incoming_neighbor_label_counts[vertex][neighbor_label];
             }
         }
-        graph.vertex_active_durations[vertex] = unionDuration(incident_intervals);
     }
-
-    if (load_timings != nullptr) {
-        load_timings->filter_milliseconds =
-            std::chrono::duration_cast<std::chrono::milliseconds>(
-                std::chrono::steady_clock::now() - filter_start).count();
-    }
-
-    return true;
 }
 
 bool readQueryGraph(const std::string& filename, Graph& query_graph) {
@@ -404,7 +449,10 @@ bool readQueryGraph(const std::string& filename, Graph& query_graph) {
         std::cerr << "Error: Cannot open query graph file " << filename << '\n';
         return false;
     }
+    return parseQueryGraph(input, query_graph);
+}
 
+bool parseQueryGraph(std::istream& input, Graph& query_graph) {
     query_graph = Graph{};
     std::unordered_map<std::string, int> vertex_by_key;
     std::vector<std::pair<int, int>> query_edges;
@@ -4,6 +4,7 @@
 #include <array>
 #include <cstddef>
 #include <cstdint>
+#include <iosfwd>
 #include <string>
 #include <vector>
 
@@ -51,6 +52,9 @@ struct Graph {
 
     // Populated only for temporal data graphs.
     std::vector<TemporalEdge> temporal_edges;
+    // Rank of each vertex among all raw input vertex IDs, including vertices
+    // removed by filtering. Seeded labels are drawn in rank order.
+    std::vector<std::size_t> label_ranks;
     std::vector<int> vertex_active_durations;
     // Outgoing and incoming neighbor-label multiplicities are kept separately
     // so directed degree/NLF filtering cannot accept a reversed edge.
@@ -79,6 +83,10 @@ bool hasMinimumConsecutiveDuration(
 
 std::string formatIntervals(const std::vector<TimeInterval>& intervals);
 
+// Parses text as a whole decimal integer, optionally negative, and accepts
+// it only within [minimum, maximum]. value is left unchanged on failure.
+bool parseInteger(const std::string& text, long long minimum, long long maximum, long long& value);
+
 namespace GraphUtils {
 bool hasEdge(const std::vector<std::vector<Edge>>& adj, int u, int v);
 }
@@ -99,6 +107,18 @@ bool readTemporalGraph(
     Graph& graph,
     std::uint32_t label_seed = kDefaultLabelSeed,
     TemporalGraphLoadTimings* load_timings = nullptr);
+// Sets each vertex's active duration to the number of snapshots covered by
+// the union of its incident arcs' intervals.
+void computeVertexActiveDurations(Graph& graph);
+// Draws the seeded label of every temporal data vertex from its label rank
+// and recomputes the neighbor-label counts. readTemporalGraph ends with this
+// call, so relabeling a loaded graph equals reloading it with label_seed.
+void assignSeededLabels(Graph& graph, std::uint32_t label_seed);
+// Recomputes the outgoing and incoming neighbor-label counts from the labels.
+void computeNeighborLabelCounts(Graph& graph);
+
 bool readQueryGraph(const std::string& filename, Graph& query_graph);
+// Parses the query file format ("u v" arcs, one per line) from any stream.
+bool parseQueryGraph(std::istream& input, Graph& query_graph);
 
 #endif // UTILS_H
@@ -1,22 +1,55 @@
 param(
     [string]$Compiler = "g++",
-    [string]$OutputPath = ".\td_tree.exe"
+    [string]$OutputPath = ".\td_tree.exe",
+    [string]$DumpOutputPath = ".\td_tree_dump.exe",
+    [string]$ServiceOutputPath = ".\td_tree_service.exe",
+    [string]$BatchOutputPath = ".\td_tree_batch.exe"
 )
 
 Set-StrictMode -Version Latest
 $ErrorActionPreference = "Stop"
 $scriptRoot = Split-Path -Parent $MyInvocation.MyCommand.Path
 $output = Join-Path $scriptRoot $OutputPath
+$dumpOutput = Join-Path $scriptRoot $DumpOutputPath
+$serviceOutput = Join-Path $scriptRoot $ServiceOutputPath
+$batchOutput = Join-Path $scriptRoot $BatchOutputPath
+$engineSources = @(
+    "BinaryMatchFormat.cpp", "CECI.cpp", "DurableMatcher.cpp", "MatchWriter.cpp", "query_decomposition.cpp",
+    "SnapshotSweep.cpp", "TDTree.cpp", "TemporalWindow.cpp", "TimeParallel.cpp", "Utils.cpp")
 
 Push-Location $scriptRoot
 try {
-    & $Compiler -Wall -Wextra -Wpedantic -O3 -std=c++17 `
-        "main.cpp" "query_decomposition.cpp" "TDTree.cpp" "Utils.cpp" `
+    & $Compiler -Wall -Wextra -Wpedantic -O3 -std=c++17 -pthread `
+        "main.cpp" @engineSources `
         -o $output
     if ($LASTEXITCODE -ne 0) {
         throw "Build failed with exit code $LASTEXITCODE"
     }
     Write-Host "Built: $output"
+
+    & $Compiler -Wall -Wextra -Wpedantic -O3 -std=c++17 -pthread `
+        "td_tree_dump.cpp" @engineSources `
+        -o $dumpOutput
+    if ($LASTEXITCODE -ne 0) {
+        throw "td_tree_dump build failed with exit code $LASTEXITCODE"
+    }
+    Write-Host "Built: $dumpOutput"
+
+    & $Compiler -Wall -Wextra -Wpedantic -O3 -std=c++17 -pthread `
+        "td_tree_service.cpp" "QueryService.cpp" @engineSources `
+        -o $serviceOutput
+    if ($LASTEXITCODE -ne 0) {
+        throw "td_tree_service build failed with exit code $LASTEXITCODE"
+    }
+    Write-Host "Built: $serviceOutput"
+
+    & $Compiler -Wall -Wextra -Wpedantic -O3 -std=c++17 -pthread `
+        "td_tree_batch.cpp" "BatchRunner.cpp" @engineSources `
+        -o $batchOutput
+    if ($LASTEXITCODE -ne 0) {
+        throw "td_tree_batch build failed with exit code $LASTEXITCODE"
+    }
+    Write-Host "Built: $batchOutput"
 }
 finally {
     Pop-Location
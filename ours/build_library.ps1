@@ -0,0 +1,42 @@
+param(
+    [string]$Compiler = "g++",
+    [string]$Archiver = "ar",
+    [string]$OutputPath = ".\libtd_tree.a"
+)
+
+# Builds the engine as a static library for linking against DurableMatcher.h:
+#   g++ -std=c++17 -pthread service.cpp -I<ours> <ours>\libtd_tree.a
+Set-StrictMode -Version Latest
+$ErrorActionPreference = "Stop"
+$scriptRoot = Split-Path -Parent $MyInvocation.MyCommand.Path
+$output = Join-Path $scriptRoot $OutputPath
+$objectDirectory = Join-Path $scriptRoot "build_library_objects"
+$librarySources = @(
+    "BinaryMatchFormat.cpp", "DurableMatcher.cpp", "MatchWriter.cpp", "query_decomposition.cpp",
+    "TDTree.cpp", "Utils.cpp")
+
+Push-Location $scriptRoot
+try {
+    New-Item -ItemType Directory -Force -Path $objectDirectory | Out-Null
+    $objects = @()
+    foreach ($source in $librarySources) {
+        $object = Join-Path $objectDirectory ([System.IO.Path]::ChangeExtension($source, ".o"))
+        & $Compiler -Wall -Wextra -Wpedantic -O3 -std=c++17 -pthread -c $source -o $object
+        if ($LASTEXITCODE -ne 0) {
+            throw "Compiling $source failed with exit code $LASTEXITCODE"
+        }
+        $objects += $object
+    }
+
+    if (Test-Path $output) {
+        Remove-Item -LiteralPath $output -Force
+    }
+    & $Archiver rcs $output @objects
+    if ($LASTEXITCODE -ne 0) {
+        throw "Archiving failed with exit code $LASTEXITCODE"
+    }
+    Write-Host "Built: $output"
+}
+finally {
+    Pop-Location
+}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <array>
 #include <chrono>
 #include <cstddef>
@@ -6,9 +7,11 @@
 #include <fstream>
 #include <iostream>
 #include <limits>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -17,7 +20,11 @@
 #include <sys/resource.h>
 #endif
 
+#include "CECI.h"
+#include "SnapshotSweep.h"
 #include "TDTree.h"
+#include "TemporalWindow.h"
+#include "TimeParallel.h"
 #include "Utils.h"
 #include "query_decomposition.h"
 
@@ -43,9 +50,14 @@ long long elapsedMilliseconds(std::chrono::steady_clock::time_point start) {
 } // namespace
 
 int main(int argc, char* argv[]) {
-    if (argc != 4 && argc != 5) {
+    if (argc < 4) {
         std::cerr << "Usage: " << argv[0]
-                  << " <Data Graph> <Query Graph> <Minimum Duration k> [Label Seed]\n";
+                  << " <Data Graph> <Query Graph> <Minimum Duration k> "
+                     "[Label Seed] [--adaptive-order] [--count-only] "
+                     "[--limit N] [--exists] [--time-limit seconds] "
+                     "[--output-format text|binary] [--profile-max-k K] [--top N] "
+                     "[--window t1 t2] [--time-parallel W] [--threads N] "
+                     "[--engine td-tree|sweep|ceci]\n";
         return 1;
     }
 
@@ -63,9 +75,220 @@ int main(int argc, char* argv[]) {
     }
 
     std::uint32_t label_seed = kDefaultLabelSeed;
-    if (argc == 5) {
+    bool label_seed_seen = false;
+    MatchOptions match_options;
+    bool adaptive_order_seen = false;
+    bool count_only_seen = false;
+    bool limit_seen = false;
+    bool exists_seen = false;
+    bool time_limit_seen = false;
+    bool output_format_seen = false;
+    // Largest k of a one-pass durability profile; 0 runs only k.
+    int profile_maximum_duration = 0;
+    bool window_seen = false;
+    SnapshotWindow window;
+    // Run starts per time-parallel window; 0 matches on one TD-tree.
+    TimeParallelOptions time_parallel_options;
+    time_parallel_options.run_starts_per_window = 0;
+    bool threads_seen = false;
+    bool engine_seen = false;
+    bool sweep_engine = false;
+    bool ceci_engine = false;
+    for (int argument_index = 4; argument_index < argc; ++argument_index) {
+        const std::string argument = argv[argument_index];
+        if (argument == "--limit") {
+            long long parsed_limit = 0;
+            if (limit_seen) {
+                std::cerr << "Error: --limit may be specified only once.\n";
+                return 1;
+            }
+            if (argument_index + 1 >= argc ||
+                !parseInteger(argv[++argument_index], 1,
+                              std::numeric_limits<long long>::max(), parsed_limit)) {
+                std::cerr << "Error: --limit requires a positive integer.\n";
+                return 1;
+            }
+            limit_seen = true;
+            match_options.limits.max_results = static_cast<std::uint64_t>(parsed_limit);
+            continue;
+        }
+        if (argument == "--output-format") {
+            if (output_format_seen) {
+                std::cerr << "Error: --output-format may be specified only once.\n";
+                return 1;
+            }
+            const std::string format = argument_index + 1 < argc ? argv[++argument_index] : "";
+            if (format == "text") {
+                match_options.output_format = MatchOutputFormat::Text;
+            } else if (format == "binary") {
+                match_options.output_format = MatchOutputFormat::Binary;
+            } else {
+                std::cerr << "Error: --output-format requires text or binary.\n";
+                return 1;
+            }
+            output_format_seen = true;
+            continue;
+        }
+        if (argument == "--window") {
+            if (window_seen) {
+                std::cerr << "Error: --window may be specified only once.\n";
+                return 1;
+            }
+            if (argument_index + 2 >= argc) {
+                std::cerr << "Error: --window requires two snapshots t1 t2.\n";
+                return 1;
+            }
+            long long first = 0;
+            long long last = 0;
+            if (!parseInteger(argv[++argument_index], std::numeric_limits<int>::min(),
+                              std::numeric_limits<int>::max(), first) ||
+                !parseInteger(argv[++argument_index], std::numeric_limits<int>::min(),
+                              std::numeric_limits<int>::max(), last)) {
+                std::cerr << "Error: --window requires two integer snapshots t1 t2.\n";
+                return 1;
+            }
+            window.first = static_cast<int>(first);
+            window.last = static_cast<int>(last);
+            if (window.length() < minimum_duration) {
+                std::cerr << "Error: --window t1 t2 must span at least k snapshots.\n";
+                return 1;
+            }
+            window_seen = true;
+            continue;
+        }
+        if (argument == "--engine") {
+            if (engine_seen) {
+                std::cerr << "Error: --engine may be specified only once.\n";
+                return 1;
+            }
+            const std::string engine = argument_index + 1 < argc ? argv[++argument_index] : "";
+            if (engine == "td-tree") {
+                sweep_engine = false;
+            } else if (engine == "sweep") {
+                sweep_engine = true;
+            } else if (engine == "ceci") {
+                ceci_engine = true;
+            } else {
+                std::cerr << "Error: --engine requires td-tree, sweep or ceci.\n";
+                return 1;
+            }
+            engine_seen = true;
+            continue;
+        }
+        if (argument == "--time-parallel") {
+            long long parsed_width = 0;
+            if (time_parallel_options.run_starts_per_window > 0) {
+                std::cerr << "Error: --time-parallel may be specified only once.\n";
+                return 1;
+            }
+            if (argument_index + 1 >= argc ||
+                !parseInteger(argv[++argument_index], 1,
+                              std::numeric_limits<int>::max(), parsed_width)) {
+                std::cerr << "Error: --time-parallel requires a positive number of run starts.\n";
+                return 1;
+            }
+            time_parallel_options.run_starts_per_window = static_cast<int>(parsed_width);
+            continue;
+        }
+        if (argument == "--threads") {
+            long long parsed_threads = 0;
+            if (threads_seen) {
+                std::cerr << "Error: --threads may be specified only once.\n";
+                return 1;
+            }
+            if (argument_index + 1 >= argc ||
+                !parseInteger(argv[++argument_index], 1, 4096, parsed_threads)) {
+                std::cerr << "Error: --threads requires a positive integer.\n";
+                return 1;
+            }
+            threads_seen = true;
+            time_parallel_options.threads = static_cast<unsigned>(parsed_threads);
+            continue;
+        }
+        if (argument == "--top") {
+            long long parsed_top = 0;
+            if (match_options.top_matches > 0) {
+                std::cerr << "Error: --top may be specified only once.\n";
+                return 1;
+            }
+            if (argument_index + 1 >= argc ||
+                !parseInteger(argv[++argument_index], 1,
+                              std::numeric_limits<long long>::max(), parsed_top)) {
+                std::cerr << "Error: --top requires a positive integer.\n";
+                return 1;
+            }
+            match_options.top_matches = static_cast<std::size_t>(parsed_top);
+            continue;
+        }
+        if (argument == "--profile-max-k") {
+            long long parsed_maximum = 0;
+            if (profile_maximum_duration > 0) {
+                std::cerr << "Error: --profile-max-k may be specified only once.\n";
+                return 1;
+            }
+            if (argument_index + 1 >= argc ||
+                !parseInteger(argv[++argument_index], minimum_duration,
+                              std::numeric_limits<int>::max(), parsed_maximum)) {
+                std::cerr << "Error: --profile-max-k requires an integer of at least k.\n";
+                return 1;
+            }
+            profile_maximum_duration = static_cast<int>(parsed_maximum);
+            continue;
+        }
+        if (argument == "--exists") {
+            if (exists_seen) {
+                std::cerr << "Error: --exists may be specified only once.\n";
+                return 1;
+            }
+            exists_seen = true;
+            match_options.limits.exists_only = true;
+            continue;
+        }
+        if (argument == "--time-limit") {
+            long long parsed_seconds = 0;
+            if (time_limit_seen) {
+                std::cerr << "Error: --time-limit may be specified only once.\n";
+                return 1;
+            }
+            if (argument_index + 1 >= argc ||
+                !parseInteger(argv[++argument_index], 0,
+                              std::numeric_limits<int>::max(), parsed_seconds)) {
+                std::cerr << "Error: --time-limit requires a non-negative integer "
+                             "number of seconds.\n";
+                return 1;
+            }
+            time_limit_seen = true;
+            match_options.limits.time_limit_seconds = static_cast<int>(parsed_seconds);
+            continue;
+        }
+        if (argument == "--count-only") {
+            if (count_only_seen) {
+                std::cerr << "Error: --count-only may be specified only once.\n";
+                return 1;
+            }
+            count_only_seen = true;
+            match_options.output_mode = MatchOutputMode::CountOnly;
+            continue;
+        }
+        if (argument == "--adaptive-order") {
+            if (adaptive_order_seen) {
+                std::cerr << "Error: --adaptive-order may be specified only once.\n";
+                return 1;
+            }
+            adaptive_order_seen = true;
+            match_options.matching_order = MatchingOrder::Adaptive;
+            continue;
+        }
+        if (argument.rfind("--", 0) == 0) {
+            std::cerr << "Error: Unknown option: " << argument << '\n';
+            return 1;
+        }
+        if (label_seed_seen) {
+            std::cerr << "Error: Label seed may be specified only once.\n";
+            return 1;
+        }
         try {
-            const std::string seed_text = argv[4];
+            const std::string& seed_text = argument;
             if (seed_text.empty() || seed_text.front() == '-') {
                 throw std::invalid_argument("label seed");
             }
@@ -79,12 +302,50 @@ int main(int argc, char* argv[]) {
                 throw std::out_of_range("label seed");
             }
             label_seed = static_cast<std::uint32_t>(parsed_seed);
+            label_seed_seen = true;
         } catch (const std::exception&) {
             std::cerr << "Error: label seed must be a 32-bit unsigned integer.\n";
             return 1;
         }
     }
 
+    if (match_options.top_matches > 0 &&
+        (match_options.output_mode == MatchOutputMode::CountOnly ||
+         match_options.limits.max_results > 0 || match_options.limits.exists_only ||
+         profile_maximum_duration > 0)) {
+        std::cerr << "Error: --top cannot be combined with --count-only, --limit, --exists "
+                     "or --profile-max-k.\n";
+        return 1;
+    }
+    if (profile_maximum_duration > 0 &&
+        match_options.output_format == MatchOutputFormat::Binary) {
+        std::cerr << "Error: --profile-max-k writes text results only.\n";
+        return 1;
+    }
+
+    const bool time_parallel = time_parallel_options.run_starts_per_window > 0;
+    if (threads_seen && !time_parallel && !ceci_engine) {
+        std::cerr << "Error: --threads requires --time-parallel or --engine ceci.\n";
+        return 1;
+    }
+    if (time_parallel &&
+        (match_options.limits.active() || match_options.top_matches > 0 ||
+         profile_maximum_duration > 0 ||
+         match_options.output_format == MatchOutputFormat::Binary)) {
+        std::cerr << "Error: --time-parallel cannot be combined with --limit, --exists, "
+                     "--time-limit, --top, --profile-max-k or binary output.\n";
+        return 1;
+    }
+    time_parallel_options.matching_order = match_options.matching_order;
+    if ((sweep_engine || ceci_engine) &&
+        (time_parallel || match_options.top_matches > 0 || profile_maximum_duration > 0 ||
+         match_options.output_format == MatchOutputFormat::Binary || adaptive_order_seen)) {
+        std::cerr << "Error: --engine sweep and --engine ceci cannot be combined with "
+                     "--time-parallel, --top, --profile-max-k, --adaptive-order or binary "
+                     "output.\n";
+        return 1;
+    }
+
     const std::string temporal_graph_file = argv[1];
     const std::string query_graph_file = argv[2];
     const std::string dataset_name =
@@ -107,39 +368,42 @@ int main(int argc, char* argv[]) {
               << " unique directed edges, " << temporal_graph.filtered_edge_count
               << " retained edges, " << temporal_graph.num_vertices
               << " active vertices, random label seed=" << label_seed << ".\n";
+    std::cout << "Output mode: " << matchOutputModeName(match_options.output_mode)
+              << ", format: " << matchOutputFormatName(match_options.output_format) << ".\n";
     std::cout << "Temporal preprocessing (ms): read="
               << temporal_load_timings.read_milliseconds
               << ", filter=" << temporal_load_timings.filter_milliseconds
               << ", total=" << timings["readAndFilterTemporalGraph"] << '\n';
 
+    if (window_seen) {
+        // The loaded graph is replaced by its clipped view; everything
+        // downstream, including label statistics, sees only the window.
+        stage_start = std::chrono::steady_clock::now();
+        const TemporalIntervalIndex interval_index(temporal_graph);
+        temporal_graph = makeWindowGraph(temporal_graph, interval_index, window, minimum_duration);
+        timings["windowView"] = elapsedMilliseconds(stage_start);
+        std::cout << "Snapshot window [" << window.first << ", " << window.last << "]: "
+                  << temporal_graph.filtered_edge_count << " edges with a " << minimum_duration
+                  << "-run inside the window (" << timings["windowView"] << " ms).\n";
+    }
+
     Graph query_graph;
     stage_start = std::chrono::steady_clock::now();
     if (!readQueryGraph(query_graph_file, query_graph)) return 2;
     timings["readQueryGraph"] = elapsedMilliseconds(stage_start);
-
-    stage_start = std::chrono::steady_clock::now();
-    std::array<std::size_t, kLabelCount> label_vertex_counts{};
-    std::array<long long, kLabelCount> label_duration_sums{};
-    for (std::size_t vertex = 0; vertex < temporal_graph.vertex_labels.size(); ++vertex) {
-        const Label label = temporal_graph.vertex_labels[vertex];
-        if (label >= kLabelCount) continue;
-        ++label_vertex_counts[label];
-        label_duration_sums[label] += temporal_graph.vertex_active_durations[vertex];
+    if ((time_parallel || sweep_engine || ceci_engine) && query_graph.num_vertices < 2) {
+        std::cerr << "Error: --time-parallel, --engine sweep and --engine ceci require a "
+                     "query with at least one arc.\n";
+        return 1;
     }
 
-    std::array<double, kLabelCount> label_average_lifespans{};
-    for (std::size_t label = 0; label < kLabelCount; ++label) {
-        if (label_vertex_counts[label] > 0) {
-            label_average_lifespans[label] =
-                static_cast<double>(label_duration_sums[label]) /
-                static_cast<double>(label_vertex_counts[label]);
-        }
-    }
+    stage_start = std::chrono::steady_clock::now();
+    const LabelStatistics label_statistics = computeLabelStatistics(temporal_graph);
     timings["labelStatistics"] = elapsedMilliseconds(stage_start);
 
     stage_start = std::chrono::steady_clock::now();
     const QueryDecomposition decomposition = decomposeQuery(
-        query_graph, label_vertex_counts, label_average_lifespans);
+        query_graph, label_statistics.vertex_counts, label_statistics.average_lifespans);
     timings["queryDecomposition"] = elapsedMilliseconds(stage_start);
     if (decomposition.root < 0) {
         std::cerr << "No query root has data candidates with a positive active lifespan.\n";
@@ -155,20 +419,100 @@ int main(int argc, char* argv[]) {
               << " S_temp=" << decomposition.temporal_selectivity[decomposition.root]
               << " | DFS order:";
     for (int query_vertex : decomposition.dfs_order) std::cout << ' ' << query_vertex;
-    std::cout << " | non-tree edges=" << decomposition.non_tree_edges.size() << '\n';
+    std::cout << " | non-tree edges=" << decomposition.non_tree_edges.size()
+              << " | matching order=" << matchingOrderName(match_options.matching_order) << '\n';
 
+    // Time-parallel runs build one TD-tree per window inside the matching
+    // stage instead, after indexing the (possibly windowed) graph here.
+    std::optional<TDTree> td_tree;
+    std::optional<TemporalIntervalIndex> time_parallel_index;
+    std::optional<SnapshotSweepMatcher> sweep_matcher;
+    std::optional<CeciMatcher> ceci_matcher;
     stage_start = std::chrono::steady_clock::now();
-    TDTree td_tree(temporal_graph, query_graph, decomposition, minimum_duration);
-    timings["buildTDTree"] = elapsedMilliseconds(stage_start);
-    td_tree.print_res();
+    if (time_parallel) {
+        time_parallel_index.emplace(temporal_graph);
+        timings["windowView"] += elapsedMilliseconds(stage_start);
+    } else if (sweep_engine) {
+        sweep_matcher.emplace(temporal_graph, query_graph, minimum_duration);
+        timings["buildSweepRuns"] = elapsedMilliseconds(stage_start);
+    } else if (ceci_engine) {
+        ceci_matcher.emplace(
+            temporal_graph, query_graph, minimum_duration, time_parallel_options.threads);
+        timings["buildCeciIndex"] = elapsedMilliseconds(stage_start);
+        const CeciStatistics& ceci_statistics = ceci_matcher->statistics();
+        std::cout << "CECI index: clusters=" << ceci_statistics.clusters
+                  << " candidates=" << ceci_statistics.forward_candidates << "->"
+                  << ceci_statistics.refined_candidates
+                  << " tree_edge_candidates=" << ceci_statistics.tree_edge_candidates
+                  << " non_tree_edge_candidates=" << ceci_statistics.non_tree_edge_candidates
+                  << " (" << timings["buildCeciIndex"] << " ms).\n";
+    } else {
+        td_tree.emplace(temporal_graph, query_graph, decomposition, minimum_duration);
+        timings["buildTDTree"] = elapsedMilliseconds(stage_start);
+        td_tree->print_res();
+    }
 
-    const std::string matching_result_file = "matching_results_" + dataset_name + ".txt";
-    const MatchSummary match_summary = td_tree.save_res(matching_result_file);
+    const std::string matching_result_file = "matching_results_" + dataset_name +
+        (match_options.output_format == MatchOutputFormat::Binary ? ".bin" : ".txt");
+    MatchSummary match_summary;
+    std::string count_strategy;
+    std::vector<TimeWindowReport> time_windows;
+    if (time_parallel) {
+        match_summary = saveTimeParallelResults(
+            matching_result_file, temporal_graph, *time_parallel_index, query_graph,
+            decomposition, minimum_duration, time_parallel_options, match_options.output_mode,
+            &time_windows);
+        count_strategy = "time-parallel";
+        for (const auto& report : time_windows) {
+            std::cout << "Time window [" << report.window.first << ", " << report.window.last
+                      << "]: edges=" << report.view_edges << " found=" << report.found_matches
+                      << " owned=" << report.owned_matches << " build_ms="
+                      << report.build_milliseconds << " enumeration_ms="
+                      << report.enumeration_milliseconds << '\n';
+        }
+    } else if (sweep_engine) {
+        match_summary = sweep_matcher->save_res(matching_result_file, match_options);
+        count_strategy = "snapshot-sweep";
+    } else if (ceci_engine) {
+        match_summary = ceci_matcher->save_res(matching_result_file, match_options);
+        count_strategy = "ceci";
+    } else if (profile_maximum_duration > 0) {
+        // One enumeration at k answers every k up to the maximum; full mode
+        // also writes one result file per k.
+        std::vector<std::string> per_k_result_files;
+        if (match_options.output_mode == MatchOutputMode::Full) {
+            for (int k = minimum_duration; k <= profile_maximum_duration; ++k) {
+                per_k_result_files.push_back(
+                    "matching_results_" + dataset_name + "_k" + std::to_string(k) + ".txt");
+            }
+        }
+        const DurabilityProfile profile = td_tree->saveDurabilityProfile(
+            matching_result_file, profile_maximum_duration, per_k_result_files, match_options);
+        match_summary = profile.summary;
+        count_strategy = "durability-profile";
+        std::cout << "Durability profile:";
+        for (std::size_t offset = 0; offset < profile.match_counts.size(); ++offset) {
+            std::cout << " k=" << minimum_duration + static_cast<int>(offset) << ':'
+                      << profile.match_counts[offset];
+        }
+        std::cout << '\n';
+    } else {
+        match_summary = td_tree->save_res(matching_result_file, match_options);
+        count_strategy = match_options.top_matches > 0
+            ? "top-matches"
+            : (match_summary.factorized_count ? "factorized" : "enumeration");
+    }
+    if (match_options.top_matches > 0) {
+        std::cout << "Top matches: kept " << match_summary.match_count << " of at most "
+                  << match_options.top_matches << ", search k raised to "
+                  << match_summary.effective_minimum_duration << '\n';
+    }
     if (!match_summary.output_written) {
         std::cerr << "Error: Could not write " << matching_result_file << '\n';
         return 4;
     }
     timings["enumerateMatches"] = match_summary.enumeration_milliseconds;
+    timings["matchWriterBlocked"] = match_summary.io_blocked_milliseconds;
     timings["endToEnd"] = elapsedMilliseconds(total_start);
 
     const std::string timing_result_file = "timing_results_" + dataset_name + ".txt";
@@ -177,15 +521,32 @@ int main(int argc, char* argv[]) {
         std::cerr << "Error: Could not write " << timing_result_file << '\n';
         return 4;
     }
-    const std::array<const char*, 9> timing_order{{
+    timing_output << "mode: " << matchOutputModeName(match_options.output_mode) << '\n'
+                  << "output_format: " << matchOutputFormatName(match_options.output_format) << '\n'
+                  << "count_strategy: " << count_strategy << '\n'
+                  << "matching_order: " << matchingOrderName(match_options.matching_order) << '\n'
+                  << "stop_reason: " << matchStopReasonName(match_summary.stop_reason) << '\n';
+    if (window_seen) {
+        timing_output << "window: " << window.first << ' ' << window.last << '\n';
+    }
+    if (time_parallel) {
+        timing_output << "time_windows: " << time_windows.size() << '\n'
+                      << "run_starts_per_window: "
+                      << time_parallel_options.run_starts_per_window << '\n';
+    }
+    const std::array<const char*, 13> timing_order{{
         "readTemporalGraph",
         "filterTemporalGraph",
         "readAndFilterTemporalGraph",
+        "windowView",
         "readQueryGraph",
         "labelStatistics",
         "queryDecomposition",
         "buildTDTree",
+        "buildSweepRuns",
+        "buildCeciIndex",
         "enumerateMatches",
+        "matchWriterBlocked",
         "endToEnd"}};
     for (const char* timing_name : timing_order) {
         const auto timing = timings.find(timing_name);
@@ -195,13 +556,26 @@ int main(int argc, char* argv[]) {
     }
 
     const std::size_t input_graph_memory = temporal_graph.getMemoryUsage();
-    const std::size_t td_tree_memory = td_tree.getMemoryUsage();
+    // A time-parallel run reports its largest per-window TD-tree and the
+    // sweep and CECI engines their run lists and index in the TD-tree slot.
+    std::size_t td_tree_memory = td_tree ? td_tree->getMemoryUsage()
+        : (sweep_matcher ? sweep_matcher->getMemoryUsage()
+                         : (ceci_matcher ? ceci_matcher->getMemoryUsage() : 0));
+    for (const auto& report : time_windows) {
+        td_tree_memory = std::max(td_tree_memory, report.td_tree_bytes);
+    }
     const std::size_t total_peak_memory = getPeakRSS();
     const std::size_t known_memory = input_graph_memory + td_tree_memory;
     const std::size_t other_memory =
         total_peak_memory > known_memory ? total_peak_memory - known_memory : 0;
 
-    std::cout << "Final durable matches: " << match_summary.match_count << '\n'
+    std::cout << "Final durable matches: " << match_summary.match_count;
+    if (match_summary.stop_reason != MatchStopReason::Complete) {
+        std::cout << " (truncated: " << matchStopReasonName(match_summary.stop_reason) << ')';
+    }
+    std::cout << '\n'
+              << "Failing-set pruned candidates: "
+              << match_summary.failing_set_pruned_candidates << '\n'
               << "Result file: " << matching_result_file << '\n'
               << "Timing file: " << timing_result_file << '\n'
               << "Memory (KiB): graph=" << input_graph_memory / 1024
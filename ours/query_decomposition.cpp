@@ -6,6 +6,25 @@
 #include <limits>
 #include <set>
 
+LabelStatistics computeLabelStatistics(const Graph& temporal_graph) {
+    LabelStatistics statistics;
+    std::array<long long, kLabelCount> duration_sums{};
+    for (std::size_t vertex = 0; vertex < temporal_graph.vertex_labels.size(); ++vertex) {
+        const Label label = temporal_graph.vertex_labels[vertex];
+        if (label >= kLabelCount) continue;
+        ++statistics.vertex_counts[label];
+        duration_sums[label] += temporal_graph.vertex_active_durations[vertex];
+    }
+    for (std::size_t label = 0; label < kLabelCount; ++label) {
+        if (statistics.vertex_counts[label] > 0) {
+            statistics.average_lifespans[label] =
+                static_cast<double>(duration_sums[label]) /
+                static_cast<double>(statistics.vertex_counts[label]);
+        }
+    }
+    return statistics;
+}
+
 QueryDecomposition decomposeQuery(
     const Graph& query_graph,
     const std::array<std::size_t, kLabelCount>& label_vertex_counts,
@@ -19,6 +19,15 @@ struct QueryDecomposition {
     bool connected = false;
 };
 
+// Per-label vertex counts and average active lifespans of a data graph,
+// the inputs of decomposeQuery's temporal selectivity.
+struct LabelStatistics {
+    std::array<std::size_t, kLabelCount> vertex_counts{};
+    std::array<double, kLabelCount> average_lifespans{};
+};
+
+LabelStatistics computeLabelStatistics(const Graph& temporal_graph);
+
 QueryDecomposition decomposeQuery(
     const Graph& query_graph,
     const std::array<std::size_t, kLabelCount>& label_vertex_counts,
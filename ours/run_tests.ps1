@@ -9,8 +9,8 @@ $testExe = Join-Path $scriptRoot "tests\test_ours.exe"
 
 Push-Location $scriptRoot
 try {
-    & $Compiler -Wall -Wextra -Wpedantic -O3 -std=c++17 `
-        "tests\test_ours.cpp" "query_decomposition.cpp" "TDTree.cpp" "Utils.cpp" `
+    & $Compiler -Wall -Wextra -Wpedantic -O3 -std=c++17 -pthread `
+        "tests\test_ours.cpp" "BatchRunner.cpp" "BinaryMatchFormat.cpp" "CECI.cpp" "DurableMatcher.cpp" "MatchWriter.cpp" "query_decomposition.cpp" "QueryService.cpp" "SnapshotSweep.cpp" "TDTree.cpp" "TemporalWindow.cpp" "TimeParallel.cpp" "Utils.cpp" `
         -o $testExe
     if ($LASTEXITCODE -ne 0) {
         throw "Test compilation failed with exit code $LASTEXITCODE"
@@ -6,6 +6,7 @@ param(
     [uint32]$LabelSeed = 42,
     [string]$OutputDir = ".\batch_results_unique_filtered",
     [string]$Compiler = "g++",
+    [switch]$AdaptiveOrder,
     [switch]$SkipBuild,
     [switch]$DryRun
 )
@@ -38,6 +39,7 @@ Write-Host "Executable : $exe"
 Write-Host "Query graph: $query"
 Write-Host "k          : $K"
 Write-Host "Label seed : $LabelSeed"
+Write-Host "Match order: $(if ($AdaptiveOrder) { 'adaptive' } else { 'static' })"
 Write-Host "Output dir : $outDir"
 
 Push-Location $scriptRoot
@@ -51,7 +53,10 @@ try {
         $generatedTiming = "timing_results_{0}.txt" -f $base
 
         Write-Host "`n=== Running: $($dataset.Name) ==="
-        Write-Host "& `"$exe`" `"$($dataset.FullName)`" `"$query`" $K $LabelSeed"
+        $runArguments = @($dataset.FullName, $query, $K, $LabelSeed)
+        if ($AdaptiveOrder) { $runArguments += "--adaptive-order" }
+        $optionText = if ($AdaptiveOrder) { " --adaptive-order" } else { "" }
+        Write-Host "& `"$exe`" `"$($dataset.FullName)`" `"$query`" $K $LabelSeed$optionText"
         if ($DryRun) {
             continue
         }
@@ -59,7 +64,7 @@ try {
         if (Test-Path $generatedMatch) { Remove-Item $generatedMatch -Force }
         if (Test-Path $generatedTiming) { Remove-Item $generatedTiming -Force }
 
-        & $exe $dataset.FullName $query $K $LabelSeed 2>&1 |
+        & $exe @runArguments 2>&1 |
             Tee-Object -FilePath $stdoutPath
         if ($LASTEXITCODE -ne 0) {
             Write-Warning "Execution failed for $($dataset.Name) (exit code: $LASTEXITCODE)"
@@ -0,0 +1,32 @@
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+
+#include "BatchRunner.h"
+
+// Runs the manifest given on the command line. See README.md for the format.
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <Manifest>\n";
+        return 1;
+    }
+    std::ifstream manifest_input(argv[1]);
+    if (!manifest_input.is_open()) {
+        std::cerr << "Error: Cannot open manifest " << argv[1] << '\n';
+        return 1;
+    }
+    BatchManifest manifest;
+    if (!readManifest(manifest_input, manifest)) return 1;
+
+    std::ofstream csv(manifest.output_file);
+    if (!csv.is_open()) {
+        std::cerr << "Error: Could not write " << manifest.output_file << '\n';
+        return 4;
+    }
+    std::size_t run_count = 0;
+    const int status = runBatch(manifest, csv, run_count);
+    if (status != 0) return status;
+    std::cout << "Runs: " << run_count << "\nResult table: " << manifest.output_file << '\n';
+    return 0;
+}
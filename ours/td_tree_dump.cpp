@@ -0,0 +1,36 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "BinaryMatchFormat.h"
+
+// Converts a result file written with --output-format binary back to the
+// text [Final Matches] section.
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argc > 3) {
+        std::cerr << "Usage: " << argv[0] << " <Binary Result> [Text Output]\n";
+        return 1;
+    }
+
+    std::ofstream file_output;
+    if (argc == 3) {
+        file_output.open(argv[2], std::ios::binary);
+        if (!file_output.is_open()) {
+            std::cerr << "Error: Could not write " << argv[2] << '\n';
+            return 4;
+        }
+    }
+    std::ostream& output = argc == 3 ? file_output : std::cout;
+
+    std::string error;
+    if (!convertBinaryMatchesToText(argv[1], output, error)) {
+        std::cerr << "Error: " << argv[1] << ": " << error << '\n';
+        return 2;
+    }
+    output.flush();
+    if (!output) {
+        std::cerr << "Error: Could not write the text output.\n";
+        return 4;
+    }
+    return 0;
+}
@@ -0,0 +1,36 @@
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <thread>
+
+#include "QueryService.h"
+#include "Utils.h"
+
+// Line-protocol query service on stdin/stdout. See README.md for the protocol.
+
+int main(int argc, char* argv[]) {
+    QueryServiceOptions options;
+    options.worker_count = std::max(1U, std::thread::hardware_concurrency());
+    for (int argument_index = 1; argument_index < argc; ++argument_index) {
+        const std::string argument = argv[argument_index];
+        long long value = 0;
+        if (argument == "--workers" && argument_index + 1 < argc &&
+            parseInteger(argv[++argument_index], 1, 1024, value)) {
+            options.worker_count = static_cast<unsigned>(value);
+        } else if (argument == "--memory-budget-mib" && argument_index + 1 < argc &&
+                   parseInteger(argv[++argument_index], 0,
+                                static_cast<long long>(std::numeric_limits<std::size_t>::max() >> 20),
+                                value)) {
+            options.memory_budget_bytes = static_cast<std::size_t>(value) << 20;
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--workers N] [--memory-budget-mib MiB]\n";
+            return 1;
+        }
+    }
+
+    serveQueries(std::cin, std::cout, options);
+    return 0;
+}
@@ -1,15 +1,33 @@
+#include "../BatchRunner.h"
+#include "../BinaryMatchFormat.h"
+#include "../CECI.h"
+#include "../DurableMatcher.h"
+#include "../MatchWriter.h"
+#include "../QueryService.h"
+#include "../SnapshotSweep.h"
 #include "../TDTree.h"
+#include "../TemporalWindow.h"
+#include "../TimeParallel.h"
 #include "../Utils.h"
 #include "../query_decomposition.h"
 
 #include <algorithm>
 #include <array>
+#include <cstddef>
 #include <cstdint>
 #include <filesystem>
 #include <fstream>
+#include <functional>
+#include <iomanip>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace {
@@ -107,6 +125,50 @@ void finalizeSyntheticGraph(Graph& graph) {
     }
 }
 
+// A random directed temporal graph over snapshots 1..6 without self-loops.
+// Each ordered pair gets an arc with probability density, active in a
+// random subset of the snapshots; long_runs biases the subsets towards long
+// runs so that large k keep some matches. Vertex v has external ID
+// id_base + v and label v % label_count. seed must not be 0.
+Graph makeRandomTemporalGraph(
+    std::uint32_t seed,
+    int id_base,
+    double density,
+    int vertex_count = 9,
+    std::size_t label_count = 3,
+    bool long_runs = false) {
+    // The odd multiplier keeps the state non-zero and spreads nearby seeds.
+    std::uint32_t state = seed * 0x9e3779b1U;
+    auto next_random = [&]() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    };
+    const std::uint32_t arc_threshold = static_cast<std::uint32_t>(density * 1024.0);
+
+    Graph graph;
+    graph.num_vertices = vertex_count;
+    graph.adj.resize(static_cast<std::size_t>(vertex_count));
+    graph.in_adj.resize(static_cast<std::size_t>(vertex_count));
+    for (int vertex = 0; vertex < vertex_count; ++vertex) {
+        graph.external_ids.push_back(id_base + vertex);
+        graph.vertex_labels.push_back(
+            static_cast<Label>(static_cast<std::size_t>(vertex) % label_count));
+    }
+    for (int u = 0; u < vertex_count; ++u) {
+        for (int v = 0; v < vertex_count; ++v) {
+            if (u == v || (next_random() & 1023U) >= arc_threshold) continue;
+            std::uint32_t mask = next_random();
+            if (long_runs) mask |= next_random();
+            mask &= 0x3fU;
+            if (mask != 0) addTemporalEdge(graph, u, v, intervalsFromMask(mask));
+        }
+    }
+    finalizeSyntheticGraph(graph);
+    return graph;
+}
+
 std::uint64_t bruteForceTriangleCount(const Graph& graph, int minimum_duration) {
     const Label label_a = labelFromString("A");
     const Label label_b = labelFromString("B");
@@ -139,6 +201,83 @@ std::uint64_t bruteForceTriangleCount(const Graph& graph, int minimum_duration)
     return count;
 }
 
+Graph makeQuery(
+    const std::vector<std::string>& labels,
+    const std::vector<std::pair<int, int>>& edges) {
+    Graph query;
+    query.num_vertices = static_cast<int>(labels.size());
+    for (const auto& label : labels) query.vertex_labels.push_back(labelFromString(label));
+    query.external_ids.resize(labels.size());
+    for (std::size_t i = 0; i < labels.size(); ++i) query.external_ids[i] = static_cast<int>(i);
+    query.adj.resize(labels.size());
+    query.in_adj.resize(labels.size());
+    for (const auto& edge : edges) {
+        query.adj[static_cast<std::size_t>(edge.first)].push_back({edge.second, -1});
+        query.in_adj[static_cast<std::size_t>(edge.second)].push_back({edge.first, -1});
+    }
+    for (auto& neighbors : query.adj) {
+        std::sort(neighbors.begin(), neighbors.end(), [](const Edge& lhs, const Edge& rhs) {
+            return lhs.to < rhs.to;
+        });
+    }
+    for (auto& neighbors : query.in_adj) {
+        std::sort(neighbors.begin(), neighbors.end(), [](const Edge& lhs, const Edge& rhs) {
+            return lhs.to < rhs.to;
+        });
+    }
+    return query;
+}
+
+// Injective label-preserving assignments whose mapped arcs share a k-run.
+std::uint64_t bruteForceMatchCount(
+    const Graph& graph,
+    const Graph& query,
+    int minimum_duration,
+    std::vector<std::vector<int>>* matches = nullptr) {
+    std::vector<int> mapping(static_cast<std::size_t>(query.num_vertices), -1);
+    std::vector<bool> used(static_cast<std::size_t>(graph.num_vertices), false);
+    std::uint64_t count = 0;
+    std::function<void(int)> assign = [&](int query_vertex) {
+        if (query_vertex == query.num_vertices) {
+            std::vector<TimeInterval> common;
+            bool first = true;
+            for (int u = 0; u < query.num_vertices; ++u) {
+                for (const auto& edge : query.adj[static_cast<std::size_t>(u)]) {
+                    const TemporalEdge* data_edge = graph.findTemporalEdge(
+                        mapping[static_cast<std::size_t>(u)],
+                        mapping[static_cast<std::size_t>(edge.to)]);
+                    if (data_edge == nullptr) return;
+                    common = first
+                        ? intersectTimeIntervals(
+                              data_edge->active_intervals, data_edge->active_intervals,
+                              minimum_duration)
+                        : intersectTimeIntervals(
+                              common, data_edge->active_intervals, minimum_duration);
+                    first = false;
+                    if (common.empty()) return;
+                }
+            }
+            ++count;
+            if (matches != nullptr) matches->push_back(mapping);
+            return;
+        }
+        for (int data_vertex = 0; data_vertex < graph.num_vertices; ++data_vertex) {
+            if (used[static_cast<std::size_t>(data_vertex)] ||
+                graph.vertex_labels[static_cast<std::size_t>(data_vertex)] !=
+                    query.vertex_labels[static_cast<std::size_t>(query_vertex)]) {
+                continue;
+            }
+            used[static_cast<std::size_t>(data_vertex)] = true;
+            mapping[static_cast<std::size_t>(query_vertex)] = data_vertex;
+            assign(query_vertex + 1);
+            mapping[static_cast<std::size_t>(query_vertex)] = -1;
+            used[static_cast<std::size_t>(data_vertex)] = false;
+        }
+    };
+    assign(0);
+    return count;
+}
+
 Graph makeMatchingDataGraph() {
     Graph graph;
     graph.num_vertices = 6;
@@ -171,6 +310,37 @@ QueryDecomposition makeDecomposition(const Graph& query) {
     return decomposeQuery(query, counts, lifespans);
 }
 
+// One match as (mapping, [start, end] per query arc), comparable across engines.
+using MatchRow = std::pair<std::vector<int>, std::vector<std::pair<int, int>>>;
+
+// Sorted rows of every match an engine reports. matcher is either an engine
+// with forEachMatch(callback, options) or a callable taking the callback; the
+// callback may run on several threads. The summary must agree with the rows.
+template <typename Matcher>
+std::vector<MatchRow> collectRows(const Matcher& matcher, const MatchOptions& options = {}) {
+    std::mutex rows_mutex;
+    std::vector<MatchRow> rows;
+    const MatchCallback callback =
+        [&](const std::vector<int>& mapping, const std::vector<TimeInterval>& intervals) {
+            MatchRow row{mapping, {}};
+            for (const auto& interval : intervals) {
+                row.second.emplace_back(interval.start, interval.end);
+            }
+            const std::lock_guard<std::mutex> lock(rows_mutex);
+            rows.push_back(std::move(row));
+            return true;
+        };
+    MatchSummary summary;
+    if constexpr (std::is_invocable_v<const Matcher&, const MatchCallback&>) {
+        summary = matcher(callback);
+    } else {
+        summary = matcher.forEachMatch(callback, options);
+    }
+    require(summary.match_count == rows.size(), "match count agrees with the reported rows");
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
 void testIntervals() {
     const std::vector<TimeInterval> lhs{{1, 5}, {10, 20}};
     const std::vector<TimeInterval> rhs{{3, 8}, {12, 14}, {18, 22}};
@@ -183,6 +353,18 @@ void testIntervals() {
     require(!hasMinimumConsecutiveDuration(intersection, 4), "minimum run rejected");
 }
 
+void testIntegerParsing() {
+    long long value = 7;
+    require(parseInteger("42", 0, 100, value) && value == 42, "plain integers parse");
+    require(parseInteger("-3", -5, 5, value) && value == -3, "negative integers parse");
+    for (const char* text : {"", "-", "+4", " 4", "4 ", "4x", "0x10", "101", "-6",
+                             "99999999999999999999"}) {
+        value = 7;
+        require(!parseInteger(text, -5, 100, value) && value == 7,
+                std::string("the integer text '") + text + "' is rejected");
+    }
+}
+
 void testFilteringAndDenseIds(const std::filesystem::path& directory) {
     const auto first_path = directory / "ours_filter_order_1.dat";
     const auto second_path = directory / "ours_filter_order_2.dat";
@@ -243,6 +425,17 @@ void testFilteringAndDenseIds(const std::filesystem::path& directory) {
                 label_for_external_id(different_survival, 1000000),
             "random labels are assigned before temporal filtering");
 
+    Graph relabeled = first;
+    assignSeededLabels(relabeled, 43U);
+    require(relabeled.vertex_labels == alternate_seed.vertex_labels &&
+            relabeled.neighbor_label_counts == alternate_seed.neighbor_label_counts &&
+            relabeled.incoming_neighbor_label_counts ==
+                alternate_seed.incoming_neighbor_label_counts,
+            "in-memory relabeling matches a fresh read with the new seed");
+    assignSeededLabels(relabeled, kDefaultLabelSeed);
+    require(relabeled.vertex_labels == first.vertex_labels,
+            "relabeling back restores the original assignment");
+
     std::filesystem::remove(first_path);
     std::filesystem::remove(second_path);
     std::filesystem::remove(different_survival_path);
@@ -453,18 +646,1228 @@ void testRandomGraphsAgainstBruteForce(const std::filesystem::path& directory) {
             "random oracle fixtures must include positive and zero-match graphs");
 }
 
+void testMultiwayIntersectionExtension(const std::filesystem::path& directory) {
+    // A hub-heavy graph with a K4 query: the last query vertex in DFS order
+    // has two mapped non-tree neighbors whose adjacency lists are intersected.
+    const Graph query = makeQuery(
+        {"A", "B", "C", "D"},
+        {{0, 1}, {0, 2}, {1, 2}, {1, 3}, {2, 3}, {3, 0}});
+    std::array<std::size_t, kLabelCount> counts{};
+    std::array<double, kLabelCount> lifespans{};
+    counts.fill(4);
+    lifespans.fill(6.0);
+    const QueryDecomposition decomposition = decomposeQuery(query, counts, lifespans);
+    require(decomposition.connected && decomposition.non_tree_edges.size() >= 2,
+            "K4 query has several non-tree arcs");
+
+    bool saw_match = false;
+    for (int round = 0; round < 16; ++round) {
+        Graph graph = makeRandomTemporalGraph(0x9e3779b9U + round, 1000, 0.5, 12, 4, true);
+        // Every A vertex also reaches each B and C vertex for 4 snapshots.
+        std::vector<std::pair<int, int>> hub_arcs;
+        for (int u = 0; u < graph.num_vertices; u += 4) {
+            for (int v = 0; v < graph.num_vertices; ++v) {
+                if ((v % 4 == 1 || v % 4 == 2) && graph.findTemporalEdge(u, v) == nullptr) {
+                    hub_arcs.emplace_back(u, v);
+                }
+            }
+        }
+        for (const auto& arc : hub_arcs) addTemporalEdge(graph, arc.first, arc.second, {{2, 5}});
+        finalizeSyntheticGraph(graph);
+
+        const std::uint64_t expected = bruteForceMatchCount(graph, query, 2);
+        saw_match = saw_match || expected > 0;
+        const auto result_path = directory /
+            ("ours_intersection_" + std::to_string(round) + ".dat");
+        TDTree tree(graph, query, decomposition, 2);
+        const MatchSummary actual = tree.save_res(result_path.string());
+        require(actual.match_count == expected,
+                "multi-way intersection differs from brute force in round " +
+                    std::to_string(round));
+        std::filesystem::remove(result_path);
+    }
+    require(saw_match, "intersection fixtures must include matches");
+}
+
+void testHubNonTreeProbing() {
+    // A <-> B with A -> C and B -> C. Six D vertices take arcs from every B
+    // and send arcs to every C, so whichever endpoint of the non-tree arc is
+    // checked has more neighbors than the other endpoint has candidates, and
+    // the check probes that candidate list instead of scanning neighbors.
+    const Graph query = makeQuery({"A", "B", "C"}, {{0, 1}, {1, 0}, {0, 2}, {1, 2}});
+    const QueryDecomposition decomposition = makeDecomposition(query);
+    require(decomposition.non_tree_edges.size() == 1, "the hub query has one non-tree arc");
+
+    auto add_hub_vertices = [](Graph& graph, int id_base) {
+        const int first_hub = graph.num_vertices;
+        for (int hub = 0; hub < 6; ++hub) {
+            graph.external_ids.push_back(id_base + hub);
+            graph.vertex_labels.push_back(labelFromString("D"));
+        }
+        graph.num_vertices += 6;
+        graph.adj.resize(static_cast<std::size_t>(graph.num_vertices));
+        graph.in_adj.resize(static_cast<std::size_t>(graph.num_vertices));
+        for (int v = 0; v < first_hub; ++v) {
+            const Label label = graph.vertex_labels[static_cast<std::size_t>(v)];
+            for (int hub = first_hub; hub < graph.num_vertices; ++hub) {
+                if (label == labelFromString("B")) addTemporalEdge(graph, v, hub, {{1, 6}});
+                if (label == labelFromString("C")) addTemporalEdge(graph, hub, v, {{1, 6}});
+            }
+        }
+        finalizeSyntheticGraph(graph);
+    };
+    // Each node keeps a candidate for every distinct (parent, child) pair of
+    // the oracle's matches. The semijoins only follow tree arcs, so on random
+    // graphs some candidates that fail the non-tree arc later may remain.
+    auto check_against_oracle = [&](const Graph& graph, const std::string& fixture,
+                                    bool relations_exact) {
+        std::vector<std::vector<int>> matches;
+        const std::uint64_t expected = bruteForceMatchCount(graph, query, 2, &matches);
+        std::vector<std::set<std::pair<int, int>>> pairs(static_cast<std::size_t>(query.num_vertices));
+        for (const auto& mapping : matches) {
+            for (int query_vertex = 0; query_vertex < query.num_vertices; ++query_vertex) {
+                const int parent = decomposition.parent[static_cast<std::size_t>(query_vertex)];
+                pairs[static_cast<std::size_t>(query_vertex)].emplace(
+                    parent < 0 ? -1 : mapping[static_cast<std::size_t>(parent)],
+                    mapping[static_cast<std::size_t>(query_vertex)]);
+            }
+        }
+        std::size_t oracle_relations = 0;
+        for (const auto& node_pairs : pairs) oracle_relations += node_pairs.size();
+
+        const TDTree tree(graph, query, decomposition, 2);
+        require(tree.forEachMatch([](const std::vector<int>&, const std::vector<TimeInterval>&) {
+                    return true;
+                }).match_count == expected,
+                "hub probing keeps every match of " + fixture);
+        require(relations_exact ? tree.candidateRelationCount() == oracle_relations
+                                : tree.candidateRelationCount() >= oracle_relations,
+                "hub probing keeps exactly the supported candidate relations of " + fixture);
+        return expected;
+    };
+
+    // a0 <-> b0 both reach c0. b1 has arcs a1 -> b1 and b1 -> a0 but none
+    // back to a1, and b0 -> c1 lasts one snapshot, so (a1, b1, c1) and
+    // (a0, b0, c1) are not matches.
+    Graph graph;
+    graph.num_vertices = 6;
+    graph.external_ids = {10, 11, 20, 21, 30, 31};
+    for (const char* label : {"A", "A", "B", "B", "C", "C"}) {
+        graph.vertex_labels.push_back(labelFromString(label));
+    }
+    graph.adj.resize(6);
+    graph.in_adj.resize(6);
+    addTemporalEdge(graph, 0, 2, {{1, 4}});
+    addTemporalEdge(graph, 2, 0, {{1, 4}});
+    addTemporalEdge(graph, 0, 4, {{1, 4}});
+    addTemporalEdge(graph, 2, 4, {{1, 4}});
+    addTemporalEdge(graph, 2, 1, {{1, 4}});
+    addTemporalEdge(graph, 1, 3, {{1, 4}});
+    addTemporalEdge(graph, 3, 0, {{1, 4}});
+    addTemporalEdge(graph, 1, 5, {{1, 4}});
+    addTemporalEdge(graph, 3, 5, {{1, 4}});
+    addTemporalEdge(graph, 2, 5, {{1, 1}});
+    add_hub_vertices(graph, 90);
+    require(check_against_oracle(graph, "the hub fixture", true) == 1,
+            "the hub fixture has one match");
+
+    bool saw_match = false;
+    for (int round = 0; round < 12; ++round) {
+        Graph random_graph = makeRandomTemporalGraph(0x1b873593U + round, 700, 0.5, 9, 3, true);
+        add_hub_vertices(random_graph, 790);
+        if (check_against_oracle(random_graph, "hub round " + std::to_string(round), false) > 0) {
+            saw_match = true;
+        }
+    }
+    require(saw_match, "hub probing rounds must include matches");
+}
+
+void testFailingSetBackjumping(const std::filesystem::path& directory) {
+    // Repeated labels make injectivity conflicts frequent: both A leaves of
+    // the star compete for the same data vertices, and the C leaf between
+    // them in DFS order cannot resolve that conflict.
+    const Graph query = makeQuery(
+        {"B", "A", "C", "A"},
+        {{0, 1}, {0, 2}, {0, 3}});
+    std::array<std::size_t, kLabelCount> counts{};
+    std::array<double, kLabelCount> lifespans{};
+    counts.fill(3);
+    lifespans.fill(6.0);
+    const QueryDecomposition decomposition = decomposeQuery(query, counts, lifespans);
+
+    std::uint64_t total_pruned = 0;
+    bool saw_match = false;
+    for (int round = 0; round < 24; ++round) {
+        const Graph graph = makeRandomTemporalGraph(0x2545f491U + round, 500, 2.0 / 3.0);
+
+        const std::uint64_t expected = bruteForceMatchCount(graph, query, 2);
+        saw_match = saw_match || expected > 0;
+        const auto result_path = directory /
+            ("ours_failing_set_" + std::to_string(round) + ".dat");
+        TDTree tree(graph, query, decomposition, 2);
+        const MatchSummary actual = tree.save_res(result_path.string());
+        require(actual.match_count == expected,
+                "failing-set pruning differs from brute force in round " +
+                    std::to_string(round));
+        total_pruned += actual.failing_set_pruned_candidates;
+        std::filesystem::remove(result_path);
+    }
+    require(saw_match, "failing-set fixtures must include matches");
+    require(total_pruned > 0, "repeated-label fixtures exercise backjumping");
+}
+
+void testAdaptiveMatchingOrder(const std::filesystem::path& directory) {
+    const std::vector<Graph> queries{
+        makeTriangleQuery(),
+        makeQuery({"A", "B", "C", "A"}, {{0, 1}, {1, 2}, {2, 3}, {3, 0}, {0, 2}}),
+        makeQuery({"B", "A", "C", "A"}, {{0, 1}, {0, 2}, {0, 3}, {2, 3}})};
+    std::array<std::size_t, kLabelCount> counts{};
+    std::array<double, kLabelCount> lifespans{};
+    counts.fill(3);
+    lifespans.fill(6.0);
+
+    bool saw_match = false;
+    for (int round = 0; round < 24; ++round) {
+        const Graph graph = makeRandomTemporalGraph(0x1b873593U + round, 700, 0.5);
+
+        for (std::size_t query_index = 0; query_index < queries.size(); ++query_index) {
+            const Graph& query = queries[query_index];
+            const QueryDecomposition decomposition = decomposeQuery(query, counts, lifespans);
+            const std::uint64_t expected = bruteForceMatchCount(graph, query, 2);
+            saw_match = saw_match || expected > 0;
+
+            const auto result_path = directory /
+                ("ours_adaptive_order_" + std::to_string(round) + ".dat");
+            TDTree tree(graph, query, decomposition, 2);
+            MatchOptions options;
+            options.matching_order = MatchingOrder::Adaptive;
+            const MatchSummary actual = tree.save_res(result_path.string(), options);
+            require(actual.match_count == expected,
+                    "adaptive order differs from brute force in round " +
+                        std::to_string(round) + " query " + std::to_string(query_index));
+            std::ifstream result(result_path, std::ios::binary);
+            const std::string contents(
+                (std::istreambuf_iterator<char>(result)), std::istreambuf_iterator<char>());
+            require(contents.find("matching_order: adaptive") != std::string::npos,
+                    "result statistics record the matching order");
+            result.close();
+            std::filesystem::remove(result_path);
+        }
+    }
+    require(saw_match, "adaptive order fixtures must include matches");
+}
+
+void testFactorizedCounting(const std::filesystem::path& directory) {
+    const std::vector<Graph> tree_queries{
+        makeQuery({"A", "B", "C", "D"}, {{0, 1}, {0, 2}, {3, 0}}),
+        makeQuery({"B", "A", "C", "D", "E"}, {{0, 1}, {1, 2}, {2, 3}, {1, 4}}),
+        makeQuery({"A", "B", "C"}, {{0, 1}, {1, 0}, {1, 2}})};
+    std::array<std::size_t, kLabelCount> counts{};
+    std::array<double, kLabelCount> lifespans{};
+    counts.fill(3);
+    lifespans.fill(6.0);
+    MatchOptions count_only;
+    count_only.output_mode = MatchOutputMode::CountOnly;
+
+    bool saw_match = false;
+    for (int round = 0; round < 24; ++round) {
+        const Graph graph = makeRandomTemporalGraph(
+            0x85ebca6bU + round, 900, 2.0 / 3.0, 10, kLabelCount);
+
+        for (std::size_t query_index = 0; query_index < tree_queries.size(); ++query_index) {
+            const Graph& query = tree_queries[query_index];
+            const QueryDecomposition decomposition = decomposeQuery(query, counts, lifespans);
+            const std::uint64_t expected = bruteForceMatchCount(graph, query, 2);
+            saw_match = saw_match || expected > 0;
+            const auto result_path = directory /
+                ("ours_factorized_" + std::to_string(round) + ".dat");
+            TDTree tree(graph, query, decomposition, 2);
+            const MatchSummary actual = tree.save_res(result_path.string(), count_only);
+            require(actual.factorized_count, "distinct-label tree queries are factorized");
+            require(actual.match_count == expected,
+                    "factorized count differs from brute force in round " +
+                        std::to_string(round) + " query " + std::to_string(query_index));
+            std::ifstream result(result_path, std::ios::binary);
+            const std::string contents(
+                (std::istreambuf_iterator<char>(result)), std::istreambuf_iterator<char>());
+            require(contents.find("\nMatch ") == std::string::npos &&
+                    contents.find("count_strategy: factorized") != std::string::npos,
+                    "count-only output omits match rows");
+            result.close();
+            std::filesystem::remove(result_path);
+        }
+    }
+    require(saw_match, "factorized fixtures must include matches");
+
+    // Repeated labels only keep the subtrees that share them from being
+    // multiplied; the vertices between those are enumerated in place.
+    const std::vector<Graph> repeated_label_queries{
+        makeQuery({"A", "B", "C", "B", "D"}, {{0, 1}, {0, 2}, {2, 3}, {0, 4}}),
+        makeQuery({"A", "B", "C", "D", "C"}, {{0, 1}, {0, 2}, {2, 3}, {3, 4}}),
+        makeQuery({"A", "B", "C", "D", "E", "B"}, {{0, 1}, {1, 2}, {0, 3}, {3, 4}, {4, 5}})};
+    // Every subtree below the root shares a label with the rest.
+    const Graph clashing = makeQuery({"A", "B", "C", "B"}, {{0, 1}, {0, 2}, {2, 3}});
+    saw_match = false;
+    for (int round = 0; round < 24; ++round) {
+        const Graph graph = makeRandomTemporalGraph(
+            0x27d4eb2fU + round, 900, 3.0 / 4.0, 10, kLabelCount, true);
+        for (std::size_t query_index = 0; query_index <= repeated_label_queries.size();
+             ++query_index) {
+            const bool factorizable = query_index < repeated_label_queries.size();
+            const Graph& query = factorizable ? repeated_label_queries[query_index] : clashing;
+            const QueryDecomposition decomposition = decomposeQuery(query, counts, lifespans);
+            const std::uint64_t expected = bruteForceMatchCount(graph, query, 2);
+            saw_match = saw_match || (factorizable && expected > 0);
+            const auto result_path = directory /
+                ("ours_factorized_repeated_" + std::to_string(round) + ".dat");
+            TDTree tree(graph, query, decomposition, 2);
+            const MatchSummary actual = tree.save_res(result_path.string(), count_only);
+            require(actual.factorized_count == factorizable,
+                    "tree queries are factorized exactly when a subtree has its own labels");
+            require(actual.match_count == expected,
+                    "repeated-label count differs from brute force in round " +
+                        std::to_string(round) + " query " + std::to_string(query_index));
+            std::filesystem::remove(result_path);
+        }
+    }
+    require(saw_match, "repeated-label factorized fixtures must include matches");
+
+    // Cyclic queries fall back to enumeration but still omit match rows.
+    const Graph data = makeMatchingDataGraph();
+    const Graph triangle = makeTriangleQuery();
+    const QueryDecomposition decomposition = makeDecomposition(triangle);
+    const auto result_path = directory / "ours_factorized_fallback.dat";
+    TDTree tree(data, triangle, decomposition, 3);
+    const MatchSummary summary = tree.save_res(result_path.string(), count_only);
+    require(!summary.factorized_count && summary.match_count == 1,
+            "cyclic count-only queries are enumerated");
+
+    // decomposeQuery gives a query without arcs no root, but a caller can
+    // still build its one-vertex decomposition by hand.
+    const Graph vertex = makeQuery({"A"}, {});
+    QueryDecomposition vertex_decomposition;
+    vertex_decomposition.spanning_tree_adj.resize(1);
+    vertex_decomposition.vertex_labels = vertex.vertex_labels;
+    vertex_decomposition.parent = {-1};
+    vertex_decomposition.dfs_order = {0};
+    vertex_decomposition.temporal_selectivity = {1.0};
+    vertex_decomposition.root = 0;
+    vertex_decomposition.connected = true;
+    TDTree vertex_tree(data, vertex, vertex_decomposition, 2);
+    const std::uint64_t enumerated = vertex_tree.forEachMatch(
+        [](const std::vector<int>&, const std::vector<TimeInterval>&) {
+            return true;
+        }).match_count;
+    const MatchSummary vertex_summary = vertex_tree.save_res(result_path.string(), count_only);
+    require(enumerated == 2 && !vertex_summary.factorized_count &&
+                vertex_summary.match_count == enumerated,
+            "count-only runs of queries without arcs match enumeration");
+    std::filesystem::remove(result_path);
+}
+
+void testResultLimitsAndExists(const std::filesystem::path& directory) {
+    const Graph query = makeQuery({"A", "B", "C"}, {{0, 1}, {0, 2}});
+    std::array<std::size_t, kLabelCount> counts{};
+    std::array<double, kLabelCount> lifespans{};
+    counts.fill(3);
+    lifespans.fill(6.0);
+    const QueryDecomposition decomposition = decomposeQuery(query, counts, lifespans);
+
+    auto read_result = [](const std::filesystem::path& path) {
+        std::ifstream result(path, std::ios::binary);
+        return std::string(
+            (std::istreambuf_iterator<char>(result)), std::istreambuf_iterator<char>());
+    };
+    const auto result_path = directory / "ours_result_limits.dat";
+    bool saw_truncation = false;
+    for (int round = 0; round < 16; ++round) {
+        const Graph graph = makeRandomTemporalGraph(0xc2b2ae35U + round, 1100, 2.0 / 3.0, 12);
+        const std::uint64_t expected = bruteForceMatchCount(graph, query, 2);
+        TDTree tree(graph, query, decomposition, 2);
+
+        for (std::uint64_t limit : {std::uint64_t{1}, std::uint64_t{3}, expected}) {
+            if (limit == 0) continue;
+            MatchOptions options;
+            options.limits.max_results = limit;
+            const MatchSummary summary = tree.save_res(result_path.string(), options);
+            const std::string contents = read_result(result_path);
+            if (limit < expected) {
+                saw_truncation = true;
+                require(summary.match_count == limit &&
+                        summary.stop_reason == MatchStopReason::ResultLimit,
+                        "--limit stops after the requested number of matches");
+                require(contents.find("Truncated: result-limit") != std::string::npos &&
+                        contents.find("stop_reason: result-limit") != std::string::npos,
+                        "truncated results are marked");
+                std::ostringstream count_line;
+                count_line << "Count: " << std::setw(20) << limit;
+                require(contents.find(count_line.str()) != std::string::npos,
+                        "the partial count is written into the placeholder");
+            } else {
+                require(summary.match_count == expected &&
+                        summary.stop_reason == MatchStopReason::Complete &&
+                        contents.find("Truncated:") == std::string::npos,
+                        "a limit equal to the match count is not a truncation");
+            }
+        }
+
+        MatchOptions exists;
+        exists.output_mode = MatchOutputMode::CountOnly;
+        exists.limits.exists_only = true;
+        const MatchSummary summary = tree.save_res(result_path.string(), exists);
+        require(!summary.factorized_count, "limited runs are enumerated");
+        require(summary.match_count == (expected > 0 ? 1U : 0U) &&
+                (summary.stop_reason == MatchStopReason::Exists) == (expected > 0),
+                "--exists stops at the first durable match");
+    }
+    std::filesystem::remove(result_path);
+    require(saw_truncation, "result-limit fixtures must include truncations");
+}
+
+void testAsyncMatchWriter() {
+    // The minimum buffer forces many handoffs and integers near a boundary.
+    std::ostringstream written;
+    std::ostringstream expected;
+    {
+        AsyncMatchWriter writer(written, 1);
+        for (int row = 0; row < 2000; ++row) {
+            const std::vector<TimeInterval> intervals{
+                {row, row}, {row + 2, row + 7 + (row % 5)}, {-row - 1, 2147483647}};
+            writer.append("Match ");
+            writer.appendInteger(static_cast<std::uint64_t>(row) * 4294967311ULL);
+            writer.append(": q0(A)->");
+            writer.appendInteger(-row);
+            writer.append(" | active=");
+            writer.appendIntervals(intervals);
+            writer.append('\n');
+            expected << "Match " << static_cast<std::uint64_t>(row) * 4294967311ULL
+                     << ": q0(A)->" << -row << " | active=" << formatIntervals(intervals) << '\n';
+        }
+        require(writer.finish(), "writer reports a healthy stream");
+        require(writer.finish(), "finish is idempotent");
+    }
+    require(written.str() == expected.str(), "async writer matches ostream formatting");
+}
+
+void testBinaryOutputRoundTrip(const std::filesystem::path& directory) {
+    const Graph query = makeQuery({"A", "B", "C"}, {{0, 1}, {1, 2}, {2, 0}});
+    std::array<std::size_t, kLabelCount> counts{};
+    std::array<double, kLabelCount> lifespans{};
+    counts.fill(3);
+    lifespans.fill(6.0);
+    const QueryDecomposition decomposition = decomposeQuery(query, counts, lifespans);
+
+    auto read_file = [](const std::filesystem::path& path) {
+        std::ifstream input(path, std::ios::binary);
+        return std::string(
+            (std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    };
+    const auto text_path = directory / "ours_binary_round_trip.txt";
+    const auto binary_path = directory / "ours_binary_round_trip.bin";
+    bool saw_match = false;
+    for (int round = 0; round < 12; ++round) {
+        const Graph graph = makeRandomTemporalGraph(0x165667b1U + round, 5000, 2.0 / 3.0, 12);
+        TDTree tree(graph, query, decomposition, 2);
+
+        MatchOptions text_options;
+        MatchOptions binary_options;
+        binary_options.output_format = MatchOutputFormat::Binary;
+        if (round % 4 == 3) {
+            text_options.limits.max_results = 2;
+            binary_options.limits.max_results = 2;
+        }
+        const MatchSummary text = tree.save_res(text_path.string(), text_options);
+        const MatchSummary binary = tree.save_res(binary_path.string(), binary_options);
+        require(binary.output_written && binary.match_count == text.match_count &&
+                binary.stop_reason == text.stop_reason,
+                "binary and text runs agree");
+        saw_match = saw_match || text.match_count > 0;
+        require(!std::filesystem::exists(binary_path.string() + ".intervals"),
+                "the interval spool file is removed");
+
+        const std::string text_contents = read_file(text_path);
+        const std::size_t section_start = text_contents.find("[Final Matches]");
+        const std::size_t section_end = text_contents.find("\n[Statistics]");
+        std::ostringstream dumped;
+        std::string error;
+        require(convertBinaryMatchesToText(binary_path.string(), dumped, error),
+                "binary result converts to text: " + error);
+        require(dumped.str() == text_contents.substr(section_start, section_end - section_start),
+                "td_tree_dump reproduces the text matches in round " + std::to_string(round));
+
+        std::ifstream binary_input(binary_path, std::ios::binary);
+        BinaryMatchHeader header;
+        require(readBinaryMatchHeader(binary_input, header, error) &&
+                    header.rowWidth() == query.num_vertices * sizeof(std::uint32_t) &&
+                    header.interval_section_offset ==
+                        header.headerSize() + header.match_count * header.rowWidth(),
+                "binary rows hold only the compact data vertices");
+    }
+    require(saw_match, "binary fixtures must include matches");
+
+    // A sidecar path that cannot be opened fails the run without leaving a
+    // partial result file.
+    const std::string blocked_sidecar = binary_path.string() + ".intervals";
+    std::filesystem::remove(binary_path);
+    std::filesystem::create_directory(blocked_sidecar);
+    {
+        const Graph graph = makeRandomTemporalGraph(0x165667b1U, 5000, 2.0 / 3.0, 12);
+        MatchOptions binary_options;
+        binary_options.output_format = MatchOutputFormat::Binary;
+        const MatchSummary blocked =
+            TDTree(graph, query, decomposition, 2).save_res(binary_path.string(), binary_options);
+        require(!blocked.output_written && !std::filesystem::exists(binary_path),
+                "an unopenable interval spool leaves no result file");
+    }
+    std::filesystem::remove(blocked_sidecar);
+
+    std::ofstream(binary_path, std::ios::binary) << "TDMB";
+    std::ostringstream ignored;
+    std::string error;
+    require(!convertBinaryMatchesToText(binary_path.string(), ignored, error) && !error.empty(),
+            "a truncated binary header is rejected");
+    std::filesystem::remove(text_path);
+    std::filesystem::remove(binary_path);
+}
+
+void testLibraryStreamingApi() {
+    const Graph graph = makeRandomTemporalGraph(0x61c88647U, 300, 2.0 / 3.0, 12);
+    const Graph path = makeQuery({"A", "B", "C"}, {{0, 1}, {1, 2}});
+    const Graph triangle = makeQuery({"A", "B", "C"}, {{0, 1}, {1, 2}, {2, 0}});
+    const std::uint64_t expected_path = bruteForceMatchCount(graph, path, 2);
+    const std::uint64_t expected_triangle = bruteForceMatchCount(graph, triangle, 2);
+    require(expected_path > 1, "library fixture needs several matches");
+
+    // One data graph handle serves several prepared queries.
+    const auto data_graph = makeDataGraphHandle(std::move(graph));
+    std::string error;
+    const auto prepared_path = prepareQuery(data_graph, path, 2, error);
+    const auto prepared_triangle = prepareQuery(data_graph, triangle, 2, error);
+    require(prepared_path != nullptr && prepared_triangle != nullptr, "queries prepare: " + error);
+    require(estimateTDTreeBytes(*data_graph, path) >= prepared_path->tdTree().getMemoryUsage() &&
+            estimateTDTreeBytes(*data_graph, triangle) >=
+                prepared_triangle->tdTree().getMemoryUsage(),
+            "admission estimates bound the built TD-trees");
+
+    std::uint64_t streamed = 0;
+    const MatchSummary full = prepared_path->forEachMatch(
+        [&](const std::vector<int>& mapping, const std::vector<TimeInterval>& intervals) {
+            require(mapping.size() == 3 && !intervals.empty() && intervals.front().length() >= 2,
+                    "callback receives a complete mapping and durable intervals");
+            for (int data_vertex : mapping) {
+                require(data_graph->graph.externalId(data_vertex) >= 300,
+                        "mappings use compact IDs of the data graph");
+            }
+            ++streamed;
+            return true;
+        });
+    require(streamed == expected_path && full.match_count == expected_path &&
+            full.stop_reason == MatchStopReason::Complete,
+            "streaming yields every durable match");
+    const MatchSummary triangles = prepared_triangle->forEachMatch(
+        [](const std::vector<int>&, const std::vector<TimeInterval>&) { return true; });
+    require(triangles.match_count == expected_triangle, "a reused graph handle stays exact");
+
+    streamed = 0;
+    const MatchSummary stopped = prepared_path->forEachMatch(
+        [&](const std::vector<int>&, const std::vector<TimeInterval>&) {
+            return ++streamed < 2;
+        });
+    require(streamed == 2 && stopped.match_count == 2 &&
+            stopped.stop_reason == MatchStopReason::Consumer,
+            "the consumer can stop enumeration early");
+
+    require(prepareQuery(data_graph, path, 1, error) == nullptr && !error.empty(),
+            "k below 2 is rejected");
+    Graph disconnected = makeQuery({"A", "B", "C", "A"}, {{0, 1}});
+    error.clear();
+    require(prepareQuery(data_graph, disconnected, 2, error) == nullptr &&
+                error == "query graph must be connected",
+            "disconnected queries are rejected");
+    // Two components that each have data candidates still never get a TD-tree.
+    Graph two_paths = makeQuery({"A", "B", "A", "B"}, {{0, 1}, {2, 3}});
+    error.clear();
+    require(prepareQuery(data_graph, two_paths, 2, error) == nullptr &&
+                error == "query graph must be connected",
+            "queries with several matchable components are rejected");
+    static_assert(!std::is_constructible<PreparedQuery,
+                      std::shared_ptr<const DataGraphHandle>, Graph, int>::value,
+        "prepared queries are only built through prepareQuery");
+}
+
+void testQueryService(const std::filesystem::path& directory) {
+    const auto graph_path = directory / "ours_service_graph.dat";
+    {
+        // A complete digraph on six vertices: 30 arcs over at most 25 label
+        // pairs, so whatever the seeded labels, some pair has several arcs.
+        std::ofstream output(graph_path);
+        for (int t = 1; t <= 4; ++t) {
+            for (int u = 1; u <= 6; ++u) {
+                for (int v = 1; v <= 6; ++v) {
+                    if (u != v) output << u * 10 << ' ' << v * 10 << ' ' << t << '\n';
+                }
+            }
+        }
+    }
+    std::string error;
+    const auto data_graph = loadGraph(graph_path.string(), kDefaultLabelSeed, error);
+    require(data_graph != nullptr, "service fixture loads: " + error);
+    const Graph& graph = data_graph->graph;
+    std::map<std::pair<Label, Label>, int> arcs_by_labels;
+    for (const TemporalEdge& arc : graph.temporal_edges) {
+        ++arcs_by_labels[{graph.vertex_labels[static_cast<std::size_t>(arc.u)],
+                          graph.vertex_labels[static_cast<std::size_t>(arc.v)]}];
+    }
+    const auto busiest = std::max_element(
+        arcs_by_labels.begin(), arcs_by_labels.end(),
+        [](const auto& lhs, const auto& rhs) { return lhs.second < rhs.second; });
+    const std::string arc_query = "0:" + labelToString(busiest->first.first) +
+                                  " 1:" + labelToString(busiest->first.second);
+    Graph query;
+    std::istringstream query_input(arc_query);
+    require(parseQueryGraph(query_input, query), "service fixture query parses");
+    const auto prepared = prepareQuery(data_graph, query, 2, error);
+    require(prepared != nullptr, "service fixture query prepares: " + error);
+    const std::uint64_t expected = prepared->forEachMatch(
+        [](const std::vector<int>&, const std::vector<TimeInterval>&) { return true; }).match_count;
+    require(expected > 1, "service fixture needs several matches");
+
+    auto serve = [](const std::string& script, std::size_t memory_budget_bytes) {
+        QueryServiceOptions options;
+        options.worker_count = 2;
+        options.memory_budget_bytes = memory_budget_bytes;
+        std::istringstream input(script);
+        std::ostringstream output;
+        serveQueries(input, output, options);
+        std::vector<std::string> lines;
+        std::istringstream reply(output.str());
+        for (std::string line; std::getline(reply, line);) lines.push_back(line);
+        return lines;
+    };
+    auto count_prefixed = [](const std::vector<std::string>& lines, const std::string& prefix) {
+        return std::count_if(lines.begin(), lines.end(), [&](const std::string& line) {
+            return line.rfind(prefix, 0) == 0;
+        });
+    };
+
+    const std::vector<std::string> lines = serve(
+        "# comment\n"
+        "\n"
+        "LOAD g " + graph_path.string() + "\n"
+        "QUERY q1 g 2 matches : " + arc_query + "\n"
+        "QUERY q2 g 2 count limit=1 : " + arc_query + "\n"
+        "QUERY q3 missing 2 count : " + arc_query + "\n"
+        "QUERY q4 g 2 count bogus : " + arc_query + "\n"
+        "QUERY q5\n"
+        "FROB\n"
+        "LOAD\n"
+        "UNLOAD g\n"
+        "UNLOAD g\n"
+        "QUERY q6 g 2 count : " + arc_query + "\n"
+        "QUIT\n"
+        "QUERY q7 g 2 count : " + arc_query + "\n",
+        0);
+    const std::string complete = matchStopReasonName(MatchStopReason::Complete);
+    const std::string result_limit = matchStopReasonName(MatchStopReason::ResultLimit);
+    require(count_prefixed(lines, "OK LOAD g vertices=" + std::to_string(graph.num_vertices) + ' ') == 1,
+            "LOAD reports the resident graph");
+    require(count_prefixed(lines, "MATCH q1 ") == static_cast<std::ptrdiff_t>(expected) &&
+                count_prefixed(lines, "RESULT q1 count=" + std::to_string(expected) +
+                                      " stop_reason=" + complete + ' ') == 1,
+            "a matches query streams every row before its result");
+    require(count_prefixed(lines, "RESULT q2 count=1 stop_reason=" + result_limit + ' ') == 1 &&
+                count_prefixed(lines, "MATCH q2 ") == 0,
+            "a count query honours its limit and streams no rows");
+    require(count_prefixed(lines, "ERROR q3 unknown graph missing") == 1 &&
+                count_prefixed(lines, "ERROR q4 invalid query options") == 1 &&
+                count_prefixed(lines, "ERROR QUERY usage:") == 1 &&
+                count_prefixed(lines, "ERROR FROB unknown command") == 1 &&
+                count_prefixed(lines, "ERROR LOAD usage:") == 1,
+            "malformed lines and unknown graphs are answered with errors");
+    require(count_prefixed(lines, "OK UNLOAD g") == 1 &&
+                count_prefixed(lines, "ERROR UNLOAD unknown graph g") == 1 &&
+                count_prefixed(lines, "ERROR q6 unknown graph g") == 1,
+            "UNLOAD removes the graph from later queries");
+    require(count_prefixed(lines, "RESULT q7") == 0 && count_prefixed(lines, "ERROR q7") == 0,
+            "lines after QUIT are ignored");
+    require(lines.size() == expected + 11, "every request gets exactly one reply");
+
+    const std::vector<std::string> rejected = serve(
+        "LOAD g " + graph_path.string() + "\nQUERY q1 g 2 count : " + arc_query + "\n", 1);
+    require(rejected.size() == 2 &&
+                rejected[1] == "ERROR q1 estimated TD-tree size " +
+                                   std::to_string(estimateTDTreeBytes(*data_graph, query)) +
+                                   " bytes exceeds the memory budget",
+            "queries estimated over the memory budget are rejected");
+    std::filesystem::remove(graph_path);
+}
+
+void testBatchRunner(const std::filesystem::path& directory) {
+    auto parse = [](const std::string& text, BatchManifest& manifest) {
+        std::istringstream input(text);
+        return readManifest(input, manifest);
+    };
+    BatchManifest parsed;
+    require(parse("# sweep\n\n  \ndataset a.dat b.dat\r\nquery q.txt\nk 4 2-3 3\n"
+                  "seed 7\nseed 9\nwindow 1 5\nmode count-only\nlimit 10\n",
+                  parsed),
+            "a manifest with comments and blank lines parses");
+    require(parsed.datasets == std::vector<std::string>({"a.dat", "b.dat"}) &&
+                parsed.queries == std::vector<std::string>({"q.txt"}) &&
+                parsed.minimum_durations == std::vector<int>({2, 3, 4}) &&
+                parsed.label_seeds == std::vector<std::uint32_t>({7, 9}) &&
+                parsed.windows.size() == 1 && parsed.windows[0].first == 1 &&
+                parsed.windows[0].last == 5 &&
+                parsed.options.output_mode == MatchOutputMode::CountOnly &&
+                parsed.options.limits.max_results == 10,
+            "manifest values are collected, and k comes back sorted and unique");
+    for (const std::string bad_row :
+         {"k 1", "k 3-2", "seed -1", "window 5 1", "mode fast", "limit 0", "dataset", "colour red"}) {
+        BatchManifest rejected;
+        require(!parse("dataset a.dat\nquery q.txt\nk 2\n" + bad_row + '\n', rejected),
+                "the manifest row '" + bad_row + "' is rejected");
+    }
+    BatchManifest incomplete;
+    require(!parse("dataset a.dat\nk 2\n", incomplete), "a manifest without queries is rejected");
+
+    const auto graph_path = directory / "ours_batch_graph.dat";
+    const auto query_path = directory / "ours_batch_query.txt";
+    const auto disconnected_path = directory / "ours_batch_disconnected.txt";
+    const auto results_directory = directory / "ours_batch_results";
+    std::filesystem::create_directories(results_directory);
+    {
+        std::ofstream output(graph_path);
+        for (int t = 1; t <= 5; ++t) {
+            for (int u = 1; u <= 5; ++u) {
+                for (int v = 1; v <= 5; ++v) {
+                    if (u != v) output << u << ' ' << v << ' ' << t << '\n';
+                }
+            }
+        }
+    }
+    std::ofstream(query_path) << "A B\n";
+    std::ofstream(disconnected_path) << "A B\nC D\n";
+
+    BatchManifest manifest;
+    require(parse("dataset " + graph_path.string() + "\nquery " + query_path.string() + ' ' +
+                      disconnected_path.string() + "\nk 2-3\nseed 1 2\nwindow 1 4\n"
+                      "results_dir " + results_directory.string() + '\n',
+                  manifest),
+            "the batch fixture manifest parses");
+    std::ostringstream csv;
+    std::size_t run_count = 0;
+    require(runBatch(manifest, csv, run_count) == 0, "the batch fixture runs");
+
+    std::istringstream table(csv.str());
+    std::vector<std::vector<std::string>> rows;
+    for (std::string line; std::getline(table, line);) {
+        std::vector<std::string> cells;
+        std::istringstream cell_input(line);
+        for (std::string cell; std::getline(cell_input, cell, ',');) cells.push_back(cell);
+        rows.push_back(std::move(cells));
+    }
+    const std::vector<std::string> header{
+        "dataset", "query", "k", "label_seed", "window", "mode", "count_strategy",
+        "matching_order", "stop_reason", "match_count", "failing_set_pruned_candidates",
+        "readTemporalGraph", "filterTemporalGraph", "readAndFilterTemporalGraph", "windowView",
+        "readQueryGraph", "labelStatistics", "queryDecomposition", "buildTDTree",
+        "enumerateMatches", "matchWriterBlocked", "endToEnd"};
+    // The disconnected query is skipped: 2 seeds x 2 k of the path query.
+    require(!rows.empty() && rows[0] == header, "the batch table has the documented columns");
+    require(run_count == 4 && rows.size() == run_count + 1, "the batch table has one row per run");
+    const std::vector<std::pair<std::string, std::string>> runs{
+        {"1", "2"}, {"1", "3"}, {"2", "2"}, {"2", "3"}};
+    for (std::size_t run = 0; run < runs.size(); ++run) {
+        const std::vector<std::string>& row = rows[run + 1];
+        require(row.size() == header.size() && row[0] == "ours_batch_graph" &&
+                    row[1] == "ours_batch_query" && row[3] == runs[run].first &&
+                    row[2] == runs[run].second && row[4] == "1-4" &&
+                    row[8] == matchStopReasonName(MatchStopReason::Complete),
+                "batch rows run seeds, then k, in order");
+        require(std::filesystem::exists(
+                    results_directory / ("matching_results_ours_batch_graph_ours_batch_query_k" +
+                                         row[2] + "_seed" + row[3] + "_w1-4.txt")),
+                "every batch run writes its result file");
+    }
+    std::filesystem::remove_all(results_directory);
+    std::filesystem::remove(graph_path);
+    std::filesystem::remove(query_path);
+    std::filesystem::remove(disconnected_path);
+}
+
+void testDurabilityProfileAndTreeReuse(const std::filesystem::path& directory) {
+    const std::vector<Graph> queries{
+        makeTriangleQuery(),
+        makeQuery({"A", "B", "A"}, {{0, 1}, {2, 1}}),
+        makeQuery({"A", "B", "C"}, {{0, 1}, {1, 0}, {1, 2}})};
+    constexpr int maximum_duration = 6;
+    MatchOptions count_only;
+    count_only.output_mode = MatchOutputMode::CountOnly;
+
+    bool saw_long_match = false;
+    for (int round = 0; round < 16; ++round) {
+        const Graph graph = makeRandomTemporalGraph(
+            0x27d4eb2fU + round, 700, 2.0 / 3.0, 8, 3, true);
+
+        for (std::size_t query_index = 0; query_index < queries.size(); ++query_index) {
+            const Graph& query = queries[query_index];
+            const QueryDecomposition decomposition = makeDecomposition(query);
+            const std::string suffix =
+                std::to_string(round) + '_' + std::to_string(query_index);
+            const auto profile_path = directory / ("ours_profile_" + suffix + ".dat");
+            std::vector<std::string> per_k_paths;
+            for (int k = 2; k <= maximum_duration; ++k) {
+                per_k_paths.push_back(
+                    (directory / ("ours_profile_" + suffix + "_k" + std::to_string(k) + ".dat"))
+                        .string());
+            }
+
+            TDTree profiled(graph, query, decomposition, 2);
+            const DurabilityProfile profile = profiled.saveDurabilityProfile(
+                profile_path.string(), maximum_duration, per_k_paths);
+            require(profile.summary.output_written, "durability profile written");
+            require(profile.match_counts.size() == per_k_paths.size(),
+                    "one profile count per k");
+
+            TDTree reused(graph, query, decomposition, 2);
+            require(!reused.raiseMinimumDuration(1), "a TD-tree cannot be reused for a smaller k");
+            for (int k = 2; k <= maximum_duration; ++k) {
+                const std::size_t offset = static_cast<std::size_t>(k - 2);
+                const std::uint64_t expected = bruteForceMatchCount(graph, query, k);
+                saw_long_match = saw_long_match || (k >= 4 && expected > 0);
+                require(profile.match_counts[offset] == expected,
+                        "profile count differs from brute force in round " + suffix +
+                            " at k=" + std::to_string(k));
+
+                std::ifstream per_k(per_k_paths[offset], std::ios::binary);
+                const std::string contents(
+                    (std::istreambuf_iterator<char>(per_k)), std::istreambuf_iterator<char>());
+                std::size_t rows = 0;
+                for (std::size_t found = contents.find("\nMatch ");
+                     found != std::string::npos;
+                     found = contents.find("\nMatch ", found + 1)) {
+                    ++rows;
+                }
+                require(rows == expected, "per-k result file holds that k's matches");
+                per_k.close();
+                std::filesystem::remove(per_k_paths[offset]);
+
+                require(reused.raiseMinimumDuration(k) && reused.minimumDuration() == k,
+                        "a TD-tree can be reused for a larger k");
+                const TDTree fresh(graph, query, decomposition, k);
+                require(reused.candidateRelationCount() >= fresh.candidateRelationCount(),
+                        "in-place filtering keeps every candidate of a fresh build");
+                require(reused.peelingInputVertexCount() == fresh.peelingInputVertexCount() &&
+                            reused.peelingSurvivorCount() == fresh.peelingSurvivorCount(),
+                        "peeling statistics follow the raised k");
+                const auto reused_path = directory / ("ours_reused_" + suffix + ".dat");
+                const MatchSummary reused_summary =
+                    reused.save_res(reused_path.string(), count_only);
+                require(reused_summary.match_count == expected,
+                        "reused TD-tree count differs from brute force in round " + suffix +
+                            " at k=" + std::to_string(k));
+                std::filesystem::remove(reused_path);
+            }
+            std::filesystem::remove(profile_path);
+        }
+    }
+    require(saw_long_match, "profile fixtures must include matches at large k");
+}
+
+void testTopMatchesByLongestRun() {
+    const std::vector<Graph> queries{
+        makeTriangleQuery(),
+        makeQuery({"A", "B", "A"}, {{0, 1}, {2, 1}})};
+    struct FoundMatch {
+        std::vector<int> mapping;
+        std::vector<TimeInterval> intervals;
+        int longest_run = 0;
+    };
+    auto collect = [](const TDTree& tree, const MatchOptions& options) {
+        std::vector<FoundMatch> found;
+        tree.forEachMatch(
+            [&](const std::vector<int>& mapping, const std::vector<TimeInterval>& intervals) {
+                int longest_run = 0;
+                for (const auto& interval : intervals) {
+                    longest_run = std::max(longest_run, interval.length());
+                }
+                found.push_back({mapping, intervals, longest_run});
+                return true;
+            },
+            options);
+        return found;
+    };
+
+    bool saw_ranking = false;
+    for (int round = 0; round < 16; ++round) {
+        const Graph graph = makeRandomTemporalGraph(
+            0x165667b1U + round, 300, 2.0 / 3.0, 9, 3, true);
+
+        for (const Graph& query : queries) {
+            const QueryDecomposition decomposition = makeDecomposition(query);
+            const TDTree tree(graph, query, decomposition, 2);
+            std::vector<FoundMatch> expected = collect(tree, {});
+            std::stable_sort(expected.begin(), expected.end(),
+                [](const FoundMatch& lhs, const FoundMatch& rhs) {
+                    return lhs.longest_run > rhs.longest_run;
+                });
+            for (const std::size_t top : {std::size_t{1}, std::size_t{3}, std::size_t{8}}) {
+                for (const MatchingOrder order : {MatchingOrder::Static, MatchingOrder::Adaptive}) {
+                    MatchOptions options;
+                    options.top_matches = top;
+                    options.matching_order = order;
+                    const std::vector<FoundMatch> actual = collect(tree, options);
+                    require(actual.size() == std::min(top, expected.size()),
+                            "top-N keeps min(N, matches) matches");
+                    for (std::size_t rank = 0; rank < actual.size(); ++rank) {
+                        require(actual[rank].longest_run == expected[rank].longest_run,
+                                "top-N ranks by longest common run in round " +
+                                    std::to_string(round));
+                        const auto same = std::find_if(expected.begin(), expected.end(),
+                            [&](const FoundMatch& match) {
+                                return match.mapping == actual[rank].mapping;
+                            });
+                        require(same != expected.end() &&
+                                    same->intervals.size() == actual[rank].intervals.size() &&
+                                    std::equal(same->intervals.begin(), same->intervals.end(),
+                                        actual[rank].intervals.begin(),
+                                        [](const TimeInterval& lhs, const TimeInterval& rhs) {
+                                            return lhs.start == rhs.start && lhs.end == rhs.end;
+                                        }),
+                                "top-N reports real matches with their full common intervals");
+                        if (order == MatchingOrder::Static) {
+                            require(actual[rank].mapping == expected[rank].mapping,
+                                    "ties keep the earliest found match");
+                        }
+                    }
+                    saw_ranking = saw_ranking || expected.size() > top;
+                }
+            }
+        }
+    }
+    require(saw_ranking, "top-N fixtures must include more matches than N");
+}
+
+void testSnapshotWindows() {
+    const std::vector<Graph> queries{
+        makeTriangleQuery(),
+        makeQuery({"A", "B", "A"}, {{0, 1}, {2, 1}})};
+
+    bool saw_match = false;
+    for (int round = 0; round < 12; ++round) {
+        const Graph graph = makeRandomTemporalGraph(
+            0x2545f491U + round, 400, 2.0 / 3.0, 8, 3, true);
+        const TemporalIntervalIndex index(graph);
+        std::size_t interval_count = 0;
+        for (const auto& edge : graph.temporal_edges) interval_count += edge.active_intervals.size();
+        require(index.entryCount() == interval_count, "the index holds every active interval");
+
+        for (int first = 0; first <= 7; ++first) {
+            for (int last = first; last <= 7; ++last) {
+                const SnapshotWindow window{first, last};
+                for (int k = 2; k <= 3; ++k) {
+                    // Oracle: clip every interval naively and keep edges with a k-run.
+                    Graph clipped;
+                    clipped.num_vertices = graph.num_vertices;
+                    clipped.external_ids = graph.external_ids;
+                    clipped.vertex_labels = graph.vertex_labels;
+                    clipped.adj.resize(graph.adj.size());
+                    clipped.in_adj.resize(graph.in_adj.size());
+                    for (const auto& edge : graph.temporal_edges) {
+                        std::vector<TimeInterval> intervals;
+                        for (const auto& interval : edge.active_intervals) {
+                            const TimeInterval part{
+                                std::max(interval.start, first), std::min(interval.end, last)};
+                            if (part.length() >= k) intervals.push_back(part);
+                        }
+                        if (!intervals.empty()) {
+                            addTemporalEdge(clipped, edge.u, edge.v, std::move(intervals));
+                        }
+                    }
+                    finalizeSyntheticGraph(clipped);
+
+                    const Graph view = makeWindowGraph(graph, index, window, k);
+                    require(view.temporal_edges.size() == clipped.temporal_edges.size(),
+                            "a window view keeps exactly the edges with a k-run inside it");
+                    for (const auto& edge : clipped.temporal_edges) {
+                        const TemporalEdge* view_edge = view.findTemporalEdge(edge.u, edge.v);
+                        require(view_edge != nullptr &&
+                                    view_edge->active_intervals.size() ==
+                                        edge.active_intervals.size() &&
+                                    std::equal(edge.active_intervals.begin(),
+                                        edge.active_intervals.end(),
+                                        view_edge->active_intervals.begin(),
+                                        [](const TimeInterval& lhs, const TimeInterval& rhs) {
+                                            return lhs.start == rhs.start && lhs.end == rhs.end;
+                                        }),
+                                "a window view clips intervals to the window");
+                    }
+
+                    for (const Graph& query : queries) {
+                        const std::uint64_t expected = bruteForceMatchCount(clipped, query, k);
+                        saw_match = saw_match || (expected > 0 && window.length() < 6);
+                        const QueryDecomposition decomposition = makeDecomposition(query);
+                        const TDTree tree(view, query, decomposition, k);
+                        const MatchSummary summary = tree.forEachMatch(
+                            [](const std::vector<int>&, const std::vector<TimeInterval>&) {
+                                return true;
+                            });
+                        require(summary.match_count == expected,
+                                "window count differs from brute force in round " +
+                                    std::to_string(round) + " for [" + std::to_string(first) +
+                                    ", " + std::to_string(last) + "] at k=" +
+                                    std::to_string(k));
+                    }
+                }
+            }
+        }
+    }
+    require(saw_match, "window fixtures must include matches in narrow windows");
+}
+
+void testTimeParallelWindows() {
+    require(planTimeWindows({1, 6}, 2, 3).size() == 2 &&
+                planTimeWindows({1, 6}, 2, 3)[1].window.last == 6 &&
+                planTimeWindows({1, 6}, 2, 3)[1].last_run_start == 4,
+            "time windows cover every run start once");
+    require(planTimeWindows({1, 2}, 1, 3).empty(), "no window fits a run longer than the span");
+
+    const std::vector<Graph> queries{
+        makeTriangleQuery(),
+        makeQuery({"A", "B", "A"}, {{0, 1}, {2, 1}})};
+
+    bool saw_overlap = false;
+    for (int round = 0; round < 12; ++round) {
+        const Graph graph = makeRandomTemporalGraph(
+            0x6b43a9b5U + round, 500, 2.0 / 3.0, 9, 3, true);
+        const TemporalIntervalIndex index(graph);
+
+        for (const Graph& query : queries) {
+            const QueryDecomposition decomposition = makeDecomposition(query);
+            for (int k = 2; k <= 3; ++k) {
+                const TDTree tree(graph, query, decomposition, k);
+                const std::vector<MatchRow> expected = collectRows(tree);
+
+                for (const int run_starts : {1, 2, 5}) {
+                    for (const unsigned threads : {1U, 3U}) {
+                        TimeParallelOptions options;
+                        options.run_starts_per_window = run_starts;
+                        options.threads = threads;
+                        std::vector<TimeWindowReport> reports;
+                        require(collectRows([&](const MatchCallback& callback) {
+                                    return forEachMatchByTimeWindows(
+                                        graph, index, query, decomposition, k, options,
+                                        callback, &reports);
+                                }) == expected,
+                                "time-parallel windows report every match once in round " +
+                                    std::to_string(round) + " with W=" +
+                                    std::to_string(run_starts));
+                        std::uint64_t found = 0;
+                        for (const auto& report : reports) found += report.found_matches;
+                        saw_overlap = saw_overlap || found > expected.size();
+                    }
+                }
+            }
+        }
+    }
+    require(saw_overlap, "time-parallel fixtures must include matches found by several windows");
+}
+
+void testSnapshotSweepEngine() {
+    const std::vector<Graph> queries{
+        makeTriangleQuery(),
+        makeTwoVertexQuery(true),
+        makeQuery({"A", "B", "A"}, {{0, 1}, {2, 1}}),
+        makeQuery({"A", "B", "C", "A"}, {{0, 1}, {1, 2}, {2, 3}, {3, 0}, {0, 2}})};
+
+    bool saw_match = false;
+    for (int round = 0; round < 16; ++round) {
+        const Graph graph = makeRandomTemporalGraph(
+            0x3c6ef372U + round, 600, 2.0 / 3.0, 9, 3, true);
+
+        for (const Graph& query : queries) {
+            const QueryDecomposition decomposition = makeDecomposition(query);
+            for (int k = 2; k <= 4; ++k) {
+                const TDTree tree(graph, query, decomposition, k);
+                const SnapshotSweepMatcher sweep(graph, query, k);
+                const std::vector<MatchRow> expected = collectRows(tree);
+                require(collectRows(sweep) == expected,
+                        "sweep engine differs from the TD-tree in round " +
+                            std::to_string(round) + " at k=" + std::to_string(k));
+                saw_match = saw_match || !expected.empty();
+
+                if (expected.size() > 1) {
+                    MatchOptions limited;
+                    limited.limits.max_results = expected.size() - 1;
+                    const MatchSummary truncated = sweep.forEachMatch(
+                        [](const std::vector<int>&, const std::vector<TimeInterval>&) {
+                            return true;
+                        },
+                        limited);
+                    require(truncated.match_count == expected.size() - 1 &&
+                                truncated.stop_reason == MatchStopReason::ResultLimit,
+                            "sweep engine honours result limits");
+                }
+            }
+        }
+    }
+    require(saw_match, "sweep fixtures must include matches");
+}
+
+void testDurablePeeling() {
+    const Graph query = makeTriangleQuery();
+    const QueryDecomposition decomposition = makeDecomposition(query);
+    Graph graph;
+    graph.num_vertices = 10;
+    graph.adj.resize(10);
+    graph.in_adj.resize(10);
+    for (int vertex = 0; vertex < graph.num_vertices; ++vertex) {
+        graph.external_ids.push_back(700 + vertex);
+    }
+    graph.vertex_labels = {
+        labelFromString("A"), labelFromString("B"), labelFromString("C"),
+        labelFromString("A"), labelFromString("B"), labelFromString("C"), labelFromString("A"),
+        labelFromString("A"), labelFromString("B"), labelFromString("C")};
+    // The one durable triangle.
+    addTemporalEdge(graph, 0, 1, {{1, 5}});
+    addTemporalEdge(graph, 1, 2, {{1, 5}});
+    addTemporalEdge(graph, 2, 0, {{1, 5}});
+    // A chain that unravels from its end: 6 has no B out-neighbour, which
+    // then leaves 5, 4 and 3 short one round at a time.
+    addTemporalEdge(graph, 3, 4, {{1, 5}});
+    addTemporalEdge(graph, 4, 5, {{1, 5}});
+    addTemporalEdge(graph, 5, 6, {{1, 5}});
+    // A static triangle whose B->C arc never lasts two snapshots.
+    addTemporalEdge(graph, 7, 8, {{1, 5}});
+    addTemporalEdge(graph, 8, 9, {{1, 1}, {3, 3}});
+    addTemporalEdge(graph, 9, 7, {{1, 5}});
+    finalizeSyntheticGraph(graph);
+
+    const TDTree tree(graph, query, decomposition, 2);
+    require(tree.peelingInputVertexCount() == 10, "peeling starts from every compatible vertex");
+    require(tree.peelingSurvivorCount() == 3, "peeling keeps only the durable triangle");
+    require(tree.forEachMatch([](const std::vector<int>&, const std::vector<TimeInterval>&) {
+                return true;
+            }).match_count == 1,
+            "peeling keeps the durable match");
+
+    const std::vector<Graph> queries{
+        query,
+        makeQuery({"A", "B", "A"}, {{0, 1}, {2, 1}}),
+        makeQuery({"A", "B", "C", "A"}, {{0, 1}, {1, 2}, {2, 3}, {3, 0}})};
+    for (int round = 0; round < 12; ++round) {
+        const Graph random_graph = makeRandomTemporalGraph(0x9e3779b9U + round, 800, 0.5);
+        for (const Graph& random_query : queries) {
+            const QueryDecomposition random_decomposition = makeDecomposition(random_query);
+            for (int k = 2; k <= 4; ++k) {
+                const TDTree random_tree(random_graph, random_query, random_decomposition, k);
+                require(random_tree.peelingSurvivorCount() <= random_tree.peelingInputVertexCount(),
+                        "peeling never adds vertices");
+                const MatchSummary summary = random_tree.forEachMatch(
+                    [](const std::vector<int>&, const std::vector<TimeInterval>&) { return true; });
+                require(summary.match_count ==
+                            bruteForceMatchCount(random_graph, random_query, k),
+                        "peeling keeps every durable match in round " + std::to_string(round) +
+                            " at k=" + std::to_string(k));
+            }
+        }
+    }
+}
+
+void testCeciEngine() {
+    const std::vector<Graph> queries{
+        makeTriangleQuery(),
+        makeTwoVertexQuery(true),
+        makeQuery({"A", "B", "A"}, {{0, 1}, {2, 1}}),
+        makeQuery({"A", "B", "C", "A"}, {{0, 1}, {1, 2}, {2, 3}, {3, 0}, {0, 2}}),
+        makeQuery({"A", "B", "C", "A"}, {{0, 1}, {1, 0}, {1, 2}, {3, 2}})};
+
+    bool saw_match = false;
+    bool saw_pruning = false;
+    for (int round = 0; round < 16; ++round) {
+        const Graph graph = makeRandomTemporalGraph(
+            0x5bd1e995U + round, 900, 2.0 / 3.0, 9, 3, true);
+
+        for (const Graph& query : queries) {
+            const QueryDecomposition decomposition = makeDecomposition(query);
+            for (int k = 2; k <= 4; ++k) {
+                const TDTree tree(graph, query, decomposition, k);
+                const std::vector<MatchRow> expected = collectRows(tree);
+                saw_match = saw_match || !expected.empty();
+
+                for (unsigned threads : {1U, 3U}) {
+                    const CeciMatcher ceci(graph, query, k, threads);
+                    require(collectRows(ceci) == expected,
+                            "CECI engine differs from the TD-tree in round " +
+                                std::to_string(round) + " at k=" + std::to_string(k) +
+                                " with " + std::to_string(threads) + " threads");
+                    const CeciStatistics& statistics = ceci.statistics();
+                    require(statistics.refined_candidates <= statistics.forward_candidates,
+                            "CECI refinement only removes candidates");
+                    saw_pruning = saw_pruning ||
+                        statistics.refined_candidates < statistics.forward_candidates;
+
+                    if (expected.size() > 1) {
+                        MatchOptions limited;
+                        limited.limits.max_results = expected.size() - 1;
+                        const MatchSummary truncated = ceci.forEachMatch(
+                            [](const std::vector<int>&, const std::vector<TimeInterval>&) {
+                                return true;
+                            },
+                            limited);
+                        require(truncated.match_count == expected.size() - 1 &&
+                                    truncated.stop_reason == MatchStopReason::ResultLimit,
+                                "CECI engine honours result limits");
+                        MatchOptions exists;
+                        exists.limits.exists_only = true;
+                        const MatchSummary found = ceci.forEachMatch(
+                            [](const std::vector<int>&, const std::vector<TimeInterval>&) {
+                                return true;
+                            },
+                            exists);
+                        require(found.match_count == 1 &&
+                                    found.stop_reason == MatchStopReason::Exists,
+                                "CECI engine stops at the first match for existence checks");
+                    }
+                }
+            }
+        }
+    }
+    require(saw_match, "CECI fixtures must include matches");
+    require(saw_pruning, "CECI fixtures must exercise backward refinement");
+}
+
 } // namespace
 
 int main() {
     try {
         const auto temp_directory = std::filesystem::temp_directory_path();
         testIntervals();
+        testIntegerParsing();
+        testAsyncMatchWriter();
         testFilteringAndDenseIds(temp_directory);
         testRepeatedLabelQueryParsing(temp_directory);
         testPdfSelectivityAndRecursiveDfs();
         testExactDurableMatching(temp_directory);
         testDirectedTreeOrientationAndReciprocalArcs(temp_directory);
         testRandomGraphsAgainstBruteForce(temp_directory);
+        testMultiwayIntersectionExtension(temp_directory);
+        testHubNonTreeProbing();
+        testFailingSetBackjumping(temp_directory);
+        testAdaptiveMatchingOrder(temp_directory);
+        testFactorizedCounting(temp_directory);
+        testResultLimitsAndExists(temp_directory);
+        testBinaryOutputRoundTrip(temp_directory);
+        testLibraryStreamingApi();
+        testQueryService(temp_directory);
+        testBatchRunner(temp_directory);
+        testDurabilityProfileAndTreeReuse(temp_directory);
+        testTopMatchesByLongestRun();
+        testSnapshotWindows();
+        testTimeParallelWindows();
+        testSnapshotSweepEngine();
+        testDurablePeeling();
+        testCeciEngine();
         std::cout << "All ours tests passed.\n";
         return 0;
     } catch (const std::exception& error) {